@@ -30,11 +30,16 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include "api0ucode.h"
 #include "btr0blob.h"
 #include "btr0pcur.h"
+#include "buf0dump.h"
 #include "ddl0ddl.h"
 #include "dict0dict.h"
+#include "fil0fil.h"
 #include "innodb0types.h"
 #include "lock0lock.h"
 #include "lock0types.h"
+#include "log0log.h"
+#include "log0writer.h"
+#include "os0aio.h"
 #include "pars0pars.h"
 #include "rem0cmp.h"
 #include "row0ins.h"
@@ -667,6 +672,16 @@ ib_err_t ib_shutdown(ib_shutdown_t flag) {
   return InnoDB::shutdown(flag);
 }
 
+ib_err_t ib_buffer_pool_dump() {
+  IB_CHECK_PANIC();
+
+  if (!srv_was_started) {
+    return DB_ERROR;
+  }
+
+  return buf_dump(srv_buf_pool);
+}
+
 ib_err_t ib_trx_start(ib_trx_t ib_trx, ib_trx_level_t ib_trx_level) {
   ib_err_t err = DB_SUCCESS;
   auto trx = reinterpret_cast<Trx *>(ib_trx);
@@ -739,6 +754,41 @@ ib_err_t ib_trx_commit(ib_trx_t ib_trx) {
   return DB_SUCCESS;
 }
 
+ib_err_t ib_trx_commit_async(ib_trx_t ib_trx, ib_trx_durable_t callback, void *arg) {
+  auto trx = reinterpret_cast<Trx *>(ib_trx);
+
+  IB_CHECK_PANIC();
+
+  ut_a(callback != nullptr);
+
+  trx->m_flush_log_async = true;
+
+  auto err = trx->commit();
+  ut_a(err == DB_SUCCESS);
+
+  /* Zero if the transaction did not write any log. */
+  const auto lsn = trx->m_commit_lsn;
+
+  err = ib_schema_unlock(ib_trx);
+  ut_a(err == DB_SUCCESS || err == DB_SCHEMA_NOT_LOCKED);
+
+  err = ib_trx_release(ib_trx);
+  ut_a(err == DB_SUCCESS);
+
+  ib_wake_master_thread();
+
+  if (lsn == 0) {
+    callback(arg);
+  } else if (srv_log_writer != nullptr && srv_log_writer->is_active()) {
+    srv_log_writer->flush_async(lsn, callback, arg);
+  } else {
+    log_sys->write_up_to(lsn, LOG_WAIT_ONE_GROUP, true);
+    callback(arg);
+  }
+
+  return DB_SUCCESS;
+}
+
 ib_err_t ib_trx_rollback(ib_trx_t ib_trx) {
   auto trx = reinterpret_cast<Trx *>(ib_trx);
 
@@ -4642,6 +4692,76 @@ ib_err_t ib_get_table_statistics(ib_crsr_t ib_crsr, ib_table_stats_t *table_stat
   return DB_SUCCESS;
 }
 
+/**
+ * Copies a latency histogram to the caller's struct.
+ *
+ * @param[in] snapshot          Histogram to copy.
+ * @param[out] latency          Caller's struct.
+ * @param[in] sizeof_ib_io_latency_t Size of the caller's struct.
+ */
+static void ib_io_latency_copy(
+  const ut::Latency_histogram::Snapshot &snapshot, ib_io_latency_t *latency, size_t sizeof_ib_io_latency_t
+) noexcept {
+  static_assert(IB_IO_LATENCY_BUCKETS == ut::Latency_histogram::N_BUCKETS, "Histogram bucket count mismatch");
+
+  ib_io_latency_t io_latency{};
+
+  io_latency.n_ios = snapshot.m_n_samples;
+  io_latency.total_us = snapshot.m_total_us;
+  io_latency.max_us = snapshot.m_max_us;
+
+  std::copy(snapshot.m_buckets.begin(), snapshot.m_buckets.end(), io_latency.buckets);
+
+  /* A caller that was built with an older, smaller struct gets a prefix. */
+  memcpy(latency, &io_latency, std::min(sizeof_ib_io_latency_t, sizeof(io_latency)));
+}
+
+ib_err_t ib_io_latency_get_by_type(const char *type, ib_io_latency_t *latency, size_t sizeof_ib_io_latency_t) {
+  IB_CHECK_PANIC();
+
+  for (auto io_request : {IO_request::Async_read, IO_request::Async_write, IO_request::Async_log_read,
+                          IO_request::Async_log_write, IO_request::Sync_read, IO_request::Sync_write,
+                          IO_request::Sync_log_read, IO_request::Sync_log_write}) {
+
+    if (ib_utf8_strcasecmp(type, to_string(io_request)) == 0) {
+      ut::Latency_histogram::Snapshot snapshot{};
+
+      srv_aio->io_latency(io_request, snapshot);
+
+      ib_io_latency_copy(snapshot, latency, sizeof_ib_io_latency_t);
+
+      return DB_SUCCESS;
+    }
+  }
+
+  return DB_NOT_FOUND;
+}
+
+ib_err_t ib_io_latency_get_by_table(const char *table_name, ib_io_latency_t *latency, size_t sizeof_ib_io_latency_t) {
+  IB_CHECK_PANIC();
+
+  srv_dict_sys->mutex_acquire();
+
+  auto table = ib_lookup_table_by_name(table_name);
+  const auto space_id = table != nullptr ? table->m_space_id : SYS_TABLESPACE;
+
+  srv_dict_sys->mutex_release();
+
+  if (table == nullptr) {
+    return DB_TABLE_NOT_FOUND;
+  }
+
+  ut::Latency_histogram::Snapshot snapshot{};
+
+  if (!srv_fil->space_io_latency(space_id, snapshot)) {
+    return DB_TABLE_NOT_FOUND;
+  }
+
+  ib_io_latency_copy(snapshot, latency, sizeof_ib_io_latency_t);
+
+  return DB_SUCCESS;
+}
+
 ib_err_t ib_get_index_stat_n_diff_key_vals(ib_crsr_t ib_crsr, const char *index_name, uint64_t *ncols, int64_t **n_diff) {
   auto cursor = reinterpret_cast<ib_cursor_t *>(ib_crsr);
   auto table = cursor->prebuilt->m_table;
@@ -23,7 +23,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 #include <strings.h>
 #endif /** HAVE_STRINGS_H */
 
+#include "buf0cleaner.h"
+#include "buf0dblwr.h"
 #include "buf0lru.h"
+#include "buf0resize.h"
 #include "db0err.h"
 #include "dict0dict.h"
 #include "innodb0types.h"
@@ -34,6 +37,9 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
 
 static char *srv_file_flush_method_str = nullptr;
 
+/* Name of the buffer pool LRU replacement policy. */
+static char *srv_LRU_policy_str = nullptr;
+
 /* A point in the LRU list (expressed as a percent), all blocks from this
 point onwards (inclusive) are considered "old" blocks. */
 static ulint lru_old_blocks_pct;
@@ -348,6 +354,44 @@ static ib_err_t ib_cfg_var_set_flush_method(struct ib_cfg_var *cfg_var, const vo
   return (err);
 }
 
+/* @} */
+
+/**
+ * Set the value of the config variable "lru_policy".
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "lru_policy"
+ * @param value - in: value to set, must point to char* variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_LRU_policy(struct ib_cfg_var *cfg_var, const void *value) {
+  const char *value_str;
+  ib_err_t err = DB_SUCCESS;
+
+  ut_a(strcasecmp(cfg_var->name, "lru_policy") == 0);
+  ut_a(cfg_var->type == IB_CFG_TEXT);
+
+  value_str = *(const char **)value;
+
+  if (0 == strcmp(value_str, "midpoint")) {
+    srv_config.m_LRU_policy = SRV_LRU_MIDPOINT;
+  } else if (0 == strcmp(value_str, "2q")) {
+    srv_config.m_LRU_policy = SRV_LRU_2Q;
+  } else if (0 == strcmp(value_str, "clock")) {
+    srv_config.m_LRU_policy = SRV_LRU_CLOCK;
+  } else {
+    err = DB_INVALID_INPUT;
+  }
+
+  if (err == DB_SUCCESS) {
+    *(const char **)cfg_var->tank = value_str;
+  } else {
+    *(const char **)cfg_var->tank = nullptr;
+  }
+
+  return (err);
+}
+
 /* @} */
 /**
  * Retrieve the value of the config variable "log_group_home_dir".
@@ -391,7 +435,7 @@ static ib_err_t ib_cfg_var_set_LRU_old_blocks_pct(struct ib_cfg_var *cfg_var, co
   }
 
   if (srv_buf_pool != nullptr) {
-    srv_buf_pool->m_LRU->old_ratio_update(*(ulint *)value, true);
+    srv_buf_pool->old_ratio_update(*(ulint *)value, true);
   }
 
   return DB_SUCCESS;
@@ -401,6 +445,28 @@ static ib_err_t ib_cfg_var_set_LRU_old_blocks_pct(struct ib_cfg_var *cfg_var, co
 
 /* ib_cfg_var_get_generic() is used to get the value of lru_old_blocks_pct */
 
+/**
+ * Set the value of the config variable "buffer_pool_size". If InnoDB is
+ * running the buffer pool is resized in the background.
+ *
+ * @param cfg_var - in/out: configuration variable to manipulate, must be "buffer_pool_size"
+ * @param value - in: value to set, must point to ulint variable
+ *
+ * @return DB_SUCCESS if set successfully
+ */
+static ib_err_t ib_cfg_var_set_buffer_pool_size(struct ib_cfg_var *cfg_var, const void *value) {
+  ut_a(strcasecmp(cfg_var->name, "buffer_pool_size") == 0);
+  ut_a(cfg_var->type == IB_CFG_ULINT);
+
+  auto ret = ib_cfg_var_set_generic(cfg_var, value);
+
+  if (ret == DB_SUCCESS && srv_was_started && srv_buf_pool != nullptr) {
+    buf_resize_start(srv_buf_pool);
+  }
+
+  return ret;
+}
+
 /* There is no ib_cfg_var_set_version() */
 
 /**
@@ -442,16 +508,66 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_mem_pool_size)},
 
+  {STRUCT_FLD(name, "autoextend_increment"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 1000),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_autoextend_increment)},
+
   {STRUCT_FLD(name, "buffer_pool_size"),
    STRUCT_FLD(type, IB_CFG_ULINT),
-   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
    STRUCT_FLD(min_val, 5 * 1024 * 1024),
    STRUCT_FLD(max_val, ULINT_MAX),
    STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
-   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(set, ib_cfg_var_set_buffer_pool_size),
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_buf_pool_size)},
 
+  {STRUCT_FLD(name, "buffer_pool_chunk_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1024 * 1024),
+   STRUCT_FLD(max_val, ULINT_MAX),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_chunk_size)},
+
+  {STRUCT_FLD(name, "buffer_pool_instances"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, Buf_pool_manager::MAX_INSTANCES),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_instances)},
+
+  {STRUCT_FLD(name, "buffer_pool_dump_at_shutdown"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_dump_at_shutdown)},
+
+  {STRUCT_FLD(name, "buffer_pool_load_at_startup"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_buf_pool_load_at_startup)},
+
   {STRUCT_FLD(name, "checksums"),
    STRUCT_FLD(type, IB_CFG_IBOOL),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -491,6 +607,17 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(set, ib_cfg_var_set_generic),
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_use_doublewrite_buf)},
+
+  {STRUCT_FLD(name, "doublewrite_files"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, DBLWR::MAX_FILES),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_n_dblwr_files)},
+
   {STRUCT_FLD(name, "file_per_table"),
    STRUCT_FLD(type, IB_CFG_IBOOL),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -501,6 +628,16 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_file_per_table)},
 
+  {STRUCT_FLD(name, "file_preallocate_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 4096),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_file_preallocate_size)},
+
   {STRUCT_FLD(name, "flush_log_at_trx_commit"),
    STRUCT_FLD(type, IB_CFG_ULONG),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -521,6 +658,16 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_file_flush_method_str)},
 
+  {STRUCT_FLD(name, "flush_syncfs"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_flush_syncfs)},
+
   {STRUCT_FLD(name, "force_recovery"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -541,6 +688,46 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_io_capacity)},
 
+  {STRUCT_FLD(name, "io_uring_sqpoll"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_io_uring_sqpoll)},
+
+  {STRUCT_FLD(name, "io_uring_sqpoll_idle"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, 60000),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_io_uring_sqpoll_idle)},
+
+  {STRUCT_FLD(name, "large_pages"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_use_large_pages)},
+
+  {STRUCT_FLD(name, "large_page_size"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 1024 * 1024 * 1024),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_large_page_size)},
+
   {STRUCT_FLD(name, "lock_wait_timeout"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -591,6 +778,16 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_log_group_home_dir),
    STRUCT_FLD(tank, nullptr)},
 
+  {STRUCT_FLD(name, "log_writer_threads"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_log_writer_threads)},
+
   {STRUCT_FLD(name, "max_dirty_pages_pct"),
    STRUCT_FLD(type, IB_CFG_ULONG),
    STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
@@ -631,6 +828,16 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &Buf_LRU::s_old_threshold_ms)},
 
+  {STRUCT_FLD(name, "lru_policy"),
+   STRUCT_FLD(type, IB_CFG_TEXT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_LRU_policy),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_LRU_policy_str)},
+
   {STRUCT_FLD(name, "open_files"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -641,6 +848,26 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_config.m_max_n_open_files)},
 
+  {STRUCT_FLD(name, "page_cleaners"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, Page_cleaner::MAX_THREADS),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_page_cleaners)},
+
+  {STRUCT_FLD(name, "random_read_ahead"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_random_read_ahead)},
+
   {STRUCT_FLD(name, "read_io_threads"),
    STRUCT_FLD(type, IB_CFG_ULINT),
    STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
@@ -683,6 +910,26 @@ static const ib_cfg_var cfg_vars_defaults[] = {
    STRUCT_FLD(get, ib_cfg_var_get_generic),
    STRUCT_FLD(tank, &srv_print_verbose_log)},
 
+  {STRUCT_FLD(name, "punch_holes"),
+   STRUCT_FLD(type, IB_CFG_IBOOL),
+   STRUCT_FLD(flag, IB_CFG_FLAG_NONE),
+   STRUCT_FLD(min_val, 0),
+   STRUCT_FLD(max_val, 0),
+   STRUCT_FLD(validate, nullptr),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_punch_holes)},
+
+  {STRUCT_FLD(name, "recovery_apply_threads"),
+   STRUCT_FLD(type, IB_CFG_ULINT),
+   STRUCT_FLD(flag, IB_CFG_FLAG_READONLY_AFTER_STARTUP),
+   STRUCT_FLD(min_val, 1),
+   STRUCT_FLD(max_val, RECV_MAX_APPLY_THREADS),
+   STRUCT_FLD(validate, ib_cfg_var_validate_numeric),
+   STRUCT_FLD(set, ib_cfg_var_set_generic),
+   STRUCT_FLD(get, ib_cfg_var_get_generic),
+   STRUCT_FLD(tank, &srv_config.m_recovery_apply_threads)},
+
   /* New, not present in InnoDB/MySQL */
   {STRUCT_FLD(name, "rollback_on_timeout"),
    STRUCT_FLD(type, IB_CFG_IBOOL),
@@ -935,23 +1182,38 @@ ib_err_t ib_cfg_init() {
   srv_file_flush_method_str = nullptr;
   srv_config.m_unix_file_flush_method = SRV_UNIX_FSYNC;
 
+  srv_LRU_policy_str = nullptr;
+  srv_config.m_LRU_policy = SRV_LRU_MIDPOINT;
+
 #define IB_CFG_SET(name, var)              \
   if (ib_cfg_set(name, var) != DB_SUCCESS) \
   ut_error
 
   IB_CFG_SET("additional_mem_pool_size", 4 * 1024 * 1024);
+  IB_CFG_SET("autoextend_increment", 8);
   IB_CFG_SET("buffer_pool_size", 8 * 1024 * 1024);
+  IB_CFG_SET("buffer_pool_instances", 1);
   IB_CFG_SET("data_home_dir", "./");
+  IB_CFG_SET("doublewrite_files", 2);
   IB_CFG_SET("file_per_table", true);
+  IB_CFG_SET("file_preallocate_size", 64);
   IB_CFG_SET("flush_method", "fsync");
+  IB_CFG_SET("flush_syncfs", false);
+  IB_CFG_SET("io_uring_sqpoll", false);
+  IB_CFG_SET("io_uring_sqpoll_idle", 1000);
   IB_CFG_SET("lock_wait_timeout", 60);
   IB_CFG_SET("log_buffer_size", 384 * 1024);
   IB_CFG_SET("log_file_size", 16 * 1024 * 1024);
   IB_CFG_SET("log_files_in_group", 2);
   IB_CFG_SET("log_group_home_dir", ".");
+  IB_CFG_SET("log_writer_threads", true);
   IB_CFG_SET("lru_old_blocks_pct", 3 * 100 / 8);
   IB_CFG_SET("lru_block_access_recency", 0);
+  IB_CFG_SET("lru_policy", "midpoint");
+  IB_CFG_SET("punch_holes", false);
+  IB_CFG_SET("recovery_apply_threads", 4);
   IB_CFG_SET("rollback_on_timeout", true);
+  IB_CFG_SET("page_cleaners", 1);
   IB_CFG_SET("read_io_threads", 4);
   IB_CFG_SET("write_io_threads", 4);
 #undef IB_CFG_SET
@@ -68,10 +68,18 @@ static const ib_status_t status_vars[] = {
 
   {"fsync_req_done", IB_STATUS_ULINT, &export_vars.innodb_data_fsyncs},
 
+  {"throttled_req_done", IB_STATUS_ULINT, &export_vars.innodb_data_throttled_reqs},
+
   {"bytes_total_written", IB_STATUS_ULINT, &export_vars.innodb_data_written},
 
   {"bytes_total_read", IB_STATUS_ULINT, &export_vars.innodb_data_read},
 
+  {"data_file_foreground_extends", IB_STATUS_ULINT, &export_vars.innodb_data_foreground_extends},
+
+  {"data_file_preallocations", IB_STATUS_ULINT, &export_vars.innodb_data_preallocations},
+
+  {"data_file_punched_holes", IB_STATUS_ULINT, &export_vars.innodb_data_punched_holes},
+
   /* Buffer pool related */
   {"buffer_pool_current_size", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_pages_total},
 
@@ -93,6 +101,12 @@ static const ib_status_t status_vars[] = {
 
   {"buffer_pool_write_reqs", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_write_requests},
 
+  {"buffer_pool_read_ahead", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_read_ahead},
+
+  {"buffer_pool_read_ahead_used", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_read_ahead_used},
+
+  {"buffer_pool_read_ahead_evicted", IB_STATUS_ULINT, &export_vars.innodb_buffer_pool_read_ahead_evicted},
+
   {"buffer_pool_total_pages", IB_STATUS_ULINT, &export_vars.innodb_pages_created},
 
   {"buffer_pool_pages_read", IB_STATUS_ULINT, &export_vars.innodb_pages_read},
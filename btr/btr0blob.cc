@@ -229,18 +229,20 @@ void Blob::blob_free(Buf_block *block, mtr_t *mtr) noexcept {
 
   mtr->commit();
 
-  mutex_enter(&m_fsp->m_buf_pool->m_mutex);
+  auto buf_pool = m_fsp->m_buf_pool->get_instance(&block->m_page);
+
+  mutex_enter(&buf_pool->m_mutex);
   mutex_enter(&block->m_mutex);
 
   /* Only free the block if it is still allocated to the same file page. */
 
   if (block->get_state() == BUF_BLOCK_FILE_PAGE && block->get_space() == space && block->get_page_no() == page_no) {
 
-    auto block_status = m_fsp->m_buf_pool->m_LRU->free_block(&block->m_page, nullptr);
+    auto block_status = buf_pool->m_LRU->free_block(&block->m_page, nullptr);
     ut_a(block_status == Buf_LRU::Block_status::FREED);
   }
 
-  mutex_exit(&m_fsp->m_buf_pool->m_mutex);
+  mutex_exit(&buf_pool->m_mutex);
   mutex_exit(&block->m_mutex);
 }
 
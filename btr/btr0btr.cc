@@ -2238,7 +2238,7 @@ bool Btree::validate_index(Index *index, Trx *trx) noexcept {
   return true;
 }
 
-Btree *Btree::create(Lock_sys *lock_sys, FSP *fsp, Buf_pool *buf_pool) noexcept {
+Btree *Btree::create(Lock_sys *lock_sys, FSP *fsp, Buf_pool_manager *buf_pool) noexcept {
   auto ptr = ut_new(sizeof(Btree));
   return new (ptr) Btree(lock_sys, fsp, buf_pool);
 }
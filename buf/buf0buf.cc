@@ -41,6 +41,7 @@ Created 11/5/1995 Heikki Tuuri
 #include "log0log.h"
 #include "log0recv.h"
 #include "mem0mem.h"
+#include "os0aio.h"
 #include "os0proc.h"
 #include "srv0srv.h"
 #include "trx0undo.h"
@@ -218,7 +219,7 @@ constexpr ulint BUF_PAGE_READ_MAX_RETRIES = 100;
 /** Checksum function. */
 crc32::Checksum crc32::checksum = {};
 
-Buf_pool *srv_buf_pool = nullptr;
+Buf_pool_manager *srv_buf_pool = nullptr;
 
 /** A chunk of buffers.  The buffer pool is allocated in chunks. */
 struct buf_chunk_t {
@@ -235,28 +236,41 @@ struct buf_chunk_t {
   Buf_block *blocks{};
 };
 
-bool Buf_pool::peek_if_too_old(const Buf_page *bpage) {
-  if (unlikely(m_freed_page_clock == 0)) {
-    /* If eviction has not started yet, do not update the statistics or move blocks
-    in the LRU list.  This is either the warm-up phase or an in-memory workload. */
-    return false;
-  } else if (m_LRU->get_old_threshold_ms() > 0 && bpage->m_old) {
-    auto access_time = buf_page_is_accessed(bpage);
+bool Buf_pool::peek_if_too_old(Buf_page *bpage) {
+  return m_LRU->page_accessed(bpage);
+}
 
-    if (access_time > 0 && ((uint32_t)(ut_time_ms() - access_time)) >= m_LRU->get_old_threshold_ms()) {
-      return true;
-    }
+uint64_t Buf_pool::get_oldest_modification() const {
+  mutex_enter(&m_mutex);
 
-    m_stat.n_pages_not_made_young++;
+  /* The blocks that are not yet in the flush list may be the oldest
+  modifications if the flush list is empty. */
+  m_flusher->insert_pending_into_flush_list();
 
-    return false;
+  auto bpage = UT_LIST_GET_LAST(m_flush_list);
+
+  uint64_t lsn;
 
+  if (bpage == nullptr) {
+    lsn = 0;
   } else {
-    /* FIXME: bpage->m_freed_page_clock is 31 bits */
-    return (m_freed_page_clock & ((1UL << 31) - 1)) >
-           ((ulint)bpage->m_freed_page_clock +
-            (m_curr_size * (Buf_LRU::OLD_RATIO_DIV - m_LRU->get_old_ratio()) / (Buf_LRU::OLD_RATIO_DIV * 4)));
+    ut_ad(bpage->m_in_flush_list);
+    lsn = bpage->m_oldest_modification;
   }
+
+  mutex_exit(&m_mutex);
+
+  /* The returned answer may be out of date: the flush_list can
+  change after the mutex has been released. */
+
+  return lsn;
+}
+
+bool Buf_pool::peek_if_young(const Buf_page *bpage) const {
+  /* FIXME: bpage->m_freed_page_clock is 31 bits */
+  return (m_freed_page_clock & ((1UL << 31) - 1)) <=
+         ((ulint)bpage->m_freed_page_clock +
+          (m_curr_size * (Buf_LRU::OLD_RATIO_DIV - m_LRU->get_old_ratio()) / (Buf_LRU::OLD_RATIO_DIV * 4)));
 }
 
 Buf_block *Buf_pool::block_alloc() {
@@ -286,16 +300,12 @@ void Buf_pool::release(Buf_block *block, ulint rw_latch, mtr_t *mtr) {
   ut_a(block->get_state() == BUF_BLOCK_FILE_PAGE);
   ut_a(block->m_page.m_buf_fix_count > 0);
 
-  if (rw_latch == RW_X_LATCH && mtr->m_modifications) {
-    mutex_acquire();
+  mutex_enter(&block->m_mutex);
 
+  if (rw_latch == RW_X_LATCH && mtr->m_modifications) {
     m_flusher->note_modification(block, mtr);
-
-    mutex_release();
   }
 
-  mutex_enter(&block->m_mutex);
-
   IF_SYNC_DEBUG(rw_lock_s_unlock(&(block->m_debug_latch));)
 
   --block->m_page.m_buf_fix_count;
@@ -414,11 +424,58 @@ void buf_page_print(const byte *read_buf, ulint) {
   }
 }
 
+void Buf_page_run::add(Buf_page *bpage) noexcept {
+  ut_ad(bpage->get_state() == BUF_BLOCK_FILE_PAGE);
+
+  if (m_n_pages > 0) {
+    const auto last = m_bpages[m_n_pages - 1];
+
+    if (m_n_pages == m_bpages.size() || last->get_space() != bpage->get_space() ||
+        last->get_page_no() + 1 != bpage->get_page_no()) {
+      submit();
+    }
+  }
+
+  m_bpages[m_n_pages++] = bpage;
+}
+
+void Buf_page_run::submit() noexcept {
+  if (m_n_pages == 0) {
+    return;
+  }
+
+  const auto page_id = m_bpages[0]->get_page_id();
+
+  db_err err;
+
+  if (m_n_pages == 1) {
+    auto bpage = m_bpages[0];
+
+    err = srv_fil->data_io(m_io_request, true, page_id, 0, UNIV_PAGE_SIZE, buf_page_get_block(bpage)->m_frame, bpage, m_priority);
+
+  } else {
+    std::array<byte *, aio::MAX_IOVECS> frames;
+    std::array<void *, aio::MAX_IOVECS> msgs;
+
+    for (ulint i = 0; i < m_n_pages; ++i) {
+      frames[i] = buf_page_get_block(m_bpages[i])->m_frame;
+      msgs[i] = m_bpages[i];
+    }
+
+    err = srv_fil->data_io_vec(m_io_request, true, page_id, m_n_pages, frames.data(), msgs.data(), m_priority);
+  }
+
+  ut_a(err == DB_SUCCESS);
+
+  m_n_pages = 0;
+}
+
 void Buf_pool::block_init(Buf_block *block, byte *frame) {
   UNIV_MEM_DESC(frame, UNIV_PAGE_SIZE, block);
 
   block->m_frame = frame;
 
+  block->m_page.m_buf_pool_index = m_instance_no;
   block->m_page.m_state = BUF_BLOCK_NOT_USED;
   block->m_page.m_buf_fix_count = 0;
   block->m_page.m_io_fix = BUF_IO_NONE;
@@ -431,6 +488,10 @@ void Buf_pool::block_init(Buf_block *block, byte *frame) {
 
   ut_d(block->m_page.m_in_page_hash = false);
   ut_d(block->m_page.m_in_flush_list = false);
+
+  block->m_page.m_in_flush_pending = false;
+  block->m_page.m_in_dblwr_batch = false;
+  block->m_page.m_flush_pending_next = nullptr;
   ut_d(block->m_page.m_in_free_list = false);
   ut_d(block->m_page.m_in_LRU_list = false);
 
@@ -483,8 +544,12 @@ buf_chunk_t *Buf_pool::chunk_init(buf_chunk_t *chunk, ulint mem_size) {
     chunk->size = size;
   }
 
+  /* Keep the page frames out of core dumps, the block descriptors stay in. */
+  os_mem_exclude_from_core(frame, (byte *)chunk->mem + chunk->mem_size - frame);
+
   /* Init block structs and assign frames for them. Then we assign the frames
-  to the first blocks (we already mapped the memory above). */
+  to the first blocks (we already mapped the memory above). The blocks are
+  added to the free list by chunk_add_to_free_list(). */
 
   auto block = chunk->blocks;
 
@@ -492,10 +557,6 @@ buf_chunk_t *Buf_pool::chunk_init(buf_chunk_t *chunk, ulint mem_size) {
 
     block_init(block, frame);
 
-    /* Add the block to the free list */
-    UT_LIST_ADD_LAST(m_free_list, &block->m_page);
-    ut_d(block->m_page.m_in_free_list = true);
-
     ++block;
 
     frame += UNIV_PAGE_SIZE;
@@ -504,6 +565,137 @@ buf_chunk_t *Buf_pool::chunk_init(buf_chunk_t *chunk, ulint mem_size) {
   return chunk;
 }
 
+void Buf_pool::chunk_add_to_free_list(buf_chunk_t *chunk) {
+  ut_ad(mutex_own(&m_mutex));
+
+  auto block = chunk->blocks;
+
+  for (ulint i = chunk->size; i--; ++block) {
+    mutex_enter(&block->m_mutex);
+
+    /* The blocks of a chunk that was withdrawn earlier are in state BUF_BLOCK_MEMORY. */
+    if (block->get_state() != BUF_BLOCK_NOT_USED) {
+      buf_block_set_state(block, BUF_BLOCK_NOT_USED);
+    }
+
+    UT_LIST_ADD_LAST(m_free_list, &block->m_page);
+    ut_d(block->m_page.m_in_free_list = true);
+
+    mutex_exit(&block->m_mutex);
+  }
+}
+
+bool Buf_pool::will_be_withdrawn(const Buf_block *block) const {
+  ut_ad(mutex_own(&m_mutex));
+
+  const auto end = m_chunks + m_n_chunks.load(std::memory_order_relaxed);
+
+  for (auto chunk = m_chunks + m_n_chunks_new; chunk < end; ++chunk) {
+    if (block >= chunk->blocks && block < chunk->blocks + chunk->size) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool Buf_pool::withdraw_if_needed(Buf_block *block) {
+  ut_ad(mutex_own(&m_mutex));
+  ut_ad(mutex_own(&block->m_mutex));
+  ut_ad(block->get_state() == BUF_BLOCK_NOT_USED);
+  ut_ad(!block->m_page.m_in_free_list);
+
+  if (likely(!will_be_withdrawn(block))) {
+    return false;
+  }
+
+  buf_block_set_state(block, BUF_BLOCK_READY_FOR_USE);
+  buf_block_set_state(block, BUF_BLOCK_MEMORY);
+
+  UT_LIST_ADD_LAST(m_withdraw_list, &block->m_page);
+
+  return true;
+}
+
+bool Buf_pool::relocate(Buf_block *block, Buf_block *new_block) {
+  ut_ad(mutex_own(&m_mutex));
+  ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
+  ut_ad(new_block->get_state() == BUF_BLOCK_READY_FOR_USE);
+  ut_ad(!will_be_withdrawn(new_block));
+
+  const auto page_id = block->m_page.get_page_id();
+  auto hash_latch = m_page_hash->get_latch(page_id);
+
+  rw_lock_x_lock(hash_latch);
+
+  mutex_enter(&block->m_mutex);
+
+  if (!buf_page_can_relocate(&block->m_page)) {
+    mutex_exit(&block->m_mutex);
+    rw_lock_x_unlock(hash_latch);
+
+    return false;
+  }
+
+  /* Nobody else can reach the new block before it is in the page hash, but
+  a stale guess pointer may be checked under its mutex. */
+  mutex_enter(&new_block->m_mutex);
+
+  auto bpage = &block->m_page;
+  auto dpage = &new_block->m_page;
+
+  memcpy(new_block->m_frame, block->m_frame, UNIV_PAGE_SIZE);
+
+  dpage->m_space = bpage->m_space;
+  dpage->m_page_no = bpage->m_page_no;
+  dpage->m_flush_type = bpage->m_flush_type;
+  dpage->m_io_fix = BUF_IO_NONE;
+  dpage->m_buf_fix_count = 0;
+  dpage->m_old = bpage->m_old;
+  dpage->m_freed_page_clock = bpage->m_freed_page_clock;
+  dpage->m_read_ahead = bpage->m_read_ahead;
+  dpage->m_access_time = bpage->m_access_time;
+  dpage->m_referenced = bpage->m_referenced;
+  dpage->m_in_A1in = bpage->m_in_A1in;
+  dpage->m_newest_modification = bpage->m_newest_modification;
+  dpage->m_oldest_modification = bpage->m_oldest_modification;
+  ut_d(dpage->m_file_page_was_freed = bpage->m_file_page_was_freed);
+
+  new_block->m_check_index_page_at_flush = block->m_check_index_page_at_flush;
+  new_block->m_modify_clock = block->m_modify_clock;
+
+  buf_block_set_state(new_block, BUF_BLOCK_FILE_PAGE);
+
+  m_LRU->relocate(bpage, dpage);
+
+  if (bpage->m_oldest_modification > 0) {
+    ut_d(dpage->m_in_flush_list = true);
+    m_flusher->relocate_on_flush_list(bpage, dpage);
+  }
+
+  m_page_hash->replace(page_id, dpage);
+
+  ut_d(dpage->m_in_page_hash = true);
+  ut_d(bpage->m_in_page_hash = false);
+
+  rw_lock_x_unlock(hash_latch);
+
+  mutex_exit(&new_block->m_mutex);
+
+  /* Optimistic cursors that point to the old block must not use it. */
+  ++block->m_modify_clock;
+
+  bpage->m_oldest_modification = 0;
+
+  buf_block_set_state(block, BUF_BLOCK_NOT_USED);
+
+  ut_a(withdraw_if_needed(block));
+
+  mutex_exit(&block->m_mutex);
+
+  return true;
+}
+
 const Buf_block *Buf_pool::chunk_not_freed(buf_chunk_t *chunk) {
   ut_ad(mutex_own(&m_mutex));
 
@@ -535,9 +727,22 @@ const Buf_block *Buf_pool::chunk_not_freed(buf_chunk_t *chunk) {
   return nullptr;
 }
 
-Buf_pool::Buf_pool() : m_LRU(new(std::nothrow) Buf_LRU(this)), m_flusher(new(std::nothrow) Buf_flush(this)) {}
+Buf_page_hash::Buf_page_hash() {
+  for (auto &shard : m_shards) {
+    rw_lock_create(&shard.m_latch, SYNC_BUF_PAGE_HASH);
+  }
+}
+
+Buf_page_hash::~Buf_page_hash() noexcept {
+  for (auto &shard : m_shards) {
+    rw_lock_free(&shard.m_latch);
+  }
+}
+
+Buf_pool::Buf_pool(ulint instance_no)
+    : m_instance_no(instance_no), m_LRU(new(std::nothrow) Buf_LRU(this)), m_flusher(new(std::nothrow) Buf_flush(this)) {}
 
-bool Buf_pool::open(uint64_t pool_size) {
+bool Buf_pool::open(uint64_t pool_size, ulint chunk_size) {
 
   if (m_LRU == nullptr || m_flusher == nullptr) {
     return false;
@@ -549,30 +754,14 @@ bool Buf_pool::open(uint64_t pool_size) {
 
   mutex_acquire();
 
-  auto chunk = reinterpret_cast<buf_chunk_t *>(mem_alloc(sizeof(buf_chunk_t)));
-
-  m_n_chunks = 1;
-  m_chunks = chunk;
+  m_chunks = reinterpret_cast<buf_chunk_t *>(mem_zalloc(MAX_CHUNKS * sizeof(buf_chunk_t)));
 
   UT_LIST_INIT(m_LRU_list);
   UT_LIST_INIT(m_free_list);
   UT_LIST_INIT(m_flush_list);
+  UT_LIST_INIT(m_withdraw_list);
 
-  if (!chunk_init(chunk, pool_size)) {
-    mem_free(chunk);
-    mutex_release();
-    return false;
-  }
-
-  srv_config.m_buf_pool_old_size = pool_size;
-
-  m_curr_size = chunk->size;
-
-  srv_config.m_buf_pool_curr_size = m_curr_size * UNIV_PAGE_SIZE;
-
-  m_page_hash = new page_hash_t{};
-
-  m_last_printout_time = ut_time();
+  m_page_hash = new Buf_page_hash{};
 
   /* 2. Initialize flushing fields */
 
@@ -591,153 +780,406 @@ bool Buf_pool::open(uint64_t pool_size) {
 
   mutex_release();
 
-  /* 4. Initialize the buddy allocator fields */
-  /* All fields are initialized by mem_zalloc(). */
-
-  crc32::checksum = crc32::init();
+  const auto n_chunks = std::min<ulint>((pool_size + chunk_size - 1) / chunk_size, MAX_CHUNKS);
 
-  return true;
+  return add_chunks(std::max<ulint>(n_chunks, 1), chunk_size);
 }
 
-void Buf_pool::close() {
-  delete m_page_hash;
+bool Buf_pool::add_chunks(ulint n_chunks, ulint chunk_size) {
+  ut_a(n_chunks <= MAX_CHUNKS);
+  ut_ad(m_n_chunks_new == m_n_chunks);
 
-  for (ulint i = BUF_FLUSH_LRU; i < BUF_FLUSH_N_TYPES; i++) {
-    os_event_free(m_no_flush[i]);
-    m_no_flush[i] = nullptr;
-  }
-}
+  while (m_n_chunks < n_chunks) {
+    auto chunk = &m_chunks[m_n_chunks];
 
-Buf_pool::~Buf_pool() {
-  auto chunks = m_chunks;
-  auto chunk = chunks + m_n_chunks;
+    if (m_n_chunks == m_n_chunks_alloc) {
+      /* The blocks are initialized before the chunk is published, the
+      buffer pool mutex is not needed for that. */
+      if (chunk_init(chunk, chunk_size) == nullptr) {
 
-  while (--chunk >= chunks) {
-    /* Bypass the checks of buf_chunk_free(), since they fail at shutdown. */
-    os_mem_free_large(chunk->mem, chunk->mem_size);
+        return false;
+      }
+
+      m_n_chunks_alloc.fetch_add(1, std::memory_order_release);
+    }
+
+    /* Register the frames for fixed buffer i/o, a withdrawn chunk was
+    unregistered when its frames were released. */
+    srv_aio->register_buffer(chunk->blocks->m_frame, chunk->size * UNIV_PAGE_SIZE);
+
+    mutex_acquire();
+
+    chunk_add_to_free_list(chunk);
+
+    m_curr_size += chunk->size;
+    m_n_chunks.fetch_add(1, std::memory_order_release);
+    m_n_chunks_new = m_n_chunks;
+
+    mutex_release();
   }
 
-  m_n_chunks = 0;
+  m_page_hash->reserve(this, m_curr_size);
 
-  mem_free(m_chunks);
+  return true;
 }
 
-void Buf_pool::make_young(Buf_page *bpage) {
+void Buf_pool::withdraw_start(ulint n_chunks) {
   mutex_acquire();
 
-  ut_a(bpage->in_file());
+  ut_a(n_chunks > 0);
+  ut_a(n_chunks < m_n_chunks);
+  ut_a(m_n_chunks_new == m_n_chunks);
+  ut_a(UT_LIST_GET_LEN(m_withdraw_list) == 0);
 
-  m_LRU->make_block_young(bpage);
+  m_n_chunks_new = n_chunks;
+
+  /* The heuristics that are based on the size of the instance see the
+  new size from now on. */
+  m_curr_size = 0;
+
+  for (ulint i = 0; i < n_chunks; ++i) {
+    m_curr_size += m_chunks[i].size;
+  }
 
   mutex_release();
 }
 
-void Buf_pool::set_accessed_make_young(Buf_page *bpage, unsigned access_time) {
+bool Buf_pool::withdraw_blocks() {
   ut_ad(!mutex_own(&m_mutex));
-  ut_a(bpage->in_file());
-
-  if (peek_if_too_old(bpage)) {
-    mutex_acquire();
 
-    m_LRU->make_block_young(bpage);
+  mutex_acquire();
 
-    mutex_release();
-  } else if (access_time == 0) {
+  const auto end = m_chunks + m_n_chunks.load(std::memory_order_relaxed);
+  const auto start = m_chunks + m_n_chunks_new;
 
-    const ulint time_ms = ut_time_ms();
+  mutex_release();
 
-    mutex_acquire();
+  /* A free block to relocate a page to, when the free list was empty. */
+  Buf_block *spare{};
 
-    buf_page_set_accessed(bpage, time_ms);
+  /* true if a page could not be relocated because there were no free blocks. */
+  bool short_of_free_blocks{};
 
-    mutex_release();
-  }
-}
+  ulint n_blocks{};
 
-void Buf_pool::check_index_page_at_flush(const Page_id &page_id) {
-  mutex_acquire();
+  for (auto chunk = start; chunk < end; ++chunk) {
 
-  auto block = hash_get_block(page_id);
+    n_blocks += chunk->size;
 
-  if (block != nullptr && block->get_state() == BUF_BLOCK_FILE_PAGE) {
-    block->m_check_index_page_at_flush = false;
-  }
+    for (ulint i = 0; i < chunk->size; i += RESIZE_BATCH_SIZE) {
 
-  mutex_release();
-}
+      if (short_of_free_blocks && spare == nullptr) {
+        /* This evicts or flushes pages at the end of the LRU list if needed,
+        it must be called without the buffer pool mutex. */
+        spare = m_LRU->get_free_block();
+        short_of_free_blocks = false;
+      }
 
-Buf_block *Buf_pool::block_align(const byte *ptr) {
-  ulint i = m_n_chunks;
-  ;
+      mutex_acquire();
 
-  /* TODO: protect Buf_pool::m_chunks with a mutex (it will
-  currently remain constant after Buf_pool::open()) */
-  for (auto chunk = m_chunks; i--; ++chunk) {
-    lint offs = ptr - chunk->blocks->m_frame;
+      const auto batch_end = chunk->blocks + std::min(i + RESIZE_BATCH_SIZE, chunk->size);
 
-    if (unlikely(offs < 0)) {
+      for (auto block = chunk->blocks + i; block < batch_end; ++block) {
 
-      continue;
-    }
+        switch (block->get_state()) {
+          case BUF_BLOCK_NOT_USED:
+            /* The block is on the free list. */
+            ut_ad(block->m_page.m_in_free_list);
+            UT_LIST_REMOVE(m_free_list, &block->m_page);
+            ut_d(block->m_page.m_in_free_list = false);
 
-    offs >>= UNIV_PAGE_SIZE_SHIFT;
+            mutex_enter(&block->m_mutex);
+            ut_a(withdraw_if_needed(block));
+            mutex_exit(&block->m_mutex);
+            break;
 
-    if (likely((ulint)offs < chunk->size)) {
-      auto block = &chunk->blocks[offs];
+          case BUF_BLOCK_FILE_PAGE: {
+            auto new_block = spare != nullptr ? spare : m_LRU->get_free_only();
 
-      /* The function buf_chunk_init() invokes block_init() so that
-      block[n].frame == block->frame + n * UNIV_PAGE_SIZE.  Check it. */
-      ut_ad(block->m_frame == page_align(ptr));
+            if (new_block == nullptr) {
+              short_of_free_blocks = true;
 
-#ifdef UNIV_DEBUG
-      /* A thread that updates these fields must hold buf_pool_mutex and
-      block->mutex.  Acquire only the latter. */
-      mutex_enter(&block->m_mutex);
+              /* Evict the page if it is clean, a modified page is relocated in a later batch. */
+              mutex_enter(&block->m_mutex);
 
-      switch (block->get_state()) {
-        case BUF_BLOCK_NOT_USED:
-        case BUF_BLOCK_READY_FOR_USE:
-        case BUF_BLOCK_MEMORY:
-          /* Some data structures contain "guess" pointers to file pages.  The
-        file pages may have been freed and reused.  Do not complain. */
-          break;
-        case BUF_BLOCK_REMOVE_HASH:
-          /* Buf_pool::m_LRU->block_remove_hashed_page() will overwrite the FIL_PAGE_OFFSET and
-          FIL_PAGE_SPACE_ID with 0xff and set the state to BUF_BLOCK_REMOVE_HASH. */
-          ut_ad(page_get_space_id(page_align(ptr)) == 0xffffffff);
-          ut_ad(page_get_page_no(page_align(ptr)) == 0xffffffff);
-          break;
-        case BUF_BLOCK_FILE_PAGE:
-          ut_ad(block->get_space() == page_get_space_id(page_align(ptr)));
-          ut_ad(block->get_page_no() == page_get_page_no(page_align(ptr)));
-          break;
-      }
+              if (m_flusher->ready_for_replace(&block->m_page)) {
+                (void) m_LRU->free_block(&block->m_page, nullptr);
+              }
 
-      mutex_exit(&block->m_mutex);
-#endif /* UNIV_DEBUG */
+              mutex_exit(&block->m_mutex);
 
-      return block;
-    }
-  }
+            } else if (relocate(block, new_block)) {
 
-  /* The block should always be found. */
-  ut_error;
-  return nullptr;
-}
+              if (new_block == spare) {
+                spare = nullptr;
+              }
 
-bool Buf_pool::pointer_is_block_field(const void *ptr) {
-  auto chunk = m_chunks;
-  const auto chunk_end = chunk + m_n_chunks;
+            } else if (new_block != spare) {
+              /* The page is buffer-fixed or I/O-fixed, try again in the next pass. */
+              mutex_enter(&new_block->m_mutex);
+              m_LRU->block_free_non_file_page(new_block);
+              mutex_exit(&new_block->m_mutex);
+            }
+            break;
+          }
 
-  /* TODO: protect Buf_pool::m_chunks with a mutex (it will
-  currently remain constant after Buf_pool::open()) */
-  while (chunk < chunk_end) {
-    if (ptr >= (void *)chunk->blocks && ptr < (void *)(chunk->blocks + chunk->size)) {
+          case BUF_BLOCK_READY_FOR_USE:
+          case BUF_BLOCK_MEMORY:
+          case BUF_BLOCK_REMOVE_HASH:
+            /* The block has been collected already, or it is in use and will
+            be collected by withdraw_if_needed() when it is freed. */
+            break;
+        }
+      }
 
-      return true;
+      mutex_release();
     }
+  }
 
-    ++chunk;
+  if (spare != nullptr) {
+    block_free(spare);
+  }
+
+  mutex_acquire();
+
+  const auto n_withdrawn = UT_LIST_GET_LEN(m_withdraw_list);
+
+  mutex_release();
+
+  ut_a(n_withdrawn <= n_blocks);
+
+  return n_withdrawn == n_blocks;
+}
+
+void Buf_pool::withdraw_end() {
+  mutex_acquire();
+
+  const auto start = m_n_chunks_new;
+  const auto end = m_n_chunks.load(std::memory_order_relaxed);
+
+  /* The blocks stay in state BUF_BLOCK_MEMORY until the chunk is reused. */
+  UT_LIST_INIT(m_withdraw_list);
+
+  m_n_chunks.store(start, std::memory_order_release);
+
+  mutex_release();
+
+  for (auto chunk = m_chunks + start; chunk < m_chunks + end; ++chunk) {
+    /* The kernel keeps the registered pages pinned, unregister them first. */
+    srv_aio->unregister_buffer(chunk->blocks->m_frame, chunk->size * UNIV_PAGE_SIZE);
+
+    os_mem_release(chunk->blocks->m_frame, chunk->size * UNIV_PAGE_SIZE);
+  }
+}
+
+void Buf_pool::withdraw_cancel() {
+  mutex_acquire();
+
+  /* Stop collecting blocks, withdraw_if_needed() returns false from now on. */
+  m_n_chunks_new = m_n_chunks;
+
+  m_curr_size = 0;
+
+  for (ulint i = 0; i < m_n_chunks; ++i) {
+    m_curr_size += m_chunks[i].size;
+  }
+
+  while (UT_LIST_GET_LEN(m_withdraw_list) > 0) {
+
+    for (ulint i = 0; i < RESIZE_BATCH_SIZE; ++i) {
+      auto bpage = UT_LIST_GET_FIRST(m_withdraw_list);
+
+      if (bpage == nullptr) {
+        break;
+      }
+
+      auto block = bpage->get_block();
+
+      UT_LIST_REMOVE(m_withdraw_list, bpage);
+
+      mutex_enter(&block->m_mutex);
+
+      buf_block_set_state(block, BUF_BLOCK_NOT_USED);
+
+      UT_LIST_ADD_LAST(m_free_list, bpage);
+      ut_d(bpage->m_in_free_list = true);
+
+      mutex_exit(&block->m_mutex);
+    }
+
+    mutex_release();
+
+    mutex_acquire();
+  }
+
+  mutex_release();
+}
+
+void Buf_page_hash::reserve(Buf_pool *buf_pool, ulint n_pages) noexcept {
+  const auto n_per_shard = n_pages / N_SHARDS + 1;
+
+  for (auto &shard : m_shards) {
+    /* A lookup may hold only the buffer pool mutex. */
+    buf_pool->mutex_acquire();
+
+    rw_lock_x_lock(&shard.m_latch);
+
+    shard.m_pages.reserve(n_per_shard);
+
+    rw_lock_x_unlock(&shard.m_latch);
+
+    buf_pool->mutex_release();
+  }
+}
+
+void Buf_pool::close() {
+  const auto n_chunks = m_n_chunks.load(std::memory_order_acquire);
+
+  /* The frames are freed with the chunks, they must not stay registered
+  for fixed buffer i/o. The withdrawn chunks were unregistered already. */
+  for (auto chunk = m_chunks; chunk < m_chunks + n_chunks; ++chunk) {
+    srv_aio->unregister_buffer(chunk->blocks->m_frame, chunk->size * UNIV_PAGE_SIZE);
+  }
+
+  delete m_page_hash;
+
+  for (ulint i = BUF_FLUSH_LRU; i < BUF_FLUSH_N_TYPES; i++) {
+    os_event_free(m_no_flush[i]);
+    m_no_flush[i] = nullptr;
+  }
+}
+
+Buf_pool::~Buf_pool() {
+  auto chunks = m_chunks;
+  auto chunk = chunks + m_n_chunks_alloc;
+
+  while (--chunk >= chunks) {
+    /* Bypass the checks of buf_chunk_free(), since they fail at shutdown. */
+    os_mem_free_large(chunk->mem, chunk->mem_size);
+  }
+
+  m_n_chunks = 0;
+  m_n_chunks_alloc = 0;
+
+  mem_free(m_chunks);
+}
+
+void Buf_pool::make_young(Buf_page *bpage) {
+  mutex_acquire();
+
+  ut_a(bpage->in_file());
+
+  m_LRU->make_block_young(bpage);
+
+  mutex_release();
+}
+
+void Buf_pool::set_accessed_make_young(Buf_page *bpage, unsigned access_time) {
+  ut_ad(!mutex_own(&m_mutex));
+  ut_a(bpage->in_file());
+
+  if (peek_if_too_old(bpage)) {
+    mutex_acquire();
+
+    m_LRU->make_block_young(bpage);
+
+    read_ahead_page_accessed(bpage);
+
+    mutex_release();
+  } else if (access_time == 0) {
+
+    const ulint time_ms = ut_time_ms();
+
+    mutex_acquire();
+
+    buf_page_set_accessed(bpage, time_ms);
+
+    read_ahead_page_accessed(bpage);
+
+    mutex_release();
+  }
+}
+
+void Buf_pool::check_index_page_at_flush(const Page_id &page_id) {
+  mutex_acquire();
+
+  auto block = hash_get_block(page_id);
+
+  if (block != nullptr && block->get_state() == BUF_BLOCK_FILE_PAGE) {
+    block->m_check_index_page_at_flush = false;
+  }
+
+  mutex_release();
+}
+
+Buf_block *Buf_pool::block_align(const byte *ptr) {
+  /* The chunk array is never reallocated and the descriptors of withdrawn
+  chunks stay mapped, a stale count only makes us miss a new chunk. */
+  ulint i = m_n_chunks_alloc.load(std::memory_order_acquire);
+
+  for (auto chunk = m_chunks; i--; ++chunk) {
+    lint offs = ptr - chunk->blocks->m_frame;
+
+    if (unlikely(offs < 0)) {
+
+      continue;
+    }
+
+    offs >>= UNIV_PAGE_SIZE_SHIFT;
+
+    if (likely((ulint)offs < chunk->size)) {
+      auto block = &chunk->blocks[offs];
+
+      /* The function buf_chunk_init() invokes block_init() so that
+      block[n].frame == block->frame + n * UNIV_PAGE_SIZE.  Check it. */
+      ut_ad(block->m_frame == page_align(ptr));
+
+#ifdef UNIV_DEBUG
+      /* A thread that updates these fields must hold buf_pool_mutex and
+      block->mutex.  Acquire only the latter. */
+      mutex_enter(&block->m_mutex);
+
+      switch (block->get_state()) {
+        case BUF_BLOCK_NOT_USED:
+        case BUF_BLOCK_READY_FOR_USE:
+        case BUF_BLOCK_MEMORY:
+          /* Some data structures contain "guess" pointers to file pages.  The
+        file pages may have been freed and reused.  Do not complain. */
+          break;
+        case BUF_BLOCK_REMOVE_HASH:
+          /* Buf_pool::m_LRU->block_remove_hashed_page() will overwrite the FIL_PAGE_OFFSET and
+          FIL_PAGE_SPACE_ID with 0xff and set the state to BUF_BLOCK_REMOVE_HASH. */
+          ut_ad(page_get_space_id(page_align(ptr)) == 0xffffffff);
+          ut_ad(page_get_page_no(page_align(ptr)) == 0xffffffff);
+          break;
+        case BUF_BLOCK_FILE_PAGE:
+          ut_ad(block->get_space() == page_get_space_id(page_align(ptr)));
+          ut_ad(block->get_page_no() == page_get_page_no(page_align(ptr)));
+          break;
+      }
+
+      mutex_exit(&block->m_mutex);
+#endif /* UNIV_DEBUG */
+
+      return block;
+    }
+  }
+
+  /* The frame belongs to some other instance. */
+  return nullptr;
+}
+
+bool Buf_pool::pointer_is_block_field(const void *ptr) {
+  auto chunk = m_chunks;
+  const auto chunk_end = chunk + m_n_chunks_alloc.load(std::memory_order_acquire);
+
+  while (chunk < chunk_end) {
+    if (ptr >= (void *)chunk->blocks && ptr < (void *)(chunk->blocks + chunk->size)) {
+
+      return true;
+    }
+
+    ++chunk;
   }
 
   return false;
@@ -759,14 +1201,18 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
   mtr_memo_type_t fix_type;
 
   for (;;) {
-    mutex_acquire();
-
     block = guess;
 
     if (block != nullptr) {
+      /* The block mutex is enough to check the guess, the state and page id of
+      a file page can only change while it is held. */
+      mutex_enter(&block->m_mutex);
+
       if (page_id.m_page_no != block->m_page.m_page_no || page_id.m_space_id != block->m_page.m_space ||
           block->get_state() != BUF_BLOCK_FILE_PAGE) {
 
+        mutex_exit(&block->m_mutex);
+
         block = guess = nullptr;
 
       } else {
@@ -775,12 +1221,10 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
     }
 
     if (block == nullptr) {
-      block = hash_get_block(page_id);
+      block = hash_lookup_and_lock(page_id);
     }
 
     if (block == nullptr) {
-      mutex_release();
-
       if (req.m_mode == BUF_GET_IF_IN_POOL) {
         return nullptr;
       }
@@ -815,11 +1259,13 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
     }
   }
 
+  ut_ad(mutex_own(&block->m_mutex));
+
   auto must_read = buf_block_get_io_fix(block) == BUF_IO_READ;
 
   if (must_read && req.m_mode == BUF_GET_IF_IN_POOL) {
     /* The page is only being read to buffer */
-    mutex_release();
+    mutex_exit(&block->m_mutex);
 
     return nullptr;
   }
@@ -838,18 +1284,14 @@ Buf_block *Buf_pool::get(Request &req, Buf_block *guess) {
 
   ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
 
-  mutex_enter(&block->m_mutex);
-
   UNIV_MEM_ASSERT_RW(&block->m_page, sizeof(block->m_page));
 
   buf_block_buf_fix_inc(block, req.m_file, req.m_line);
 
-  mutex_exit(&block->m_mutex);
-
   /* Check if this is the first access to the page */
   auto access_time = buf_page_is_accessed(&block->m_page);
 
-  mutex_release();
+  mutex_exit(&block->m_mutex);
 
   set_accessed_make_young(&block->m_page, access_time);
 
@@ -1036,6 +1478,8 @@ bool Buf_pool::try_get_known_nowait(Request &req) {
 
     m_LRU->make_block_young(&req.m_guess->m_page);
 
+    read_ahead_page_accessed(&req.m_guess->m_page);
+
     mutex_release();
 
   } else if (!buf_page_is_accessed(&req.m_guess->m_page)) {
@@ -1050,6 +1494,8 @@ bool Buf_pool::try_get_known_nowait(Request &req) {
 
     buf_page_set_accessed(&req.m_guess->m_page, time_ms);
 
+    read_ahead_page_accessed(&req.m_guess->m_page);
+
     mutex_release();
   }
 
@@ -1097,21 +1543,13 @@ const Buf_block *Buf_pool::try_get_by_page_id(Request &req) {
 
   const auto &page_id{req.m_page_id};
 
-  mutex_acquire();
-
-  auto block = hash_get_block(page_id);
+  auto block = hash_lookup_and_lock(page_id);
 
   if (block == nullptr) {
 
-    mutex_release();
-
     return nullptr;
   }
 
-  mutex_enter(&block->m_mutex);
-
-  mutex_release();
-
   ut_ad(block->get_space() == page_id.m_space_id);
   ut_ad(block->get_page_no() == page_id.m_page_no);
   ut_ad(block->get_state() == BUF_BLOCK_FILE_PAGE);
@@ -1162,7 +1600,10 @@ void Buf_pool::page_init_low(Buf_page *bpage) {
   bpage->m_io_fix = BUF_IO_NONE;
   bpage->m_buf_fix_count = 0;
   bpage->m_freed_page_clock = 0;
+  bpage->m_read_ahead = false;
   bpage->m_access_time = 0;
+  bpage->m_referenced = false;
+  bpage->m_in_A1in = false;
   bpage->m_newest_modification = 0;
   bpage->m_oldest_modification = 0;
 
@@ -1216,11 +1657,15 @@ void Buf_pool::page_init(const Page_id &page_id, Buf_block *block) {
   ut_ad(!block->m_page.m_in_page_hash);
   ut_d(block->m_page.m_in_page_hash = true);
 
-  auto it = m_page_hash->emplace(page_id, &block->m_page);
-  ut_a(it.second);
+#ifdef UNIV_SYNC_DEBUG
+  ut_ad(rw_lock_own(m_page_hash->get_latch(page_id), RW_LOCK_EX));
+#endif /* UNIV_SYNC_DEBUG */
+
+  const auto inserted = m_page_hash->insert(page_id, &block->m_page);
+  ut_a(inserted);
 }
 
-Buf_page *Buf_pool::init_for_read(db_err *err, const Page_id &page_id, int64_t tablespace_version) {
+Buf_page *Buf_pool::init_for_read(db_err *err, const Page_id &page_id, int64_t tablespace_version, bool read_ahead) {
   Buf_page *bpage{};
   auto block = m_LRU->get_free_block();
 
@@ -1257,12 +1702,20 @@ Buf_page *Buf_pool::init_for_read(db_err *err, const Page_id &page_id, int64_t t
 
     bpage = &block->m_page;
 
+    auto hash_latch = m_page_hash->get_latch(page_id);
+
+    rw_lock_x_lock(hash_latch);
+
     mutex_enter(&block->m_mutex);
 
     page_init(page_id, block);
 
+    rw_lock_x_unlock(hash_latch);
+
     m_LRU->add_block(bpage, true /* to old blocks */);
 
+    bpage->m_read_ahead = read_ahead;
+
     rw_lock_x_lock_gen(&block->m_rw_lock, BUF_IO_READ);
 
     buf_page_set_io_fix(bpage, BUF_IO_READ);
@@ -1313,10 +1766,16 @@ Buf_block *Buf_pool::create(const Page_id &page_id, mtr_t *mtr) {
 
   block = free_block;
 
+  auto hash_latch = m_page_hash->get_latch(page_id);
+
+  rw_lock_x_lock(hash_latch);
+
   mutex_enter(&block->m_mutex);
 
   page_init(page_id, block);
 
+  rw_lock_x_unlock(hash_latch);
+
   /* The block must be put to the LRU list */
   m_LRU->add_block(&block->m_page, false);
 
@@ -1529,9 +1988,12 @@ bool Buf_pool::validate() {
   ulint n_lru = 0;
   ulint n_flush = 0;
   ulint n_free = 0;
+  ulint n_blocks = 0;
 
   mutex_acquire();
 
+  m_flusher->insert_pending_into_flush_list();
+
   auto chunk = m_chunks;
 
   /* Check the uncompressed blocks. */
@@ -1540,6 +2002,8 @@ bool Buf_pool::validate() {
     ulint j;
     Buf_block *block = chunk->blocks;
 
+    n_blocks += chunk->size;
+
     for (j = chunk->size; j--; block++) {
 
       mutex_enter(&block->m_mutex);
@@ -1599,8 +2063,12 @@ bool Buf_pool::validate() {
     }
   }
 
-  if (n_lru + n_free > m_curr_size) {
-    log_info(std::format("n LRU {}, n free {}, pool {}", n_lru, n_free, m_curr_size));
+  /* During a shrink m_curr_size is already the new size, but the blocks of
+  the chunks that are being withdrawn are still counted. */
+  if (n_lru + n_free + UT_LIST_GET_LEN(m_withdraw_list) > n_blocks) {
+    log_info(std::format(
+      "n LRU {}, n free {}, n withdrawn {}, pool {}", n_lru, n_free, UT_LIST_GET_LEN(m_withdraw_list), n_blocks
+    ));
     ut_error;
   }
 
@@ -1774,72 +2242,11 @@ ulint Buf_pool::get_n_pending_ios() {
   return m_n_pend_reads + m_n_flush[BUF_FLUSH_LRU] + m_n_flush[BUF_FLUSH_LIST] + m_n_flush[BUF_FLUSH_SINGLE_PAGE];
 }
 
-void Buf_pool::print_io(ib_stream_t ib_stream) {
-  time_t current_time = time(nullptr);
-  double time_elapsed = difftime(current_time, m_last_printout_time);
-
-  if (time_elapsed < 15) {
-    return;
-  }
-
-  mutex_acquire();
-
-  /* Calculate per-second averages */
-  double reads_per_sec = 0.0;
-  double writes_per_sec = 0.0;
-  double page_gets_per_sec = 0.0;
-  double pages_created_per_sec = 0.0;
-  double pages_made_young_per_sec = 0.0;
-  double pages_not_made_young_per_sec = 0.0;
-  double read_ahead_pages_per_sec = 0.0;
-  double read_ahead_pages_evicted_per_sec = 0.0;
-
-  if (time_elapsed > 0) {
-    reads_per_sec = (m_stat.n_pages_read - m_old_stat.n_pages_read) / time_elapsed;
-    writes_per_sec = (m_stat.n_pages_written - m_old_stat.n_pages_written) / time_elapsed;
-    page_gets_per_sec = (m_stat.n_page_gets - m_old_stat.n_page_gets) / time_elapsed;
-    pages_created_per_sec = (m_stat.n_pages_created - m_old_stat.n_pages_created) / time_elapsed;
-    pages_made_young_per_sec = (m_stat.n_pages_made_young - m_old_stat.n_pages_made_young) / time_elapsed;
-    pages_not_made_young_per_sec = (m_stat.n_pages_not_made_young - m_old_stat.n_pages_not_made_young) / time_elapsed;
-    read_ahead_pages_per_sec = (m_stat.n_ra_pages_read - m_old_stat.n_ra_pages_read) / time_elapsed;
-    read_ahead_pages_evicted_per_sec = (m_stat.n_ra_pages_evicted - m_old_stat.n_ra_pages_evicted) / time_elapsed;
-  }
-
-  log_info(std::format(
-    "Buffer pool I/O:\n"
-    "  Total reads: {}, writes: {}, page gets: {}, pages created: {}\n"
-    "  Reads/sec: {:.2f}, writes/sec: {:.2f}, page gets/sec: {:.2f}, pages created/sec: {:.2f}\n"
-    "  Pages made young: {}, not young: {}, read ahead: {}, evicted: {}\n"
-    "  Pages made young/sec: {:.2f}, not young/sec: {:.2f}, read ahead/sec: {:.2f}, evicted/sec: {:.2f}\n"
-    "  Pending reads: {}, pending writes: {}",
-    m_stat.n_pages_read,
-    m_stat.n_pages_written,
-    m_stat.n_page_gets,
-    m_stat.n_pages_created,
-    reads_per_sec,
-    writes_per_sec,
-    page_gets_per_sec,
-    pages_created_per_sec,
-    m_stat.n_pages_made_young,
-    m_stat.n_pages_not_made_young,
-    m_stat.n_ra_pages_read,
-    m_stat.n_ra_pages_evicted,
-    pages_made_young_per_sec,
-    pages_not_made_young_per_sec,
-    read_ahead_pages_per_sec,
-    read_ahead_pages_evicted_per_sec,
-    m_n_pend_reads,
-    m_n_flush[BUF_FLUSH_LRU] + m_n_flush[BUF_FLUSH_LIST] + m_n_flush[BUF_FLUSH_SINGLE_PAGE]
-  ));
-
-  m_last_printout_time = current_time;
-
-  mutex_release();
-}
-
 ulint Buf_pool::get_modified_ratio_pct() {
   mutex_acquire();
 
+  m_flusher->insert_pending_into_flush_list();
+
   const ulint n_modified = m_flush_list.size();
   const ulint n_pages = m_LRU_list.size() + m_free_list.size();
 
@@ -1860,11 +2267,12 @@ void Buf_pool::init() {
   mutex_create(&m_mutex, IF_DEBUG("buffer_pool", ) IF_SYNC_DEBUG(SYNC_BUF_POOL, ) Current_location());
 
   m_n_chunks = 0;
+  m_n_chunks_alloc = 0;
+  m_n_chunks_new = 0;
   m_chunks = nullptr;
   m_curr_size = 0;
   m_page_hash = nullptr;
   m_n_pend_reads = 0;
-  m_last_printout_time = time(nullptr);
 
   m_stat = buf_pool_stat_t{};
   m_old_stat = buf_pool_stat_t{};
@@ -1883,6 +2291,7 @@ void Buf_pool::init() {
 
   UT_LIST_INIT(m_LRU_list);
   UT_LIST_INIT(m_free_list);
+  UT_LIST_INIT(m_withdraw_list);
   m_LRU_old = nullptr;
   m_LRU_old_len = 0;
 }
@@ -1900,3 +2309,445 @@ Buf_page *Buf_pool::set_file_page_was_freed(const Page_id &page_id) {
 
   return bpage;
 }
+
+Buf_pool_manager::~Buf_pool_manager() noexcept {
+  for (auto buf_pool : m_instances) {
+    delete buf_pool;
+  }
+}
+
+bool Buf_pool_manager::open(uint64_t pool_size, ulint n_instances) {
+  ut_a(m_instances.empty());
+  ut_a(n_instances > 0 && n_instances <= MAX_INSTANCES);
+
+  const auto instance_size = pool_size / n_instances;
+
+  /* The instances are allocated in chunks of this size, so that they can
+  grow and shrink online. Each instance gets at least one chunk. */
+  m_chunk_size = std::min<ulint>(srv_config.m_buf_pool_chunk_size, instance_size);
+
+  for (ulint i = 0; i < n_instances; ++i) {
+    auto buf_pool = new (std::nothrow) Buf_pool(i);
+
+    if (buf_pool == nullptr) {
+      return false;
+    }
+
+    m_instances.push_back(buf_pool);
+
+    if (!buf_pool->open(instance_size, m_chunk_size)) {
+      return false;
+    }
+  }
+
+  srv_config.m_buf_pool_old_size = pool_size;
+  srv_config.m_buf_pool_curr_size = get_curr_size();
+
+  m_last_printout_time = ut_time();
+
+  crc32::checksum = crc32::init();
+
+  return true;
+}
+
+void Buf_pool_manager::close() {
+  for (auto buf_pool : m_instances) {
+    buf_pool->close();
+  }
+}
+
+Buf_block *Buf_pool_manager::block_alloc() {
+  const auto i = m_next_alloc.fetch_add(1, std::memory_order_relaxed);
+
+  return m_instances[i % m_instances.size()]->block_alloc();
+}
+
+Buf_block *Buf_pool_manager::block_align(const byte *ptr) {
+  for (auto buf_pool : m_instances) {
+    auto block = buf_pool->block_align(ptr);
+
+    if (block != nullptr) {
+      return block;
+    }
+  }
+
+  /* The block should always be found. */
+  ut_error;
+  return nullptr;
+}
+
+#ifdef UNIV_DEBUG
+ulint Buf_pool_manager::get_latched_pages_number() {
+  ulint n_latched{};
+
+  for (auto buf_pool : m_instances) {
+    n_latched += buf_pool->get_latched_pages_number();
+  }
+
+  return n_latched;
+}
+
+bool Buf_pool_manager::validate() {
+  for (auto buf_pool : m_instances) {
+    ut_a(buf_pool->validate());
+  }
+
+  return true;
+}
+#endif /* UNIV_DEBUG */
+
+uint64_t Buf_pool_manager::get_curr_size() const {
+  return get_curr_n_pages() * UNIV_PAGE_SIZE;
+}
+
+ulint Buf_pool_manager::get_curr_n_pages() const {
+  ulint n_pages{};
+
+  for (auto buf_pool : m_instances) {
+    n_pages += buf_pool->m_curr_size;
+  }
+
+  return n_pages;
+}
+
+lsn_t Buf_pool_manager::get_oldest_modification() const {
+  lsn_t oldest_lsn{};
+
+  for (auto buf_pool : m_instances) {
+    const auto lsn = buf_pool->get_oldest_modification();
+
+    if (lsn > 0 && (oldest_lsn == 0 || lsn < oldest_lsn)) {
+      oldest_lsn = lsn;
+    }
+  }
+
+  return oldest_lsn;
+}
+
+ulint Buf_pool_manager::get_n_pending_ios() const {
+  ulint n_pending{};
+
+  for (auto buf_pool : m_instances) {
+    n_pending += buf_pool->get_n_pending_ios();
+  }
+
+  return n_pending;
+}
+
+ulint Buf_pool_manager::get_n_pend_reads() const {
+  ulint n_pend_reads{};
+
+  for (auto buf_pool : m_instances) {
+    n_pend_reads += buf_pool->m_n_pend_reads;
+  }
+
+  return n_pend_reads;
+}
+
+bool Buf_pool_manager::is_io_pending() const {
+  for (auto buf_pool : m_instances) {
+    if (buf_pool->is_io_pending()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool Buf_pool_manager::all_freed() {
+  for (auto buf_pool : m_instances) {
+    if (!buf_pool->all_freed()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void Buf_pool_manager::invalidate() {
+  for (auto buf_pool : m_instances) {
+    buf_pool->invalidate();
+  }
+}
+
+ulint Buf_pool_manager::get_modified_ratio_pct() const {
+  ulint n_modified{};
+  ulint n_pages{};
+
+  for (auto buf_pool : m_instances) {
+    buf_pool->mutex_acquire();
+
+    buf_pool->m_flusher->insert_pending_into_flush_list();
+
+    n_modified += buf_pool->m_flush_list.size();
+    n_pages += buf_pool->m_LRU_list.size() + buf_pool->m_free_list.size();
+
+    buf_pool->mutex_release();
+  }
+
+  return n_pages == 0 ? 0 : (n_modified * 100) / n_pages;
+}
+
+bool Buf_pool_manager::running_out() {
+  for (auto buf_pool : m_instances) {
+    if (buf_pool->m_LRU->buf_pool_running_out()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+buf_pool_stat_t Buf_pool_manager::get_stat() const {
+  buf_pool_stat_t stat{};
+
+  for (auto buf_pool : m_instances) {
+    const auto &s = buf_pool->m_stat;
+
+    stat.n_page_gets += s.n_page_gets;
+    stat.n_pages_read += s.n_pages_read;
+    stat.n_pages_written += s.n_pages_written;
+    stat.n_pages_created += s.n_pages_created;
+    stat.n_ra_pages_read += s.n_ra_pages_read;
+    stat.n_ra_pages_evicted += s.n_ra_pages_evicted;
+    stat.n_ra_pages_used += s.n_ra_pages_used;
+    stat.n_pages_made_young += s.n_pages_made_young;
+    stat.n_pages_not_made_young += s.n_pages_not_made_young;
+  }
+
+  return stat;
+}
+
+ulint Buf_pool_manager::get_n_page_ios() const {
+  ulint n_ios{};
+
+  for (auto buf_pool : m_instances) {
+    n_ios += buf_pool->m_stat.n_pages_read + buf_pool->m_stat.n_pages_written;
+  }
+
+  return n_ios;
+}
+
+ulint Buf_pool_manager::get_write_requests() const {
+  ulint n_write_requests{};
+
+  for (auto buf_pool : m_instances) {
+    n_write_requests += buf_pool->m_write_requests.load(std::memory_order_relaxed);
+  }
+
+  return n_write_requests;
+}
+
+ulint Buf_pool_manager::get_LRU_len() const {
+  ulint len{};
+
+  for (auto buf_pool : m_instances) {
+    len += UT_LIST_GET_LEN(buf_pool->m_LRU_list);
+  }
+
+  return len;
+}
+
+ulint Buf_pool_manager::get_free_len() const {
+  ulint len{};
+
+  for (auto buf_pool : m_instances) {
+    len += UT_LIST_GET_LEN(buf_pool->m_free_list);
+  }
+
+  return len;
+}
+
+ulint Buf_pool_manager::get_flush_list_len() const {
+  ulint len{};
+
+  for (auto buf_pool : m_instances) {
+    buf_pool->mutex_acquire();
+
+    /* The blocks that are pending are modified too. */
+    buf_pool->m_flusher->insert_pending_into_flush_list();
+
+    len += UT_LIST_GET_LEN(buf_pool->m_flush_list);
+
+    buf_pool->mutex_release();
+  }
+
+  return len;
+}
+
+void Buf_pool_manager::print_io(ib_stream_t) {
+  time_t current_time = time(nullptr);
+  double time_elapsed = difftime(current_time, m_last_printout_time);
+
+  if (time_elapsed < 15) {
+    return;
+  }
+
+  buf_pool_stat_t stat{};
+  buf_pool_stat_t old_stat{};
+  ulint n_pend_reads{};
+  ulint n_pend_writes{};
+
+  for (auto buf_pool : m_instances) {
+    buf_pool->mutex_acquire();
+
+    const auto &s = buf_pool->m_stat;
+    const auto &o = buf_pool->m_old_stat;
+
+    stat.n_pages_read += s.n_pages_read;
+    stat.n_pages_written += s.n_pages_written;
+    stat.n_page_gets += s.n_page_gets;
+    stat.n_pages_created += s.n_pages_created;
+    stat.n_pages_made_young += s.n_pages_made_young;
+    stat.n_pages_not_made_young += s.n_pages_not_made_young;
+    stat.n_ra_pages_read += s.n_ra_pages_read;
+    stat.n_ra_pages_evicted += s.n_ra_pages_evicted;
+    stat.n_ra_pages_used += s.n_ra_pages_used;
+
+    old_stat.n_pages_read += o.n_pages_read;
+    old_stat.n_pages_written += o.n_pages_written;
+    old_stat.n_page_gets += o.n_page_gets;
+    old_stat.n_pages_created += o.n_pages_created;
+    old_stat.n_pages_made_young += o.n_pages_made_young;
+    old_stat.n_pages_not_made_young += o.n_pages_not_made_young;
+    old_stat.n_ra_pages_read += o.n_ra_pages_read;
+    old_stat.n_ra_pages_evicted += o.n_ra_pages_evicted;
+    old_stat.n_ra_pages_used += o.n_ra_pages_used;
+
+    n_pend_reads += buf_pool->m_n_pend_reads;
+    n_pend_writes +=
+      buf_pool->m_n_flush[BUF_FLUSH_LRU] + buf_pool->m_n_flush[BUF_FLUSH_LIST] + buf_pool->m_n_flush[BUF_FLUSH_SINGLE_PAGE];
+
+    buf_pool->mutex_release();
+  }
+
+  /* Calculate per-second averages */
+  double reads_per_sec = 0.0;
+  double writes_per_sec = 0.0;
+  double page_gets_per_sec = 0.0;
+  double pages_created_per_sec = 0.0;
+  double pages_made_young_per_sec = 0.0;
+  double pages_not_made_young_per_sec = 0.0;
+  double read_ahead_pages_per_sec = 0.0;
+  double read_ahead_pages_evicted_per_sec = 0.0;
+  double read_ahead_pages_used_per_sec = 0.0;
+
+  if (time_elapsed > 0) {
+    reads_per_sec = (stat.n_pages_read - old_stat.n_pages_read) / time_elapsed;
+    writes_per_sec = (stat.n_pages_written - old_stat.n_pages_written) / time_elapsed;
+    page_gets_per_sec = (stat.n_page_gets - old_stat.n_page_gets) / time_elapsed;
+    pages_created_per_sec = (stat.n_pages_created - old_stat.n_pages_created) / time_elapsed;
+    pages_made_young_per_sec = (stat.n_pages_made_young - old_stat.n_pages_made_young) / time_elapsed;
+    pages_not_made_young_per_sec = (stat.n_pages_not_made_young - old_stat.n_pages_not_made_young) / time_elapsed;
+    read_ahead_pages_per_sec = (stat.n_ra_pages_read - old_stat.n_ra_pages_read) / time_elapsed;
+    read_ahead_pages_evicted_per_sec = (stat.n_ra_pages_evicted - old_stat.n_ra_pages_evicted) / time_elapsed;
+    read_ahead_pages_used_per_sec = (stat.n_ra_pages_used - old_stat.n_ra_pages_used) / time_elapsed;
+  }
+
+  log_info(std::format(
+    "Buffer pool I/O ({} instances):\n"
+    "  Total reads: {}, writes: {}, page gets: {}, pages created: {}\n"
+    "  Reads/sec: {:.2f}, writes/sec: {:.2f}, page gets/sec: {:.2f}, pages created/sec: {:.2f}\n"
+    "  Pages made young: {}, not young: {}, read ahead: {}, used: {}, evicted: {}\n"
+    "  Pages made young/sec: {:.2f}, not young/sec: {:.2f}, read ahead/sec: {:.2f}, used/sec: {:.2f}, evicted/sec: {:.2f}\n"
+    "  Pending reads: {}, pending writes: {}",
+    m_instances.size(),
+    stat.n_pages_read,
+    stat.n_pages_written,
+    stat.n_page_gets,
+    stat.n_pages_created,
+    reads_per_sec,
+    writes_per_sec,
+    page_gets_per_sec,
+    pages_created_per_sec,
+    stat.n_pages_made_young,
+    stat.n_pages_not_made_young,
+    stat.n_ra_pages_read,
+    stat.n_ra_pages_used,
+    stat.n_ra_pages_evicted,
+    pages_made_young_per_sec,
+    pages_not_made_young_per_sec,
+    read_ahead_pages_per_sec,
+    read_ahead_pages_used_per_sec,
+    read_ahead_pages_evicted_per_sec,
+    n_pend_reads,
+    n_pend_writes
+  ));
+
+  m_last_printout_time = current_time;
+}
+
+void Buf_pool_manager::refresh_io_stats() {
+  for (auto buf_pool : m_instances) {
+    buf_pool->refresh_io_stats();
+  }
+
+  m_last_printout_time = time(nullptr);
+}
+
+ulint Buf_pool_manager::old_ratio_update(ulint old_pct, bool adjust) {
+  ulint new_pct{};
+
+  for (auto buf_pool : m_instances) {
+    new_pct = buf_pool->m_LRU->old_ratio_update(old_pct, adjust);
+  }
+
+  return new_pct;
+}
+
+void Buf_pool_manager::stat_update() {
+  for (auto buf_pool : m_instances) {
+    buf_pool->m_LRU->stat_update();
+    buf_pool->m_flusher->stat_update();
+  }
+}
+
+ulint Buf_pool_manager::get_desired_flush_rate() {
+  ulint n_flush{};
+
+  for (auto buf_pool : m_instances) {
+    n_flush += buf_pool->m_flusher->get_desired_flush_rate();
+  }
+
+  return n_flush;
+}
+
+ulint Buf_pool_manager::flush_list(DBLWR *dblwr, ulint min_n, lsn_t lsn_limit) {
+  ulint page_count{};
+  bool skipped{};
+
+  /* Spread the work evenly over the instances. */
+  if (min_n != ULINT_MAX) {
+    min_n = (min_n + m_instances.size() - 1) / m_instances.size();
+  }
+
+  for (auto buf_pool : m_instances) {
+    const auto n_flushed = buf_pool->m_flusher->batch(dblwr, BUF_FLUSH_LIST, min_n, lsn_limit);
+
+    if (n_flushed == ULINT_UNDEFINED) {
+      skipped = true;
+    } else {
+      page_count += n_flushed;
+    }
+  }
+
+  return skipped ? ULINT_UNDEFINED : page_count;
+}
+
+void Buf_pool_manager::wait_batch_end(buf_flush type) {
+  for (auto buf_pool : m_instances) {
+    buf_pool->m_flusher->wait_batch_end(type);
+  }
+}
+
+void Buf_pool_manager::free_margin(DBLWR *dblwr) {
+  for (auto buf_pool : m_instances) {
+    buf_pool->m_flusher->free_margin(dblwr);
+  }
+}
+
+void Buf_pool_manager::free_flush_list() {
+  for (auto buf_pool : m_instances) {
+    buf_pool->m_flusher->free_flush_list();
+  }
+}
@@ -0,0 +1,287 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file buf/buf0cleaner.cc
+Background flushing of the buffer pool.
+*******************************************************/
+
+#include "buf0cleaner.h"
+
+#include "buf0buf.h"
+#include "buf0flu.h"
+#include "log0log.h"
+#include "os0thread.h"
+#include "srv0srv.h"
+
+#include <chrono>
+
+Page_cleaner *srv_page_cleaner{};
+
+Page_cleaner::Page_cleaner(Buf_pool_manager *buf_pool, DBLWR *dblwr, ulint n_threads) noexcept
+    : m_buf_pool(buf_pool), m_dblwr(dblwr), m_n_threads(n_threads) {
+  ut_a(m_n_threads > 0 && m_n_threads <= MAX_THREADS);
+}
+
+Page_cleaner::~Page_cleaner() noexcept {
+  ut_a(!is_active());
+}
+
+Page_cleaner *Page_cleaner::create(Buf_pool_manager *buf_pool, DBLWR *dblwr, ulint n_threads) noexcept {
+  auto ptr = ut_new(sizeof(Page_cleaner));
+
+  return ptr != nullptr ? new (ptr) Page_cleaner(buf_pool, dblwr, n_threads) : nullptr;
+}
+
+void Page_cleaner::destroy(Page_cleaner *&page_cleaner) noexcept {
+  call_destructor(page_cleaner);
+  ut_delete(page_cleaner);
+  page_cleaner = nullptr;
+}
+
+void Page_cleaner::start() noexcept {
+  ut_a(!is_active());
+
+  m_last_activity_count = srv_activity_count;
+
+  m_n_threads_active.store(m_n_threads, std::memory_order_relaxed);
+
+  os_thread_create(&Page_cleaner::coordinator_thread, this, nullptr);
+
+  for (ulint i = 1; i < m_n_threads; ++i) {
+    os_thread_create(&Page_cleaner::worker_thread, this, nullptr);
+  }
+
+  log_info(std::format("Started {} page cleaner threads", m_n_threads));
+}
+
+void Page_cleaner::shutdown() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_shutdown = true;
+  }
+
+  m_wakeup_cv.notify_all();
+  m_round_cv.notify_all();
+
+  while (is_active()) {
+    os_thread_sleep(10000);
+  }
+}
+
+void Page_cleaner::wakeup() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_wakeup_requested) {
+      return;
+    }
+
+    m_wakeup_requested = true;
+  }
+
+  m_wakeup_cv.notify_one();
+}
+
+ulint Page_cleaner::get_n_pages_to_flush(lsn_t &lsn_limit, bool &sync) noexcept {
+  const ulint io_capacity = PCT_IO(100);
+  const auto lsn = log_sys->get_lsn();
+  const auto oldest_lsn = m_buf_pool->get_oldest_modification();
+  const auto age = oldest_lsn == 0 ? 0 : lsn - oldest_lsn;
+  const auto max_age_async = log_sys->m_max_modified_age_async;
+  const auto max_age_sync = log_sys->m_max_modified_age_sync;
+
+  ulint n_pages{};
+
+  sync = false;
+  lsn_limit = IB_UINT64_T_MAX;
+
+  if (age > max_age_sync) {
+    /* Same target as Log::checkpoint_margin() uses when the user threads have to
+    wait, flush everything up to it and start the next round without sleeping. */
+    sync = true;
+    n_pages = ULINT_MAX;
+    lsn_limit = oldest_lsn + 2 * (age - max_age_sync);
+
+  } else if (age > max_age_async) {
+    /* Ramp up from the IO capacity at the async limit to twice that at the sync limit. */
+    const auto range = std::max<lsn_t>(max_age_sync - max_age_async, 1);
+
+    n_pages = io_capacity + ulint(io_capacity * (age - max_age_async) / range);
+    lsn_limit = oldest_lsn + (age - max_age_async);
+  }
+
+  if (m_buf_pool->get_modified_ratio_pct() > srv_config.m_max_buf_pool_modified_pct) {
+
+    /* Try to keep the number of modified pages in the buffer pool under the limit wished by the user */
+    n_pages = std::max<ulint>(n_pages, io_capacity);
+
+  } else if (srv_config.m_adaptive_flushing) {
+
+    /* Try to keep the rate of flushing of dirty pages such that redo log generation
+    does not produce bursts of IO at checkpoint time. */
+    n_pages = std::max<ulint>(n_pages, std::min<ulint>(m_buf_pool->get_desired_flush_rate(), io_capacity));
+  }
+
+  const auto activity_count = srv_activity_count;
+
+  if (activity_count == m_last_activity_count) {
+    /* The server is idle, use the spare IO capacity. */
+    n_pages = std::max<ulint>(n_pages, io_capacity);
+  }
+
+  m_last_activity_count = activity_count;
+
+  return n_pages;
+}
+
+void Page_cleaner::flush_instances() noexcept {
+  const auto n_instances = m_buf_pool->get_n_instances();
+
+  for (;;) {
+    const auto i = m_next_instance.fetch_add(1, std::memory_order_relaxed);
+
+    if (i >= n_instances) {
+      break;
+    }
+
+    auto flusher = m_buf_pool->get_instance(i)->m_flusher.get();
+
+    if (m_request.m_n_pages > 0) {
+      const auto n_flushed = flusher->batch(m_dblwr, BUF_FLUSH_LIST, m_request.m_n_pages, m_request.m_lsn_limit);
+
+      if (n_flushed != ULINT_UNDEFINED) {
+        m_n_flushed_list.fetch_add(n_flushed, std::memory_order_relaxed);
+      }
+    }
+
+    /* Keep enough replaceable blocks at the end of the LRU list so that
+    the user threads do not have to flush. */
+    const auto n_flushed = flusher->LRU_flush(m_dblwr);
+
+    if (n_flushed != ULINT_UNDEFINED) {
+      m_n_flushed_LRU.fetch_add(n_flushed, std::memory_order_relaxed);
+    }
+  }
+}
+
+void Page_cleaner::run_round(ulint n_pages, lsn_t lsn_limit) noexcept {
+  const auto n_instances = m_buf_pool->get_n_instances();
+
+  /* Spread the work evenly over the instances. */
+  if (n_pages != ULINT_MAX) {
+    n_pages = (n_pages + n_instances - 1) / n_instances;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_request.m_n_pages = n_pages;
+    m_request.m_lsn_limit = lsn_limit;
+    m_next_instance.store(0, std::memory_order_relaxed);
+    m_n_pending = m_n_threads;
+    ++m_round;
+  }
+
+  m_round_cv.notify_all();
+
+  /* The coordinator does its share of the work too. */
+  flush_instances();
+
+  std::unique_lock<std::mutex> lock(m_mutex);
+
+  --m_n_pending;
+
+  m_done_cv.wait(lock, [this] { return m_n_pending == 0; });
+}
+
+void *Page_cleaner::coordinator_thread(void *arg) noexcept {
+  auto cleaner = static_cast<Page_cleaner *>(arg);
+  bool sync{};
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(cleaner->m_mutex);
+
+      if (!sync) {
+        cleaner->m_wakeup_cv.wait_for(lock, std::chrono::seconds(1), [cleaner] {
+          return cleaner->m_shutdown || cleaner->m_wakeup_requested;
+        });
+      }
+
+      cleaner->m_wakeup_requested = false;
+
+      if (cleaner->m_shutdown) {
+        break;
+      }
+    }
+
+    lsn_t lsn_limit;
+    const auto n_pages = cleaner->get_n_pages_to_flush(lsn_limit, sync);
+
+    cleaner->run_round(n_pages, lsn_limit);
+  }
+
+  cleaner->m_n_threads_active.fetch_sub(1, std::memory_order_relaxed);
+
+  /* We count the number of threads in os_thread_exit(). A created
+  thread should always use that to exit and not use return() to exit. */
+
+  os_thread_exit();
+
+  return nullptr;
+}
+
+void *Page_cleaner::worker_thread(void *arg) noexcept {
+  auto cleaner = static_cast<Page_cleaner *>(arg);
+  uint64_t round{};
+
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(cleaner->m_mutex);
+
+      cleaner->m_round_cv.wait(lock, [cleaner, round] { return cleaner->m_shutdown || cleaner->m_round != round; });
+
+      /* Finish a round that was started before the shutdown request. */
+      if (cleaner->m_round == round) {
+        ut_ad(cleaner->m_shutdown);
+        break;
+      }
+
+      round = cleaner->m_round;
+    }
+
+    cleaner->flush_instances();
+
+    {
+      std::lock_guard<std::mutex> lock(cleaner->m_mutex);
+
+      if (--cleaner->m_n_pending == 0) {
+        cleaner->m_done_cv.notify_one();
+      }
+    }
+  }
+
+  cleaner->m_n_threads_active.fetch_sub(1, std::memory_order_relaxed);
+
+  /* We count the number of threads in os_thread_exit(). A created
+  thread should always use that to exit and not use return() to exit. */
+
+  os_thread_exit();
+
+  return nullptr;
+}
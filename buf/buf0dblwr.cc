@@ -22,23 +22,35 @@ Doublewrite buffer
 Created 2024-09-25 by Sunny Bains. */
 
 #include "buf0dblwr.h"
+#include "os0file.h"
+#include "srv0srv.h"
 #include "trx0sys.h"
 
+#include <filesystem>
+
 /** The doublewrite buffer instance */
 DBLWR *srv_dblwr{};
 
-DBLWR::DBLWR(FSP *fsp) : m_fsp(fsp), m_block1(ULINT32_UNDEFINED), m_block2(ULINT32_UNDEFINED) {
+DBLWR::Batch::Batch(space_id_t space_id, page_no_t page_no) noexcept : m_space_id(space_id), m_page_no(page_no) {
 
-  mutex_create(&m_mutex, IF_DEBUG("DBLWR::m_mutex", ) IF_SYNC_DEBUG(SYNC_DOUBLEWRITE, ) Current_location());
+  mutex_create(&m_mutex, IF_DEBUG("DBLWR::Batch::m_mutex", ) IF_SYNC_DEBUG(SYNC_DOUBLEWRITE, ) Current_location());
 
-  m_ptr = static_cast<byte *>(ut_new((1 + 2 * SYS_DOUBLEWRITE_BLOCK_SIZE) * UNIV_PAGE_SIZE));
+  m_ptr = static_cast<byte *>(ut_new((1 + BATCH_SIZE) * UNIV_PAGE_SIZE));
 
   m_write_buf = static_cast<byte *>(ut_align(m_ptr, UNIV_PAGE_SIZE));
 
-  m_bpages.resize(2 * SYS_DOUBLEWRITE_BLOCK_SIZE);
+  m_bpages.resize(BATCH_SIZE);
+
+  m_write_done = os_event_create(nullptr);
+  m_pending_done = os_event_create(nullptr);
+  m_synced = os_event_create(nullptr);
 }
 
-DBLWR::~DBLWR() {
+DBLWR::Batch::~Batch() noexcept {
+  os_event_free(m_synced);
+  os_event_free(m_pending_done);
+  os_event_free(m_write_done);
+
   if (m_ptr != nullptr) {
     ut_delete(m_ptr);
   }
@@ -46,6 +58,15 @@ DBLWR::~DBLWR() {
   mutex_free(&m_mutex);
 }
 
+DBLWR::DBLWR(FSP *fsp) : m_fsp(fsp), m_block1(ULINT32_UNDEFINED), m_block2(ULINT32_UNDEFINED) {}
+
+DBLWR::~DBLWR() {
+  for (auto batch : m_batches) {
+    call_destructor(batch);
+    ut_delete(batch);
+  }
+}
+
 bool DBLWR::is_page_inside(page_no_t page_no) const noexcept {
   if (page_no >= m_block1 && page_no < m_block1 + SYS_DOUBLEWRITE_BLOCK_SIZE) {
     return true;
@@ -204,19 +225,178 @@ bool DBLWR::check_if_exists(Fil *fil, std::pair<page_no_t, page_no_t> &offsets)
   return exists;
 }
 
+db_err DBLWR::open(ulint n_batches, ulint n_files) noexcept {
+  ut_a(m_batches.empty());
+  ut_a(n_batches > 0);
+  ut_a(n_files > 0 && n_files <= MAX_FILES);
+
+  /* There is no point in having files without batches. */
+  n_files = std::min(n_files, n_batches);
+
+  const auto file_size = ((n_batches + n_files - 1) / n_files) * BATCH_SIZE * UNIV_PAGE_SIZE;
+
+  /* Without the doublewrite the files are not written, none is created or
+  extended. The existing ones are still opened, they may hold pages written
+  before a crash of a run that used them. */
+  const auto n_used = srv_config.m_use_doublewrite_buf ? n_files : 0;
+
+  for (ulint i{}; i < MAX_FILES; ++i) {
+    const auto path = std::filesystem::path(srv_config.m_data_home) / std::format("{}{}", DBLWR_FILE_PREFIX, i);
+    const auto space_id = space_id_t(SRV_DBLWR_SPACE_FIRST_ID + i);
+
+    bool success;
+    auto fh = os_file_create_simple_no_error_handling(path.c_str(), OS_FILE_OPEN, OS_FILE_READ_WRITE, &success);
+
+    if (!success) {
+      if (i >= n_used) {
+        continue;
+      }
+
+      fh = os_file_create_simple_no_error_handling(path.c_str(), OS_FILE_CREATE, OS_FILE_READ_WRITE, &success);
+
+      if (!success) {
+        log_err(std::format("Cannot create the doublewrite file {}", path.string()));
+        return DB_ERROR;
+      }
+
+      log_info(std::format("Creating doublewrite file {} of {} MB", path.string(), file_size / (1024 * 1024)));
+    }
+
+    off_t size;
+
+    success = os_file_get_size(fh, &size);
+    ut_a(success);
+
+    /* A file from a run with fewer buffer pool instances is extended, the
+    pages that are already in it are kept for recovery. */
+    if (i < n_used && size < off_t(file_size)) {
+      success = os_file_set_size(path.c_str(), fh, file_size);
+      size = file_size;
+    }
+
+    os_file_close(fh);
+
+    if (!success) {
+      log_err(std::format("Cannot extend the doublewrite file {}: probably out of disk space", path.string()));
+      return DB_ERROR;
+    }
+
+    if (size < off_t(UNIV_PAGE_SIZE)) {
+      continue;
+    }
+
+    if (!m_fsp->m_fil->space_create(path.c_str(), space_id, 0, FIL_DBLWR)) {
+      return DB_ERROR;
+    }
+
+    m_fsp->m_fil->node_create(path.c_str(), ulint(size / UNIV_PAGE_SIZE), space_id, false);
+
+    m_space_ids.push_back(space_id);
+  }
+
+  if (n_used == 0) {
+    return DB_SUCCESS;
+  }
+
+  m_batches.reserve(n_batches);
+
+  for (ulint i{}; i < n_batches; ++i) {
+    auto ptr = ut_new(sizeof(Batch));
+
+    if (ptr == nullptr) {
+      return DB_OUT_OF_MEMORY;
+    }
+
+    const auto space_id = space_id_t(SRV_DBLWR_SPACE_FIRST_ID + i % n_files);
+    const auto page_no = page_no_t((i / n_files) * BATCH_SIZE);
+
+    m_batches.push_back(new (ptr) Batch(space_id, page_no));
+  }
+
+  return DB_SUCCESS;
+}
+
+void DBLWR::write_batch(Batch *batch) noexcept {
+  ut_ad(mutex_own(&batch->m_mutex));
+  ut_a(batch->m_first_free > 0);
+  ut_a(batch->m_first_free <= BATCH_SIZE);
+
+  const auto sig_count = os_event_reset(batch->m_write_done);
+
+  auto err = m_fsp->m_fil->data_io(
+    IO_request::Async_write,
+    false,
+    Page_id(batch->m_space_id, batch->m_page_no),
+    0,
+    batch->m_first_free * UNIV_PAGE_SIZE,
+    batch->m_write_buf,
+    batch
+  );
+  ut_a(err == DB_SUCCESS);
+
+  os_event_wait_low(batch->m_write_done, sig_count);
+
+  /* Now flush the doublewrite file data to disk */
+  m_fsp->m_fil->flush(batch->m_space_id);
+}
+
+void DBLWR::io_complete(Batch *batch) noexcept {
+  os_event_set(batch->m_write_done);
+}
+
+void DBLWR::data_write_complete(Batch *batch) noexcept {
+  ut_a(batch->m_n_pending > 0);
+
+  if (batch->m_n_pending.fetch_sub(1) == 1) {
+    os_event_set(batch->m_pending_done);
+  }
+}
+
+void DBLWR::wait_for_data_writes(Batch *batch) noexcept {
+  for (;;) {
+    const auto sig_count = os_event_reset(batch->m_pending_done);
+
+    if (batch->m_n_pending == 0) {
+      break;
+    }
+
+    os_event_wait_low(batch->m_pending_done, sig_count);
+  }
+}
+
+/** The copy of a page in the doublewrite buffer that is used in recovery. */
+struct Dblwr_copy {
+  /** The copy of the page. */
+  const byte *m_page{};
+
+  /** The page LSN of the copy. */
+  lsn_t m_lsn{};
+
+  /** true if the copy is corrupt. */
+  bool m_is_corrupt{};
+};
+
 void DBLWR::recover_pages() noexcept {
   ut_a(m_block1 != ULINT32_UNDEFINED);
   ut_a(m_block2 != ULINT32_UNDEFINED);
 
-  auto ptr = static_cast<byte *>(ut_new(2 * UNIV_PAGE_SIZE));
+  auto fil = m_fsp->m_fil;
+  auto buf_pool = m_fsp->m_buf_pool;
+
+  ulint n_pages{BATCH_SIZE};
+
+  for (auto space_id : m_space_ids) {
+    n_pages += fil->space_get_size(space_id);
+  }
+
+  /* One page for the alignment and one for reading in the data file pages. */
+  auto ptr = static_cast<byte *>(ut_new((n_pages + 2) * UNIV_PAGE_SIZE));
   auto read_buf = static_cast<byte *>(ut_align(ptr, UNIV_PAGE_SIZE));
 
   /* Read the trx sys header to check if we are using the doublewrite buffer.
    * Note: We bypass the buffer pool here.*/
 
-  m_fsp->m_fil->data_io(
-    IO_request::Sync_read, false, Page_id(SYS_TABLESPACE, TRX_SYS_PAGE_NO), 0, UNIV_PAGE_SIZE, read_buf, nullptr
-  );
+  fil->data_io(IO_request::Sync_read, false, Page_id(SYS_TABLESPACE, TRX_SYS_PAGE_NO), 0, UNIV_PAGE_SIZE, read_buf, nullptr);
 
   {
     const auto dblwr = read_buf + SYS_DOUBLEWRITE;
@@ -225,15 +405,16 @@ void DBLWR::recover_pages() noexcept {
     ut_a(mach_read_from_4(dblwr + SYS_DOUBLEWRITE_MAGIC) == SYS_DOUBLEWRITE_MAGIC_N);
   }
 
-  auto buf = m_write_buf;
+  const auto buf = read_buf + UNIV_PAGE_SIZE;
 
-  /* Read the pages from both the doublewrite buffers into memory */
+  /* Read the pages from both the doublewrite blocks in the system tablespace,
+  they were written by older versions, and from the doublewrite files. */
 
-  m_fsp->m_fil->data_io(
+  fil->data_io(
     IO_request::Sync_read, false, Page_id(SYS_TABLESPACE, m_block1), 0, SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE, buf, nullptr
   );
 
-  m_fsp->m_fil->data_io(
+  fil->data_io(
     IO_request::Sync_read,
     false,
     Page_id(SYS_TABLESPACE, m_block2),
@@ -243,36 +424,72 @@ void DBLWR::recover_pages() noexcept {
     nullptr
   );
 
+  auto ptr_end = buf + BATCH_SIZE * UNIV_PAGE_SIZE;
+
+  for (auto space_id : m_space_ids) {
+    const auto size = fil->space_get_size(space_id);
+
+    for (page_no_t page_no{}; page_no < size; page_no += BATCH_SIZE) {
+      const auto len = std::min<ulint>(BATCH_SIZE, size - page_no) * UNIV_PAGE_SIZE;
+
+      fil->data_io(IO_request::Sync_read, false, Page_id(space_id, page_no), 0, len, ptr_end, nullptr);
+
+      ptr_end += len;
+    }
+  }
+
+  /* A page can have a copy in more than one batch, the most recent one,
+  that is the one with the highest LSN, is used. A copy can be corrupt if
+  the server crashed while the batch was written, the pages of the batch
+  were then not written to the data files. */
+
+  Page_id_hash<Dblwr_copy> copies;
+
+  for (auto page = buf; page < ptr_end; page += UNIV_PAGE_SIZE) {
+    const auto lsn = mach_read_from_8(page + FIL_PAGE_LSN);
+    const Page_id page_id(mach_read_from_4(page + FIL_PAGE_SPACE_ID), mach_read_from_4(page + FIL_PAGE_OFFSET));
+
+    if (lsn == 0 || page_id.space_id() >= SRV_LOG_SPACE_FIRST_ID) {
+      /* Never written to, or garbage */
+      continue;
+    }
+
+    const auto is_corrupt = buf_pool->is_corrupted(page);
+    auto &copy = copies[page_id];
+
+    if (copy.m_page == nullptr || (copy.m_is_corrupt && !is_corrupt) || (!is_corrupt && lsn > copy.m_lsn)) {
+      copy = Dblwr_copy{.m_page = page, .m_lsn = lsn, .m_is_corrupt = is_corrupt};
+    }
+  }
+
   /* Check if any of these pages is half-written in data files, in the intended
    * position */
 
-  auto page = buf;
-
-  for (ulint i{}; i < SYS_DOUBLEWRITE_BLOCK_SIZE * 2; ++i) {
-    const auto page_no = mach_read_from_4(page + FIL_PAGE_OFFSET);
-    const auto space_id = mach_read_from_4(page + FIL_PAGE_SPACE_ID);
+  for (const auto &[page_id, copy] : copies) {
+    const auto page = copy.m_page;
+    const auto space_id = page_id.space_id();
+    const auto page_no = page_id.page_no();
 
-    if (!m_fsp->m_fil->tablespace_exists_in_mem(space_id)) {
+    if (!fil->tablespace_exists_in_mem(space_id)) {
       /* Maybe we have dropped the single-table tablespace
       and this page once belonged to it: do nothing */
-    } else if (!m_fsp->m_fil->check_adress_in_tablespace(space_id, page_no)) {
+    } else if (!fil->check_adress_in_tablespace(space_id, page_no)) {
       log_warn(std::format(
         "A page in the doublewrite buffer is not within space bounds; space id {}"
-        " page number {}, page {} in doublewrite buf.",
+        " page number {}.",
         space_id,
-        page_no,
-        i
+        page_no
       ));
 
     } else if (space_id == SYS_TABLESPACE && is_page_inside(page_no)) {
       /* It is an unwritten doublewrite buffer page: do nothing */
     } else {
       /* Read in the actual page from the file */
-      m_fsp->m_fil->data_io(IO_request::Sync_read, false, Page_id(space_id, page_no), 0, UNIV_PAGE_SIZE, read_buf, nullptr);
+      fil->data_io(IO_request::Sync_read, false, page_id, 0, UNIV_PAGE_SIZE, read_buf, nullptr);
 
       /* Check if the page is corrupt */
 
-      if (unlikely(m_fsp->m_buf_pool->is_corrupted(read_buf))) {
+      if (unlikely(buf_pool->is_corrupted(read_buf))) {
 
         log_warn(std::format(
           "Database page corruption or a failed file read of space {} page {}."
@@ -281,7 +498,7 @@ void DBLWR::recover_pages() noexcept {
           page_no
         ));
 
-        if (m_fsp->m_buf_pool->is_corrupted(page)) {
+        if (copy.m_is_corrupt) {
           log_info("Dump of the page:");
           buf_page_print(read_buf, 0);
           log_warn("Dump of corresponding page in doublewrite buffer:");
@@ -297,16 +514,14 @@ void DBLWR::recover_pages() noexcept {
         /* Write the good page from the doublewrite buffer to the intended
          * position */
 
-        m_fsp->m_fil->data_io(IO_request::Sync_write, false, Page_id(space_id, page_no), 0, UNIV_PAGE_SIZE, page, nullptr);
+        fil->data_io(IO_request::Sync_write, false, page_id, 0, UNIV_PAGE_SIZE, const_cast<byte *>(page), nullptr);
 
         log_info("Recovered the page from the doublewrite buffer.");
       }
     }
-
-    page += UNIV_PAGE_SIZE;
   }
 
-  m_fsp->m_fil->flush_file_spaces(FIL_TABLESPACE);
+  fil->flush_file_spaces(FIL_TABLESPACE);
 
   ut_delete(ptr);
 }
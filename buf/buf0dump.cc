@@ -0,0 +1,348 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file buf/buf0dump.cc
+Dump the page ids of the buffer pool to a file and load them back.
+*******************************************************/
+
+#include "buf0dump.h"
+
+#include "buf0buf.h"
+#include "buf0rea.h"
+#include "mach0data.h"
+#include "os0file.h"
+#include "os0thread.h"
+#include "srv0srv.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <filesystem>
+#include <vector>
+
+/** Identifies a dump file, "IBPD" */
+constexpr uint32_t BUF_DUMP_MAGIC = 0x49425044;
+
+/** Size of the file header: the magic number and the number of entries. */
+constexpr ulint BUF_DUMP_HEADER_SIZE = 8;
+
+/** Size of an entry: the space id and the page number. */
+constexpr ulint BUF_DUMP_ENTRY_SIZE = 8;
+
+/** Maximum number of pages the load thread reads in one batch. */
+constexpr ulint BUF_LOAD_BATCH_SIZE = 64;
+
+/** The load thread waits while there are more than this many pending reads. */
+constexpr ulint BUF_LOAD_MAX_PENDING_READS = 4 * BUF_LOAD_BATCH_SIZE;
+
+/** true while the load thread is running. */
+static std::atomic<bool> buf_load_active{};
+
+/** Set to tell the load thread to stop. */
+static std::atomic<bool> buf_load_abort_requested{};
+
+/** @return the path of the dump file. */
+static std::filesystem::path buf_dump_get_path() {
+  return std::filesystem::path(srv_config.m_data_home) / BUF_DUMP_FILENAME;
+}
+
+db_err buf_dump(Buf_pool_manager *buf_pool) {
+  const auto n_instances = buf_pool->get_n_instances();
+  std::vector<std::vector<Page_id>> instance_page_ids(n_instances);
+
+  /* Collect the page ids of each instance, most recently used first. */
+  for (ulint i = 0; i < n_instances; ++i) {
+    auto instance = buf_pool->get_instance(i);
+    auto &page_ids = instance_page_ids[i];
+
+    instance->mutex_acquire();
+
+    page_ids.reserve(UT_LIST_GET_LEN(instance->m_LRU_list));
+
+    for (auto bpage = UT_LIST_GET_FIRST(instance->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
+
+      if (bpage->get_state() == BUF_BLOCK_FILE_PAGE) {
+        page_ids.push_back(bpage->get_page_id());
+      }
+    }
+
+    instance->mutex_release();
+  }
+
+  /* Interleave the instances so that the file stays ordered by recency,
+  the loader drops the entries at the end if the buffer pool is smaller. */
+
+  ulint n_pages{};
+
+  for (const auto &page_ids : instance_page_ids) {
+    n_pages += page_ids.size();
+  }
+
+  std::vector<byte> buf(BUF_DUMP_HEADER_SIZE + n_pages * BUF_DUMP_ENTRY_SIZE);
+
+  mach_write_to_4(&buf[0], BUF_DUMP_MAGIC);
+  mach_write_to_4(&buf[4], n_pages);
+
+  auto ptr = &buf[BUF_DUMP_HEADER_SIZE];
+
+  for (ulint pos{}, n_written{}; n_written < n_pages; ++pos) {
+    for (const auto &page_ids : instance_page_ids) {
+      if (pos < page_ids.size()) {
+        mach_write_to_4(ptr, page_ids[pos].space_id());
+        mach_write_to_4(ptr + 4, page_ids[pos].page_no());
+
+        ptr += BUF_DUMP_ENTRY_SIZE;
+        ++n_written;
+      }
+    }
+  }
+
+  const auto path = buf_dump_get_path();
+  const auto tmp_path = std::filesystem::path(path).concat(".incomplete");
+
+  os_file_delete_if_exists(tmp_path.c_str());
+
+  bool success;
+  auto file = os_file_create_simple_no_error_handling(tmp_path.c_str(), OS_FILE_CREATE, OS_FILE_READ_WRITE, &success);
+
+  if (!success) {
+    log_err(std::format("Cannot create the buffer pool dump file {}", tmp_path.string()));
+    return DB_ERROR;
+  }
+
+  success = os_file_write(tmp_path.c_str(), file, buf.data(), buf.size(), 0) && os_file_flush(file);
+
+  os_file_close(file);
+
+  if (!success || !os_file_rename(tmp_path.c_str(), path.c_str())) {
+    log_err(std::format("Cannot write the buffer pool dump file {}", path.string()));
+
+    os_file_delete_if_exists(tmp_path.c_str());
+
+    return DB_ERROR;
+  }
+
+  log_info(std::format("Dumped {} buffer pool page ids to {}", n_pages, path.string()));
+
+  return DB_SUCCESS;
+}
+
+/**
+ * Reads the page ids from the dump file.
+ *
+ * @param[in] max_pages         Maximum number of entries to read.
+ * @param[out] page_ids         The page ids read from the file.
+ *
+ * @return DB_SUCCESS, DB_NOT_FOUND if there is no dump file or an error code.
+ */
+static db_err buf_load_read_file(ulint max_pages, std::vector<Page_id> &page_ids) {
+  const auto path = buf_dump_get_path();
+
+  bool success;
+  auto file = os_file_create_simple_no_error_handling(path.c_str(), OS_FILE_OPEN, OS_FILE_READ_ONLY, &success);
+
+  if (!success) {
+    return DB_NOT_FOUND;
+  }
+
+  off_t file_size;
+  byte header[BUF_DUMP_HEADER_SIZE];
+
+  if (!os_file_get_size(file, &file_size) || ulint(file_size) < BUF_DUMP_HEADER_SIZE ||
+      !os_file_read_no_error_handling(file, header, sizeof(header), 0) || mach_read_from_4(header) != BUF_DUMP_MAGIC) {
+
+    os_file_close(file);
+
+    log_warn(std::format("Ignoring the buffer pool dump file {}, it is not valid", path.string()));
+
+    return DB_CORRUPTION;
+  }
+
+  const auto n_stored = std::min<ulint>(mach_read_from_4(header + 4), (ulint(file_size) - BUF_DUMP_HEADER_SIZE) / BUF_DUMP_ENTRY_SIZE);
+  const auto n_pages = std::min<ulint>(n_stored, max_pages);
+
+  std::vector<byte> buf(n_pages * BUF_DUMP_ENTRY_SIZE);
+
+  success = buf.empty() || os_file_read_no_error_handling(file, buf.data(), buf.size(), BUF_DUMP_HEADER_SIZE);
+
+  os_file_close(file);
+
+  if (!success) {
+    log_warn(std::format("Cannot read the buffer pool dump file {}", path.string()));
+
+    return DB_ERROR;
+  }
+
+  page_ids.reserve(n_pages);
+
+  for (ulint i = 0; i < n_pages; ++i) {
+    const auto ptr = &buf[i * BUF_DUMP_ENTRY_SIZE];
+
+    page_ids.emplace_back(space_id_t(mach_read_from_4(ptr)), page_no_t(mach_read_from_4(ptr + 4)));
+  }
+
+  return DB_SUCCESS;
+}
+
+/**
+ * Waits until it is time to issue the next batch of reads. Keeps the number of
+ * pending reads bounded and, if the user threads had to read pages since the
+ * last call, limits the load to the IO capacity.
+ *
+ * @param[in] buf_pool          The buffer pool that is being loaded.
+ * @param[in] n_pages           Number of pages read in the last batch.
+ * @param[in,out] last_n_reads  Value of srv_buf_pool_reads at the last call.
+ * @param[in,out] start_ms      Start of the current one second interval.
+ * @param[in,out] n_loaded      Pages read in the current one second interval.
+ *
+ * @return false if the load should stop.
+ */
+static bool buf_load_throttle(Buf_pool_manager *buf_pool, ulint n_pages, ulint &last_n_reads, ulint &start_ms, ulint &n_loaded) {
+  n_loaded += n_pages;
+
+  while (buf_pool->get_n_pend_reads() > BUF_LOAD_MAX_PENDING_READS) {
+    if (buf_load_abort_requested.load(std::memory_order_relaxed)) {
+      return false;
+    }
+
+    os_thread_sleep(10000);
+  }
+
+  const auto n_reads = srv_buf_pool_reads;
+  const auto foreground_reads = n_reads != last_n_reads;
+
+  last_n_reads = n_reads;
+
+  const auto elapsed_ms = ut_time_ms() - start_ms;
+
+  if (elapsed_ms >= 1000) {
+    start_ms = ut_time_ms();
+    n_loaded = 0;
+  } else if (foreground_reads && n_loaded >= PCT_IO(100)) {
+    /* The user threads are reading too, do not use more than the IO
+    capacity for the load, sleep until the end of the interval. */
+    os_thread_sleep((1000 - elapsed_ms) * 1000);
+
+    start_ms = ut_time_ms();
+    n_loaded = 0;
+  }
+
+  return !buf_load_abort_requested.load(std::memory_order_relaxed);
+}
+
+/**
+ * Reads in the pages listed in the dump file.
+ *
+ * @param[in] buf_pool          The buffer pool to load the pages into.
+ */
+static void buf_load(Buf_pool_manager *buf_pool) {
+  std::vector<Page_id> page_ids;
+
+  /* The entries at the end of the file are the least recently used,
+  drop the ones that would not fit. */
+  auto err = buf_load_read_file(buf_pool->get_curr_n_pages(), page_ids);
+
+  if (err != DB_SUCCESS) {
+    return;
+  }
+
+  const auto start_time = ut_time_ms();
+
+  /* Sort by space and page number so that the reads of a tablespace are
+  issued in file order. */
+  std::sort(page_ids.begin(), page_ids.end(), [](const Page_id &lhs, const Page_id &rhs) {
+    return lhs.space_id() < rhs.space_id() || (lhs.space_id() == rhs.space_id() && lhs.page_no() < rhs.page_no());
+  });
+
+  ulint n_read{};
+  ulint n_loaded{};
+  ulint start_ms = ut_time_ms();
+  ulint last_n_reads = srv_buf_pool_reads;
+  std::array<page_no_t, BUF_LOAD_BATCH_SIZE> page_nos;
+
+  for (ulint i = 0; i < page_ids.size();) {
+    if (buf_pool->get_free_len() == 0) {
+      /* Loading more pages would evict pages that the user threads read in. */
+      break;
+    }
+
+    const auto space_id = page_ids[i].space_id();
+
+    ulint n_pages{};
+
+    while (i < page_ids.size() && n_pages < page_nos.size() && page_ids[i].space_id() == space_id) {
+      page_nos[n_pages++] = page_ids[i++].page_no();
+    }
+
+    const auto n_issued = buf_read_load_pages(space_id, page_nos.data(), n_pages);
+
+    n_read += n_issued;
+
+    if (!buf_load_throttle(buf_pool, n_issued, last_n_reads, start_ms, n_loaded)) {
+      break;
+    }
+  }
+
+  log_info(std::format(
+    "Buffer pool load {}: read {} of {} pages in {} ms",
+    buf_load_abort_requested.load(std::memory_order_relaxed) ? "aborted" : "completed",
+    n_read,
+    page_ids.size(),
+    ut_time_ms() - start_time
+  ));
+}
+
+/**
+ * The load thread.
+ *
+ * @param[in] arg               The buffer pool to load the pages into.
+ *
+ * @return nullptr.
+ */
+static void *buf_load_thread(void *arg) {
+  buf_load(static_cast<Buf_pool_manager *>(arg));
+
+  buf_load_active.store(false, std::memory_order_release);
+
+  /* We count the number of threads in os_thread_exit(). A created
+  thread should always use that to exit and not use return() to exit. */
+
+  os_thread_exit();
+
+  return nullptr;
+}
+
+void buf_load_start(Buf_pool_manager *buf_pool) {
+  ut_a(!buf_load_is_active());
+
+  buf_load_abort_requested.store(false, std::memory_order_relaxed);
+  buf_load_active.store(true, std::memory_order_release);
+
+  os_thread_create(buf_load_thread, buf_pool, nullptr);
+}
+
+void buf_load_abort() {
+  buf_load_abort_requested.store(true, std::memory_order_relaxed);
+
+  while (buf_load_is_active()) {
+    os_thread_sleep(10000);
+  }
+}
+
+bool buf_load_is_active() {
+  return buf_load_active.load(std::memory_order_acquire);
+}
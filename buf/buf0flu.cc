@@ -25,6 +25,7 @@ Created 11/11/1995 Heikki Tuuri
 #include "buf0flu.h"
 #include <algorithm>
 #include "buf0buf.h"
+#include "buf0cleaner.h"
 #include "buf0dblwr.h"
 #include "buf0lru.h"
 #include "buf0rea.h"
@@ -111,14 +112,14 @@ void Buf_flush::free_flush_list() {
 
 void Buf_flush::insert_into_flush_list(Buf_block *block) {
   ut_ad(m_buf_pool->mutex_is_owned());
-  ut_ad(
-    (UT_LIST_GET_FIRST(m_buf_pool->m_flush_list) == nullptr) ||
-    (UT_LIST_GET_FIRST(m_buf_pool->m_flush_list)->m_oldest_modification <= block->m_page.m_oldest_modification)
-  );
 
   /* If we are in the recovery then we need to update the flush
-  red-black tree as well. */
-  if (m_buf_pool->m_recovery_flush_list != nullptr) {
+  red-black tree as well. The mini-transactions also commit concurrently,
+  a block can be older than the newest one in the list, but only by the
+  lsn ranges that were not closed yet. */
+  if (m_buf_pool->m_recovery_flush_list != nullptr ||
+      (UT_LIST_GET_FIRST(m_buf_pool->m_flush_list) != nullptr &&
+       UT_LIST_GET_FIRST(m_buf_pool->m_flush_list)->m_oldest_modification > block->m_page.m_oldest_modification)) {
     insert_sorted_into_flush_list(block);
     return;
   }
@@ -177,6 +178,37 @@ void Buf_flush::insert_sorted_into_flush_list(Buf_block *block) {
 #endif /* UNIV_DEBUG || UNIV_BUF_DEBUG */
 }
 
+void Buf_flush::insert_pending_into_flush_list() {
+  ut_ad(m_buf_pool->mutex_is_owned());
+
+  auto bpage = m_buf_pool->m_flush_pending.exchange(nullptr, std::memory_order_acquire);
+
+  if (bpage == nullptr) {
+    return;
+  }
+
+  /* The stack is newest first, reverse it so that the oldest modification
+  is inserted first. */
+  Buf_page *prev{};
+
+  while (bpage != nullptr) {
+    auto next = bpage->m_flush_pending_next;
+
+    bpage->m_flush_pending_next = prev;
+    prev = bpage;
+    bpage = next;
+  }
+
+  for (bpage = prev; bpage != nullptr; bpage = bpage->m_flush_pending_next) {
+    ut_ad(bpage->m_in_flush_pending);
+    ut_ad(bpage->m_oldest_modification != 0);
+
+    bpage->m_in_flush_pending = false;
+
+    insert_into_flush_list(reinterpret_cast<Buf_block *>(bpage));
+  }
+}
+
 bool Buf_flush::ready_for_replace(Buf_page *bpage) {
   ut_ad(m_buf_pool->mutex_is_owned());
   ut_ad(mutex_own(buf_page_get_mutex(bpage)));
@@ -199,6 +231,10 @@ bool Buf_flush::ready_for_flush(Buf_page *bpage, buf_flush flush_type) {
   ut_ad(mutex_own(buf_page_get_mutex(bpage)));
   ut_ad(flush_type == to_int(BUF_FLUSH_LRU) || flush_type == BUF_FLUSH_LIST);
 
+  if (unlikely(bpage->m_in_flush_pending)) {
+    insert_pending_into_flush_list();
+  }
+
   if (bpage->m_oldest_modification != 0 && buf_page_get_io_fix(bpage) == BUF_IO_NONE) {
     ut_ad(bpage->m_in_flush_list);
 
@@ -222,6 +258,11 @@ bool Buf_flush::ready_for_flush(Buf_page *bpage, buf_flush flush_type) {
 void Buf_flush::remove(Buf_page *bpage) {
   ut_ad(m_buf_pool->mutex_is_owned());
   ut_ad(mutex_own(buf_page_get_mutex(bpage)));
+
+  if (unlikely(bpage->m_in_flush_pending)) {
+    insert_pending_into_flush_list();
+  }
+
   ut_ad(bpage->m_in_flush_list);
 
   switch (bpage->get_state()) {
@@ -259,6 +300,10 @@ void Buf_flush::relocate_on_flush_list(Buf_page *bpage, Buf_page *dpage) {
   ut_ad(m_buf_pool->mutex_is_owned());
   ut_ad(mutex_own(buf_page_get_mutex(bpage)));
 
+  if (unlikely(bpage->m_in_flush_pending)) {
+    insert_pending_into_flush_list();
+  }
+
   ut_ad(bpage->m_in_flush_list);
   ut_ad(dpage->m_in_flush_list);
 
@@ -295,6 +340,12 @@ void Buf_flush::relocate_on_flush_list(Buf_page *bpage, Buf_page *dpage) {
 void Buf_flush::write_complete(Buf_page *bpage) {
   remove(bpage);
 
+  if (bpage->m_in_dblwr_batch) {
+    bpage->m_in_dblwr_batch = false;
+
+    srv_dblwr->data_write_complete(srv_dblwr->get_batch(m_buf_pool->m_instance_no));
+  }
+
   auto flush_type = buf_page_get_flush_type(bpage);
 
   m_buf_pool->m_n_flush[flush_type]--;
@@ -320,6 +371,9 @@ void Buf_flush::write_complete(Buf_page *bpage) {
 }
 
 void Buf_flush::sync_datafiles() {
+  /* Submit the writes that we posted in batch mode */
+  srv_aio->submit_batch();
+
   /* Wait until all pending async writes are completed */
   srv_aio->wait_for_pending_ops(aio::WRITE);
 
@@ -330,32 +384,38 @@ void Buf_flush::sync_datafiles() {
 }
 
 void Buf_flush::buffered_writes(DBLWR *dblwr) {
-  ulint len;
-  ulint len2;
-  byte *write_buf;
-
   if (!srv_config.m_use_doublewrite_buf || dblwr == nullptr) {
     /* Sync the writes to the disk. */
     sync_datafiles();
     return;
   }
 
-  mutex_enter(&dblwr->m_mutex);
+  auto batch = dblwr->get_batch(m_buf_pool->m_instance_no);
+
+  mutex_enter(&batch->m_mutex);
+
+  /* The region of the batch in the doublewrite file protects the data file
+  writes of the previous batch until they are synced. */
+  while (batch->m_is_syncing) {
+    const auto sig_count = os_event_reset(batch->m_synced);
 
-  /* Write first to doublewrite buffer blocks. We use synchronous
-  aio and thus know that file write has been completed when the
-  control returns. */
+    mutex_exit(&batch->m_mutex);
 
-  if (dblwr->m_first_free == 0) {
+    os_event_wait_low(batch->m_synced, sig_count);
+
+    mutex_enter(&batch->m_mutex);
+  }
 
-    mutex_exit(&dblwr->m_mutex);
+  if (batch->m_first_free == 0) {
+
+    mutex_exit(&batch->m_mutex);
 
     return;
   }
 
-  for (ulint i{}; i < dblwr->m_first_free; ++i) {
+  for (ulint i{}; i < batch->m_first_free; ++i) {
 
-    auto block = reinterpret_cast<const Buf_block *>(dblwr->m_bpages[i]);
+    auto block = reinterpret_cast<const Buf_block *>(batch->m_bpages[i]);
 
     if (block->get_state() != BUF_BLOCK_FILE_PAGE) {
       /* No simple validate for compressed pages exists. */
@@ -383,66 +443,53 @@ void Buf_flush::buffered_writes(DBLWR *dblwr) {
   }
 
   /* Increment the doublewrite flushed pages counter */
-  srv_dblwr_pages_written += dblwr->m_first_free;
+  srv_dblwr_pages_written += batch->m_first_free;
   ++srv_dblwr_writes;
 
-  len = std::min<ulint>(SYS_DOUBLEWRITE_BLOCK_SIZE, dblwr->m_first_free) * UNIV_PAGE_SIZE;
-
-  write_buf = dblwr->m_write_buf;
+  batch->m_is_syncing = true;
 
-  ulint i{};
+  /* Write the batch to its region of the doublewrite file, the write is
+  complete and flushed to disk when the control returns. */
+  dblwr->write_batch(batch);
 
-  srv_fil->data_io(IO_request::Sync_write, false, Page_id(TRX_SYS_SPACE, dblwr->m_block1), 0, len, write_buf, nullptr);
+  const auto write_buf = batch->m_write_buf;
 
-  for (len2 = 0; len2 + UNIV_PAGE_SIZE <= len; len2 += UNIV_PAGE_SIZE, i++) {
-    const Buf_block *block = reinterpret_cast<Buf_block *>(dblwr->m_bpages[i]);
+  for (ulint i{}; i < batch->m_first_free; ++i) {
+    const auto block = reinterpret_cast<const Buf_block *>(batch->m_bpages[i]);
+    const auto page = write_buf + i * UNIV_PAGE_SIZE;
 
     if (likely(block->get_state() == BUF_BLOCK_FILE_PAGE) &&
-        unlikely(memcmp(write_buf + len2 + (FIL_PAGE_LSN + 4), write_buf + len2 + (UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM + 4), 4)
-        )) {
+        unlikely(memcmp(page + (FIL_PAGE_LSN + 4), page + (UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM + 4), 4))) {
 
       log_err(
         "The page to be written seems corrupt! The lsn fields do not match!"
-        " Noticed in the doublewrite block1."
+        " Noticed in the doublewrite batch."
       );
     }
   }
 
-  if (dblwr->m_first_free <= SYS_DOUBLEWRITE_BLOCK_SIZE) {
-    goto flush;
-  }
-
-  len = (dblwr->m_first_free - SYS_DOUBLEWRITE_BLOCK_SIZE) * UNIV_PAGE_SIZE;
-
-  write_buf = dblwr->m_write_buf + SYS_DOUBLEWRITE_BLOCK_SIZE * UNIV_PAGE_SIZE;
-  ut_ad(i == SYS_DOUBLEWRITE_BLOCK_SIZE);
-
-  srv_fil->data_io(IO_request::Sync_write, false, Page_id(TRX_SYS_SPACE, dblwr->m_block2), 0, len, (void *)write_buf, nullptr);
+  /* We know that the writes have been flushed to disk now
+  and in recovery we will find them in the doublewrite file.
+  Next do the writes to the intended positions. Sort the pages
+  so that neighbours are written with a single vectored write. */
 
-  for (len2 = 0; len2 + UNIV_PAGE_SIZE <= len; len2 += UNIV_PAGE_SIZE, i++) {
-    const Buf_block *block = reinterpret_cast<Buf_block *>(dblwr->m_bpages[i]);
+  const auto first = batch->m_bpages.begin();
 
-    if (likely(block->get_state() == BUF_BLOCK_FILE_PAGE) &&
-        unlikely(memcmp(write_buf + len2 + (FIL_PAGE_LSN + 4), write_buf + len2 + (UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM + 4), 4)
-        )) {
-      log_err(
-        "The page to be written seems corrupt! The lsn fields do not match!"
-        " Noticed in the doublewrite block2."
-      );
-    }
-  }
+  std::sort(first, first + batch->m_first_free, [](const Buf_page *lhs, const Buf_page *rhs) {
+    return lhs->get_space() < rhs->get_space() ||
+           (lhs->get_space() == rhs->get_space() && lhs->get_page_no() < rhs->get_page_no());
+  });
 
-flush:
-  /* Now flush the doublewrite buffer data to disk */
+  /* The tablespaces written to, the batch is sorted by space id. */
+  std::vector<space_id_t> space_ids;
 
-  srv_fil->flush(TRX_SYS_SPACE);
+  ut_a(batch->m_n_pending == 0);
+  batch->m_n_pending = batch->m_first_free;
 
-  /* We know that the writes have been flushed to disk now
-  and in recovery we will find them in the doublewrite buffer
-  blocks. Next do the writes to the intended positions. */
+  Buf_page_run run(IO_request::Async_write);
 
-  for (i = 0; i < dblwr->m_first_free; ++i) {
-    const Buf_block *block = reinterpret_cast<Buf_block *>(dblwr->m_bpages[i]);
+  for (ulint i{}; i < batch->m_first_free; ++i) {
+    const Buf_block *block = reinterpret_cast<Buf_block *>(batch->m_bpages[i]);
 
     ut_a(block->m_page.in_file());
 
@@ -458,50 +505,75 @@ flush:
       ));
     }
 
-    srv_fil->data_io(IO_request::Async_write, true, block->get_page_id(), 0, UNIV_PAGE_SIZE, (void *)block->m_frame, (void *)block);
+    if (space_ids.empty() || space_ids.back() != block->get_space()) {
+      space_ids.push_back(block->get_space());
+    }
+
+    batch->m_bpages[i]->m_in_dblwr_batch = true;
+
+    run.add(batch->m_bpages[i]);
 
     /* Increment the counter of I/O operations used
     for selecting LRU policy. */
     m_buf_pool->m_LRU->stat_inc_io();
   }
 
-  /* Sync the writes to the disk. */
-  sync_datafiles();
+  run.submit();
+
+  /* We can now reuse the doublewrite memory buffer, the next batch of the
+  instance is filled while we sync. It is written to the doublewrite file
+  only after m_is_syncing is cleared. */
+  batch->m_first_free = 0;
+
+  mutex_exit(&batch->m_mutex);
+
+  srv_aio->submit_batch();
+
+  /* Wait for the writes of this batch only, the other instances have
+  their own, and flush the tablespaces that it wrote to. */
+  dblwr->wait_for_data_writes(batch);
+
+  srv_fil->flush_spaces(space_ids);
+
+  mutex_enter(&batch->m_mutex);
 
-  /* We can now reuse the doublewrite memory buffer: */
-  dblwr->m_first_free = 0;
+  batch->m_is_syncing = false;
 
-  mutex_exit(&dblwr->m_mutex);
+  os_event_set(batch->m_synced);
+
+  mutex_exit(&batch->m_mutex);
 }
 
 void Buf_flush::post_to_doublewrite_buf(DBLWR *dblwr, Buf_page *bpage) {
+  auto batch = dblwr->get_batch(m_buf_pool->m_instance_no);
+
   for (;;) {
-    mutex_enter(&dblwr->m_mutex);
+    mutex_enter(&batch->m_mutex);
 
     ut_a(bpage->in_file());
 
-    if (dblwr->m_first_free < 2 * SYS_DOUBLEWRITE_BLOCK_SIZE) {
+    if (batch->m_first_free < DBLWR::BATCH_SIZE) {
       break;
     }
 
-    mutex_exit(&dblwr->m_mutex);
+    mutex_exit(&batch->m_mutex);
 
     buffered_writes(dblwr);
   }
 
   ut_a(bpage->get_state() == BUF_BLOCK_FILE_PAGE);
 
-  memcpy(dblwr->m_write_buf + UNIV_PAGE_SIZE * dblwr->m_first_free, reinterpret_cast<Buf_block *>(bpage)->m_frame, UNIV_PAGE_SIZE);
+  memcpy(batch->m_write_buf + UNIV_PAGE_SIZE * batch->m_first_free, reinterpret_cast<Buf_block *>(bpage)->m_frame, UNIV_PAGE_SIZE);
 
-  dblwr->m_bpages[dblwr->m_first_free] = bpage;
+  batch->m_bpages[batch->m_first_free] = bpage;
 
-  ++dblwr->m_first_free;
+  ++batch->m_first_free;
 
-  if (dblwr->m_first_free >= 2 * SYS_DOUBLEWRITE_BLOCK_SIZE) {
-    mutex_exit(&dblwr->m_mutex);
+  if (batch->m_first_free >= DBLWR::BATCH_SIZE) {
+    mutex_exit(&batch->m_mutex);
     buffered_writes(dblwr);
   } else {
-    mutex_exit(&dblwr->m_mutex);
+    mutex_exit(&batch->m_mutex);
   }
 }
 
@@ -523,7 +595,7 @@ void Buf_flush::init_for_writing(byte *page, lsn_t newest_lsn) {
   mach_write_to_4(page + UNIV_PAGE_SIZE - FIL_PAGE_END_LSN_CHKSUM, BUF_NO_CHECKSUM_MAGIC);
 }
 
-void Buf_flush::write_block_low(DBLWR *dblwr, Buf_page *bpage) {
+void Buf_flush::write_block_low(DBLWR *dblwr, Buf_page *bpage, Buf_page_run &run) {
   page_t *frame = nullptr;
 
   ut_ad(bpage->in_file());
@@ -556,7 +628,8 @@ void Buf_flush::write_block_low(DBLWR *dblwr, Buf_page *bpage) {
   }
 
   if (!srv_config.m_use_doublewrite_buf || dblwr == nullptr) {
-    srv_fil->data_io(IO_request::Async_write, true, bpage->get_page_id(), 0, UNIV_PAGE_SIZE, frame, bpage);
+    ut_a(frame != nullptr);
+    run.add(bpage);
   } else {
     post_to_doublewrite_buf(dblwr, bpage);
   }
@@ -588,7 +661,7 @@ inline static bool free_page_if_truncated(Buf_pool *buf_pool, Buf_page *bpage) {
   return false;
 }
 
-void Buf_flush::page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type) {
+void Buf_flush::page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type, Buf_page_run &run) {
   ut_ad(m_buf_pool->mutex_is_owned());
   ut_ad(flush_type == BUF_FLUSH_LRU || flush_type == BUF_FLUSH_LIST);
   ut_ad(bpage->in_file());
@@ -631,6 +704,9 @@ void Buf_flush::page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type) {
       m_flush_list or LRU_list. */
 
       if (!is_s_latched) {
+        /* The writes in the run must be posted before they are synced. */
+        run.submit();
+
         buffered_writes(dblwr);
 
         rw_lock_s_lock_gen(&((Buf_block *)bpage)->m_rw_lock, BUF_IO_WRITE);
@@ -665,7 +741,7 @@ void Buf_flush::page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type) {
   m_oldest_modification != 0.  Thus, it cannot be relocated in the
   buffer pool or removed from m_flush_list or LRU_list. */
 
-  write_block_low(dblwr, bpage);
+  write_block_low(dblwr, bpage, run);
 }
 
 ulint Buf_flush::try_neighbors(DBLWR *dblwr, space_id_t space, page_no_t page_no, buf_flush flush_type) {
@@ -697,6 +773,9 @@ ulint Buf_flush::try_neighbors(DBLWR *dblwr, space_id_t space, page_no_t page_no
     high = srv_fil->space_get_size(space);
   }
 
+  /* Contiguous dirty pages are written with a single vectored write. */
+  Buf_page_run run(IO_request::Async_write);
+
   m_buf_pool->mutex_acquire();
 
   for (auto i = low; i < high; ++i) {
@@ -737,7 +816,7 @@ ulint Buf_flush::try_neighbors(DBLWR *dblwr, space_id_t space, page_no_t page_no
         Semaphore waits are expensive because we must flush the doublewrite buffer before
         we start waiting. */
 
-        page(dblwr, bpage, flush_type);
+        page(dblwr, bpage, flush_type, run);
         ut_ad(!mutex_own(block_mutex));
         ++count;
 
@@ -750,6 +829,8 @@ ulint Buf_flush::try_neighbors(DBLWR *dblwr, space_id_t space, page_no_t page_no
 
   m_buf_pool->mutex_release();
 
+  run.submit();
+
   return count;
 }
 
@@ -775,6 +856,8 @@ ulint Buf_flush::batch(DBLWR *dblwr, buf_flush flush_type, ulint min_n, uint64_t
 
   m_buf_pool->m_init_flush[flush_type] = true;
 
+  insert_pending_into_flush_list();
+
   for (;;) {
   flush_next:
     /* If we have flushed enough, leave the loop */
@@ -888,7 +971,7 @@ ulint Buf_flush::LRU_recommendation() {
   bpage = UT_LIST_GET_LAST(m_buf_pool->m_LRU_list);
 
   while (bpage != nullptr && n_replaceable < get_free_block_margin() + get_extra_margin() &&
-         (distance < Buf_LRU::get_free_search_len())) {
+         (distance < m_buf_pool->m_LRU->get_free_search_len())) {
 
     auto block_mutex = buf_page_get_mutex(bpage);
 
@@ -917,11 +1000,27 @@ ulint Buf_flush::LRU_recommendation() {
   }
 }
 
+ulint Buf_flush::LRU_flush(DBLWR *dblwr) {
+  const auto n_to_flush = LRU_recommendation();
+
+  return n_to_flush > 0 ? batch(dblwr, BUF_FLUSH_LRU, n_to_flush, 0) : 0;
+}
+
 void Buf_flush::free_margin(DBLWR *dblwr) {
   auto n_to_flush = LRU_recommendation();
 
   if (n_to_flush > 0) {
 
+    if (n_to_flush < get_free_block_margin() + get_extra_margin() && srv_page_cleaner != nullptr &&
+        srv_page_cleaner->is_active()) {
+
+      /* There are still replaceable blocks left, let the page cleaner
+      restore the margin in the background. */
+      srv_page_cleaner->wakeup();
+
+      return;
+    }
+
     const auto n_flushed = batch(dblwr, BUF_FLUSH_LRU, n_to_flush, 0);
 
     if (n_flushed == ULINT_UNDEFINED) {
@@ -972,10 +1071,16 @@ ulint Buf_flush::get_desired_flush_rate() {
   /* log_capacity should never be zero after the initialization of log subsystem. */
   ut_ad(log_capacity != 0);
 
-  /* Get total number of dirty pages. It is OK to access m_flush_list without holding
-  any mtex as we are using this only for heuristics. */
+  /* Get total number of dirty pages, the blocks that mini-transactions have pushed
+  to m_flush_pending included. */
+  m_buf_pool->mutex_acquire();
+
+  insert_pending_into_flush_list();
+
   auto n_dirty = UT_LIST_GET_LEN(m_buf_pool->m_flush_list);
 
+  m_buf_pool->mutex_release();
+
   /* An overflow can happen if we generate more than 2^32 bytes of redo in this
   interval i.e.: 4G of redo in 1 second. We can safely consider this as infinity
   because if we ever come close to 4G we'll start a synchronous flush of dirty pages.
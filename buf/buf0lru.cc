@@ -34,12 +34,15 @@ Created 11/5/1995 Heikki Tuuri
 #include "buf0flu.h"
 #include "fil0fil.h"
 #include "log0recv.h"
+#include "os0aio.h"
 #include "os0file.h"
 #include "os0sync.h"
 #include "srv0srv.h"
 #include "sync0sync.h"
 #include "ut0lst.h"
 
+#include <deque>
+
 /** The number of blocks from the LRU_old pointer onward, including
 the block pointed to, must be Buf_LRU::old_ratio/OLD_RATIO_DIV
 of the whole LRU list length, except that the tolerance defined below
@@ -58,6 +61,170 @@ static_assert(NON_MIN_LEN < Buf_LRU::OLD_MIN_LEN, "error Buf_LRU::NON_MIN_LEN >=
 ulint Buf_LRU::s_old_ratio{};
 ulint Buf_LRU::s_old_threshold_ms{};
 
+/** Midpoint insertion, the replacement policy of InnoDB. */
+struct Buf_LRU_midpoint : public Buf_LRU_policy {
+  explicit Buf_LRU_midpoint(Buf_pool *buf_pool) : m_buf_pool(buf_pool) {}
+
+  const char *name() const override { return "midpoint"; }
+
+  bool add_to_old(const Buf_page *, bool old) override { return old; }
+
+  bool accessed(Buf_page *bpage) override {
+    if (unlikely(m_buf_pool->m_freed_page_clock == 0)) {
+      /* If eviction has not started yet, do not update the statistics or move blocks
+      in the LRU list.  This is either the warm-up phase or an in-memory workload. */
+      return false;
+    } else if (m_buf_pool->m_LRU->get_old_threshold_ms() > 0 && bpage->m_old) {
+      auto access_time = buf_page_is_accessed(bpage);
+
+      if (access_time > 0 && ((uint32_t)(ut_time_ms() - access_time)) >= m_buf_pool->m_LRU->get_old_threshold_ms()) {
+        return true;
+      }
+
+      m_buf_pool->m_stat.n_pages_not_made_young++;
+
+      return false;
+
+    } else {
+      return !m_buf_pool->peek_if_young(bpage);
+    }
+  }
+
+  bool second_chance(Buf_page *) override { return false; }
+
+  void evicted(const Page_id &, bool) override {}
+
+  /** The buffer pool instance. */
+  Buf_pool *m_buf_pool{};
+};
+
+/** 2Q, the old blocks are the FIFO of the pages referenced once (A1in) and
+the ghost list remembers the pages evicted from it (A1out). */
+struct Buf_LRU_2Q : public Buf_LRU_policy {
+  explicit Buf_LRU_2Q(Buf_pool *buf_pool) : m_buf_pool(buf_pool) {}
+
+  const char *name() const override { return "2q"; }
+
+  bool add_to_old(const Buf_page *bpage, bool old) override {
+    if (!old) {
+      return false;
+    }
+
+    auto it = m_ghosts.find(bpage->get_page_id());
+
+    if (it == m_ghosts.end()) {
+      return true;
+    }
+
+    /* The page was evicted from the old blocks recently: it is referenced
+    more than once, put it to the start of the list. */
+    m_ghosts.erase(it);
+
+    return false;
+  }
+
+  bool accessed(Buf_page *bpage) override {
+    if (unlikely(m_buf_pool->m_freed_page_clock == 0)) {
+      return false;
+    } else if (!bpage->m_old) {
+      return !m_buf_pool->peek_if_young(bpage);
+    } else if (!bpage->m_in_A1in) {
+      /* The page was young before, it is in Am. */
+      return true;
+    } else {
+      m_buf_pool->m_stat.n_pages_not_made_young++;
+      return false;
+    }
+  }
+
+  bool second_chance(Buf_page *) override { return false; }
+
+  void evicted(const Page_id &page_id, bool old) override {
+    if (!old) {
+      return;
+    }
+
+    ++m_seq;
+
+    m_ghosts[page_id] = m_seq;
+    m_fifo.emplace_back(page_id, m_seq);
+
+    const auto max_ghosts = m_buf_pool->m_curr_size / 2;
+
+    while (m_fifo.size() > max_ghosts) {
+      const auto &[id, seq] = m_fifo.front();
+
+      /* A page that was read in again and evicted again has a newer entry. */
+      if (auto it = m_ghosts.find(id); it != m_ghosts.end() && it->second == seq) {
+        m_ghosts.erase(it);
+      }
+
+      m_fifo.pop_front();
+    }
+  }
+
+  /** The buffer pool instance. */
+  Buf_pool *m_buf_pool{};
+
+  /** Sequence number of the last eviction. */
+  uint64_t m_seq{};
+
+  /** The ids of the evicted pages in eviction order. Entries of pages that
+  were read in again are left in place and skipped when they are trimmed. */
+  std::deque<std::pair<Page_id, uint64_t>> m_fifo{};
+
+  /** The ghost list, page id to the sequence number of its eviction. */
+  Page_id_hash<uint64_t> m_ghosts{};
+};
+
+/** CLOCK with the LRU list as the clock, the tail of the list is the hand. */
+struct Buf_LRU_clock : public Buf_LRU_policy {
+  const char *name() const override { return "clock"; }
+
+  bool add_to_old(const Buf_page *, bool) override { return false; }
+
+  bool accessed(Buf_page *bpage) override {
+    /* Not protected by any mutex, the bit is a hint. */
+    if (!bpage->m_referenced) {
+      bpage->m_referenced = true;
+    }
+
+    return false;
+  }
+
+  bool second_chance(Buf_page *bpage) override {
+    if (bpage->m_referenced) {
+      bpage->m_referenced = false;
+      return true;
+    }
+
+    return false;
+  }
+
+  void evicted(const Page_id &, bool) override {}
+};
+
+std::unique_ptr<Buf_LRU_policy> Buf_LRU_policy::create(ulint policy, Buf_pool *buf_pool) {
+  switch (policy) {
+    case SRV_LRU_MIDPOINT:
+      return std::make_unique<Buf_LRU_midpoint>(buf_pool);
+    case SRV_LRU_2Q:
+      return std::make_unique<Buf_LRU_2Q>(buf_pool);
+    case SRV_LRU_CLOCK:
+      return std::make_unique<Buf_LRU_clock>();
+  }
+
+  ut_error;
+
+  return nullptr;
+}
+
+Buf_LRU::Buf_LRU(Buf_pool *buf_pool)
+  : m_buf_pool(buf_pool),
+    m_policy(Buf_LRU_policy::create(srv_config.m_LRU_policy, buf_pool)),
+    m_old_ratio(s_old_ratio),
+    m_old_threshold_ms(s_old_threshold_ms) {}
+
 void Buf_LRU::invalidate_tablespace(space_id_t id) {
   bool all_freed{};
 
@@ -66,7 +233,7 @@ void Buf_LRU::invalidate_tablespace(space_id_t id) {
 
     all_freed = true;
 
-    auto bpage = UT_LIST_GET_LAST(srv_buf_pool->m_LRU_list);
+    auto bpage = UT_LIST_GET_LAST(m_buf_pool->m_LRU_list);
 
     while (bpage != nullptr) {
       ut_a(bpage->in_file());
@@ -91,6 +258,9 @@ void Buf_LRU::invalidate_tablespace(space_id_t id) {
 
       } else {
         auto block_mutex = buf_page_get_mutex(bpage);
+        auto hash_latch = m_buf_pool->m_page_hash->get_latch(bpage->get_page_id());
+
+        rw_lock_x_lock(hash_latch);
 
         mutex_enter(block_mutex);
 
@@ -100,12 +270,17 @@ void Buf_LRU::invalidate_tablespace(space_id_t id) {
           currently reading it in, or flushing the modifications to the file */
 
           all_freed = false;
+
+          mutex_exit(block_mutex);
+
+          rw_lock_x_unlock(hash_latch);
+
           break;
 
         } else {
 
           if (bpage->m_oldest_modification != 0) {
-            srv_buf_pool->m_flusher->remove(bpage);
+            m_buf_pool->m_flusher->remove(bpage);
           }
 
           /* Remove from the LRU list. */
@@ -119,6 +294,8 @@ void Buf_LRU::invalidate_tablespace(space_id_t id) {
         }
 
         mutex_exit(block_mutex);
+
+        rw_lock_x_unlock(hash_latch);
       }
 
       bpage = prev_bpage;
@@ -135,34 +312,48 @@ void Buf_LRU::invalidate_tablespace(space_id_t id) {
 bool Buf_LRU::free_from_common_LRU_list(ulint n_iterations) {
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
-  auto distance = 100 + (n_iterations * srv_buf_pool->m_curr_size) / 10;
+  auto distance = 100 + (n_iterations * m_buf_pool->m_curr_size) / 10;
 
-  for (auto bpage = UT_LIST_GET_LAST(srv_buf_pool->m_LRU_list); likely(bpage != nullptr) && likely(distance > 0);
-       bpage = UT_LIST_GET_PREV(m_LRU_list, bpage), distance--) {
+  for (auto bpage = UT_LIST_GET_LAST(m_buf_pool->m_LRU_list); likely(bpage != nullptr) && likely(distance > 0);
+       distance--) {
 
     auto block_mutex = buf_page_get_mutex(bpage);
 
     ut_ad(bpage->m_in_LRU_list);
     ut_ad(bpage->in_file());
 
+    auto prev_bpage = UT_LIST_GET_PREV(m_LRU_list, bpage);
+
+    if (m_policy->second_chance(bpage)) {
+      make_block_young(bpage);
+      bpage = prev_bpage;
+      continue;
+    }
+
     mutex_enter(block_mutex);
 
-    auto accessed = buf_page_is_accessed(bpage);
-    auto block_status = free_block(bpage, nullptr);
+    const auto page_id = bpage->get_page_id();
+    const auto old = bpage->m_old;
+    const auto read_ahead = bpage->m_read_ahead;
+    const auto block_status = free_block(bpage, nullptr);
 
     mutex_exit(block_mutex);
 
     switch (block_status) {
       case Block_status::FREED:
-        /* Keep track of pages that are evicted without ever being accessed.
-	his gives us a measure of the effectiveness of readahead */
-        if (!accessed) {
-          ++srv_buf_pool->m_stat.n_ra_pages_evicted;
+        /* Keep track of read-ahead pages that are evicted without ever being
+        accessed. This gives us a measure of the effectiveness of readahead */
+        if (read_ahead) {
+          ++m_buf_pool->m_stat.n_ra_pages_evicted;
         }
+
+        m_policy->evicted(page_id, old);
+
         return true;
 
       case Block_status::NOT_FREED:
         /* The block was dirty, buffer-fixed, or I/O-fixed.  Keep looking. */
+        bpage = prev_bpage;
         continue;
 
       case Block_status::CANNOT_RELOCATE:
@@ -182,9 +373,9 @@ bool Buf_LRU::search_and_free_block(ulint n_iterations) {
   auto freed = free_from_common_LRU_list(n_iterations);
 
   if (!freed) {
-    srv_buf_pool->m_LRU_flush_ended = 0;
-  } else if (srv_buf_pool->m_LRU_flush_ended > 0) {
-    --srv_buf_pool->m_LRU_flush_ended;
+    m_buf_pool->m_LRU_flush_ended = 0;
+  } else if (m_buf_pool->m_LRU_flush_ended > 0) {
+    --m_buf_pool->m_LRU_flush_ended;
   }
 
   m_buf_pool->mutex_release();
@@ -195,7 +386,7 @@ bool Buf_LRU::search_and_free_block(ulint n_iterations) {
 void Buf_LRU::try_free_flushed_blocks() {
   m_buf_pool->mutex_acquire();
 
-  while (srv_buf_pool->m_LRU_flush_ended > 0) {
+  while (m_buf_pool->m_LRU_flush_ended > 0) {
 
     m_buf_pool->mutex_release();
 
@@ -211,7 +402,7 @@ bool Buf_LRU::buf_pool_running_out() {
   m_buf_pool->mutex_acquire();
 
   auto ret = !recv_recovery_on &&
-             UT_LIST_GET_LEN(srv_buf_pool->m_free_list) + UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) < srv_buf_pool->m_curr_size / 4;
+             UT_LIST_GET_LEN(m_buf_pool->m_free_list) + UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < m_buf_pool->m_curr_size / 4;
 
   m_buf_pool->mutex_release();
 
@@ -221,24 +412,32 @@ bool Buf_LRU::buf_pool_running_out() {
 Buf_block *Buf_LRU::get_free_only() {
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
-  auto block = (Buf_block *)UT_LIST_GET_FIRST(srv_buf_pool->m_free_list);
+  Buf_block *block;
 
-  if (block != nullptr) {
+  while ((block = (Buf_block *)UT_LIST_GET_FIRST(m_buf_pool->m_free_list)) != nullptr) {
     ut_ad(block->m_page.m_in_free_list);
     ut_d(block->m_page.m_in_free_list = false);
     ut_ad(!block->m_page.m_in_flush_list);
     ut_ad(!block->m_page.m_in_LRU_list);
     ut_a(!block->m_page.in_file());
 
-    UT_LIST_REMOVE(srv_buf_pool->m_free_list, (&block->m_page));
+    UT_LIST_REMOVE(m_buf_pool->m_free_list, (&block->m_page));
 
     mutex_enter(&block->m_mutex);
 
+    /* Do not hand out the blocks of a chunk that is being withdrawn. */
+    if (unlikely(m_buf_pool->withdraw_if_needed(block))) {
+      mutex_exit(&block->m_mutex);
+      continue;
+    }
+
     buf_block_set_state(block, BUF_BLOCK_READY_FOR_USE);
 
     UNIV_MEM_ALLOC(block->m_frame, UNIV_PAGE_SIZE);
 
     mutex_exit(&block->m_mutex);
+
+    break;
   }
 
   return block;
@@ -255,7 +454,7 @@ loop:
   m_buf_pool->mutex_acquire();
 
   if (!recv_recovery_on &&
-      UT_LIST_GET_LEN(srv_buf_pool->m_free_list) + UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) < srv_buf_pool->m_curr_size / 20) {
+      UT_LIST_GET_LEN(m_buf_pool->m_free_list) + UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < m_buf_pool->m_curr_size / 20) {
 
     ut_print_timestamp(ib_stream);
 
@@ -265,13 +464,13 @@ loop:
       " Check that your transactions do not set too many row locks."
       " Your buffer pool size is %lu MB. Maybe you should make the buffer pool bigger?"
       " We intentionally generate a seg fault to print a stack trace on Linux!\n",
-      (ulong)(srv_buf_pool->m_curr_size / (1024 * 1024 / UNIV_PAGE_SIZE))
+      (ulong)(m_buf_pool->m_curr_size / (1024 * 1024 / UNIV_PAGE_SIZE))
     );
 
     ut_error;
 
-  } else if (!recv_recovery_on && (UT_LIST_GET_LEN(srv_buf_pool->m_free_list) + UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list)) <
-                                    srv_buf_pool->m_curr_size / 3) {
+  } else if (!recv_recovery_on && (UT_LIST_GET_LEN(m_buf_pool->m_free_list) + UT_LIST_GET_LEN(m_buf_pool->m_LRU_list)) <
+                                    m_buf_pool->m_curr_size / 3) {
 
     if (!m_switched_on_monitor) {
 
@@ -285,7 +484,7 @@ loop:
         " row locks. Your buffer pool size is %lu MB.Maybe you should"
         " make the buffer pool bigger? Starting the InnoDB Monitor to"
         " print diagnostics, including lock heap and hash index sizes",
-        (ulong)(srv_buf_pool->m_curr_size / (1024 * 1024 / UNIV_PAGE_SIZE))
+        (ulong)(m_buf_pool->m_curr_size / (1024 * 1024 / UNIV_PAGE_SIZE))
       );
 
       m_switched_on_monitor = true;
@@ -367,14 +566,17 @@ loop:
     os_event_set(srv_lock_timeout_thread_event);
   }
 
-  /* No free block was found: try to flush the LRU list */
+  /* No free block was found: try to flush the LRU list. The blocks may
+  be held by reads that we posted in batch mode, submit those first. */
+
+  srv_aio->submit_batch();
 
-  srv_buf_pool->m_flusher->free_margin(srv_dblwr);
+  m_buf_pool->m_flusher->free_margin(srv_dblwr);
   ++srv_buf_pool_wait_free;
 
   m_buf_pool->mutex_acquire();
 
-  if (srv_buf_pool->m_LRU_flush_ended > 0) {
+  if (m_buf_pool->m_LRU_flush_ended > 0) {
     /* We have written pages in an LRU flush. To make the insert
     buffer more efficient, we try to move these pages to the free
     list. */
@@ -397,7 +599,7 @@ loop:
 }
 
 void Buf_LRU::old_adjust_len() {
-  ut_a(srv_buf_pool->m_LRU_old);
+  ut_a(m_buf_pool->m_LRU_old);
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
   ut_ad(m_old_ratio >= OLD_RATIO_MIN);
   ut_ad(m_old_ratio <= OLD_RATIO_MAX);
@@ -407,15 +609,15 @@ void Buf_LRU::old_adjust_len() {
     "OLD_RATIO_MIN * OLD_MIN_LEN <= OLD_RATIO_DIV * (OLD_TOLERANCE + 5)"
   );
 
-  auto old_len = srv_buf_pool->m_LRU_old_len;
+  auto old_len = m_buf_pool->m_LRU_old_len;
 
   auto new_len = std::min<ulint>(
-    UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) * m_old_ratio / OLD_RATIO_DIV,
-    UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) - (OLD_TOLERANCE + NON_MIN_LEN)
+    UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) * m_old_ratio / OLD_RATIO_DIV,
+    UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) - (OLD_TOLERANCE + NON_MIN_LEN)
   );
 
   for (;;) {
-    auto lru_old = srv_buf_pool->m_LRU_old;
+    auto lru_old = m_buf_pool->m_LRU_old;
 
     ut_a(lru_old->m_old);
     ut_ad(lru_old->m_in_LRU_list);
@@ -424,19 +626,19 @@ void Buf_LRU::old_adjust_len() {
 
     if (old_len + OLD_TOLERANCE < new_len) {
 
-      srv_buf_pool->m_LRU_old = lru_old = UT_LIST_GET_PREV(m_LRU_list, lru_old);
+      m_buf_pool->m_LRU_old = lru_old = UT_LIST_GET_PREV(m_LRU_list, lru_old);
 
-      old_len = ++srv_buf_pool->m_LRU_old_len;
+      old_len = ++m_buf_pool->m_LRU_old_len;
 
       buf_page_set(lru_old, true);
 
     } else if (old_len > new_len + OLD_TOLERANCE) {
 
-      srv_buf_pool->m_LRU_old = UT_LIST_GET_NEXT(m_LRU_list, lru_old);
+      m_buf_pool->m_LRU_old = UT_LIST_GET_NEXT(m_LRU_list, lru_old);
 
-      --srv_buf_pool->m_LRU_old_len;
+      --m_buf_pool->m_LRU_old_len;
 
-      old_len = srv_buf_pool->m_LRU_old_len;
+      old_len = m_buf_pool->m_LRU_old_len;
 
       buf_page_set(lru_old, false);
 
@@ -448,13 +650,13 @@ void Buf_LRU::old_adjust_len() {
 
 void Buf_LRU::old_init() {
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
-  ut_a(UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) == OLD_MIN_LEN);
+  ut_a(UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) == OLD_MIN_LEN);
 
   /* We first initialize all blocks in the LRU list as old and then use
   the adjust function to move the LRU_old pointer to the right
   position */
 
-  for (auto bpage = UT_LIST_GET_LAST(srv_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_PREV(m_LRU_list, bpage)) {
+  for (auto bpage = UT_LIST_GET_LAST(m_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_PREV(m_LRU_list, bpage)) {
 
     ut_ad(bpage->m_in_LRU_list);
     ut_ad(bpage->in_file());
@@ -463,14 +665,14 @@ void Buf_LRU::old_init() {
     bpage->m_old = true;
   }
 
-  srv_buf_pool->m_LRU_old = UT_LIST_GET_FIRST(srv_buf_pool->m_LRU_list);
-  srv_buf_pool->m_LRU_old_len = UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list);
+  m_buf_pool->m_LRU_old = UT_LIST_GET_FIRST(m_buf_pool->m_LRU_list);
+  m_buf_pool->m_LRU_old_len = UT_LIST_GET_LEN(m_buf_pool->m_LRU_list);
 
   old_adjust_len();
 }
 
 void Buf_LRU::remove_block(Buf_page *bpage) {
-  ut_ad(srv_buf_pool);
+  ut_ad(m_buf_pool != nullptr);
   ut_ad(bpage);
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
@@ -481,7 +683,7 @@ void Buf_LRU::remove_block(Buf_page *bpage) {
   /* If the LRU_old pointer is defined and points to just this block,
   move it backward one step */
 
-  if (unlikely(bpage == srv_buf_pool->m_LRU_old)) {
+  if (unlikely(bpage == m_buf_pool->m_LRU_old)) {
 
     /* Below: the previous block is guaranteed to exist, because the LRU_old pointer is
     only allowed to differ by OLD_TOLERANCE from strict Buf_LRU::old_ratio/OLD_RATIO_DIV
@@ -489,37 +691,37 @@ void Buf_LRU::remove_block(Buf_page *bpage) {
     auto prev_bpage = UT_LIST_GET_PREV(m_LRU_list, bpage);
 
     ut_a(prev_bpage);
-    srv_buf_pool->m_LRU_old = prev_bpage;
+    m_buf_pool->m_LRU_old = prev_bpage;
     buf_page_set(prev_bpage, true);
 
-    ++srv_buf_pool->m_LRU_old_len;
+    ++m_buf_pool->m_LRU_old_len;
   }
 
   /* Remove the block from the LRU list */
-  UT_LIST_REMOVE(srv_buf_pool->m_LRU_list, bpage);
+  UT_LIST_REMOVE(m_buf_pool->m_LRU_list, bpage);
   ut_d(bpage->m_in_LRU_list = false);
 
   /* If the LRU list is so short that LRU_old is not defined,
   clear the "old" flags and return */
-  if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) < OLD_MIN_LEN) {
+  if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < OLD_MIN_LEN) {
 
-    for (bpage = UT_LIST_GET_FIRST(srv_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
+    for (bpage = UT_LIST_GET_FIRST(m_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
       /* This loop temporarily violates the assertions of buf_page_set(). */
       bpage->m_old = false;
     }
 
-    srv_buf_pool->m_LRU_old = nullptr;
-    srv_buf_pool->m_LRU_old_len = 0;
+    m_buf_pool->m_LRU_old = nullptr;
+    m_buf_pool->m_LRU_old_len = 0;
 
     return;
   }
 
-  ut_ad(srv_buf_pool->m_LRU_old);
+  ut_ad(m_buf_pool->m_LRU_old);
 
   /* Update the LRU_old_len field if necessary */
   if (buf_page_is_old(bpage)) {
 
-    srv_buf_pool->m_LRU_old_len--;
+    m_buf_pool->m_LRU_old_len--;
   }
 
   /* Adjust the length of the old block list if necessary */
@@ -527,78 +729,82 @@ void Buf_LRU::remove_block(Buf_page *bpage) {
 }
 
 void Buf_LRU::add_block_to_end_low(Buf_page *bpage) {
-  ut_ad(srv_buf_pool);
+  ut_ad(m_buf_pool != nullptr);
   ut_ad(bpage);
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
   ut_a(bpage->in_file());
 
   ut_ad(!bpage->m_in_LRU_list);
-  UT_LIST_ADD_LAST(srv_buf_pool->m_LRU_list, bpage);
+  UT_LIST_ADD_LAST(m_buf_pool->m_LRU_list, bpage);
   ut_d(bpage->m_in_LRU_list = true);
 
-  if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) > OLD_MIN_LEN) {
+  if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) > OLD_MIN_LEN) {
 
-    ut_ad(srv_buf_pool->m_LRU_old);
+    ut_ad(m_buf_pool->m_LRU_old);
 
     /* Adjust the length of the old block list if necessary */
 
     buf_page_set(bpage, true);
-    srv_buf_pool->m_LRU_old_len++;
+    m_buf_pool->m_LRU_old_len++;
     old_adjust_len();
 
-  } else if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) == OLD_MIN_LEN) {
+  } else if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) == OLD_MIN_LEN) {
 
     /* The LRU list is now long enough for LRU_old to become
     defined: init it */
 
     old_init();
   } else {
-    buf_page_set(bpage, srv_buf_pool->m_LRU_old != nullptr);
+    buf_page_set(bpage, m_buf_pool->m_LRU_old != nullptr);
   }
 }
 
 void Buf_LRU::add_block_low(Buf_page *bpage, bool old) {
-  ut_ad(srv_buf_pool);
+  ut_ad(m_buf_pool != nullptr);
   ut_ad(bpage);
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
   ut_a(bpage->in_file());
   ut_ad(!bpage->m_in_LRU_list);
 
-  if (!old || (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) < OLD_MIN_LEN)) {
+  if (!old || (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) < OLD_MIN_LEN)) {
 
-    UT_LIST_ADD_FIRST(srv_buf_pool->m_LRU_list, bpage);
+    UT_LIST_ADD_FIRST(m_buf_pool->m_LRU_list, bpage);
 
-    bpage->m_freed_page_clock = srv_buf_pool->m_freed_page_clock;
+    bpage->m_freed_page_clock = m_buf_pool->m_freed_page_clock;
   } else {
-    UT_LIST_INSERT_AFTER(srv_buf_pool->m_LRU_list, srv_buf_pool->m_LRU_old, bpage);
-    srv_buf_pool->m_LRU_old_len++;
+    UT_LIST_INSERT_AFTER(m_buf_pool->m_LRU_list, m_buf_pool->m_LRU_old, bpage);
+    m_buf_pool->m_LRU_old_len++;
   }
 
   ut_d(bpage->m_in_LRU_list = true);
 
-  if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) > OLD_MIN_LEN) {
+  if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) > OLD_MIN_LEN) {
 
-    ut_ad(srv_buf_pool->m_LRU_old);
+    ut_ad(m_buf_pool->m_LRU_old);
 
     /* Adjust the length of the old block list if necessary */
 
     buf_page_set(bpage, old);
     old_adjust_len();
 
-  } else if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) == OLD_MIN_LEN) {
+  } else if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) == OLD_MIN_LEN) {
 
     /* The LRU list is now long enough for LRU_old to become
     defined: init it */
 
     old_init();
   } else {
-    buf_page_set(bpage, srv_buf_pool->m_LRU_old != nullptr);
+    buf_page_set(bpage, m_buf_pool->m_LRU_old != nullptr);
   }
 }
 
 void Buf_LRU::add_block(Buf_page *bpage, bool old) {
+  old = m_policy->add_to_old(bpage, old);
+
+  bpage->m_in_A1in = old;
+
   add_block_low(bpage, old);
 }
 
@@ -606,9 +812,11 @@ void Buf_LRU::make_block_young(Buf_page *bpage) {
   ut_ad(mutex_own(&m_buf_pool->m_mutex));
 
   if (bpage->m_old) {
-    ++srv_buf_pool->m_stat.n_pages_made_young;
+    ++m_buf_pool->m_stat.n_pages_made_young;
   }
 
+  bpage->m_in_A1in = false;
+
   remove_block(bpage);
   add_block_low(bpage, false);
 }
@@ -618,6 +826,29 @@ void Buf_LRU::make_block(Buf_page *bpage) {
   add_block_to_end_low(bpage);
 }
 
+void Buf_LRU::relocate(Buf_page *bpage, Buf_page *dpage) {
+  ut_ad(mutex_own(&m_buf_pool->m_mutex));
+  ut_ad(bpage->m_in_LRU_list);
+
+  auto prev = UT_LIST_GET_PREV(m_LRU_list, bpage);
+
+  UT_LIST_REMOVE(m_buf_pool->m_LRU_list, bpage);
+  ut_d(bpage->m_in_LRU_list = false);
+
+  if (prev != nullptr) {
+    UT_LIST_INSERT_AFTER(m_buf_pool->m_LRU_list, prev, dpage);
+  } else {
+    UT_LIST_ADD_FIRST(m_buf_pool->m_LRU_list, dpage);
+  }
+
+  ut_d(dpage->m_in_LRU_list = true);
+
+  /* The old flag was copied, the length of the old part does not change. */
+  if (m_buf_pool->m_LRU_old == bpage) {
+    m_buf_pool->m_LRU_old = dpage;
+  }
+}
+
 Buf_LRU::Block_status Buf_LRU::free_block(Buf_page *bpage, bool *buf_pool_mutex_released) {
   auto block_mutex = buf_page_get_mutex(bpage);
 
@@ -625,21 +856,39 @@ Buf_LRU::Block_status Buf_LRU::free_block(Buf_page *bpage, bool *buf_pool_mutex_
   ut_ad(mutex_own(block_mutex));
   ut_ad(bpage->in_file());
   ut_ad(bpage->m_in_LRU_list);
-  ut_ad(!bpage->m_in_flush_list == !bpage->m_oldest_modification);
+  ut_ad(bpage->m_in_flush_pending || !bpage->m_in_flush_list == !bpage->m_oldest_modification);
 
   UNIV_MEM_ASSERT_RW(bpage, sizeof(*bpage));
 
-  if (!buf_page_can_relocate(bpage)) {
+  if (!buf_page_can_relocate(bpage) || bpage->m_oldest_modification > 0) {
 
-    /* Do not free buffer-fixed or I/O-fixed blocks. */
+    /* Do not free buffer-fixed, I/O-fixed or modified blocks. */
     return Block_status::NOT_FREED;
   }
 
-  if (bpage->m_oldest_modification > 0) {
+  /* The page hash shard latch must be acquired before the block mutex. The buffer
+  pool mutex prevents the page from being evicted or relocated while the block mutex
+  is released, but it can be buffer-fixed by a lookup, so check again. */
+  auto hash_latch = m_buf_pool->m_page_hash->get_latch(bpage->get_page_id());
+
+  mutex_exit(block_mutex);
+
+  rw_lock_x_lock(hash_latch);
+
+  mutex_enter(block_mutex);
+
+  if (!buf_page_can_relocate(bpage) || bpage->m_oldest_modification > 0) {
+
+    rw_lock_x_unlock(hash_latch);
 
     return Block_status::NOT_FREED;
+  }
 
-  } else if (block_remove_hashed_page(bpage) == BUF_BLOCK_REMOVE_HASH) {
+  const auto state = block_remove_hashed_page(bpage);
+
+  rw_lock_x_unlock(hash_latch);
+
+  if (state == BUF_BLOCK_REMOVE_HASH) {
     ut_a(bpage->m_buf_fix_count == 0);
 
     if (buf_pool_mutex_released) {
@@ -698,7 +947,12 @@ void Buf_LRU::block_free_non_file_page(Buf_block *block) {
   memset(frame + FIL_PAGE_SPACE_ID, 0xcafe, 4);
 #endif /* UNIV_DEBUG */
 
-  UT_LIST_ADD_FIRST(srv_buf_pool->m_free_list, &block->m_page);
+  /* A block of a chunk that is being withdrawn is not put back on the free list. */
+  if (unlikely(m_buf_pool->withdraw_if_needed(block))) {
+    return;
+  }
+
+  UT_LIST_ADD_FIRST(m_buf_pool->m_free_list, &block->m_page);
 
   ut_d(block->m_page.m_in_free_list = true);
 
@@ -717,7 +971,7 @@ Buf_page_state Buf_LRU::block_remove_hashed_page(Buf_page *bpage) {
 
   remove_block(bpage);
 
-  srv_buf_pool->m_freed_page_clock += 1;
+  m_buf_pool->m_freed_page_clock += 1;
 
   switch (bpage->get_state()) {
     case BUF_BLOCK_FILE_PAGE:
@@ -735,7 +989,7 @@ Buf_page_state Buf_LRU::block_remove_hashed_page(Buf_page *bpage) {
       break;
   }
 
-  auto hashed_bpage = srv_buf_pool->hash_get_page(Page_id(bpage->m_space, bpage->m_page_no));
+  auto hashed_bpage = m_buf_pool->hash_get_page(Page_id(bpage->m_space, bpage->m_page_no));
 
   if (unlikely(bpage != hashed_bpage)) {
     ib_logger(ib_stream, "Error: page %lu %lu not found in the hash table ", (ulong)bpage->m_space, (ulong)bpage->m_page_no);
@@ -755,11 +1009,11 @@ Buf_page_state Buf_LRU::block_remove_hashed_page(Buf_page *bpage) {
 
     m_buf_pool->mutex_release();
 
-    srv_buf_pool->print();
+    m_buf_pool->print();
 
     print();
 
-    srv_buf_pool->validate();
+    m_buf_pool->validate();
 
     validate();
 #endif /* UNIV_DEBUG */
@@ -769,7 +1023,11 @@ Buf_page_state Buf_LRU::block_remove_hashed_page(Buf_page *bpage) {
   ut_ad(bpage->m_in_page_hash);
   ut_d(bpage->m_in_page_hash = false);
 
-  srv_buf_pool->m_page_hash->erase(Page_id(bpage->m_space, bpage->m_page_no));
+#ifdef UNIV_SYNC_DEBUG
+  ut_ad(rw_lock_own(m_buf_pool->m_page_hash->get_latch(Page_id(bpage->m_space, bpage->m_page_no)), RW_LOCK_EX));
+#endif /* UNIV_SYNC_DEBUG */
+
+  m_buf_pool->m_page_hash->erase(Page_id(bpage->m_space, bpage->m_page_no));
 
   switch (bpage->get_state()) {
     case BUF_BLOCK_FILE_PAGE:
@@ -817,13 +1075,13 @@ ulint Buf_LRU::old_ratio_update(ulint old_pct, bool adjust) {
   if (adjust) {
     m_buf_pool->mutex_acquire();
 
-    auto buf_LRU = srv_buf_pool->m_LRU.get();
+    auto buf_LRU = m_buf_pool->m_LRU.get();
 
     if (ratio != buf_LRU->m_old_ratio) {
 
       buf_LRU->m_old_ratio = ratio;
 
-      if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) >= OLD_MIN_LEN) {
+      if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) >= OLD_MIN_LEN) {
 
         buf_LRU->old_adjust_len();
       }
@@ -841,7 +1099,7 @@ ulint Buf_LRU::old_ratio_update(ulint old_pct, bool adjust) {
 
 void Buf_LRU::stat_update() {
   /* If we haven't started eviction yet then don't update stats. */
-  if (srv_buf_pool->m_freed_page_clock != 0) {
+  if (m_buf_pool->m_freed_page_clock != 0) {
     m_buf_pool->mutex_acquire();
 
     /* Update the index. */
@@ -866,26 +1124,26 @@ void Buf_LRU::stat_update() {
 bool Buf_LRU::validate() {
   m_buf_pool->mutex_acquire();
 
-  if (UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) >= OLD_MIN_LEN) {
+  if (UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) >= OLD_MIN_LEN) {
 
-    ut_a(srv_buf_pool->m_LRU_old);
+    ut_a(m_buf_pool->m_LRU_old);
 
-    const auto old_len = srv_buf_pool->m_LRU_old_len;
+    const auto old_len = m_buf_pool->m_LRU_old_len;
 
     const auto new_len = std::min<ulint>(
-      UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) * m_old_ratio / OLD_RATIO_DIV,
-      UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) - (OLD_TOLERANCE + NON_MIN_LEN)
+      UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) * m_old_ratio / OLD_RATIO_DIV,
+      UT_LIST_GET_LEN(m_buf_pool->m_LRU_list) - (OLD_TOLERANCE + NON_MIN_LEN)
     );
 
     ut_a(old_len >= new_len - OLD_TOLERANCE);
     ut_a(old_len <= new_len + OLD_TOLERANCE);
   }
 
-  UT_LIST_CHECK(srv_buf_pool->m_LRU_list);
+  UT_LIST_CHECK(m_buf_pool->m_LRU_list);
 
   ulint old_len{};
 
-  for (auto bpage = UT_LIST_GET_FIRST(srv_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
+  for (auto bpage = UT_LIST_GET_FIRST(m_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
 
     switch (bpage->get_state()) {
       default:
@@ -906,7 +1164,7 @@ bool Buf_LRU::validate() {
       ++old_len;
 
       if (old_len >= 1) {
-        ut_a(srv_buf_pool->m_LRU_old == bpage);
+        ut_a(m_buf_pool->m_LRU_old == bpage);
       } else {
         ut_a(prev == nullptr || buf_page_is_old(prev));
       }
@@ -915,14 +1173,14 @@ bool Buf_LRU::validate() {
     }
   }
 
-  ut_a(srv_buf_pool->m_LRU_old_len == old_len);
+  ut_a(m_buf_pool->m_LRU_old_len == old_len);
 
   auto check = [](const Buf_page *page) {
     ut_ad(page->m_in_free_list);
   };
-  ut_list_validate(srv_buf_pool->m_free_list, check);
+  ut_list_validate(m_buf_pool->m_free_list, check);
 
-  for (auto bpage = UT_LIST_GET_FIRST(srv_buf_pool->m_free_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_list, bpage)) {
+  for (auto bpage = UT_LIST_GET_FIRST(m_buf_pool->m_free_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_list, bpage)) {
 
     ut_a(bpage->get_state() == BUF_BLOCK_NOT_USED);
   }
@@ -935,7 +1193,7 @@ bool Buf_LRU::validate() {
 void Buf_LRU::print() {
   m_buf_pool->mutex_acquire();
 
-  for (auto bpage = UT_LIST_GET_FIRST(srv_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
+  for (auto bpage = UT_LIST_GET_FIRST(m_buf_pool->m_LRU_list); bpage != nullptr; bpage = UT_LIST_GET_NEXT(m_LRU_list, bpage)) {
 
     ib_logger(ib_stream, "BLOCK space %lu page %lu ", (ulong)bpage->get_space(), (ulong)bpage->get_page_no());
 
@@ -32,16 +32,24 @@ Created 11/5/1995 Heikki Tuuri
 #include "buf0flu.h"
 #include "buf0lru.h"
 #include "log0recv.h"
+#include "os0aio.h"
 #include "os0file.h"
 #include "srv0srv.h"
 #include "trx0sys.h"
 #include "ut0logger.h"
 
-/** If there are srv_buf_pool->m_curr_size per the number below pending reads, then
+/** If there are Buf_pool::m_curr_size per the number below pending reads, then
 read-ahead is not done: this is to prevent flooding the buffer pool with
 i/o-fixed buffer blocks */
 constexpr ulint BUF_READ_AHEAD_PEND_LIMIT = 2;
 
+/** The number of pages of a read-ahead area that must have been recently
+accessed for random read-ahead to read in the rest of the area.
+@param[in] area                 Size of the read-ahead area in pages. */
+constexpr ulint buf_read_ahead_random_threshold(ulint area) {
+  return 13 + area / 8;
+}
+
 /**
  * @brief Low-level function which reads a page asynchronously from a file to
  * the buffer srv_buf_pool if it is not already there, in which case does nothing.
@@ -61,10 +69,18 @@ constexpr ulint BUF_READ_AHEAD_PEND_LIMIT = 2;
  *
  * @param[in] page_no_t in: page number
  *
+ * @param[in] read_ahead in: true if the page is read in by read-ahead
+ *
+ * @param[in,out] run in: if not nullptr the asynchronous read is added to this
+ *  run of pages and is posted when the run is submitted
+ *
  * @return DB_SUCCESS if a request was posted to the IO layer, DB_FAIL the request was not posted
  *  or error code from the IO layer.
  */
-static db_err buf_read_page(IO_request io_request, bool batch, const Page_id &page_id, int64_t tablespace_version) {
+static db_err buf_read_page(
+  IO_request io_request, bool batch, const Page_id &page_id, int64_t tablespace_version, bool read_ahead,
+  Buf_page_run *run = nullptr
+) {
   ut_a(io_request == IO_request::Async_read || io_request == IO_request::Sync_read);
 
   if (srv_dblwr != nullptr && page_id.space_id() == TRX_SYS_SPACE && srv_dblwr->is_page_inside(page_id.page_no())) {
@@ -80,7 +96,8 @@ static db_err buf_read_page(IO_request io_request, bool batch, const Page_id &pa
   or is being dropped; if we succeed in initing the page in the buffer
   pool for read, then DISCARD cannot proceed until the read has
   completed */
-  auto bpage = srv_buf_pool->init_for_read(&err, page_id, tablespace_version);
+  auto buf_pool = srv_buf_pool->get_instance(page_id);
+  auto bpage = buf_pool->init_for_read(&err, page_id, tablespace_version, read_ahead);
 
   if (bpage == nullptr) {
     /* The bpage can be nullptr if the page is already in the buffer pool. */
@@ -92,13 +109,21 @@ static db_err buf_read_page(IO_request io_request, bool batch, const Page_id &pa
 
   ut_a(bpage->get_state() == BUF_BLOCK_FILE_PAGE);
 
+  if (run != nullptr) {
+    ut_a(io_request == IO_request::Async_read && batch);
+
+    run->add(bpage);
+
+    return DB_SUCCESS;
+  }
+
   err = srv_fil->data_io(io_request, batch, page_id, 0, UNIV_PAGE_SIZE, buf_page_get_block(bpage)->get_frame(), bpage);
 
   ut_a(err == DB_SUCCESS);
 
   if (io_request == IO_request::Sync_read) {
     /* The i/o is already completed when we arrive from srv_fil->read */
-    srv_buf_pool->io_complete(bpage);
+    buf_pool->io_complete(bpage);
   } else {
     ut_a(io_request == IO_request::Async_read);
   }
@@ -108,7 +133,13 @@ static db_err buf_read_page(IO_request io_request, bool batch, const Page_id &pa
 
 bool buf_read_page(const Page_id &page_id) {
   auto tablespace_version = srv_fil->space_get_version(page_id.space_id());
-  auto err = buf_read_page(IO_request::Sync_read, false, page_id, tablespace_version);
+
+  if (srv_config.m_random_read_ahead) {
+    /* Post the reads for the rest of the area before we wait for this page. */
+    buf_read_ahead_random(srv_buf_pool->get_instance(page_id), page_id);
+  }
+
+  auto err = buf_read_page(IO_request::Sync_read, false, page_id, tablespace_version, false);
 
   if (err == DB_SUCCESS) {
 
@@ -124,11 +155,13 @@ bool buf_read_page(const Page_id &page_id) {
     ));
   }
 
+  auto buf_pool = srv_buf_pool->get_instance(page_id);
+
   /* Flush pages from the end of the LRU list if necessary */
-  srv_buf_pool->m_flusher->free_margin(srv_dblwr);
+  buf_pool->m_flusher->free_margin(srv_dblwr);
 
   /* Increment number of I/O operations used for LRU policy. */
-  srv_buf_pool->m_LRU->stat_inc_io();
+  buf_pool->m_LRU->stat_inc_io();
 
   return err == DB_SUCCESS;
 }
@@ -145,7 +178,7 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, const Page_id &page_id) {
   ulint fail_count;
   db_err err;
   ulint i;
-  const ulint buf_read_ahead_linear_area = srv_buf_pool->get_read_ahead_area();
+  const ulint buf_read_ahead_linear_area = buf_pool->get_read_ahead_area();
   ulint threshold;
   auto space = page_id.space_id();
   auto offset = page_id.page_no();
@@ -184,7 +217,7 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, const Page_id &page_id) {
     return 0;
   }
 
-  if (srv_buf_pool->m_n_pend_reads > srv_buf_pool->m_curr_size / BUF_READ_AHEAD_PEND_LIMIT) {
+  if (buf_pool->m_n_pend_reads > buf_pool->m_curr_size / BUF_READ_AHEAD_PEND_LIMIT) {
     buf_pool->mutex_release();
 
     return 0;
@@ -202,7 +235,7 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, const Page_id &page_id) {
 
   /* How many out of order accessed pages can we ignore
   when working out the access pattern for linear readahead */
-  threshold = std::min<ulint>((64 - srv_config.m_read_ahead_threshold), srv_buf_pool->get_read_ahead_area());
+  threshold = std::min<ulint>((64 - srv_config.m_read_ahead_threshold), buf_read_ahead_linear_area);
 
   fail_count = 0;
 
@@ -211,7 +244,7 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, const Page_id &page_id) {
   for (i = low; i < high; i++) {
     current_page_id.set_page_no(i);
 
-    bpage = srv_buf_pool->hash_get_page(current_page_id);
+    bpage = buf_pool->hash_get_page(current_page_id);
 
     if (bpage == nullptr || !buf_page_is_accessed(bpage)) {
       /* Not accessed */
@@ -246,7 +279,7 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, const Page_id &page_id) {
   /* If we got this far, we know that enough pages in the area have
   been accessed in the right order: linear read-ahead can be sensible */
 
-  bpage = srv_buf_pool->hash_get_page(page_id);
+  bpage = buf_pool->hash_get_page(page_id);
 
   if (bpage == nullptr) {
     buf_pool->mutex_release();
@@ -306,11 +339,13 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, const Page_id &page_id) {
 
   count = 0;
 
+  Buf_page_run run(IO_request::Async_read);
+
   for (i = low; i < high; i++) {
     /* It is only sensible to do read-ahead in the non-sync
     aio mode: hence false as the first parameter */
 
-    err = buf_read_page(IO_request::Async_read, true, Page_id(space, i), tablespace_version);
+    err = buf_read_page(IO_request::Async_read, true, Page_id(space, i), tablespace_version, true, &run);
 
     if (err == DB_SUCCESS) {
 
@@ -330,54 +365,238 @@ ulint buf_read_ahead_linear(Buf_pool *buf_pool, const Page_id &page_id) {
     }
   }
 
+  run.submit();
+
+  /* Pass the whole read-ahead area to the kernel in one go. */
+  srv_aio->submit_batch();
+
   /* Flush pages from the end of the LRU list if necessary */
-  srv_buf_pool->m_flusher->free_margin(srv_dblwr);
+  buf_pool->m_flusher->free_margin(srv_dblwr);
 
   /* Read ahead is considered one I/O operation for the purpose of LRU policy decision. */
-  srv_buf_pool->m_LRU->stat_inc_io();
+  buf_pool->m_LRU->stat_inc_io();
 
-  srv_buf_pool->m_stat.n_ra_pages_read += count;
+  buf_pool->m_stat.n_ra_pages_read += count;
 
   return count;
 }
 
-void buf_read_recv_pages(bool sync, const Page_id &page_id, const page_no_t *page_nos, ulint n_stored) {
-  auto space = page_id.space_id();
-  if (srv_fil->space_get_size(space) == ULINT_UNDEFINED) {
-    /* It is a single table tablespace and the .ibd file is
-    missing: do nothing */
-    return;
+ulint buf_read_ahead_random(Buf_pool *buf_pool, const Page_id &page_id) {
+  const auto space = page_id.space_id();
+  const auto offset = page_id.page_no();
+  const ulint area = buf_pool->get_read_ahead_area();
+
+  if (unlikely(srv_startup_is_before_trx_rollback_phase)) {
+    /* No read-ahead to avoid thread deadlocks */
+    return 0;
   }
 
-  auto tablespace_version = srv_fil->space_get_version(space);
+  if (Trx_sys::is_hdr_page(space, offset)) {
+    /* Don't do a read-ahead in the system area. Being cautious. */
+    return 0;
+  }
+
+  const auto low = (offset / area) * area;
+  const auto high = (offset / area + 1) * area;
+
+  /* Remember the tablespace version before we ask the tablespace size
+  below: if DISCARD + IMPORT changes the actual .ibd file meanwhile, we
+  do not try to read outside the bounds of the tablespace! */
+
+  const auto tablespace_version = srv_fil->space_get_version(space);
+
+  if (high > srv_fil->space_get_size(space)) {
+    /* The area is not whole */
+    return 0;
+  }
 
-  for (ulint i = 0; i < n_stored; i++) {
-    ulint count{};
+  const auto threshold = buf_read_ahead_random_threshold(area);
 
-    while (srv_buf_pool->m_n_pend_reads >= recv_n_pool_free_frames / 2) {
+  buf_pool->mutex_acquire();
+
+  if (buf_pool->m_n_pend_reads > buf_pool->m_curr_size / BUF_READ_AHEAD_PEND_LIMIT) {
+    buf_pool->mutex_release();
+
+    return 0;
+  }
+
+  /* Count how many pages of the area have been accessed and are still near
+  the start of the LRU list, the order of the accesses does not matter. */
+
+  ulint n_recent{};
+  Page_id current_page_id(space, low);
+
+  for (auto i = low; i < high && n_recent < threshold; ++i) {
+    current_page_id.set_page_no(i);
+
+    const auto bpage = buf_pool->hash_get_page(current_page_id);
+
+    if (bpage != nullptr && buf_page_is_accessed(bpage) && buf_pool->peek_if_young(bpage)) {
+      ++n_recent;
+    }
+  }
+
+  buf_pool->mutex_release();
 
-      os_thread_sleep(10000);
+  if (n_recent < threshold) {
+    return 0;
+  }
 
-      count++;
+  ulint count{};
+  Buf_page_run run(IO_request::Async_read);
 
-      if (count > 1000) {
+  for (auto i = low; i < high; ++i) {
+    if (i == offset) {
+      /* The caller reads this page synchronously. */
+      continue;
+    }
+
+    const auto err = buf_read_page(IO_request::Async_read, true, Page_id(space, i), tablespace_version, true, &run);
+
+    if (err == DB_SUCCESS) {
+
+      ++count;
+
+    } else if (err == DB_TABLESPACE_DELETED) {
+
+      log_info(std::format(
+        "Random readahead trying to access tablespace {} page {}, but the tablespace does not"
+        " exist or is just being dropped.",
+        space,
+        i
+      ));
+
+      break;
+
+    } else {
+      ut_a(err == DB_FAIL);
+    }
+  }
+
+  run.submit();
+
+  srv_aio->submit_batch();
+
+  /* Read ahead is considered one I/O operation for the purpose of LRU policy decision. */
+  buf_pool->m_LRU->stat_inc_io();
+
+  buf_pool->m_stat.n_ra_pages_read += count;
+
+  return count;
+}
+
+ulint buf_read_load_pages(space_id_t space, const page_no_t *page_nos, ulint n_stored) {
+  /* Remember the tablespace version before we ask the tablespace size
+  below: if DISCARD + IMPORT changes the actual .ibd file meanwhile, we
+  do not try to read outside the bounds of the tablespace! */
+
+  const auto tablespace_version = srv_fil->space_get_version(space);
+
+  if (tablespace_version == -1) {
+    /* The tablespace does not exist (anymore) or is not open yet. */
+    return 0;
+  }
+
+  const auto size = srv_fil->space_get_size(space);
+
+  ulint count{};
+  Buf_page_run run(IO_request::Async_read, IO_priority::Prefetch);
+
+  for (ulint i = 0; i < n_stored && page_nos[i] < size; ++i) {
+    const auto err =
+      buf_read_page(IO_request::Async_read, true, Page_id(space, page_nos[i]), tablespace_version, false, &run);
+
+    if (err == DB_SUCCESS) {
+
+      ++count;
+
+    } else if (err == DB_TABLESPACE_DELETED) {
+
+      break;
+
+    } else {
+      ut_a(err == DB_FAIL);
+    }
+  }
+
+  run.submit();
+
+  srv_aio->submit_batch();
+
+  /* Flush pages from the end of the LRU list if necessary */
+  srv_buf_pool->free_margin(srv_dblwr);
+
+  return count;
+}
+
+ulint buf_read_recv_pages(const Page_id *page_ids, ulint n_pages, ulint max_pending) {
+  ulint count{};
+  ulint n_batched{};
+  ulint size{ULINT_UNDEFINED};
+  int64_t tablespace_version{-1};
+  space_id_t space{NULL_SPACE_ID};
+
+  Buf_page_run run(IO_request::Async_read, IO_priority::Prefetch);
+
+  for (ulint i = 0; i < n_pages; ++i) {
+    const auto &page_id = page_ids[i];
+
+    if (page_id.space_id() != space) {
+      space = page_id.space_id();
+      size = srv_fil->space_get_size(space);
+      tablespace_version = srv_fil->space_get_version(space);
+    }
+
+    if (size == ULINT_UNDEFINED) {
+      /* It is a single table tablespace and the .ibd file is
+      missing: do nothing */
+      continue;
+    }
+
+    ulint n_waits{};
+
+    while (srv_buf_pool->get_n_pend_reads() >= max_pending) {
+
+      /* Some of the pending reads may be ours and not submitted yet. */
+      if (n_batched > 0) {
+        run.submit();
+        srv_aio->submit_batch();
+        n_batched = 0;
+      }
+
+      os_thread_sleep(1000);
+
+      if (++n_waits % 10000 == 0) {
 
         log_err(std::format(
           "Waited for 10 seconds for pending reads to the buffer pool to"
           " be finished. Number of pending reads {}. pending pread calls {}",
-          srv_buf_pool->m_n_pend_reads,
+          srv_buf_pool->get_n_pend_reads(),
           os_file_n_pending_preads.load()
         ));
       }
     }
 
-    if ((i + 1 == n_stored) && sync) {
-      buf_read_page(IO_request::Sync_read, false, Page_id(space, page_nos[i]), tablespace_version);
-    } else {
-      buf_read_page(IO_request::Async_read, true, Page_id(space, page_nos[i]), tablespace_version);
+    const auto err = buf_read_page(IO_request::Async_read, true, page_id, tablespace_version, false, &run);
+
+    if (err == DB_SUCCESS) {
+      ++count;
+
+      /* Post the runs that are complete in batches, not one by one. */
+      if (++n_batched >= aio::MAX_IOVECS) {
+        run.submit();
+        srv_aio->submit_batch();
+        n_batched = 0;
+      }
     }
   }
 
+  run.submit();
+
+  srv_aio->submit_batch();
+
   /* Flush pages from the end of the LRU list if necessary */
-  srv_buf_pool->m_flusher->free_margin(srv_dblwr);
+  srv_buf_pool->free_margin(srv_dblwr);
+
+  return count;
 }
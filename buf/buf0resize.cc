@@ -0,0 +1,193 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file buf/buf0resize.cc
+Online resizing of the buffer pool.
+*******************************************************/
+
+#include "buf0resize.h"
+
+#include "buf0buf.h"
+#include "os0thread.h"
+#include "srv0srv.h"
+
+#include <algorithm>
+#include <atomic>
+
+/** The withdrawal waits this long, in microseconds, between passes over the
+blocks that are still in use. */
+constexpr ulint BUF_RESIZE_WITHDRAW_WAIT = 10000;
+
+/** Log a message every this many passes if the withdrawal does not complete. */
+constexpr ulint BUF_RESIZE_WITHDRAW_LOG_INTERVAL = 1000;
+
+/** true while the resize thread is running. */
+static std::atomic<bool> buf_resize_active{};
+
+/** Set when a resize is requested, cleared by the resize thread when it starts resizing. */
+static std::atomic<bool> buf_resize_requested{};
+
+/** Set to tell the resize thread to stop. */
+static std::atomic<bool> buf_resize_abort_requested{};
+
+/**
+ * Shrinks a buffer pool instance.
+ *
+ * @param[in] i                 Index of the instance.
+ * @param[in,out] buf_pool      The instance to shrink.
+ * @param[in] n_chunks          Number of chunks after the resize.
+ *
+ * @return false if the resize was aborted.
+ */
+static bool buf_resize_shrink(ulint i, Buf_pool *buf_pool, ulint n_chunks) {
+  buf_pool->withdraw_start(n_chunks);
+
+  for (ulint n_passes = 1; !buf_pool->withdraw_blocks(); ++n_passes) {
+
+    if (buf_resize_abort_requested.load(std::memory_order_relaxed)) {
+      buf_pool->withdraw_cancel();
+      return false;
+    }
+
+    if (n_passes % BUF_RESIZE_WITHDRAW_LOG_INTERVAL == 0) {
+      log_warn(std::format(
+        "Buffer pool instance {}: still waiting for pages that are in use to be released after {} passes", i, n_passes
+      ));
+    }
+
+    os_thread_sleep(BUF_RESIZE_WITHDRAW_WAIT);
+  }
+
+  buf_pool->withdraw_end();
+
+  return true;
+}
+
+/**
+ * Resizes the buffer pool instances to the size that was requested last.
+ *
+ * @param[in,out] buf_pool      The buffer pool to resize.
+ */
+static void buf_resize(Buf_pool_manager *buf_pool) {
+  const auto pool_size = srv_config.m_buf_pool_size;
+  const auto n_instances = buf_pool->get_n_instances();
+  const auto chunk_size = buf_pool->get_chunk_size();
+  const auto instance_size = pool_size / n_instances;
+
+  auto n_chunks = std::max<ulint>((instance_size + chunk_size - 1) / chunk_size, 1);
+
+  if (n_chunks > Buf_pool::MAX_CHUNKS) {
+    log_warn(std::format(
+      "Buffer pool size {} needs {} chunks of {} bytes per instance, using the maximum of {}",
+      pool_size,
+      n_chunks,
+      chunk_size,
+      Buf_pool::MAX_CHUNKS
+    ));
+
+    n_chunks = Buf_pool::MAX_CHUNKS;
+  }
+
+  const auto old_size = buf_pool->get_curr_size();
+  const auto start_time = ut_time_ms();
+
+  bool aborted{};
+
+  for (ulint i = 0; i < n_instances && !aborted; ++i) {
+    auto instance = buf_pool->get_instance(i);
+
+    if (n_chunks > instance->get_n_chunks()) {
+
+      if (!instance->add_chunks(n_chunks, chunk_size)) {
+        log_err(std::format("Cannot allocate memory to grow buffer pool instance {} to {} chunks", i, n_chunks));
+        break;
+      }
+
+    } else if (n_chunks < instance->get_n_chunks()) {
+
+      aborted = !buf_resize_shrink(i, instance, n_chunks);
+    }
+
+    aborted = aborted || buf_resize_abort_requested.load(std::memory_order_relaxed);
+  }
+
+  srv_config.m_buf_pool_old_size = pool_size;
+  srv_config.m_buf_pool_curr_size = buf_pool->get_curr_size();
+
+  log_info(std::format(
+    "Buffer pool resize {}: from {} MB to {} MB in {} ms",
+    aborted ? "aborted" : "completed",
+    old_size / (1024 * 1024),
+    srv_config.m_buf_pool_curr_size / (1024 * 1024),
+    ut_time_ms() - start_time
+  ));
+}
+
+/**
+ * The resize thread.
+ *
+ * @param[in] arg               The buffer pool to resize.
+ *
+ * @return nullptr.
+ */
+static void *buf_resize_thread(void *arg) {
+  auto buf_pool = static_cast<Buf_pool_manager *>(arg);
+
+  do {
+    while (buf_resize_requested.exchange(false, std::memory_order_acq_rel) &&
+           !buf_resize_abort_requested.load(std::memory_order_relaxed)) {
+
+      buf_resize(buf_pool);
+    }
+
+    buf_resize_active.store(false, std::memory_order_release);
+
+    /* A request that was made after the check above but before the store
+    did not start a thread, handle it here. */
+  } while (buf_resize_requested.load(std::memory_order_acquire) &&
+           !buf_resize_abort_requested.load(std::memory_order_relaxed) &&
+           !buf_resize_active.exchange(true, std::memory_order_acq_rel));
+
+  /* We count the number of threads in os_thread_exit(). A created
+  thread should always use that to exit and not use return() to exit. */
+
+  os_thread_exit();
+
+  return nullptr;
+}
+
+void buf_resize_start(Buf_pool_manager *buf_pool) {
+  buf_resize_requested.store(true, std::memory_order_release);
+
+  if (!buf_resize_active.exchange(true, std::memory_order_acq_rel)) {
+    buf_resize_abort_requested.store(false, std::memory_order_relaxed);
+
+    os_thread_create(buf_resize_thread, buf_pool, nullptr);
+  }
+}
+
+void buf_resize_abort() {
+  buf_resize_abort_requested.store(true, std::memory_order_relaxed);
+
+  while (buf_resize_is_active()) {
+    os_thread_sleep(10000);
+  }
+}
+
+bool buf_resize_is_active() {
+  return buf_resize_active.load(std::memory_order_acquire);
+}
@@ -0,0 +1,193 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file fil/fil0extend.cc
+Background preallocation of the tablespace files and returning of the
+free extents to the file system.
+*******************************************************/
+
+#include "fil0extend.h"
+
+#include "fil0fil.h"
+#include "fsp0fsp.h"
+#include "os0thread.h"
+#include "ut0mem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+Fil_extender *srv_fil_extender{};
+
+Fil_extender::Fil_extender(Fil *fil, FSP *fsp) noexcept : m_fil(fil), m_fsp(fsp) {}
+
+Fil_extender::~Fil_extender() noexcept {
+  ut_a(!is_active());
+}
+
+Fil_extender *Fil_extender::create(Fil *fil, FSP *fsp) noexcept {
+  auto ptr = ut_new(sizeof(Fil_extender));
+
+  return ptr != nullptr ? new (ptr) Fil_extender(fil, fsp) : nullptr;
+}
+
+void Fil_extender::destroy(Fil_extender *&extender) noexcept {
+  call_destructor(extender);
+  ut_delete(extender);
+  extender = nullptr;
+}
+
+void Fil_extender::start() noexcept {
+  ut_a(!is_active());
+
+  m_is_active.store(true, std::memory_order_relaxed);
+
+  os_thread_create(&Fil_extender::thread, this, nullptr);
+
+  log_info("Started the file extender thread");
+}
+
+void Fil_extender::shutdown() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_shutdown = true;
+  }
+
+  m_wakeup_cv.notify_one();
+
+  while (is_active()) {
+    os_thread_sleep(10000);
+  }
+}
+
+void Fil_extender::request(space_id_t space_id) noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_shutdown || std::find(m_queue.begin(), m_queue.end(), space_id) != m_queue.end()) {
+      return;
+    }
+
+    m_queue.push_back(space_id);
+  }
+
+  m_wakeup_cv.notify_one();
+}
+
+void Fil_extender::punch_hole(space_id_t space_id, page_no_t page_no) noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  if (m_shutdown) {
+    return;
+  }
+
+  /* If it is still queued, the extent was allocated and freed again since:
+  the redo log of its pages is newer than the LSN that was noted. */
+  auto &free_extent = m_free_extents[Page_id(space_id, page_no)];
+
+  free_extent.m_lsn = 0;
+  free_extent.m_generation = m_next_generation++;
+}
+
+bool Fil_extender::is_current(const Page_id &page_id, uint64_t generation) noexcept {
+  std::lock_guard<std::mutex> lock(m_mutex);
+
+  auto it = m_free_extents.find(page_id);
+
+  return it != m_free_extents.end() && it->second.m_generation == generation;
+}
+
+void Fil_extender::punch_holes() noexcept {
+  std::vector<std::pair<Page_id, Free_extent>> free_extents;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    free_extents.assign(m_free_extents.begin(), m_free_extents.end());
+  }
+
+  for (auto &[page_id, free_extent] : free_extents) {
+    const auto generation = free_extent.m_generation;
+
+    const auto done = m_fsp->punch_free_extent(page_id.space_id(), page_id.page_no(), free_extent.m_lsn, [&] {
+      return is_current(page_id, generation);
+    });
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto it = m_free_extents.find(page_id);
+
+    if (it == m_free_extents.end() || it->second.m_generation != generation) {
+      /* Freed again meanwhile, the new request replaces ours. */
+      continue;
+    } else if (done) {
+      m_free_extents.erase(it);
+    } else {
+      it->second.m_lsn = free_extent.m_lsn;
+    }
+  }
+}
+
+void *Fil_extender::thread(void *arg) noexcept {
+  auto extender = static_cast<Fil_extender *>(arg);
+
+  for (;;) {
+    space_id_t space_id{};
+    bool preallocate{};
+    bool punch{};
+
+    {
+      std::unique_lock<std::mutex> lock(extender->m_mutex);
+
+      extender->m_wakeup_cv.wait_for(lock, std::chrono::seconds(1), [extender] {
+        return extender->m_shutdown || !extender->m_queue.empty();
+      });
+
+      if (extender->m_shutdown) {
+        extender->m_queue.clear();
+        extender->m_free_extents.clear();
+        break;
+      }
+
+      if (!extender->m_queue.empty()) {
+        space_id = extender->m_queue.front();
+        preallocate = true;
+
+        extender->m_queue.erase(extender->m_queue.begin());
+      } else {
+        /* Nothing to preallocate for a second. */
+        punch = !extender->m_free_extents.empty();
+      }
+    }
+
+    if (preallocate) {
+      extender->m_fil->preallocate(space_id);
+    } else if (punch) {
+      extender->punch_holes();
+    }
+  }
+
+  extender->m_is_active.store(false, std::memory_order_relaxed);
+
+  /* We count the number of threads in os_thread_exit(). A created
+  thread should always use that to exit and not use return() to exit. */
+
+  os_thread_exit();
+
+  return nullptr;
+}
@@ -23,12 +23,15 @@ Created 10/25/1995 Heikki Tuuri
 *******************************************************/
 
 #include <algorithm>
+#include <array>
 #include <filesystem>
 
 #include "buf0buf.h"
+#include "buf0dblwr.h"
 #include "buf0flu.h"
 #include "buf0lru.h"
 #include "dict0dict.h"
+#include "fil0extend.h"
 #include "fil0fil.h"
 #include "fsp0fsp.h"
 #include "log0recv.h"
@@ -39,6 +42,7 @@ Created 10/25/1995 Heikki Tuuri
 #include "os0aio.h"
 #include "os0file.h"
 #include "os0sync.h"
+#include "os0thread.h"
 #include "page0page.h"
 #include "srv0srv.h"
 #include "sync0sync.h"
@@ -141,6 +145,71 @@ Fil::~Fil() noexcept {
   mutex_free(&m_mutex);
 }
 
+Fil::Space_map::~Space_map() noexcept {
+  for (auto &dir_ptr : m_dirs) {
+    auto dir = dir_ptr.load(std::memory_order_relaxed);
+
+    if (dir == nullptr) {
+      continue;
+    }
+
+    for (auto &leaf_ptr : dir->m_leaves) {
+      auto leaf = leaf_ptr.load(std::memory_order_relaxed);
+
+      if (leaf != nullptr) {
+        ut_delete(leaf);
+      }
+    }
+
+    ut_delete(dir);
+  }
+}
+
+fil_space_t *Fil::Space_map::get(space_id_t space_id) const noexcept {
+  auto dir = m_dirs[space_id >> (DIR_BITS + LEAF_BITS)].load(std::memory_order_acquire);
+
+  if (dir == nullptr) {
+    return nullptr;
+  }
+
+  auto leaf = dir->m_leaves[(space_id >> LEAF_BITS) & ((1 << DIR_BITS) - 1)].load(std::memory_order_acquire);
+
+  if (leaf == nullptr) {
+    return nullptr;
+  }
+
+  /* Sequentially consistent, see ut::Rcu::read_lock(). */
+  return leaf->m_spaces[space_id & ((1 << LEAF_BITS) - 1)].load();
+}
+
+void Fil::Space_map::set(space_id_t space_id, fil_space_t *space) noexcept {
+  auto &dir_ptr = m_dirs[space_id >> (DIR_BITS + LEAF_BITS)];
+  auto dir = dir_ptr.load(std::memory_order_relaxed);
+
+  if (dir == nullptr) {
+    if (space == nullptr) {
+      return;
+    }
+
+    dir = new (ut_new(sizeof(Dir))) Dir{};
+    dir_ptr.store(dir, std::memory_order_release);
+  }
+
+  auto &leaf_ptr = dir->m_leaves[(space_id >> LEAF_BITS) & ((1 << DIR_BITS) - 1)];
+  auto leaf = leaf_ptr.load(std::memory_order_relaxed);
+
+  if (leaf == nullptr) {
+    if (space == nullptr) {
+      return;
+    }
+
+    leaf = new (ut_new(sizeof(Leaf))) Leaf{};
+    leaf_ptr.store(leaf, std::memory_order_release);
+  }
+
+  leaf->m_spaces[space_id & ((1 << LEAF_BITS) - 1)].store(space);
+}
+
 const char *Fil::normalize_path(const char *ptr) {
   if (*ptr == '.' && *(ptr + 1) == SRV_PATH_SEPARATOR) {
 
@@ -197,6 +266,20 @@ int64_t Fil::space_get_version(space_id_t id) {
   return version;
 }
 
+bool Fil::space_io_latency(space_id_t id, ut::Latency_histogram::Snapshot &snapshot) {
+  mutex_enter(&m_mutex);
+
+  auto space = space_get_by_id(id);
+
+  if (space != nullptr) {
+    space->m_io_latency.add_to(snapshot);
+  }
+
+  mutex_exit(&m_mutex);
+
+  return space != nullptr;
+}
+
 rw_lock_t *Fil::space_get_latch(space_id_t id) {
   mutex_enter(&m_mutex);
 
@@ -237,17 +320,20 @@ void Fil::node_create(const char *name, ulint size, space_id_t id, bool is_raw)
 
   node->m_file_name = mem_strdup(name);
   node->open = false;
+  node->m_fixed_fh = -1;
 
   ut_a(!is_raw || srv_start_raw_disk_in_use);
 
   node->m_is_raw_disk = is_raw;
   node->m_size_in_pages = size;
+  node->m_alloc_size_in_pages = size;
   node->m_magic_n = FIL_NODE_MAGIC_N;
   node->m_n_pending = 0;
   node->m_n_pending_flushes = 0;
 
   node->m_modification_counter = 0;
   node->m_flush_counter = 0;
+  node->m_needs_fsync = true;
 
   auto space = space_get_by_id(id);
 
@@ -267,6 +353,10 @@ void Fil::node_create(const char *name, ulint size, space_id_t id, bool is_raw)
     UT_LIST_ADD_LAST(space->m_chain, node);
     ut_a(UT_LIST_GET_LEN(space->m_chain) == 1 || space->m_type == FIL_LOG);
 
+    if (space->m_type != FIL_LOG) {
+      m_space_map.set(id, space);
+    }
+
     if (id < SRV_LOG_SPACE_FIRST_ID && m_max_assigned_id < id) {
 
       m_max_assigned_id = id;
@@ -281,7 +371,7 @@ void Fil::node_open_file(fil_node_t *node, fil_space_t *space, bool startup) {
   bool success;
 
   ut_ad(mutex_own(&m_mutex));
-  ut_a(node->m_n_pending == 0);
+  ut_a(node->n_pending() == 0);
   ut_a(node->open == false);
 
   if (node->m_size_in_pages == 0) {
@@ -356,6 +446,7 @@ void Fil::node_open_file(fil_node_t *node, fil_space_t *space, bool startup) {
     }
 
     node->m_size_in_pages = ulint(size_bytes / UNIV_PAGE_SIZE);
+    node->m_alloc_size_in_pages = node->m_size_in_pages;
 
     space->m_size_in_pages += node->m_size_in_pages;
   }
@@ -378,16 +469,25 @@ void Fil::node_open_file(fil_node_t *node, fil_space_t *space, bool startup) {
 
   node->open = true;
 
+  srv_aio->register_file(node);
+
   ++m_n_open;
+
+  node_enable_lock_free_io(node, space);
 }
 
 void Fil::node_close_file(fil_node_t *node) {
   ut_ad(mutex_own(&m_mutex));
   ut_a(node->open);
-  ut_a(node->m_n_pending == 0);
+
+  node_disable_lock_free_io(node);
+
+  ut_a(node->n_pending() == 0);
   ut_a(node->m_n_pending_flushes == 0);
   ut_a(node->m_modification_counter == node->m_flush_counter);
 
+  srv_aio->unregister_file(node);
+
   auto ret = os_file_close(node->m_fh);
   ut_a(ret);
 
@@ -475,7 +575,7 @@ void Fil::mutex_enter_and_prepare_for_io(space_id_t space_id) {
 void Fil::node_free(fil_node_t *node, fil_space_t *space) {
   ut_ad(mutex_own(&(m_mutex)));
   ut_a(node->m_magic_n == FIL_NODE_MAGIC_N);
-  ut_a(node->m_n_pending == 0);
+  ut_a(node->n_pending() == 0);
 
   if (node->open) {
     /* We fool the assertion in fil_node_close_file() to think
@@ -572,6 +672,8 @@ try_again:
 
   space = static_cast<fil_space_t *>(mem_alloc(sizeof(fil_space_t)));
 
+  new (&space->m_io_latency) ut::Latency_histogram();
+
   space->m_name = mem_strdup(name);
   space->m_id = id;
 
@@ -586,6 +688,7 @@ try_again:
 
   space->m_stop_ios = false;
   space->m_is_being_deleted = false;
+  space->m_is_extending = false;
   space->m_type = fil_type;
   space->m_size_in_pages = 0;
   space->m_flags = flags;
@@ -593,6 +696,7 @@ try_again:
   space->m_n_reserved_extents = 0;
 
   space->m_n_pending_flushes = 0;
+  space->m_n_pending_ops = 0;
 
   UT_LIST_INIT(space->m_chain);
   space->m_magic_n = FIL_SPACE_MAGIC_N;
@@ -679,6 +783,11 @@ bool Fil::space_free(space_id_t id, bool own_mutex) {
     ut_a(r == 1);
   }
 
+  /* Wait for the lock-free lookups that may have found the space, see
+  node_try_prepare_for_data_io(). */
+  m_space_map.set(id, nullptr);
+  m_rcu.synchronize();
+
   {
     auto found_space = space_get_by_name(space->m_name);
     ut_a(found_space != nullptr);
@@ -1177,17 +1286,20 @@ bool Fil::delete_tablespace(space_id_t id) {
 
     auto node = UT_LIST_GET_FIRST(space->m_chain);
 
-    if (space->m_n_pending_flushes == 0 && node->m_n_pending == 0) {
+    node_disable_lock_free_io(node);
+
+    if (space->m_n_pending_flushes == 0 && node->n_pending() == 0 && space->m_n_pending_ops == 0) {
       return delete_file(id, space->m_name);
     }
 
     if (!(count % 1000)) {
       log_warn(std::format(
-        "Trying to delete tablespace {}, but there are {} flushes and {}"
-        " pending i/o's on it, loop count {}.",
+        "Trying to delete tablespace {}, but there are {} flushes, {}"
+        " pending i/o's and {} pending operations on it, loop count {}.",
         space->m_name,
         space->m_n_pending_flushes,
-        node->m_n_pending,
+        node->n_pending(),
+        space->m_n_pending_ops,
         count
       ));
     }
@@ -1304,6 +1416,7 @@ retry:
 
   if (count > 25000) {
     space->m_stop_ios = false;
+    node_enable_lock_free_io(UT_LIST_GET_FIRST(space->m_chain), space);
     mutex_exit(&m_mutex);
 
     return false;
@@ -1319,7 +1432,9 @@ retry:
 
   node = UT_LIST_GET_FIRST(space->m_chain);
 
-  if (node->m_n_pending > 0 || node->m_n_pending_flushes > 0) {
+  node_disable_lock_free_io(node);
+
+  if (node->n_pending() > 0 || node->m_n_pending_flushes > 0) {
     /* There are pending i/o's or flushes, sleep for a while and
     retry */
 
@@ -1377,6 +1492,8 @@ retry:
 
   space->m_stop_ios = false;
 
+  node_enable_lock_free_io(node, space);
+
   mutex_exit(&m_mutex);
 
   if (success) {
@@ -1484,7 +1601,7 @@ db_err Fil::create_new_single_table_tablespace(space_id_t *space_id, const char
 
   mach_write_to_4(page + FIL_PAGE_SPACE_ID, *space_id);
 
-  srv_buf_pool->m_flusher->init_for_writing(page, 0);
+  Buf_flush::init_for_writing(page, 0);
 
   ret = os_file_write(path, file, page, UNIV_PAGE_SIZE, 0);
 
@@ -2034,73 +2151,259 @@ ulint Fil::get_space_id_for_table(const char *name) {
   return space_id;
 }
 
+page_no_t Fil::preallocate_n_pages(const fil_node_t *node) noexcept {
+  const auto n_pages = page_no_t(srv_config.m_file_preallocate_size * ((1024 * 1024) / UNIV_PAGE_SIZE));
+
+  return std::min<page_no_t>(n_pages, node->m_size_in_pages);
+}
+
+void Fil::request_preallocation(const fil_space_t *space, const fil_node_t *node) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+
+  if (srv_fil_extender == nullptr || space->m_type != FIL_TABLESPACE || space->m_id == SYS_TABLESPACE || node->m_is_raw_disk) {
+    return;
+  }
+
+  const auto n_pages = preallocate_n_pages(node);
+
+  /* Top up when half of the preallocated pages have been used. */
+  if (n_pages > 0 && node->m_alloc_size_in_pages - node->m_size_in_pages < n_pages / 2) {
+    srv_fil_extender->request(space->m_id);
+  }
+}
+
 bool Fil::extend_space_to_desired_size(page_no_t *actual_size, space_id_t space_id, page_no_t size_after_extend) {
-  mutex_enter_and_prepare_for_io(space_id);
+  fil_space_t *space;
 
-  auto space = space_get_by_id(space_id);
+  for (;;) {
+    mutex_enter_and_prepare_for_io(space_id);
+
+    space = space_get_by_id(space_id);
+
+    if (space->m_size_in_pages >= size_after_extend) {
+      *actual_size = space->m_size_in_pages;
+
+      mutex_exit(&m_mutex);
+
+      return true;
+    }
+
+    const auto node = UT_LIST_GET_LAST(space->m_chain);
 
-  if (space->m_size_in_pages >= size_after_extend) {
-    *actual_size = space->m_size_in_pages;
+    /* The pages that were already allocated in the file can be handed out
+    while the space is being extended further. */
+    if (!space->m_is_extending || node->m_alloc_size_in_pages - node->m_size_in_pages >= size_after_extend - space->m_size_in_pages) {
+      break;
+    }
 
+    /* Another thread is allocating pages for the space, they may be all that
+    we need. */
     mutex_exit(&m_mutex);
 
-    return true;
+    os_thread_sleep(1000);
   }
 
-  auto page_size = UNIV_PAGE_SIZE;
-
+  const auto page_size = off_t(UNIV_PAGE_SIZE);
+  const page_no_t n_pages = size_after_extend - space->m_size_in_pages;
   auto node = UT_LIST_GET_LAST(space->m_chain);
 
-  node_prepare_for_io(node, space);
+  bool success{true};
+  bool flush_space{};
 
-  auto start_page_no = space->m_size_in_pages;
-  /* Extend at most 64 pages at a time */
-  auto buf_size = std::min<ulint>(64, size_after_extend - start_page_no) * page_size;
-  auto buf2 = static_cast<byte *>(mem_alloc(buf_size + page_size));
-  auto buf = static_cast<byte *>(ut_align(buf2, page_size));
+  if (node->m_alloc_size_in_pages - node->m_size_in_pages < n_pages) {
+    /* The file extender hasn't kept up or is disabled, allocate the pages
+    ourselves. Other extensions of the space wait until we are done. */
+    ++m_n_foreground_extends;
 
-  memset(buf, 0, buf_size);
+    node_prepare_for_io(node, space);
 
-  bool success{true};
-  auto io_request = IO_request::Sync_write;
+    space->m_is_extending = true;
 
-  while (start_page_no < size_after_extend) {
-    const ulint n_pages = std::min<ulint>(buf_size / page_size, size_after_extend - start_page_no);
-    const off_t off = off_t(start_page_no) * page_size;
+    const auto start_page_no = node->m_alloc_size_in_pages;
+    const auto end_page_no = node->m_size_in_pages + n_pages;
 
-    IO_ctx io_ctx = {.m_batch = false, .m_fil_node = node, .m_msg = nullptr, .m_io_request = io_request};
+    mutex_exit(&m_mutex);
 
-    success = srv_aio->submit(std::move(io_ctx), buf, page_size * n_pages, off);
+    success = os_file_extend(
+      node->m_file_name, node->m_fh, off_t(start_page_no) * page_size, off_t(end_page_no - start_page_no) * page_size
+    );
+
+    mutex_enter(&m_mutex);
+
+    /* Even a failed extension may have changed the size of the file. */
+    node->m_needs_fsync = true;
 
     if (success) {
-      node->m_size_in_pages += n_pages;
-      space->m_size_in_pages += n_pages;
+      /* The file extender may have published a larger size meanwhile. */
+      node->m_alloc_size_in_pages = std::max(node->m_alloc_size_in_pages, end_page_no);
 
       os_has_said_disk_full = false;
     } else {
       /* Let us measure the size of the file to determine how much we were able
-       * to extend it */
+      to extend it */
+      const auto file_size = page_no_t(os_file_get_size_as_iblonglong(node->m_fh) / page_size);
 
-      auto n_pages = ((ulint)(os_file_get_size_as_iblonglong(node->m_fh) / page_size)) - node->m_size_in_pages;
+      node->m_alloc_size_in_pages = std::max(node->m_alloc_size_in_pages, file_size);
+    }
 
-      node->m_size_in_pages += n_pages;
-      space->m_size_in_pages += n_pages;
+    space->m_is_extending = false;
 
-      break;
-    }
+    node_complete_io(node, IO_request::Sync_write);
 
-    start_page_no += n_pages;
+    flush_space = true;
   }
 
-  mem_free(buf2);
+  /* The pages were already allocated in the file, handing them out is enough. */
+  const auto n_added = std::min<page_no_t>(n_pages, node->m_alloc_size_in_pages - node->m_size_in_pages);
 
-  node_complete_io(node, io_request);
+  node->m_size_in_pages += n_added;
+  space->m_size_in_pages += n_added;
 
   *actual_size = space->m_size_in_pages;
 
+  request_preallocation(space, node);
+
   mutex_exit(&m_mutex);
 
-  flush(space_id);
+  if (flush_space) {
+    flush(space_id);
+  }
+
+  return success;
+}
+
+void Fil::preallocate(space_id_t space_id) {
+  mutex_enter_and_prepare_for_io(space_id);
+
+  auto space = space_get_by_id(space_id);
+
+  if (space == nullptr || space->m_is_being_deleted || space->m_stop_ios || space->m_is_extending) {
+    /* A foreground extension asks again when it is done. */
+    mutex_exit(&m_mutex);
+
+    return;
+  }
+
+  auto node = UT_LIST_GET_LAST(space->m_chain);
+  const auto end_page_no = node->m_size_in_pages + preallocate_n_pages(node);
+
+  if (node->m_alloc_size_in_pages >= end_page_no) {
+    mutex_exit(&m_mutex);
+
+    return;
+  }
+
+  /* The pending i/o keeps the file open and the space from being dropped. */
+  node_prepare_for_io(node, space);
+
+  space->m_is_extending = true;
+
+  const auto start_page_no = node->m_alloc_size_in_pages;
+
+  mutex_exit(&m_mutex);
+
+  const auto page_size = off_t(UNIV_PAGE_SIZE);
+
+  auto success = os_file_extend(
+    node->m_file_name, node->m_fh, off_t(start_page_no) * page_size, off_t(end_page_no - start_page_no) * page_size
+  );
+
+  /* The flush below doesn't change the file, a foreground extension needn't
+  wait for it. The new pages are only published after it. */
+  mutex_enter(&m_mutex);
+
+  space->m_is_extending = false;
+
+  mutex_exit(&m_mutex);
+
+  /* The pages are later handed out without flushing the file, make the new
+  file size durable now. */
+  if (success) {
+    success = os_file_flush(node->m_fh);
+  }
+
+  mutex_enter(&m_mutex);
+
+  if (success) {
+    node->m_alloc_size_in_pages = std::max(node->m_alloc_size_in_pages, end_page_no);
+
+    ++m_n_preallocations;
+  }
+
+  /* Nothing was written that needs a flush. */
+  node_complete_io(node, IO_request::Sync_read);
+
+  mutex_exit(&m_mutex);
+}
+
+bool Fil::space_acquire(space_id_t space_id) {
+  mutex_enter(&m_mutex);
+
+  auto space = space_get_by_id(space_id);
+  const auto found = space != nullptr && !space->m_is_being_deleted;
+
+  if (found) {
+    ++space->m_n_pending_ops;
+  }
+
+  mutex_exit(&m_mutex);
+
+  return found;
+}
+
+void Fil::space_release(space_id_t space_id) {
+  mutex_enter(&m_mutex);
+
+  auto space = space_get_by_id(space_id);
+
+  ut_a(space->m_n_pending_ops > 0);
+
+  --space->m_n_pending_ops;
+
+  mutex_exit(&m_mutex);
+}
+
+bool Fil::punch_hole(space_id_t space_id, page_no_t page_no, page_no_t n_pages) {
+  mutex_enter_and_prepare_for_io(space_id);
+
+  auto space = space_get_by_id(space_id);
+
+  if (space == nullptr || space->m_is_being_deleted || space->m_stop_ios) {
+    mutex_exit(&m_mutex);
+
+    return false;
+  }
+
+  /* Find the file that contains the pages, the extents don't span files. */
+  auto node = UT_LIST_GET_FIRST(space->m_chain);
+
+  while (node != nullptr && node->m_size_in_pages <= page_no) {
+    page_no -= node->m_size_in_pages;
+    node = UT_LIST_GET_NEXT(m_chain, node);
+  }
+
+  if (node == nullptr || node->m_is_raw_disk || node->m_size_in_pages - page_no < n_pages) {
+    mutex_exit(&m_mutex);
+
+    return false;
+  }
+
+  node_prepare_for_io(node, space);
+
+  mutex_exit(&m_mutex);
+
+  const auto page_size = off_t(UNIV_PAGE_SIZE);
+  const auto success = os_file_punch_hole(node->m_file_name, node->m_fh, off_t(page_no) * page_size, off_t(n_pages) * page_size);
+
+  mutex_enter(&m_mutex);
+
+  if (success) {
+    ++m_n_punched_holes;
+  }
+
+  node_complete_io(node, IO_request::Sync_write);
+
+  mutex_exit(&m_mutex);
 
   return success;
 }
@@ -2157,7 +2460,7 @@ void Fil::node_prepare_for_io(fil_node_t *node, fil_space_t *space) {
 
   if (node->open == false) {
     /* File is closed: open it */
-    ut_a(node->m_n_pending == 0);
+    ut_a(node->n_pending() == 0);
 
     node_open_file(node, space, false);
   }
@@ -2165,23 +2468,116 @@ void Fil::node_prepare_for_io(fil_node_t *node, fil_space_t *space) {
   node->m_n_pending++;
 }
 
+void Fil::node_enable_lock_free_io(fil_node_t *node, const fil_space_t *space) noexcept {
+  if (node->open && !space->m_stop_ios && !space->m_is_being_deleted && space->m_type != FIL_LOG) {
+    node->m_n_pending.fetch_or(FIL_NODE_LOCK_FREE_IO);
+  }
+}
+
+void Fil::node_disable_lock_free_io(fil_node_t *node) noexcept {
+  node->m_n_pending.fetch_and(~FIL_NODE_LOCK_FREE_IO);
+}
+
+fil_node_t *Fil::node_try_prepare_for_data_io(space_id_t space_id) noexcept {
+  fil_node_t *node{};
+  auto token = m_rcu.read_lock();
+
+  if (auto space = m_space_map.get(space_id); space != nullptr) {
+    node = UT_LIST_GET_FIRST(space->m_chain);
+
+    /* The pending count can only be incremented while the flag is set.
+    The threads that close the file or drop the space clear it first
+    and then wait for the count to drop to zero. */
+    auto n_pending = node->m_n_pending.load(std::memory_order_relaxed);
+
+    do {
+      if (!(n_pending & FIL_NODE_LOCK_FREE_IO)) {
+        node = nullptr;
+        break;
+      }
+    } while (!node->m_n_pending.compare_exchange_weak(n_pending, n_pending + 1, std::memory_order_acquire));
+  }
+
+  m_rcu.read_unlock(token);
+
+  return node;
+}
+
+bool Fil::node_note_write(fil_node_t *node) noexcept {
+  const auto counter = m_modification_counter.fetch_add(1) + 1;
+
+  for (auto old_counter = node->m_modification_counter.load(); old_counter < counter;) {
+    if (node->m_modification_counter.compare_exchange_weak(old_counter, counter)) {
+      break;
+    }
+  }
+
+  /* Read after the counter was bumped, pairs with the re-check in
+  space_remove_from_unflushed_if_flushed(). */
+  return !node->m_space->m_is_in_unflushed_spaces.load();
+}
+
+void Fil::space_add_to_unflushed(fil_space_t *space) {
+  ut_ad(mutex_own(&m_mutex));
+
+  if (!space->m_is_in_unflushed_spaces) {
+
+    space->m_is_in_unflushed_spaces = true;
+    UT_LIST_ADD_FIRST(m_unflushed_spaces, space);
+  }
+}
+
+void Fil::space_remove_from_unflushed_if_flushed(fil_space_t *space) {
+  ut_ad(mutex_own(&m_mutex));
+
+  if (space->m_is_in_unflushed_spaces && space_is_flushed(space)) {
+
+    /* A write may complete without the mutex. Clear the flag before
+    checking again, then either we see the write or the write sees the
+    flag cleared and waits for the mutex to add the space back. */
+    space->m_is_in_unflushed_spaces = false;
+
+    if (space_is_flushed(space)) {
+      UT_LIST_REMOVE(m_unflushed_spaces, space);
+    } else {
+      space->m_is_in_unflushed_spaces = true;
+    }
+  }
+}
+
 void Fil::node_complete_io(fil_node_t *node, IO_request io_request) {
   ut_ad(mutex_own(&m_mutex));
 
-  ut_a(node->m_n_pending > 0);
+  /* The asynchronous writes must be flushed too, the doublewrite batches
+  and the data file writes that follow them rely on it. */
+  if (io_request == IO_request::Sync_write || io_request == IO_request::Async_write) {
+    if (node_note_write(node)) {
+      space_add_to_unflushed(node->m_space);
+    }
+  }
+
+  /* Release the file last, see rename_tablespace(). */
+  const auto n_pending = node->m_n_pending.fetch_sub(1, std::memory_order_release);
 
-  --node->m_n_pending;
+  ut_a((n_pending & ~FIL_NODE_LOCK_FREE_IO) > 0);
+}
+
+void Fil::node_complete_data_io(fil_node_t *node, IO_request io_request) {
+  ut_ad(!mutex_own(&m_mutex));
 
-  if (io_request == IO_request::Sync_write) {
-    ++m_modification_counter;
-    node->m_modification_counter = m_modification_counter;
+  if (io_request == IO_request::Sync_write || io_request == IO_request::Async_write) {
+    if (node_note_write(node)) {
+      mutex_enter(&m_mutex);
 
-    if (!node->m_space->m_is_in_unflushed_spaces) {
+      space_add_to_unflushed(node->m_space);
 
-      node->m_space->m_is_in_unflushed_spaces = true;
-      UT_LIST_ADD_FIRST(m_unflushed_spaces, node->m_space);
+      mutex_exit(&m_mutex);
     }
   }
+
+  const auto n_pending = node->m_n_pending.fetch_sub(1, std::memory_order_release);
+
+  ut_a((n_pending & ~FIL_NODE_LOCK_FREE_IO) > 0);
 }
 
 [[noreturn]] void Fil::report_invalid_page_access(
@@ -2330,42 +2726,20 @@ db_err Fil::log_io(
   return DB_SUCCESS;
 }
 
-db_err Fil::data_io(
-  IO_request io_request, bool batched, const Page_id &page_id, ulint byte_offset, ulint len, void *buf, void *message
-) {
-
-  ut_ad(len > 0);
-  ut_ad(buf != nullptr);
-  ut_ad(byte_offset < UNIV_PAGE_SIZE);
+fil_node_t *Fil::node_prepare_for_data_io(IO_request io_request, const Page_id &page_id, ulint byte_offset, ulint len) {
+  if (auto fil_node = node_try_prepare_for_data_io(page_id.space_id()); likely(fil_node != nullptr)) {
+    auto space = fil_node->m_space;
 
-  static_assert((1 << UNIV_PAGE_SIZE_SHIFT) == UNIV_PAGE_SIZE, "error (1 << UNIV_PAGE_SIZE_SHIFT) != UNIV_PAGE_SIZE");
+    /* The size only grows while the file is open for lock-free i/o and a
+    page is only accessed after the extension that added it, a relaxed load
+    is enough for the bounds check. */
+    if (fil_node->m_size_in_pages.load(std::memory_order_relaxed) <= page_id.page_no() && space->m_id != SYS_TABLESPACE &&
+        space->m_type == FIL_TABLESPACE) {
 
-  ut_ad(validate());
-
-  bool is_sync_request{};
-
-  switch (io_request) {
-    case IO_request::None:
-    case IO_request::Sync_log_read:
-    case IO_request::Async_log_read:
-    case IO_request::Sync_log_write:
-    case IO_request::Async_log_write:
-      ut_error;
-      break;
-
-    case IO_request::Sync_read:
-      is_sync_request = true;
-      // falthrough
-    case IO_request::Async_read:
-      srv_data_read += len;
-      break;
+      report_invalid_page_access(page_id, space->m_name, byte_offset, len, io_request);
+    }
 
-    case IO_request::Sync_write:
-      is_sync_request = true;
-      // falthrough
-    case IO_request::Async_write:
-      srv_data_written += len;
-      break;
+    return fil_node;
   }
 
   /* Reserve the Fil::system mutex and make sure that we can open at
@@ -2387,7 +2761,7 @@ db_err Fil::data_io(
       len
     ));
 
-    return DB_TABLESPACE_DELETED;
+    return nullptr;
   }
 
   /* Only one data file per space is supported */
@@ -2412,6 +2786,54 @@ db_err Fil::data_io(
   /* Now we have made the changes in the data structures of Fil::system */
   mutex_exit(&m_mutex);
 
+  return fil_node;
+}
+
+db_err Fil::data_io(
+  IO_request io_request, bool batched, const Page_id &page_id, ulint byte_offset, ulint len, void *buf, void *message,
+  IO_priority priority
+) {
+
+  ut_ad(len > 0);
+  ut_ad(buf != nullptr);
+  ut_ad(byte_offset < UNIV_PAGE_SIZE);
+
+  static_assert((1 << UNIV_PAGE_SIZE_SHIFT) == UNIV_PAGE_SIZE, "error (1 << UNIV_PAGE_SIZE_SHIFT) != UNIV_PAGE_SIZE");
+
+  ut_ad(validate());
+
+  bool is_sync_request{};
+
+  switch (io_request) {
+    case IO_request::None:
+    case IO_request::Sync_log_read:
+    case IO_request::Async_log_read:
+    case IO_request::Sync_log_write:
+    case IO_request::Async_log_write:
+      ut_error;
+      break;
+
+    case IO_request::Sync_read:
+      is_sync_request = true;
+      // falthrough
+    case IO_request::Async_read:
+      srv_data_read += len;
+      break;
+
+    case IO_request::Sync_write:
+      is_sync_request = true;
+      // falthrough
+    case IO_request::Async_write:
+      srv_data_written += len;
+      break;
+  }
+
+  auto fil_node = node_prepare_for_data_io(io_request, page_id, byte_offset, len);
+
+  if (fil_node == nullptr) {
+    return DB_TABLESPACE_DELETED;
+  }
+
   /* Calculate the low 32 bits and the high 32 bits of the file offset */
 
   const off_t off = (off_t(page_id.page_no()) * off_t(UNIV_PAGE_SIZE)) + byte_offset;
@@ -2423,7 +2845,9 @@ db_err Fil::data_io(
   ut_a(byte_offset % IB_FILE_BLOCK_SIZE == 0);
   ut_a((len % IB_FILE_BLOCK_SIZE) == 0);
 
-  IO_ctx io_ctx = {.m_batch = batched, .m_fil_node = fil_node, .m_msg = message, .m_io_request = io_request};
+  IO_ctx io_ctx = {
+    .m_batch = batched, .m_fil_node = fil_node, .m_msg = message, .m_io_request = io_request, .m_priority = priority
+  };
 
   /* Queue the aio request */
   auto err = srv_aio->submit(std::move(io_ctx), buf, len, off);
@@ -2432,15 +2856,66 @@ db_err Fil::data_io(
   if (is_sync_request) {
     /* The i/o operation is already completed when we return from os_aio: */
 
-    mutex_enter(&m_mutex);
+    node_complete_data_io(fil_node, io_request);
 
-    node_complete_io(fil_node, io_request);
+    ut_ad(validate());
+  }
 
-    mutex_exit(&m_mutex);
+  return DB_SUCCESS;
+}
 
-    ut_ad(validate());
+db_err Fil::data_io_vec(
+  IO_request io_request, bool batched, const Page_id &page_id, ulint n_pages, byte *const *frames, void *const *messages,
+  IO_priority priority
+) {
+  ut_a(n_pages > 1 && n_pages <= aio::MAX_IOVECS);
+  ut_a(io_request == IO_request::Async_read || io_request == IO_request::Async_write);
+
+  ut_ad(validate());
+
+  const auto len = n_pages * UNIV_PAGE_SIZE;
+
+  if (io_request == IO_request::Async_read) {
+    srv_data_read += len;
+  } else {
+    srv_data_written += len;
+  }
+
+  auto fil_node = node_prepare_for_data_io(io_request, page_id, 0, len);
+
+  if (fil_node == nullptr) {
+    return DB_TABLESPACE_DELETED;
+  }
+
+  ut_a(fil_node->m_size_in_pages - page_id.page_no() >= n_pages);
+
+  const off_t off = off_t(page_id.page_no()) * off_t(UNIV_PAGE_SIZE);
+
+  std::array<iovec, aio::MAX_IOVECS> iov;
+
+  /* Freed in aio_wait() after the completion of every page was handled. */
+  auto msgs = static_cast<void **>(mem_alloc(n_pages * sizeof(void *)));
+
+  for (ulint i = 0; i < n_pages; ++i) {
+    ut_ad(frames[i] != nullptr);
+
+    iov[i].iov_base = frames[i];
+    iov[i].iov_len = UNIV_PAGE_SIZE;
+    msgs[i] = messages[i];
   }
 
+  IO_ctx io_ctx = {
+    .m_batch = batched,
+    .m_fil_node = fil_node,
+    .m_msg = msgs,
+    .m_io_request = io_request,
+    .m_n_msgs = uint32_t(n_pages),
+    .m_priority = priority
+  };
+
+  auto err = srv_aio->submit(std::move(io_ctx), iov.data(), n_pages, off);
+  ut_a(err == DB_SUCCESS);
+
   return DB_SUCCESS;
 }
 
@@ -2458,11 +2933,7 @@ bool Fil::aio_wait(ulint segment) {
   ut_a(io_ctx.m_ret > 0);
   ut_a(err == DB_SUCCESS);
 
-  mutex_enter(&m_mutex);
-
-  node_complete_io(io_ctx.m_fil_node, io_ctx.m_io_request);
-
-  mutex_exit(&m_mutex);
+  node_complete_data_io(io_ctx.m_fil_node, io_ctx.m_io_request);
 
   ut_ad(validate());
 
@@ -2472,8 +2943,22 @@ bool Fil::aio_wait(ulint segment) {
   deadlocks in the i/o system. We keep tablespace 0 data files always
   open, and use a special i/o thread to serve insert buffer requests. */
 
-  if (io_ctx.m_fil_node->m_space->m_type == FIL_TABLESPACE) {
+  if (io_ctx.m_n_msgs > 1) {
+    /* A vectored request, see data_io_vec(). */
+    auto msgs = static_cast<void **>(io_ctx.m_msg);
+
+    ut_a(io_ctx.m_fil_node->m_space->m_type == FIL_TABLESPACE);
+
+    for (ulint i = 0; i < io_ctx.m_n_msgs; ++i) {
+      srv_buf_pool->io_complete(reinterpret_cast<Buf_page *>(msgs[i]));
+    }
+
+    mem_free(msgs);
+
+  } else if (io_ctx.m_fil_node->m_space->m_type == FIL_TABLESPACE) {
     srv_buf_pool->io_complete(reinterpret_cast<Buf_page *>(io_ctx.m_msg));
+  } else if (io_ctx.m_fil_node->m_space->m_type == FIL_DBLWR) {
+    srv_dblwr->io_complete(reinterpret_cast<DBLWR::Batch *>(io_ctx.m_msg));
   } else {
     log_sys->io_complete(reinterpret_cast<log_group_t *>(io_ctx.m_msg));
   }
@@ -2483,6 +2968,7 @@ bool Fil::aio_wait(ulint segment) {
 
 void Fil::flush(space_id_t space_id) {
   os_file_t file;
+  bool data_only;
   int64_t old_mod_counter;
 
   mutex_enter(&m_mutex);
@@ -2508,7 +2994,7 @@ void Fil::flush(space_id_t space_id) {
       old_mod_counter */
       old_mod_counter = node->m_modification_counter;
 
-      if (space->m_type == FIL_TABLESPACE) {
+      if (space->m_type != FIL_LOG) {
         ++m_n_pending_tablespace_flushes;
       } else {
         ++m_n_pending_log_flushes;
@@ -2539,9 +3025,13 @@ void Fil::flush(space_id_t space_id) {
       file = node->m_fh;
       node->m_n_pending_flushes++;
 
+      data_only = !node->m_needs_fsync;
+
+      node->m_needs_fsync = false;
+
       mutex_exit(&m_mutex);
 
-      os_file_flush(file);
+      os_file_flush(file, data_only);
 
       mutex_enter(&m_mutex);
 
@@ -2551,15 +3041,10 @@ void Fil::flush(space_id_t space_id) {
       if (node->m_flush_counter < old_mod_counter) {
         node->m_flush_counter = old_mod_counter;
 
-        if (space->m_is_in_unflushed_spaces && space_is_flushed(space)) {
-
-          space->m_is_in_unflushed_spaces = false;
-
-          UT_LIST_REMOVE(m_unflushed_spaces, space);
-        }
+        space_remove_from_unflushed_if_flushed(space);
       }
 
-      if (space->m_type == FIL_TABLESPACE) {
+      if (space->m_type != FIL_LOG) {
         --m_n_pending_tablespace_flushes;
       } else {
         --m_n_pending_log_flushes;
@@ -2575,38 +3060,142 @@ void Fil::flush(space_id_t space_id) {
 }
 
 void Fil::flush_file_spaces(ulint purpose) {
-  mutex_enter(&m_mutex);
+  flush_spaces_low(purpose, nullptr);
+}
+
+void Fil::flush_spaces(const std::vector<space_id_t> &space_ids) {
+  ut_ad(std::is_sorted(space_ids.begin(), space_ids.end()));
+
+  if (!space_ids.empty()) {
+    flush_spaces_low(FIL_TABLESPACE, &space_ids);
+  }
+}
+
+void Fil::flush_spaces_low(ulint purpose, const std::vector<space_id_t> *space_ids) {
+  /* A file being flushed. */
+  struct Flush {
+    /** Space of the file. */
+    fil_space_t *m_space;
 
-  auto n_space_ids = UT_LIST_GET_LEN(m_unflushed_spaces);
+    /** File to flush. */
+    fil_node_t *m_node;
 
-  if (n_space_ids == 0) {
+    /** The flush covers the writes up to this modification counter value. */
+    int64_t m_mod_counter;
+  };
+
+  mutex_enter(&m_mutex);
+
+  if (UT_LIST_GET_LEN(m_unflushed_spaces) == 0) {
     mutex_exit(&m_mutex);
     return;
   }
 
-  /* Assemble a list of space ids to flush.  Previously, we
-  traversed unflushed_spaces and called UT_LIST_GET_NEXT()
-  on a space that was just removed from the list by Fil::flush().
-  Thus, the space could be dropped and the memory overwritten. */
+  std::vector<Flush> flushes;
+  std::vector<aio::Fsync_request> requests;
 
-  std::vector<space_id_t> space_ids;
-
-  space_ids.reserve(n_space_ids + 1);
+  /* Spaces with a file that another thread is flushing, Fil::flush() waits for it. */
+  std::vector<space_id_t> busy_space_ids;
 
   for (auto space : m_unflushed_spaces) {
-    if (space->m_type == purpose && !space->m_is_being_deleted) {
-      space_ids.push_back(space->m_id);
+    if (space->m_type != Fil_type(purpose) || space->m_is_being_deleted) {
+      continue;
     }
-  }
 
-  space_ids.push_back(FIL_NULL);
+    if (space_ids != nullptr && !std::binary_search(space_ids->begin(), space_ids->end(), space->m_id)) {
+      continue;
+    }
+
+    for (auto node : space->m_chain) {
+      if (node->m_modification_counter <= node->m_flush_counter) {
+        continue;
+      }
+
+      ut_a(node->open);
+
+      if (node->m_n_pending_flushes > 0) {
+        if (busy_space_ids.empty() || busy_space_ids.back() != space->m_id) {
+          busy_space_ids.push_back(space->m_id);
+        }
+        continue;
+      }
+
+      /* Prevent dropping of the space and closing of the file while we are flushing */
+      ++space->m_n_pending_flushes;
+      ++node->m_n_pending_flushes;
+
+      if (space->m_type != FIL_LOG) {
+        ++m_n_pending_tablespace_flushes;
+      } else {
+        ++m_n_pending_log_flushes;
+        ++m_n_log_flushes;
+      }
+
+      flushes.push_back(Flush{.m_space = space, .m_node = node, .m_mod_counter = node->m_modification_counter});
+      requests.push_back(aio::Fsync_request{.m_fh = node->m_fh, .m_datasync = !node->m_needs_fsync});
+
+      node->m_needs_fsync = false;
+    }
+  }
 
   mutex_exit(&m_mutex);
 
-  for (auto space_id : space_ids) {
-    if (space_id == FIL_NULL) {
-      break;
+  if (!requests.empty()) {
+    if (srv_config.m_flush_syncfs) {
+      std::vector<os_file_t> files;
+
+      files.reserve(requests.size());
+
+      for (const auto &request : requests) {
+        files.push_back(request.m_fh);
+      }
+
+      (void) os_file_syncfs(files.data(), files.size());
+
+    } else {
+      srv_aio->fsync(requests.data(), requests.size());
+
+      os_n_fsyncs += requests.size();
+
+      for (ulint i = 0; i < requests.size(); ++i) {
+        if (requests[i].m_ret < 0) {
+          log_fatal(std::format(
+            "Flushing file {} failed. Operating system error number {} - '{}'.",
+            flushes[i].m_node->m_file_name,
+            -requests[i].m_ret,
+            strerror(-requests[i].m_ret)
+          ));
+        }
+      }
     }
+  }
+
+  mutex_enter(&m_mutex);
+
+  for (const auto &flush : flushes) {
+    auto space = flush.m_space;
+    auto node = flush.m_node;
+
+    --node->m_n_pending_flushes;
+
+    if (node->m_flush_counter < flush.m_mod_counter) {
+      node->m_flush_counter = flush.m_mod_counter;
+
+      space_remove_from_unflushed_if_flushed(space);
+    }
+
+    if (space->m_type != FIL_LOG) {
+      --m_n_pending_tablespace_flushes;
+    } else {
+      --m_n_pending_log_flushes;
+    }
+
+    --space->m_n_pending_flushes;
+  }
+
+  mutex_exit(&m_mutex);
+
+  for (auto space_id : busy_space_ids) {
     flush(space_id);
   }
 }
@@ -2620,9 +3209,9 @@ bool Fil::validate() {
 
     for (auto node : space->m_chain) {
 
-      ut_a(node->open || node->m_n_pending == 0);
+      ut_a(node->open || node->n_pending() == 0);
 
-      if (node->m_n_pending > 0) {
+      if (node->n_pending() > 0) {
         ut_a(node->open);
       }
 
@@ -27,6 +27,7 @@ Created 11/29/1995 Heikki Tuuri
 #include "buf0buf.h"
 #include "dict0dict.h"
 #include "dict0store.h"
+#include "fil0extend.h"
 #include "fil0fil.h"
 #include "fut0fut.h"
 #include "log0log.h"
@@ -89,6 +90,10 @@ constexpr ulint FSP_HEADER_SIZE = 32 + 5 * FLST_BASE_NODE_SIZE;
 /** This many free extents are added to the free list from above FSP_FREE_LIMIT at a time */
 constexpr ulint FSP_FREE_ADD = 4;
 
+/** Upper bound in megabytes of the growth proportional part of the increment
+by which a tablespace is extended, see FSP::try_extend_data_file() */
+constexpr ulint FSP_MAX_AUTOEXTEND_INCREMENT = 256;
+
 /** The list node for linking segment inode pages */
 constexpr ulint FSEG_INODE_PAGE_NODE = FSEG_PAGE_DATA;
 
@@ -787,9 +792,14 @@ bool FSP::try_extend_data_file(ulint *actual_increase, space_id_t space, fsp_hea
   if (size < 32 * extent_size) {
     size_increase = extent_size;
   } else {
-    /* Below in fsp_fill_free_list() we assume that we add at most FSP_FREE_ADD
-    extents at a time */
-    size_increase = FSP_FREE_ADD * extent_size;
+    /* Grow bigger tablespaces in proportion to their size so that the number
+    of extensions stays small. fill_free_list() initializes at most FSP_FREE_ADD
+    extents at a time, the rest are initialized when it is called next. */
+    const page_no_t pages_per_mb = (1024 * 1024) / UNIV_PAGE_SIZE;
+    const page_no_t min_increase = std::max<page_no_t>(FSP_FREE_ADD * extent_size, srv_config.m_autoextend_increment * pages_per_mb);
+    const page_no_t max_increase = std::max<page_no_t>(min_increase, FSP_MAX_AUTOEXTEND_INCREMENT * pages_per_mb);
+
+    size_increase = std::clamp<page_no_t>(ut_calc_align_down(size / 16, pages_per_mb), min_increase, max_increase);
   }
 
   if (size_increase == 0) {
@@ -807,7 +817,7 @@ bool FSP::try_extend_data_file(ulint *actual_increase, space_id_t space, fsp_hea
   /* We ignore any fragments of a full megabyte when storing the size
   to the space header */
 
-  const auto new_size = ut_calc_align_down(actual_size, (1024 * 1024) / UNIV_PAGE_SIZE);
+  const auto new_size = ut_calc_align_down(std::min<page_no_t>(actual_size, size + size_increase), (1024 * 1024) / UNIV_PAGE_SIZE);
   mlog_write_ulint(header + FSP_SIZE, new_size, MLOG_4BYTES, mtr);
 
   *actual_increase = new_size - old_size;
@@ -882,6 +892,62 @@ void FSP::free_extent(space_id_t space, ulint page, mtr_t *mtr) noexcept {
   xdes_init(descr, mtr);
 
   flst_add_last(header + FSP_FREE, descr + XDES_FLST_NODE, mtr);
+
+  if (srv_config.m_punch_holes && srv_fil_extender != nullptr) {
+    srv_fil_extender->punch_hole(space, page_no_t(page - page % FSP_EXTENT_SIZE));
+  }
+}
+
+bool FSP::punch_free_extent(space_id_t space, page_no_t page_no, lsn_t &lsn, const std::function<bool()> &is_current) noexcept {
+  if (!m_fil->space_acquire(space)) {
+    return true;
+  }
+
+  bool done{true};
+  mtr_t mtr;
+
+  mtr.start();
+
+  mtr_x_lock(m_fil->space_get_latch(space), &mtr);
+
+  auto descr = xdes_get_descriptor(space, page_no, &mtr);
+
+  if (descr != nullptr && xdes_get_state(descr, &mtr) == XDES_FREE) {
+    if (!is_current()) {
+      /* It was allocated and freed again after lsn was noted, the pages
+      have newer log records. The request of the second free replaces this
+      one. */
+    } else if (lsn == 0) {
+      /* We hold the latch that the mini-transaction which freed the extent
+      held, it has committed. The log records that modified the pages of the
+      extent are all below the current LSN. */
+      lsn = m_log->get_lsn();
+      done = false;
+    } else {
+      m_log->acquire();
+
+      const auto checkpoint_lsn = m_log->m_last_checkpoint_lsn;
+
+      m_log->release();
+
+      /* Recovery could still apply log records to the pages, it must find
+      them intact. Once the checkpoint is past, the pages were also written
+      out and are not written again unless the extent is allocated. */
+      if (checkpoint_lsn < lsn) {
+        done = false;
+      } else {
+        /* The space latch stops the extent from being allocated meanwhile. A
+        failure only leaves the blocks allocated. */
+        (void) m_fil->punch_hole(space, page_no, FSP_EXTENT_SIZE);
+      }
+    }
+  }
+
+  mtr.commit();
+
+  m_fil->space_release(space);
+
+  return done;
 }
 
 void FSP::fseg_fill_free_list(FSP::fseg_inode_t *inode, space_id_t space, page_no_t hint, mtr_t *mtr) noexcept {
@@ -1213,7 +1279,7 @@ bool FSP::fseg_validate_low(fseg_inode_t *inode, mtr_t *mtr2) noexcept {
   return true;
 }
 
-FSP *FSP::create(Log *log, Fil *fil, Buf_pool *buf_pool) noexcept {
+FSP *FSP::create(Log *log, Fil *fil, Buf_pool_manager *buf_pool) noexcept {
   auto ptr = static_cast<log_t *>(ut_new(sizeof(FSP)));
   return new (ptr) FSP(log, fil, buf_pool);
 }
@@ -30,7 +30,7 @@ struct Fil;
 struct FSP;
 struct mtr_t;
 struct Btree;
-struct Buf_pool;
+struct Buf_pool_manager;
 struct Buf_block;
 struct Index;
 using rec_t = byte;
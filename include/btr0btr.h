@@ -43,7 +43,7 @@ struct Btree {
    * @param[in] fsp             File space.
    * @param[in] buf_pool        Buffer pool.
    */
-  Btree(Lock_sys *lock_sys, FSP *fsp, Buf_pool *buf_pool) noexcept
+  Btree(Lock_sys *lock_sys, FSP *fsp, Buf_pool_manager *buf_pool) noexcept
   : m_lock_sys{lock_sys}, m_fsp{fsp}, m_buf_pool{buf_pool} {}
 
   /**
@@ -559,7 +559,7 @@ struct Btree {
    * 
    * @return Newly created B-tree instance
    */
-  static Btree *create(Lock_sys *lock_sys, FSP *fsp, Buf_pool *buf_pool) noexcept;
+  static Btree *create(Lock_sys *lock_sys, FSP *fsp, Buf_pool_manager *buf_pool) noexcept;
 
   /**
    * Destroys a B-tree instance.
@@ -875,5 +875,5 @@ private:
   FSP *m_fsp{};
 
   /** Buffer pool to use */
-  Buf_pool *m_buf_pool{};
+  Buf_pool_manager *m_buf_pool{};
 };
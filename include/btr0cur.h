@@ -31,7 +31,7 @@ Created 10/16/1994 Heikki Tuuri
 
 struct FSP;
 struct Btree;
-struct Buf_pool;
+struct Buf_pool_manager;
 struct Lock_sys;
 
 /** Mode flags for Btree cursor operations; these can be ORed */
@@ -649,7 +649,7 @@ struct Btree_cursor {
    *
    * @return Buffer pool
    */
-  inline Buf_pool *get_buf_pool() noexcept { return m_fsp->m_buf_pool; }
+  inline Buf_pool_manager *get_buf_pool() noexcept { return m_fsp->m_buf_pool; }
 
   /**
    * Gets the B-tree system.
@@ -30,9 +30,12 @@ Created 11/5/1995 Heikki Tuuri
 #include "fil0types.h"
 #include "mach0data.h"
 #include "mtr0types.h"
+#include "os0aio.h"
 #include "page0types.h"
 #include "ut0crc32.h"
 
+#include <array>
+
 /** mutex protecting the buffer pool struct and control blocks, except the
 read-write lock in them */
 extern mutex_t buf_pool_mutex;
@@ -73,6 +76,52 @@ extern ulint buf_pool_mutex_exit_forbidden;
  */
 void buf_page_print(const byte *read_buf, ulint);
 
+/**
+ * Pages with consecutive page numbers in the same tablespace that are read
+ * or written with a single vectored i/o. The pages are posted in batch mode,
+ * the caller must call AIO::submit_batch() after submit().
+ */
+struct Buf_page_run {
+  /**
+   * @brief Constructor.
+   *
+   * @param[in] io_request      IO_request::Async_read or Async_write.
+   * @param[in] priority        Priority class of the i/os.
+   */
+  explicit Buf_page_run(IO_request io_request, IO_priority priority = IO_priority::Default) noexcept
+    : m_io_request(io_request), m_priority(priority) {
+    ut_a(io_request == IO_request::Async_read || io_request == IO_request::Async_write);
+  }
+
+  /** Destructor. */
+  ~Buf_page_run() noexcept { ut_a(m_n_pages == 0); }
+
+  /**
+   * @brief Adds an io-fixed page to the run. If the page does not extend the
+   * run then the run is submitted first and the page starts a new run.
+   *
+   * @param[in] bpage           Page to read or write.
+   */
+  void add(Buf_page *bpage) noexcept;
+
+  /**
+   * @brief Posts the pages in the run to the i/o layer and empties the run.
+   */
+  void submit() noexcept;
+
+  /** Read or write. */
+  const IO_request m_io_request;
+
+  /** Priority class of the i/os. */
+  const IO_priority m_priority;
+
+  /** Number of pages in m_bpages. */
+  ulint m_n_pages{};
+
+  /** The pages of the run in page number order. */
+  std::array<Buf_page *, aio::MAX_IOVECS> m_bpages{};
+};
+
 /*** Let us list the consistency conditions for different control block states.
 
 NOT_USED:
@@ -129,28 +178,6 @@ FILE_PAGE => NOT_USED	NOTE: This transition is allowed if and only if
   (3) io_fix == 0.
 */
 
-inline uint64_t Buf_pool::get_oldest_modification() const {
-  mutex_enter(&m_mutex);
-
-  auto bpage = UT_LIST_GET_LAST(m_flush_list);
-
-  uint64_t lsn;
-
-  if (bpage == nullptr) {
-    lsn = 0;
-  } else {
-    ut_ad(bpage->m_in_flush_list);
-    lsn = bpage->m_oldest_modification;
-  }
-
-  mutex_exit(&m_mutex);
-
-  /* The returned answer may be out of date: the flush_list can
-  change after the mutex has been released. */
-
-  return lsn;
-}
-
 inline Buf_page_state Buf_page::get_state() const {
 #ifdef UNIV_DEBUG
   switch (m_state) {
@@ -542,10 +569,14 @@ inline void Buf_block::fix_dec() {
  * @return The page if found, nullptr otherwise.
  */
 inline Buf_page *Buf_pool::hash_get_page(const Page_id &page_id) {
-  ut_ad(mutex_own(&m_mutex));
-
-  if (auto it = m_page_hash->find(page_id); it != m_page_hash->end()) {
-    auto bpage = it->second;
+#ifdef UNIV_SYNC_DEBUG
+  ut_ad(
+    mutex_own(&m_mutex) || rw_lock_own(m_page_hash->get_latch(page_id), RW_LOCK_SHARED) ||
+    rw_lock_own(m_page_hash->get_latch(page_id), RW_LOCK_EX)
+  );
+#endif /* UNIV_SYNC_DEBUG */
+
+  if (auto bpage = m_page_hash->find(page_id); bpage != nullptr) {
     ut_a(bpage->in_file());
     ut_ad(bpage->m_in_page_hash);
     UNIV_MEM_ASSERT_RW(bpage, sizeof(*bpage));
@@ -572,15 +603,41 @@ inline Buf_block *Buf_pool::hash_get_block(const Page_id &page_id) {
  * @return true if the page exists, false otherwise.
  */
 inline bool Buf_pool::peek(const Page_id &page_id) {
-  mutex_enter(&m_mutex);
+  auto hash_latch = m_page_hash->get_latch(page_id);
+
+  rw_lock_s_lock(hash_latch);
 
   auto bpage = hash_get_page(page_id);
 
-  mutex_exit(&m_mutex);
+  rw_lock_s_unlock(hash_latch);
 
   return bpage != nullptr;
 }
 
+/**
+ * @brief Looks up a file page without acquiring the buffer pool mutex.
+ *
+ * @param page_id The page ID containing space and page number.
+ * @return The block with its mutex held, nullptr if not found.
+ */
+inline Buf_block *Buf_pool::hash_lookup_and_lock(const Page_id &page_id) {
+  auto hash_latch = m_page_hash->get_latch(page_id);
+
+  rw_lock_s_lock(hash_latch);
+
+  auto block = hash_get_block(page_id);
+
+  if (block != nullptr) {
+    /* The block cannot be removed from the page hash while we hold the
+    shard latch, so it is safe to wait for its mutex here. */
+    mutex_enter(&block->m_mutex);
+  }
+
+  rw_lock_s_unlock(hash_latch);
+
+  return block;
+}
+
 inline buf_frame_t *Buf_block::get_frame() const {
 #ifdef UNIV_DEBUG
   switch (get_state()) {
@@ -0,0 +1,216 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file include/buf0cleaner.h
+Background flushing of the buffer pool.
+
+The page cleaner consists of a coordinator thread and a set of worker
+threads. The coordinator wakes up once a second, or when it is signalled
+by a thread that runs short of free blocks or log space, and decides how
+many pages to flush based on the age of the oldest modification relative
+to the log capacity, the share of dirty pages and the configured IO
+capacity. The buffer pool instances are then flushed in parallel by the
+coordinator and the workers.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "buf0types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+struct Page_cleaner {
+  /** Maximum number of page cleaner threads, including the coordinator. */
+  static constexpr ulint MAX_THREADS = 64;
+
+  /**
+   * Constructor.
+   *
+   * @param[in,out] buf_pool    Buffer pool to flush.
+   * @param[in,out] dblwr       Doublewrite buffer to use for the writes.
+   * @param[in] n_threads       Number of threads, including the coordinator.
+   */
+  Page_cleaner(Buf_pool_manager *buf_pool, DBLWR *dblwr, ulint n_threads) noexcept;
+
+  /**
+   * Destructor.
+   */
+  ~Page_cleaner() noexcept;
+
+  /**
+   * Create an instance of the page cleaner.
+   *
+   * @param[in,out] buf_pool    Buffer pool to flush.
+   * @param[in,out] dblwr       Doublewrite buffer to use for the writes.
+   * @param[in] n_threads       Number of threads, including the coordinator.
+   *
+   * @return an instance or nullptr if there is an error.
+   */
+  [[nodiscard]] static Page_cleaner *create(Buf_pool_manager *buf_pool, DBLWR *dblwr, ulint n_threads) noexcept;
+
+  /**
+   * Destroy an instance of the page cleaner, the threads must have been stopped.
+   *
+   * @param[in,out] page_cleaner Instance to destroy, set to nullptr.
+   */
+  static void destroy(Page_cleaner *&page_cleaner) noexcept;
+
+  /**
+   * Start the coordinator and the worker threads.
+   */
+  void start() noexcept;
+
+  /**
+   * Stop the threads and wait for them to exit. Any flush batch that
+   * is running is completed first.
+   */
+  void shutdown() noexcept;
+
+  /**
+   * Request a flush round without waiting for the next one second tick.
+   * Threads that run short of replaceable blocks or log space call this
+   * instead of flushing synchronously.
+   */
+  void wakeup() noexcept;
+
+  /**
+   * @return true if the page cleaner threads are running.
+   */
+  [[nodiscard]] bool is_active() const noexcept { return m_n_threads_active.load(std::memory_order_relaxed) > 0; }
+
+  /**
+   * @return the number of pages flushed from the flush lists so far.
+   */
+  [[nodiscard]] ulint get_n_flushed_list() const noexcept { return m_n_flushed_list.load(std::memory_order_relaxed); }
+
+  /**
+   * @return the number of pages flushed from the LRU lists so far.
+   */
+  [[nodiscard]] ulint get_n_flushed_LRU() const noexcept { return m_n_flushed_LRU.load(std::memory_order_relaxed); }
+
+ private:
+  /** Work that is handed out to the threads in a flush round. */
+  struct Request {
+    /** Minimum number of pages to flush from the flush list of each instance. */
+    ulint m_n_pages{};
+
+    /** Flush all pages whose oldest modification is smaller than this. */
+    lsn_t m_lsn_limit{};
+  };
+
+  /**
+   * The coordinator thread.
+   *
+   * @param[in] arg             The Page_cleaner instance.
+   *
+   * @return nullptr.
+   */
+  static void *coordinator_thread(void *arg) noexcept;
+
+  /**
+   * A worker thread.
+   *
+   * @param[in] arg             The Page_cleaner instance.
+   *
+   * @return nullptr.
+   */
+  static void *worker_thread(void *arg) noexcept;
+
+  /**
+   * Calculate the number of pages to flush in the next round.
+   *
+   * @param[out] lsn_limit      Flush pages older than this LSN.
+   * @param[out] sync           true if the checkpoint age is beyond the
+   *                            synchronous flush limit and the coordinator
+   *                            should not sleep before the next round.
+   *
+   * @return total number of pages to flush from the flush lists.
+   */
+  [[nodiscard]] ulint get_n_pages_to_flush(lsn_t &lsn_limit, bool &sync) noexcept;
+
+  /**
+   * Run a flush round, the coordinator and the workers share the instances.
+   *
+   * @param[in] n_pages         Total number of pages to flush from the flush lists.
+   * @param[in] lsn_limit       Flush pages older than this LSN.
+   */
+  void run_round(ulint n_pages, lsn_t lsn_limit) noexcept;
+
+  /**
+   * Flush the instances that have not been claimed by another thread yet.
+   */
+  void flush_instances() noexcept;
+
+ private:
+  /** Buffer pool to flush. */
+  Buf_pool_manager *m_buf_pool{};
+
+  /** Doublewrite buffer to use. */
+  DBLWR *m_dblwr{};
+
+  /** Number of threads, including the coordinator. */
+  const ulint m_n_threads{};
+
+  /** Protects the fields below up to m_n_threads_active. */
+  std::mutex m_mutex{};
+
+  /** Signalled to wake up the coordinator. */
+  std::condition_variable m_wakeup_cv{};
+
+  /** Signalled when a new round starts or on shutdown. */
+  std::condition_variable m_round_cv{};
+
+  /** Signalled when the last thread finishes its part of a round. */
+  std::condition_variable m_done_cv{};
+
+  /** true if wakeup() was called since the coordinator last checked. */
+  bool m_wakeup_requested{};
+
+  /** true if the threads should exit. */
+  bool m_shutdown{};
+
+  /** Incremented at the start of every round. */
+  uint64_t m_round{};
+
+  /** Number of threads that have not finished the current round. */
+  ulint m_n_pending{};
+
+  /** The work of the current round. */
+  Request m_request{};
+
+  /** Index of the next buffer pool instance to flush in this round. */
+  std::atomic<ulint> m_next_instance{};
+
+  /** Number of threads that are running. */
+  std::atomic<ulint> m_n_threads_active{};
+
+  /** Pages flushed from the flush lists. */
+  std::atomic<ulint> m_n_flushed_list{};
+
+  /** Pages flushed from the LRU lists. */
+  std::atomic<ulint> m_n_flushed_LRU{};
+
+  /** Value of srv_activity_count at the last round, used to detect idle periods. */
+  ulint m_last_activity_count{};
+};
+
+/** The page cleaner, nullptr if flushing is done by the master thread. */
+extern Page_cleaner *srv_page_cleaner;
@@ -72,8 +72,82 @@ constexpr auto SYS_DOUBLEWRITE_BLOCK_SIZE = FSP_EXTENT_SIZE;
 
 /* @} */
 
-/** Doublewrite control struct */
+/** Prefix of the names of the doublewrite files, in the data home directory.
+The files are numbered from 0. */
+constexpr char DBLWR_FILE_PREFIX[] = "ib_doublewrite_";
+
+/** Doublewrite control struct.
+
+The pages of a flush batch are first written, in one request, to a region of
+a dedicated doublewrite file and the file is flushed. Only then are the pages
+written to their positions in the data files. Each buffer pool instance has
+its own batch, and therefore its own region, so that the page cleaner threads
+that flush different instances do not wait for each other. The batches are
+spread over the doublewrite files. The doublewrite blocks in the system
+tablespace are no longer written to, they are only read in recovery. */
 struct DBLWR {
+  /** Maximum number of doublewrite files. */
+  static constexpr ulint MAX_FILES = 4;
+
+  /** Number of pages in a batch. */
+  static constexpr ulint BATCH_SIZE = 2 * SYS_DOUBLEWRITE_BLOCK_SIZE;
+
+  /** A batch of pages that are written to the doublewrite file together. */
+  struct Batch {
+    /**
+     * Constructor.
+     *
+     * @param[in] space_id      Space id of the doublewrite file of the batch.
+     * @param[in] page_no       First page of the batch in the doublewrite file.
+     */
+    Batch(space_id_t space_id, page_no_t page_no) noexcept;
+
+    /**
+     * Destructor.
+     */
+    ~Batch() noexcept;
+
+    /** Mutex protecting the batch, it is held while the batch is written to
+    the doublewrite file and its data file writes are posted. */
+    mutex_t m_mutex{};
+
+    /** Space id of the doublewrite file the batch is written to. */
+    space_id_t m_space_id{};
+
+    /** First page of the batch in the doublewrite file. */
+    page_no_t m_page_no{};
+
+    /** First free position in write_buf measured in units of UNIV_PAGE_SIZE */
+    ulint m_first_free{};
+
+    /** Write buffer used in writing to the doublewrite file, aligned to an
+    address divisible by UNIV_PAGE_SIZE */
+    byte *m_write_buf{};
+
+    /** pointer to write_buf, but unaligned */
+    byte *m_ptr{};
+
+    /** Array to store pointers to the buffer blocks which have been
+    cached to write_buf */
+    std::vector<Buf_page*> m_bpages{};
+
+    /** Set when the write of the batch to the doublewrite file completes. */
+    Cond_var *m_write_done{};
+
+    /** Number of data file writes of the batch that have not completed. */
+    std::atomic<ulint> m_n_pending{};
+
+    /** Set when m_n_pending drops to zero. */
+    Cond_var *m_pending_done{};
+
+    /** true from the write of the batch to the doublewrite file until its
+    data file writes are synced, the region of the batch in the doublewrite
+    file must not be overwritten before that. Protected by m_mutex. */
+    bool m_is_syncing{};
+
+    /** Set when m_is_syncing is cleared. */
+    Cond_var *m_synced{};
+  };
 
   /** 
    * Constructor.
@@ -110,13 +184,22 @@ struct DBLWR {
   db_err initialize() noexcept;
 
   /**
-   * At a database startup initializes the doublewrite buffer memory structure if
-   * we already have a doublewrite buffer created in the data files. If we are
-   * upgrading to an InnoDB version which supports multiple tablespaces, then this
-   * function performs the necessary update operations. If we are in a crash
-   * recovery, this function uses a possible doublewrite buffer to restore
-   * half-written pages in the data files.
-   * 
+   * Opens the doublewrite files and creates the ones that are missing. All the
+   * existing files are opened, also those beyond n_files, so that recovery
+   * scans them, the batches are only placed in the first n_files files.
+   *
+   * @param[in] n_batches         Number of batches, one per buffer pool instance.
+   * @param[in] n_files           Number of files to spread the batches over.
+   *
+   * @return DB_SUCCESS if successful, otherwise an error code.
+   */
+  db_err open(ulint n_batches, ulint n_files) noexcept;
+
+  /**
+   * At a database startup uses the copies of the pages in the doublewrite
+   * blocks of the system tablespace and in the doublewrite files to restore
+   * half-written pages in the data files. If a page has several copies the
+   * one with the highest LSN that is not corrupt is used.
    */
   void recover_pages() noexcept;
 
@@ -142,31 +225,62 @@ struct DBLWR {
    */
   static bool check_if_exists(Fil* fil, std::pair<page_no_t, page_no_t> &offsets) noexcept;
 
+  /**
+   * @param[in] instance_no       Buffer pool instance number.
+   *
+   * @return the batch of the buffer pool instance.
+   */
+  [[nodiscard]] Batch *get_batch(ulint instance_no) noexcept {
+    return m_batches[instance_no % m_batches.size()];
+  }
+
+  /**
+   * Writes the pages of a batch to its region of the doublewrite file with an
+   * asynchronous request, waits for it to complete and flushes the file. The
+   * caller must own batch->m_mutex.
+   *
+   * @param[in,out] batch         The batch to write.
+   */
+  void write_batch(Batch *batch) noexcept;
+
+  /**
+   * Called by the i/o handler thread when the write of a batch completes.
+   *
+   * @param[in,out] batch         The batch that was written.
+   */
+  void io_complete(Batch *batch) noexcept;
+
+  /**
+   * Called by the i/o handler thread when the write of a page of the batch
+   * to its data file completes.
+   *
+   * @param[in,out] batch         The batch of the page.
+   */
+  void data_write_complete(Batch *batch) noexcept;
+
+  /**
+   * Waits until the data file writes of the batch have completed. Only
+   * the writes of this batch are waited for, not those of the other
+   * buffer pool instances.
+   *
+   * @param[in,out] batch         The batch whose writes to wait for.
+   */
+  void wait_for_data_writes(Batch *batch) noexcept;
+
   /** Filespace manager for IO. */
   FSP *m_fsp{};
 
-  /** mutex protecting the first_free field and write_buf */
-  mutex_t m_mutex{};
-
   /** The page number of the first doublewrite block (64 pages) */
   page_no_t m_block1{};
 
   /** Page number of the second block */
   page_no_t m_block2{};
 
-  /** First free position in write_buf measured in units of UNIV_PAGE_SIZE */
-  ulint m_first_free{};
-
-  /** Write buffer used in writing to the doublewrite buffer, aligned to an
-  address divisible by UNIV_PAGE_SIZE (which is required by Windows aio) */
-  byte *m_write_buf{};
-
-  /** pointer to write_buf, but unaligned */
-  byte *m_ptr{};
+  /** Space ids of the open doublewrite files. */
+  std::vector<space_id_t> m_space_ids{};
 
-   /** Array to store pointers to the buffer blocks which have been
-  cached to write_buf */
-  std::vector<Buf_page*> m_bpages{};
+  /** The batches, one per buffer pool instance. */
+  std::vector<Batch*> m_batches{};
 };
 
 /** Doublewrite system */
@@ -0,0 +1,66 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file include/buf0dump.h
+Dump the page ids of the buffer pool to a file and load them back.
+
+The dump is a list of (space id, page number) pairs taken from the LRU
+lists of the buffer pool instances, most recently used first. At startup
+a background thread reads the list back, sorts it so that the reads of a
+tablespace are issued in file order and reads the pages in batches of
+asynchronous requests. The loader backs off when the user threads are
+doing reads of their own so that it does not hurt the foreground latency.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "buf0types.h"
+
+/** Name of the dump file, in the data home directory. */
+constexpr char BUF_DUMP_FILENAME[] = "ib_buffer_pool";
+
+/**
+ * @brief Writes the page ids of the pages in the buffer pool to the dump file.
+ *        The file is written under a temporary name and renamed when it is
+ *        complete, so that a crash during the dump does not leave a partial
+ *        file behind.
+ *
+ * @param buf_pool The buffer pool to dump.
+ * @return DB_SUCCESS or error code.
+ */
+[[nodiscard]] db_err buf_dump(Buf_pool_manager *buf_pool);
+
+/**
+ * @brief Starts the background thread that reads in the pages listed in the
+ *        dump file. Does nothing if there is no dump file.
+ *
+ * @param buf_pool The buffer pool to load the pages into.
+ */
+void buf_load_start(Buf_pool_manager *buf_pool);
+
+/**
+ * @brief Requests the load thread to stop and waits for it to exit. Does
+ *        nothing if the load thread is not running.
+ */
+void buf_load_abort();
+
+/**
+ * @return true if the load thread is running.
+ */
+[[nodiscard]] bool buf_load_is_active();
@@ -74,19 +74,31 @@ struct Buf_flush {
 
   /**
    * Flushes pages from the end of the LRU list if there is too small
-   * a margin of replaceable pages there.
+   * a margin of replaceable pages there. If the page cleaner is running
+   * it is woken up instead, unless there are no replaceable pages left.
    * 
    * @param[in,out] dblwr The doublewrite buffer to use
    */
   void free_margin(DBLWR *dblwr);
 
+  /**
+   * Flushes pages from the end of the LRU list if there is too small
+   * a margin of replaceable pages there. Used by the page cleaner.
+   * 
+   * @param[in,out] dblwr The doublewrite buffer to use
+   * 
+   * @return number of pages queued for writing; ULINT_UNDEFINED if there
+   *         was an LRU flush batch already running
+   */
+  ulint LRU_flush(DBLWR *dblwr);
+
   /**
    * Initializes a page for writing to the tablespace.
    *
    * @param page The page to initialize.
    * @param newest_lsn The newest modification LSN to the page.
    */
-  void init_for_writing(byte *page, uint64_t newest_lsn);
+  static void init_for_writing(byte *page, uint64_t newest_lsn);
 
   /**
    * This utility flushes dirty blocks from the end of the LRU list or flush_list.
@@ -181,11 +193,23 @@ struct Buf_flush {
    */
   void insert_sorted_into_flush_list(Buf_block *block);
 
+  /**
+   * @brief Moves the blocks that mini-transactions have pushed to Buf_pool::m_flush_pending
+   * to the flush list. Must be called before the flush list is used to find the oldest
+   * modification, and before a block that is pending is flushed, relocated or removed.
+   */
+  void insert_pending_into_flush_list();
+
   /**
    * @brief This function should be called at a mini-transaction commit, if a page was
    * modified in it. Puts the block to the list of modified blocks, if it is not
    * already in it.
    *
+   * The buffer pool mutex is not needed: the block is pushed to Buf_pool::m_flush_pending
+   * and moved to the flush list later. The mini-transactions commit concurrently, so the
+   * blocks are pushed roughly in the order of their oldest modification and the few that
+   * are out of order are inserted sorted.
+   *
    * @param block The block which is modified.
    * @param mtr The mini-transaction.
    */
@@ -195,7 +219,7 @@ struct Buf_flush {
   #ifdef UNIV_SYNC_DEBUG
     ut_ad(rw_lock_own(&block->m_lock, RW_LOCK_EX));
   #endif /* UNIV_SYNC_DEBUG */
-    ut_ad(mutex_own(&m_buf_pool->m_mutex));
+    ut_ad(mutex_own(&block->m_mutex));
   
     ut_ad(mtr->m_start_lsn != 0);
     ut_ad(mtr->m_modifications);
@@ -207,13 +231,23 @@ struct Buf_flush {
   
       block->m_page.m_oldest_modification = mtr->m_start_lsn;
       ut_ad(block->m_page.m_oldest_modification != 0);
-  
-      insert_into_flush_list(block);
+
+      auto bpage = &block->m_page;
+
+      ut_ad(!bpage->m_in_flush_pending);
+      bpage->m_in_flush_pending = true;
+
+      auto head = m_buf_pool->m_flush_pending.load(std::memory_order_relaxed);
+
+      do {
+        bpage->m_flush_pending_next = head;
+      } while (!m_buf_pool->m_flush_pending.compare_exchange_weak(head, bpage, std::memory_order_release, std::memory_order_relaxed));
+
     } else {
       ut_ad(block->m_page.m_oldest_modification <= mtr->m_start_lsn);
     }
   
-    ++m_buf_pool->m_write_requests;
+    m_buf_pool->m_write_requests.fetch_add(1, std::memory_order_relaxed);
   }
   
   /**
@@ -256,7 +290,7 @@ struct Buf_flush {
   available to replacement in the free list and at the end of the LRU list (to
   make sure that a read-ahead batch can be read efficiently in a single sweep). */
   auto get_free_block_margin() const {
-    return 5 + srv_buf_pool->get_read_ahead_area();
+    return 5 + m_buf_pool->get_read_ahead_area();
   }
 
   /** Extra margin to apply above the free block margin */
@@ -321,8 +355,8 @@ private:
   void sync_datafiles();
 
   /**
-   * @brief Flushes possible buffered writes from the doublewrite memory buffer to disk,
-   * and also wakes up the aio thread if simulated aio is used.
+   * @brief Flushes possible buffered writes from the doublewrite batch of this
+   * buffer pool instance to disk, and also wakes up the aio thread if simulated aio is used.
    * It is very important to call this function after a batch of writes has been posted,
    * and also when we may have to wait for a page latch! Otherwise a deadlock of threads can occur.
    * 
@@ -331,7 +365,8 @@ private:
   void buffered_writes(DBLWR *dblwr);
 
   /**
-   * @brief Posts a buffer page for writing. If the doublewrite memory buffer is full,
+   * @brief Posts a buffer page for writing to the doublewrite batch of this buffer
+   * pool instance. If the batch is full,
    * calls buf_pool->m_flusher->buffered_writes and waits for for free space to appear.
    *
    * @param bpage The buffer block to write.
@@ -344,19 +379,21 @@ private:
    * 
    * @param[in,out] dblwr The doublewrite buffer to use
    * @param bpage The buffer block to write.
+   * @param[in,out] run If the doublewrite buffer is not used the write is added to this run of neighbours.
    */
-  void write_block_low(DBLWR *dblwr, Buf_page *bpage);
+  void write_block_low(DBLWR *dblwr, Buf_page *bpage, Buf_page_run &run);
 
   /**
    * @brief Writes a flushable page asynchronously from the buffer pool to a file.
-   * NOTE: in simulated aio we must call os_aio_simulated_wake_handler_threads after we have posted a batch of writes!
+   * NOTE: the write is posted in batch mode, we must call AIO::submit_batch() after we have posted a batch of writes!
    * NOTE: buf_pool_mutex and buf_page_get_mutex(bpage) must be held upon entering this function, and they will be released by this function.
    * 
    * @param[in,out] dblwr Doublewrite buffer to use
    * @param bpage The buffer control block.
    * @param flush_type The flush type.
+   * @param[in,out] run Run of neighbours that the write is added to, submitted before we wait for the page latch.
    */
-  void page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type);
+  void page(DBLWR *dblwr, Buf_page *bpage, buf_flush flush_type, Buf_page_run &run);
 
   /**
    * @brief Flushes to disk all flushable pages within the flush area.
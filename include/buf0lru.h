@@ -29,6 +29,87 @@ Created 11/5/1995 Heikki Tuuri
 #include "buf0types.h"
 #include "ut0byte.h"
 
+#include <memory>
+
+/** @brief Replacement policy of the LRU list of a buffer pool instance.
+
+All the policies share the LRU list and its old sublist, a policy decides
+where a page is inserted, whether an access moves it to the head of the
+list and whether the eviction scan may free it. Except for accessed() the
+methods are called with the buffer pool mutex held.
+
+- Midpoint insertion (SRV_LRU_MIDPOINT): a page that is read in is inserted
+  at the head of the old sublist and made young when it is accessed again
+  lru_block_access_recency ms after the first access. Young pages are only
+  moved to the head when they are at risk of becoming old.
+
+- 2Q (SRV_LRU_2Q): the pages that are read in form a FIFO in the old
+  sublist, an access does not make such a page young. The ids of the pages
+  evicted from the old sublist are remembered in a ghost list of up to half
+  the size of the buffer pool. A page whose id is in the ghost list
+  when it is read in again was referenced twice within that window and is
+  inserted at the head of the list. A scan therefore only churns the old
+  sublist and the ghost list.
+
+- CLOCK (SRV_LRU_CLOCK): an access sets the reference bit of the page and
+  never moves it. The eviction scan starts at the tail of the list, a page
+  whose reference bit is set is given a second chance: the bit is cleared
+  and the page is moved to the head of the list. */
+struct Buf_LRU_policy {
+  virtual ~Buf_LRU_policy() = default;
+
+  /**
+   * @return the name of the policy.
+   */
+  [[nodiscard]] virtual const char *name() const = 0;
+
+  /**
+   * Decides where a page is inserted in the LRU list.
+   *
+   * @param bpage The page that is added to the LRU list.
+   * @param old The position requested by the caller, true if the page was read in.
+   *
+   * @return true if the page should be put to the old blocks.
+   */
+  [[nodiscard]] virtual bool add_to_old(const Buf_page *bpage, bool old) = 0;
+
+  /**
+   * Called when a page is accessed, without holding the buffer pool mutex.
+   *
+   * @param bpage The page that was accessed.
+   *
+   * @return true if the page should be moved to the head of the LRU list.
+   */
+  [[nodiscard]] virtual bool accessed(Buf_page *bpage) = 0;
+
+  /**
+   * Called by the eviction scan before it tries to free a page.
+   *
+   * @param bpage The page that is a candidate for eviction.
+   *
+   * @return true if the page should be moved to the head of the LRU list instead.
+   */
+  [[nodiscard]] virtual bool second_chance(Buf_page *bpage) = 0;
+
+  /**
+   * Called after the eviction scan freed a page.
+   *
+   * @param page_id The id of the page that was evicted.
+   * @param old true if the page was in the old blocks.
+   */
+  virtual void evicted(const Page_id &page_id, bool old) = 0;
+
+  /**
+   * Creates a replacement policy.
+   *
+   * @param policy The policy, one of SRV_LRU_MIDPOINT, SRV_LRU_2Q or SRV_LRU_CLOCK.
+   * @param buf_pool The buffer pool instance that the policy is for.
+   *
+   * @return the policy.
+   */
+  [[nodiscard]] static std::unique_ptr<Buf_LRU_policy> create(ulint policy, Buf_pool *buf_pool);
+};
+
 struct Buf_LRU {
 
   /** Number of intervals for which we keep the history of these stats.
@@ -79,12 +160,9 @@ struct Buf_LRU {
     ulint m_io{};
   };
 
-  /** Constructor
-  @param[in] old_threshold_ms   Move the blocks to the "new" list after this threshold. */
-  explicit Buf_LRU(Buf_pool *buf_pool)
-    : m_buf_pool(buf_pool),
-      m_old_ratio(s_old_ratio),
-      m_old_threshold_ms(s_old_threshold_ms) {}
+  /** Constructor, the replacement policy is srv_config.m_LRU_policy.
+  @param[in] buf_pool           The buffer pool instance that owns the list. */
+  explicit Buf_LRU(Buf_pool *buf_pool);
 
   /**
    * Tries to remove LRU flushed blocks from the end of the LRU list and put
@@ -175,6 +253,24 @@ struct Buf_LRU {
    */
   void add_block(Buf_page *bpage, bool old);
   
+  /**
+   * Called when a page is accessed, without holding the buffer pool mutex.
+   *
+   * @param bpage The page that was accessed.
+   *
+   * @return true if the replacement policy wants the page moved to the start of the LRU list.
+   */
+  [[nodiscard]] bool page_accessed(Buf_page *bpage) {
+    return m_policy->accessed(bpage);
+  }
+
+  /**
+   * @return the name of the replacement policy.
+   */
+  [[nodiscard]] const char *get_policy_name() const {
+    return m_policy->name();
+  }
+
   /**
    * Moves a block to the start of the LRU list.
    * 
@@ -188,6 +284,15 @@ struct Buf_LRU {
    * @param bpage The control block to be moved.
    */
   void make_block(Buf_page *bpage);
+
+  /**
+   * Replaces a block with another one at the same position in the LRU list.
+   * Note that it is assumed that the contents of bpage has already been copied to dpage.
+   *
+   * @param bpage The control block being replaced, in the LRU list.
+   * @param dpage The control block that takes its place.
+   */
+  void relocate(Buf_page *bpage, Buf_page *dpage);
   
   /**
    * Update the historical stats that we are collecting for LRU eviction policy 
@@ -211,8 +316,8 @@ struct Buf_LRU {
   #endif /* UNIV_DEBUG */
   
   /** Maximum LRU list search length in buf_pool->m_flusher->LRU_recommendation() */
-  static ulint get_free_search_len () {
-    return 5 + 2 * srv_buf_pool->get_read_ahead_area();
+  ulint get_free_search_len() const {
+    return 5 + 2 * m_buf_pool->get_read_ahead_area();
   }
 
   /** Increments the I/O counter in buf_LRU_stat_cur. */
@@ -311,6 +416,9 @@ private:
   /** The buffer pool. */
   Buf_pool *m_buf_pool{};
 
+  /** The replacement policy. Protected by buf_pool_mutex. */
+  std::unique_ptr<Buf_LRU_policy> m_policy;
+
   /** Reserve this much/OLD_RATIO_DIV of the buffer pool for "old" blocks.
   Protected by buf_pool_mutex. */
   ulint m_old_ratio{};
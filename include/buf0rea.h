@@ -61,7 +61,7 @@ bool buf_read_page(const Page_id &page_id);
  *   NOTE 2: the calling thread may own latches on pages: to avoid deadlocks
  *        this function must be written such that it cannot end up waiting
  *        for these latches!
- * @param buf_pool The buffer pool.
+ * @param buf_pool The buffer pool instance that caches page_id.
  * @param page_id The page ID containing space and page number. NOTE: the current thread must
  *  want access to this page (see NOTE 3 above).
  * @return The number of page read requests issued.
@@ -69,15 +69,46 @@ bool buf_read_page(const Page_id &page_id);
 ulint buf_read_ahead_linear(Buf_pool *buf_pool, const Page_id &page_id);
 
 /**
- * @brief Issues read requests for pages which recovery wants to read in.
+ * @brief Applies random read-ahead if enough pages of the read-ahead area
+ *        of the specified page have been recently accessed, in any order.
+ *        The other pages of the area are then read in asynchronously. Does
+ *        not read any page if the area is not whole or if there are too many
+ *        pending reads.
+ *   NOTE: the calling thread may own latches on pages: to avoid deadlocks
+ *        this function must be written such that it cannot end up waiting
+ *        for these latches!
+ * @param buf_pool The buffer pool instance that caches page_id.
+ * @param page_id The page ID of the page that the current thread is about to
+ *  read; it is not read in by this function.
+ * @return The number of page read requests issued.
+ */
+ulint buf_read_ahead_random(Buf_pool *buf_pool, const Page_id &page_id);
+
+/**
+ * @brief Issues asynchronous read requests for pages of a tablespace, used
+ *        to warm up the buffer pool from a dump. Pages that are already in
+ *        the buffer pool or that are beyond the end of the tablespace are
+ *        skipped.
  *
- * @param sync true if the caller wants this function to wait for the
- *                  highest address page to get read in, before this
- *                  function returns
- * @param page_id The page ID containing space and page number.
- * @param page_nos array of page numbers to read, with the highest page number the last in the array
+ * @param space The tablespace ID.
+ * @param page_nos array of page numbers to read, in ascending order
  * @param n_stored number of page numbers in the array
+ * @return The number of page read requests issued.
+ */
+ulint buf_read_load_pages(space_id_t space, const page_no_t *page_nos, ulint n_stored);
+
+/**
+ * @brief Issues asynchronous read requests for pages which recovery wants to
+ * read in. Pages with consecutive page numbers are read with a single vectored
+ * i/o and the requests are posted in large batches. The function waits for
+ * the pending reads to drop below max_pending before it adds more.
+ *
+ * @param page_ids Pages to read, in (space, page_no) order.
+ * @param n_pages number of pages in the array
+ * @param max_pending maximum number of pending reads in the buffer pool
+ *
+ * @return The number of page read requests issued.
  */
-void buf_read_recv_pages(bool sync, const Page_id &page_id, const page_no_t *page_nos, ulint n_stored);
+ulint buf_read_recv_pages(const Page_id *page_ids, ulint n_pages, ulint max_pending);
 
 /* @} */
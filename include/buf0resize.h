@@ -0,0 +1,60 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file include/buf0resize.h
+Online resizing of the buffer pool.
+
+The buffer pool instances are allocated in chunks of a fixed size. When the
+"buffer_pool_size" configuration variable is changed while InnoDB is running,
+a background thread adds chunks to, or withdraws chunks from, every instance.
+
+A new chunk is initialized without holding the buffer pool mutex and is then
+linked into the free list. To withdraw a chunk its free blocks are taken off
+the free list and its file pages are copied to blocks in the remaining chunks
+or evicted, a batch of blocks at a time, so that the user threads are never
+stalled for long. Blocks that are in use are collected when they are freed.
+The page frames of a withdrawn chunk are returned to the operating system,
+its block descriptors are kept because stale "guess" pointers may still
+refer to them, and are reused when the buffer pool grows again.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include "buf0types.h"
+
+/**
+ * @brief Requests the buffer pool to be resized to srv_config.m_buf_pool_size.
+ *        Starts the resize thread if it is not running, otherwise the thread
+ *        resizes again once the current resize completes.
+ *
+ * @param buf_pool The buffer pool to resize.
+ */
+void buf_resize_start(Buf_pool_manager *buf_pool);
+
+/**
+ * @brief Requests the resize thread to stop and waits for it to exit. A shrink
+ *        that is in progress is rolled back. Does nothing if the resize thread
+ *        is not running.
+ */
+void buf_resize_abort();
+
+/**
+ * @return true if the resize thread is running.
+ */
+[[nodiscard]] bool buf_resize_is_active();
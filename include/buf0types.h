@@ -27,15 +27,18 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 
 #include "innodb0types.h"
 
+#include <atomic>
 #include <functional>
 #include <optional>
 #include <set>
 #include <sstream>
 #include <unordered_map>
+#include <vector>
 
 #include "sync0mutex.h"
 #include "sync0rw.h"
 #include "ut0mem.h"
+#include "ut0rnd.h"
 
 /** Mini-transaction. */
 struct mtr_t;
@@ -58,9 +61,15 @@ struct buf_chunk_t;
 /** Buffer pool comprising buf_chunk_t */
 struct Buf_pool;
 
+/** The set of buffer pool instances */
+struct Buf_pool_manager;
+
 /** Buffer pool statistics struct */
 struct buf_pool_stat_t;
 
+/** Doublewrite buffer */
+struct DBLWR;
+
 /** A buffer frame. @see page_t */
 using buf_frame_t = byte;
 
@@ -119,8 +128,8 @@ constexpr ulint BUF_MAKE_YOUNG = 51;
 constexpr ulint BUF_KEEP_OLD = 52;
 /* @} */
 
-/** The buffer pool of the database */
-extern Buf_pool *srv_buf_pool;
+/** The buffer pool instances of the database */
+extern Buf_pool_manager *srv_buf_pool;
 
 #ifdef UNIV_DEBUG
 /*! If this is set true, the program prints info whenever read or flush occurs */
@@ -303,15 +312,33 @@ struct Buf_page {
 
   bool m_old;
 
+  /** Index of the buffer pool instance that owns this block, set when
+  the block is created and never changed after that. */
+  uint8_t m_buf_pool_index;
+
   /** the value of Buf_pool::freed_page_clock when this block was the last time
   put to the head of the LRU list; a thread is allowed to read this for
   heuristic purposes without holding any mutex or latch */
   unsigned m_freed_page_clock : 31;
 
+  /** true if the page was read in by read-ahead and has not been accessed
+  since; protected by buf_pool_mutex */
+  unsigned m_read_ahead : 1;
+
   /** time of first access, or 0 if the block was never accessed in the
   buffer pool */
   uint32_t m_access_time{};
 
+  /** reference bit of the CLOCK replacement policy, set when the page is
+  accessed and cleared by the eviction scan; a thread is allowed to set it
+  without holding any mutex or latch */
+  bool m_referenced;
+
+  /** true while the page is in the A1in queue of the 2Q replacement policy:
+  it was put to the old blocks when it was added to the LRU list and it has
+  not been made young since; protected by buf_pool_mutex */
+  bool m_in_A1in;
+
   /** @name Page flushing fields
   All these are protected by buf_pool_mutex. */
   /* @{ */
@@ -336,6 +363,19 @@ struct Buf_page {
   all modifications are on disk */
   lsn_t m_oldest_modification;
 
+  /** true if the block was modified by a mini-transaction and is in
+  Buf_pool::m_flush_pending, not yet in the flush list. Set under the
+  block mutex, cleared under buf_pool_mutex. */
+  bool m_in_flush_pending;
+
+  /** next block in Buf_pool::m_flush_pending */
+  Buf_page *m_flush_pending_next;
+
+  /** true while the write of the page to the data file is counted in
+  DBLWR::Batch::m_n_pending of the batch of its buffer pool instance. Set
+  before the write is posted, cleared when it completes. */
+  bool m_in_dblwr_batch;
+
   /* @} */
 
   /** @name LRU replacement algorithm fields
@@ -517,6 +557,9 @@ struct buf_pool_stat_t {
   being accessed */
   ulint n_ra_pages_evicted{};
 
+  /** number of read ahead pages that were accessed after they were read in */
+  ulint n_ra_pages_used{};
+
   /** number of pages made young, in calls to m_LRU->make_block_young() */
   ulint n_pages_made_young{};
 
@@ -525,13 +568,122 @@ struct buf_pool_stat_t {
   ulint n_pages_not_made_young{};
 };
 
+/** @brief Hash table of the file pages of a buffer pool instance.
+
+The table is split into shards, each protected by its own rw-latch. A lookup
+only needs the S-latch of the shard that the page maps to, so buffer pool hits
+do not serialize on the buffer pool mutex. Inserting or removing a page needs
+both the buffer pool mutex and the X-latch of the shard. Holding the buffer
+pool mutex alone is therefore also enough for a lookup.
+
+The latching order is: buffer pool mutex, page hash shard latch, block mutex. */
+struct Buf_page_hash {
+  /** Number of shards, must be a power of 2. */
+  static constexpr ulint N_SHARDS = 64;
+
+  /** Constructor. */
+  Buf_page_hash();
+
+  /** Destructor. */
+  ~Buf_page_hash() noexcept;
+
+  /**
+   * @brief Returns the latch that protects the shard of a page.
+   *
+   * @param page_id The page ID containing space and page number.
+   * @return The shard latch.
+   */
+  [[nodiscard]] rw_lock_t *get_latch(const Page_id &page_id) noexcept { return &get_shard(page_id).m_latch; }
+
+  /**
+   * @brief Looks up a page. The caller must hold the shard latch or the buffer pool mutex.
+   *
+   * @param page_id The page ID containing space and page number.
+   * @return The page if found, nullptr otherwise.
+   */
+  [[nodiscard]] Buf_page *find(const Page_id &page_id) noexcept {
+    auto &shard = get_shard(page_id);
+
+    if (auto it = shard.m_pages.find(page_id); it != shard.m_pages.end()) {
+      return it->second;
+    }
+
+    return nullptr;
+  }
+
+  /**
+   * @brief Inserts a page. The caller must hold the shard X-latch.
+   *
+   * @param page_id The page ID containing space and page number.
+   * @param bpage The control block of the page.
+   * @return true if inserted, false if the page was already in the table.
+   */
+  [[nodiscard]] bool insert(const Page_id &page_id, Buf_page *bpage) noexcept {
+    return get_shard(page_id).m_pages.emplace(page_id, bpage).second;
+  }
+
+  /**
+   * @brief Removes a page. The caller must hold the shard X-latch.
+   *
+   * @param page_id The page ID containing space and page number.
+   */
+  void erase(const Page_id &page_id) noexcept { get_shard(page_id).m_pages.erase(page_id); }
+
+  /**
+   * @brief Replaces the control block of a page that is in the table. The caller
+   * must hold the shard X-latch.
+   *
+   * @param page_id The page ID containing space and page number.
+   * @param bpage The new control block of the page.
+   */
+  void replace(const Page_id &page_id, Buf_page *bpage) noexcept {
+    auto it = get_shard(page_id).m_pages.find(page_id);
+
+    ut_a(it != get_shard(page_id).m_pages.end());
+    it->second = bpage;
+  }
+
+  /**
+   * @brief Makes room for n_pages pages so that inserts do not have to rehash.
+   * The shards are resized one at a time, holding only that shard's X-latch and
+   * the buffer pool mutex, so that the lookups of the other shards can proceed.
+   *
+   * @param buf_pool The buffer pool instance that owns the table.
+   * @param n_pages Expected number of pages in the table.
+   */
+  void reserve(Buf_pool *buf_pool, ulint n_pages) noexcept;
+
+ private:
+  /** One partition of the page hash. */
+  struct alignas(hardware_destructive_interference_size) Shard {
+    /** Protects m_pages. */
+    rw_lock_t m_latch;
+
+    /** Pages in this shard, indexed by (m_space, m_page_no). */
+    Page_id_hash<Buf_page *> m_pages{};
+  };
+
+  /**
+   * @brief Returns the shard that a page maps to.
+   *
+   * @param page_id The page ID containing space and page number.
+   * @return The shard.
+   */
+  [[nodiscard]] Shard &get_shard(const Page_id &page_id) noexcept {
+    return m_shards[ut_fold_ulint_pair(page_id.m_space_id, page_id.m_page_no) & (N_SHARDS - 1)];
+  }
+
+  static_assert((N_SHARDS & (N_SHARDS - 1)) == 0, "N_SHARDS must be a power of 2");
+
+  /** The shards. */
+  std::array<Shard, N_SHARDS> m_shards;
+};
+
 /** @brief The buffer pool structure.
 
 NOTE! The definition appears here only for other modules of this
 directory (buf) to see it. Do not use from outside! */
 struct Buf_pool {
-  using page_hash_t = Page_id_hash<Buf_page *>;
-
   struct Request {
     /** RW_S_LATCH or RW_X_LATCH */
     ulint m_rw_latch{};
@@ -563,22 +715,76 @@ struct Buf_pool {
 
   static_assert(std::is_standard_layout<Request>::value, "Request must have a standard layout");
 
-  /** Default constructor. */
-  Buf_pool();
+  /** Constructor.
+  @param[in] instance_no        Index of this instance in the Buf_pool_manager. */
+  explicit Buf_pool(ulint instance_no);
 
   /** Destructor. */
   ~Buf_pool() noexcept;
 
-  [[nodiscard]] bool open(uint64_t pool_size);
+  /** Maximum number of chunks in an instance. */
+  static constexpr ulint MAX_CHUNKS = 1024;
+
+  /** Number of blocks that are handled under one acquisition of the buffer
+  pool mutex when chunks are withdrawn, bounds the stall that an online
+  shrink causes to the user threads. */
+  static constexpr ulint RESIZE_BATCH_SIZE = 64;
+
+  /** Creates the chunks of the instance.
+  @param[in] pool_size          Size of the instance in bytes.
+  @param[in] chunk_size         Size of a chunk in bytes.
+  @return true on success. */
+  [[nodiscard]] bool open(uint64_t pool_size, ulint chunk_size);
+
+  /** Grows the instance to n_chunks chunks. Chunks that were withdrawn by an
+  earlier shrink are reused before new memory is allocated. The blocks are
+  initialized without holding the buffer pool mutex.
+  @param[in] n_chunks           Number of chunks after the resize.
+  @param[in] chunk_size         Size of a new chunk in bytes.
+  @return false if memory could not be allocated for all the chunks, the
+          chunks that were added are kept. */
+  [[nodiscard]] bool add_chunks(ulint n_chunks, ulint chunk_size);
+
+  /** Starts shrinking the instance to n_chunks chunks. From now on the blocks
+  of the chunks at the end are not handed out any more, they are collected
+  in m_withdraw_list when they become free.
+  @param[in] n_chunks           Number of chunks after the resize. */
+  void withdraw_start(ulint n_chunks);
+
+  /** Collects the blocks of the chunks that are being withdrawn. Free blocks
+  are taken off the free list, the file pages in the chunks are relocated to
+  blocks in the remaining chunks or, if there are no free blocks, evicted.
+  Pages that are buffer-fixed or I/O-fixed are left for the next call.
+  @return true if all the blocks of the withdrawn chunks have been collected. */
+  [[nodiscard]] bool withdraw_blocks();
+
+  /** Completes the shrink started by withdraw_start(): returns the memory of
+  the page frames of the withdrawn chunks to the operating system. The block
+  descriptors stay mapped because stale "guess" pointers may still point to
+  them, they are reused if the instance grows again. */
+  void withdraw_end();
+
+  /** Stops a shrink started by withdraw_start() and puts the blocks that were
+  collected so far back on the free list. */
+  void withdraw_cancel();
+
+  /**
+   * @brief If the block is in a chunk that is being withdrawn, collects it in
+   * m_withdraw_list instead of letting it be put on the free list. The caller
+   * must hold the buffer pool mutex and the block mutex.
+   *
+   * @param[in,out] block       Block in state BUF_BLOCK_NOT_USED that is not in any list.
+   * @return true if the block was collected.
+   */
+  [[nodiscard]] bool withdraw_if_needed(Buf_block *block);
+
+  /** @return the number of chunks in use. */
+  [[nodiscard]] ulint get_n_chunks() const { return m_n_chunks.load(std::memory_order_relaxed); }
 
   /** Returns the number of pending buf pool ios.
   @return number of pending I/O operations */
   [[nodiscard]] ulint get_n_pending_ios();
 
-  /** Prints info of the buffer i/o.
-  @para,[in,out] ib_stream      File write to write. */
-  void print_io(ib_stream_t ib_stream);
-
   /** Returns the ratio in percents of modified pages in the buffer pool /
   database pages in the buffer pool.
   @return modified page percentage ratio */
@@ -747,6 +953,18 @@ struct Buf_pool {
    */
   [[nodiscard]] Buf_block *hash_get_block(const Page_id &page_id);
 
+  /**
+   * @brief Looks up a file page without acquiring the buffer pool mutex.
+   *
+   * Only the page hash shard latch is held during the lookup. If the page
+   * is found then its block mutex is acquired before the shard latch is
+   * released, so that the caller can buffer-fix the block.
+   *
+   * @param page_id The page ID containing space and page number.
+   * @return The block with its mutex held, nullptr if not found.
+   */
+  [[nodiscard]] Buf_block *hash_lookup_and_lock(const Page_id &page_id);
+
   /**
    * @brief Checks if the page can be found in the buffer pool hash table.
    *
@@ -763,7 +981,7 @@ struct Buf_pool {
 
   /** Gets the block to whose frame the pointer is pointing to.
   @param[in] ptr                 Pointer to a frame.
-  @return pointer to block, never nullptr */
+  @return pointer to block, or nullptr if the frame is not in this instance */
   [[nodiscard]] Buf_block *block_align(const byte *ptr);
 
   /** Find out if a pointer belongs to a buf_block_t. It can be a pointer to
@@ -784,9 +1002,11 @@ struct Buf_pool {
    * @param page_id - The page ID containing space and page number.
    * @param[in] tablespace_version - Prevents reading from a wrong version of the
    *  tablespace in case we have done DISCARD + IMPORT.
+   * @param[in] read_ahead - true if the page is read in by read-ahead and not
+   *  because a thread is waiting for it.
    * @return Pointer to the block or nullptr.
    */
-  Buf_page *init_for_read(db_err *err, const Page_id &page_id, int64_t tablespace_version);
+  Buf_page *init_for_read(db_err *err, const Page_id &page_id, int64_t tablespace_version, bool read_ahead);
 
   /**
    * @brief Completes an asynchronous read or write request of a file page to or from the buffer pool.
@@ -860,6 +1080,14 @@ struct Buf_pool {
 
 #endif /* UNIV_DEBUG */
        /* @} */
+
+  /** Checks if a block is in the part of the LRU list that has been recently
+   * accessed. NOTE: does not reserve the buffer pool mutex, the result is
+   * only a heuristic.
+   * @param[in] bpage               Block to check.
+   * @return true if the block is near the start of the LRU list */
+  [[nodiscard]] bool peek_if_young(const Buf_page *bpage) const;
+
  private:
   /**
    * @brief Sets the time of the first access of a page and moves a page to the
@@ -873,6 +1101,20 @@ struct Buf_pool {
    */
   void set_accessed_make_young(Buf_page *bpage, unsigned access_time);
 
+  /**
+   * Counts the first access to a page that was read in by read-ahead.
+   *
+   * @param bpage Buffer block of a file page (in/out)
+   */
+  void read_ahead_page_accessed(Buf_page *bpage) {
+    ut_ad(mutex_own(&m_mutex));
+
+    if (unlikely(bpage->m_read_ahead)) {
+      bpage->m_read_ahead = false;
+      ++m_stat.n_ra_pages_used;
+    }
+  }
+
   /**
    * @brief Inits a page to the buffer buf_pool.
    *
@@ -882,11 +1124,12 @@ struct Buf_pool {
    */
   void page_init(space_id_t space, page_no_t page_no, Buf_block *block);
 
-  /** Recommends a move of a block to the start of the LRU list if there is danger
-   * of dropping from the buffer pool. NOTE: does not reserve the buffer pool mutex.
+  /** Notes an access to a block and recommends a move of it to the start of the
+   * LRU list if the replacement policy asks for it, e.g., if there is danger of
+   * dropping from the buffer pool. NOTE: does not reserve the buffer pool mutex.
    * @param[in,out] bpage            Block to make younger.
    * @return true if should be made younger */
-  bool peek_if_too_old(const Buf_page *bpage);
+  bool peek_if_too_old(Buf_page *bpage);
 
   /**
    * @brief Allocates a chunk of buffer frames.
@@ -899,6 +1142,14 @@ struct Buf_pool {
    */
   buf_chunk_t *chunk_init(buf_chunk_t *chunk, ulint mem_size);
 
+  /**
+   * @brief Puts the blocks of a chunk on the free list. The caller must hold
+   * the buffer pool mutex.
+   *
+   * @param[in] chunk Chunk whose blocks to free, in state BUF_BLOCK_NOT_USED.
+   */
+  void chunk_add_to_free_list(buf_chunk_t *chunk);
+
   /**
    * @brief Checks that all file pages in the buffer chunk are in a replaceable state.
    *
@@ -907,6 +1158,26 @@ struct Buf_pool {
    */
   const Buf_block *chunk_not_freed(buf_chunk_t *chunk);
 
+  /**
+   * @brief Checks if a block is in one of the chunks that are being withdrawn.
+   *
+   * @param[in] block Block to check.
+   * @return true if the block will be withdrawn.
+   */
+  [[nodiscard]] bool will_be_withdrawn(const Buf_block *block) const;
+
+  /**
+   * @brief Copies a file page to a free block and replaces the block with the
+   * new block in the page hash, the LRU list and the flush list. The caller
+   * must hold the buffer pool mutex and must not hold any block mutex.
+   *
+   * @param[in,out] block       Block that contains the file page.
+   * @param[in,out] new_block   Block in state BUF_BLOCK_READY_FOR_USE to copy the page to.
+   * @return true if the page was relocated and the old block was collected for
+   *         the withdrawal, false if the page is buffer-fixed or I/O-fixed.
+   */
+  [[nodiscard]] bool relocate(Buf_block *block, Buf_block *new_block);
+
   /**
    * @brief Initializes a buffer control block when the buf_pool is created.
    *
@@ -940,25 +1211,41 @@ struct Buf_pool {
   /** @name General fields */
   /* @{ */
 
-  /** number of buffer pool chunks */
-  ulint m_n_chunks{};
+  /** Index of this instance in Buf_pool_manager::m_instances */
+  const ulint m_instance_no;
+
+  /** number of buffer pool chunks in use, the chunks that are being withdrawn
+  are included until the withdrawal completes; modified under the buffer pool
+  mutex, read without it by block_align() */
+  std::atomic<ulint> m_n_chunks{};
+
+  /** number of buffer pool chunks that have memory allocated, the chunks from
+  m_n_chunks onwards have been withdrawn: their frames have been returned to
+  the operating system, but their block descriptors stay mapped */
+  std::atomic<ulint> m_n_chunks_alloc{};
+
+  /** number of chunks that remain after the current shrink, equal to m_n_chunks
+  if the instance is not being shrunk; protected by the buffer pool mutex */
+  ulint m_n_chunks_new{};
 
-  /** buffer pool chunks */
+  /** buffer pool chunks, an array of MAX_CHUNKS entries that is never
+  reallocated so that it can be read without the buffer pool mutex */
   buf_chunk_t *m_chunks{};
 
+  /** blocks of the chunks being withdrawn that have been collected, in state
+  BUF_BLOCK_MEMORY; protected by the buffer pool mutex */
+  UT_LIST_BASE_NODE_T(Buf_page, m_list) m_withdraw_list{};
+
   /** current pool size in pages */
   ulint m_curr_size{};
 
   /** hash table of Buf_page or buf_block_t file pages,
   Buf_page::in_file() == true, indexed by (m_nspace_id, m_page_no) */
-  page_hash_t *m_page_hash{};
+  Buf_page_hash *m_page_hash{};
 
   /** Number of pending read operations */
   ulint m_n_pend_reads{};
 
-  /** When buf_print_io was last time called */
-  time_t m_last_printout_time;
-
   /** current statistics */
   buf_pool_stat_t m_stat;
 
@@ -1023,7 +1310,14 @@ struct Buf_pool {
   ulint m_LRU_old_len{};
 
   /** Number of write requests issued */
-  ulint m_write_requests{};
+  std::atomic<ulint> m_write_requests{};
+
+  /** Stack of the blocks that mini-transactions modified for the first time
+  since they were last flushed, linked by Buf_page::m_flush_pending_next,
+  newest first. A mini-transaction pushes a block without holding
+  buf_pool_mutex, the blocks are moved to the flush list under it by
+  Buf_flush::insert_pending_into_flush_list(). */
+  std::atomic<Buf_page *> m_flush_pending{};
 
   /** LRU replacement algorithm */
   std::unique_ptr<Buf_LRU> m_LRU{};
@@ -1032,6 +1326,222 @@ struct Buf_pool {
   std::unique_ptr<Buf_flush> m_flusher{};
 };
 
+/** The buffer pool is partitioned into several independent Buf_pool instances,
+each with its own mutex, page hash, free list, LRU list and flush list. A page
+is mapped to an instance by a hash of its Page_id, all pages of an aligned
+read-ahead area map to the same instance. A block records the index of the
+instance that owns it in Buf_page::m_buf_pool_index. */
+struct Buf_pool_manager {
+  /** Maximum number of buffer pool instances, must fit in Buf_page::m_buf_pool_index. */
+  static constexpr ulint MAX_INSTANCES = 64;
+
+  /** Pages within an aligned area of (1 << AREA_SHIFT) pages are mapped to the
+  same instance, this must not be smaller than the maximum read-ahead area. */
+  static constexpr ulint AREA_SHIFT = 6;
+
+  /** Default constructor. */
+  Buf_pool_manager() = default;
+
+  /** Destructor. */
+  ~Buf_pool_manager() noexcept;
+
+  /** Create the buffer pool instances.
+  @param[in] pool_size          Total size of the buffer pool in bytes.
+  @param[in] n_instances        Number of buffer pool instances.
+  @return true on success. */
+  [[nodiscard]] bool open(uint64_t pool_size, ulint n_instances);
+
+  /** Prepares the buffer pool instances for shutdown. */
+  void close();
+
+  /** @return the number of buffer pool instances. */
+  [[nodiscard]] ulint get_n_instances() const noexcept { return m_instances.size(); }
+
+  /** @return the size of a chunk in bytes, the buffer pool grows and shrinks
+  in multiples of this times the number of instances. */
+  [[nodiscard]] ulint get_chunk_size() const noexcept { return m_chunk_size; }
+
+  /** @return the buffer pool instance with the given index.
+  @param[in] i                  Instance index. */
+  [[nodiscard]] Buf_pool *get_instance(ulint i) const noexcept {
+    ut_ad(i < m_instances.size());
+    return m_instances[i];
+  }
+
+  /** @return the buffer pool instance that caches the page.
+  @param[in] page_id            Page to look up. */
+  [[nodiscard]] Buf_pool *get_instance(const Page_id &page_id) const noexcept {
+    if (m_instances.size() == 1) {
+      return m_instances[0];
+    }
+
+    const auto fold = ut_fold_ulint_pair(page_id.space_id(), page_id.page_no() >> AREA_SHIFT);
+
+    return m_instances[fold % m_instances.size()];
+  }
+
+  /** @return the buffer pool instance that owns the block.
+  @param[in] bpage              Control block, can be in any state. */
+  [[nodiscard]] Buf_pool *get_instance(const Buf_page *bpage) const noexcept {
+    ut_ad(bpage->m_buf_pool_index < m_instances.size());
+    return m_instances[bpage->m_buf_pool_index];
+  }
+
+  /** @see Buf_pool::get() */
+  Buf_block *get(Buf_pool::Request &req, Buf_block *guess) { return get_instance(req.m_page_id)->get(req, guess); }
+
+  /** @see Buf_pool::try_get() */
+  bool try_get(Buf_pool::Request &req) { return get_instance(&req.m_guess->m_page)->try_get(req); }
+
+  /** @see Buf_pool::try_get_known_nowait() */
+  bool try_get_known_nowait(Buf_pool::Request &req) { return get_instance(&req.m_guess->m_page)->try_get_known_nowait(req); }
+
+  /** @see Buf_pool::try_get_by_page_id() */
+  const Buf_block *try_get_by_page_id(Buf_pool::Request &req) { return get_instance(req.m_page_id)->try_get_by_page_id(req); }
+
+  /** @see Buf_pool::create() */
+  [[nodiscard]] Buf_block *create(const Page_id &page_id, mtr_t *mtr) { return get_instance(page_id)->create(page_id, mtr); }
+
+  /** @see Buf_pool::peek() */
+  [[nodiscard]] bool peek(const Page_id &page_id) { return get_instance(page_id)->peek(page_id); }
+
+  /** @see Buf_pool::check_index_page_at_flush() */
+  void check_index_page_at_flush(const Page_id &page_id) { get_instance(page_id)->check_index_page_at_flush(page_id); }
+
+  /** @see Buf_pool::is_corrupted() */
+  [[nodiscard]] bool is_corrupted(const byte *read_buf) { return m_instances[0]->is_corrupted(read_buf); }
+
+  /** @see Buf_pool::make_young() */
+  void make_young(Buf_page *bpage) { get_instance(bpage)->make_young(bpage); }
+
+  /** @see Buf_pool::io_complete() */
+  void io_complete(Buf_page *bpage) { get_instance(bpage)->io_complete(bpage); }
+
+  /** @see Buf_pool::release() */
+  void release(Buf_block *block, ulint rw_latch, mtr_t *mtr) { get_instance(&block->m_page)->release(block, rw_latch, mtr); }
+
+  /** @see Buf_pool::block_free() */
+  void block_free(Buf_block *block) { get_instance(&block->m_page)->block_free(block); }
+
+  /** Allocates a buffer block from the instances in a round-robin fashion.
+  @return own: the allocated block, in state BUF_BLOCK_MEMORY */
+  [[nodiscard]] Buf_block *block_alloc();
+
+  /** Gets the block to whose frame the pointer is pointing to.
+  @param[in] ptr                 Pointer to a frame.
+  @return pointer to block, never nullptr */
+  [[nodiscard]] Buf_block *block_align(const byte *ptr);
+
+#ifdef UNIV_DEBUG
+  /** @see Buf_pool::set_file_page_was_freed() */
+  Buf_page *set_file_page_was_freed(const Page_id &page_id) { return get_instance(page_id)->set_file_page_was_freed(page_id); }
+
+  /** @return the number of latched pages in all the instances. */
+  [[nodiscard]] ulint get_latched_pages_number();
+
+  /** Validate all the instances.
+  @return true if they are consistent. */
+  bool validate();
+#endif /* UNIV_DEBUG */
+
+  /** @return the current size of the buffer pool in bytes. */
+  [[nodiscard]] uint64_t get_curr_size() const;
+
+  /** @return the smallest oldest_modification lsn of any page in all the
+  instances, zero if all modified pages have been flushed to disk. */
+  [[nodiscard]] lsn_t get_oldest_modification() const;
+
+  /** @return the number of pending I/O operations in all the instances. */
+  [[nodiscard]] ulint get_n_pending_ios() const;
+
+  /** @return the number of pending reads in all the instances. */
+  [[nodiscard]] ulint get_n_pend_reads() const;
+
+  /** @return true if there is pending I/O in any of the instances. */
+  [[nodiscard]] bool is_io_pending() const;
+
+  /** @return true if all file pages in all the instances are in a replaceable state. */
+  [[nodiscard]] bool all_freed();
+
+  /** @see Buf_pool::invalidate() */
+  void invalidate();
+
+  /** @return the ratio in percents of modified pages to database pages in all the instances. */
+  [[nodiscard]] ulint get_modified_ratio_pct() const;
+
+  /** @return true if less than 25 % of any of the instances is available. */
+  [[nodiscard]] bool running_out();
+
+  /** @return the statistics summed over all the instances. */
+  [[nodiscard]] buf_pool_stat_t get_stat() const;
+
+  /** @return the number of pages read and written by all the instances. */
+  [[nodiscard]] ulint get_n_page_ios() const;
+
+  /** @return the number of write requests summed over all the instances. */
+  [[nodiscard]] ulint get_write_requests() const;
+
+  /** @return the total length of the LRU lists, without holding any mutex. */
+  [[nodiscard]] ulint get_LRU_len() const;
+
+  /** @return the total length of the free lists, without holding any mutex. */
+  [[nodiscard]] ulint get_free_len() const;
+
+  /** @return the total length of the flush lists, after moving the pending blocks to them. */
+  [[nodiscard]] ulint get_flush_list_len() const;
+
+  /** @return the total size of the instances in pages. */
+  [[nodiscard]] ulint get_curr_n_pages() const;
+
+  /** Prints info of the buffer i/o summed over all the instances.
+  @param[in,out] ib_stream      Stream to write to. */
+  void print_io(ib_stream_t ib_stream);
+
+  /** Refreshes the statistics used to print per-second averages. */
+  void refresh_io_stats();
+
+  /** Update the reserved percentage of "old" blocks in all the instances.
+  @see Buf_LRU::old_ratio_update() */
+  ulint old_ratio_update(ulint old_pct, bool adjust);
+
+  /** Update the LRU and flush statistics of all the instances at the end of an interval. */
+  void stat_update();
+
+  /** @return the desired flush rate summed over all the instances. */
+  [[nodiscard]] ulint get_desired_flush_rate();
+
+  /** Flush dirty pages from the flush list of every instance.
+  @param[in] dblwr              Doublewrite buffer.
+  @param[in] min_n              Minimum number of pages to flush in total, ULINT_MAX for all.
+  @param[in] lsn_limit          Flush only pages whose oldest_modification is less than this.
+  @return number of pages queued for writing, ULINT_UNDEFINED if a flush list batch
+  was already running in some instance; the other instances are flushed anyway. */
+  ulint flush_list(DBLWR *dblwr, ulint min_n, lsn_t lsn_limit);
+
+  /** Wait for batches of the given type to end in all the instances.
+  @param[in] type               BUF_FLUSH_LRU or BUF_FLUSH_LIST. */
+  void wait_batch_end(buf_flush type);
+
+  /** Flush pages from the end of the LRU lists if necessary.
+  @param[in] dblwr              Doublewrite buffer. */
+  void free_margin(DBLWR *dblwr);
+
+  /** Free the recovery flush list red-black trees of all the instances. */
+  void free_flush_list();
+
+  /** The buffer pool instances. */
+  std::vector<Buf_pool *> m_instances{};
+
+  /** Size of a chunk in bytes. */
+  ulint m_chunk_size{};
+
+  /** Used by block_alloc() to spread the allocations over the instances. */
+  std::atomic<ulint> m_next_alloc{};
+
+  /** When print_io() was last time called */
+  time_t m_last_printout_time{};
+};
+
 /** We need this to alias a buf_block_t from a Buf_page. */
 static_assert(std::is_standard_layout<Buf_block>::value, "buf_block_t must have a standard layout");
 
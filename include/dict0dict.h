@@ -46,7 +46,7 @@ struct FSP;
 struct mtr_t;
 struct Table;
 struct Index;
-struct Buf_pool;
+struct Buf_pool_manager;
 struct Btree;
 
 /** Data dictionary system. */
@@ -0,0 +1,186 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file include/fil0extend.h
+Background preallocation of the tablespace files and returning of the
+free extents to the file system.
+
+Extending a data file in the mini-transaction that needs the new pages
+stalls the user thread for as long as the file system takes to allocate
+the blocks. The file extender thread keeps file_preallocate_size megabytes
+allocated, with fallocate(), ahead of the size of every single-table
+tablespace that grows, so that Fil::extend_space_to_desired_size() usually
+only has to hand out pages that are already in the file.
+
+With punch_holes set, the extents that FSP frees are queued here too. About
+once a second the thread punches holes for the ones that are still free and
+that crash recovery no longer needs, see FSP::punch_free_extent(). The queue
+is not persistent, the extents that are still queued at shutdown stay
+allocated in the file.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct Fil;
+struct FSP;
+
+struct Fil_extender {
+  /**
+   * Constructor.
+   *
+   * @param[in,out] fil         Tablespace memory cache.
+   * @param[in,out] fsp         File space management.
+   */
+  Fil_extender(Fil *fil, FSP *fsp) noexcept;
+
+  /**
+   * Destructor.
+   */
+  ~Fil_extender() noexcept;
+
+  /**
+   * Create an instance of the file extender.
+   *
+   * @param[in,out] fil         Tablespace memory cache.
+   * @param[in,out] fsp         File space management.
+   *
+   * @return an instance or nullptr if there is an error.
+   */
+  [[nodiscard]] static Fil_extender *create(Fil *fil, FSP *fsp) noexcept;
+
+  /**
+   * Destroy an instance of the file extender, the thread must have been stopped.
+   *
+   * @param[in,out] extender    Instance to destroy, set to nullptr.
+   */
+  static void destroy(Fil_extender *&extender) noexcept;
+
+  /**
+   * Start the extender thread.
+   */
+  void start() noexcept;
+
+  /**
+   * Stop the thread and wait for it to exit. The queued requests are dropped,
+   * the spaces are extended in the foreground if they need more pages.
+   */
+  void shutdown() noexcept;
+
+  /**
+   * Queue a tablespace for preallocation and wake up the thread. Called with
+   * the Fil mutex held, must not block.
+   *
+   * @param[in] space_id        Tablespace to preallocate pages for.
+   */
+  void request(space_id_t space_id) noexcept;
+
+  /**
+   * Queue a free extent to be returned to the file system. Called by the
+   * mini-transaction that frees the extent, must not block.
+   *
+   * @param[in] space_id        Tablespace of the extent.
+   * @param[in] page_no         First page of the extent.
+   */
+  void punch_hole(space_id_t space_id, page_no_t page_no) noexcept;
+
+  /**
+   * @return true if the extender thread is running.
+   */
+  [[nodiscard]] bool is_active() const noexcept { return m_is_active.load(std::memory_order_relaxed); }
+
+ private:
+  /** An extent that was freed, see FSP::punch_free_extent(). */
+  struct Free_extent {
+    /** 0 until the extent was seen free, then the LSN that the checkpoint
+    must reach before the hole can be punched. */
+    lsn_t m_lsn{};
+
+    /** Changes every time the extent is freed, a hole is only punched if
+    it did not change since its LSN was noted. */
+    uint64_t m_generation{};
+  };
+
+  /** Free extents by the page ID of their first page. */
+  using Free_extents = std::unordered_map<Page_id, Free_extent, Page_id::Hash>;
+
+  /**
+   * Punch holes for the queued extents that can be returned to the file
+   * system. The extents stay queued meanwhile, so that freeing one again
+   * resets its LSN.
+   */
+  void punch_holes() noexcept;
+
+  /**
+   * Checks if an extent was freed again since its LSN was noted. Called
+   * with the space latch held, which the mini-transaction that frees an
+   * extent holds too.
+   *
+   * @param[in] page_id         First page of the extent.
+   * @param[in] generation      Generation of the extent when it was noted.
+   *
+   * @return true if the extent was not freed again.
+   */
+  [[nodiscard]] bool is_current(const Page_id &page_id, uint64_t generation) noexcept;
+
+  /**
+   * The extender thread.
+   *
+   * @param[in] arg             The Fil_extender instance.
+   *
+   * @return nullptr.
+   */
+  static void *thread(void *arg) noexcept;
+
+ private:
+  /** Tablespace memory cache. */
+  Fil *m_fil{};
+
+  /** File space management. */
+  FSP *m_fsp{};
+
+  /** Protects the fields below up to m_is_active. */
+  std::mutex m_mutex{};
+
+  /** Signalled when a space is queued or on shutdown. */
+  std::condition_variable m_wakeup_cv{};
+
+  /** Spaces to preallocate pages for, in the order of the requests. */
+  std::vector<space_id_t> m_queue{};
+
+  /** Free extents to punch holes for. */
+  Free_extents m_free_extents{};
+
+  /** Generation of the next extent that is freed. */
+  uint64_t m_next_generation{1};
+
+  /** true if the thread should exit. */
+  bool m_shutdown{};
+
+  /** true while the thread is running. */
+  std::atomic<bool> m_is_active{};
+};
+
+/** The file extender, nullptr if the files are only extended in the foreground. */
+extern Fil_extender *srv_fil_extender;
@@ -33,8 +33,12 @@ Created 10/25/1995 Heikki Tuuri
 #include "os0file.h"
 #include "srv0srv.h"
 #include "sync0rw.h"
+#include "ut0rcu.h"
 
+#include <array>
+#include <atomic>
 #include <unordered_map>
+#include <vector>
 
 // Forward declaration
 struct mtr_t;
@@ -55,6 +59,13 @@ struct Fil {
   @param[in] space_id             Tablespace ID */
   int64_t space_get_version(space_id_t space_id);
 
+  /** Adds the latency histogram of the completed i/o requests to a tablespace
+  to a snapshot.
+  @param[in] space_id             Tablespace ID
+  @param[in,out] snapshot         Snapshot to add to
+  @return false if the tablespace does not exist in the memory cache */
+  bool space_io_latency(space_id_t space_id, ut::Latency_histogram::Snapshot &snapshot);
+
   /** Returns the latch of a file space.
   @param[in] space_id             Tablespace ID
   @return	latch protecting storage allocation */
@@ -62,7 +73,7 @@ struct Fil {
 
   /** Returns the type of a file space.
   @param[in] space_id             Tablespace ID
-  @return	FIL_TABLESPACE or FIL_LOG */
+  @return	FIL_TABLESPACE, FIL_LOG or FIL_DBLWR */
   ulint space_get_type(space_id_t space_id);
 
   /** Appends a new file to the chain of files of a space. File must be closed.
@@ -78,7 +89,7 @@ struct Fil {
   @param[in] name                 Tablespace name
   @param[in] space_id             Tablespace ID
   @param[in] flags                Tablespace flags
-  @param[in] purpose              FIL_TABLESPACE, or FIL_LOG if log
+  @param[in] purpose              FIL_TABLESPACE, FIL_LOG if log or FIL_DBLWR if doublewrite file
   @return	true if success */
   bool space_create(const char *name, space_id_t space_id, ulint flags, Fil_type type);
 
@@ -310,6 +321,46 @@ struct Fil {
    */
   bool extend_space_to_desired_size(page_no_t *actual_size, space_id_t space_id, page_no_t size_after_extend);
 
+  /**
+   * Allocates pages ahead of the size of a single-table tablespace so that
+   * extend_space_to_desired_size() doesn't have to touch the file. Called
+   * by the file extender thread, the Fil mutex is not held while the file
+   * is extended.
+   *
+   * @param[in] space_id          space id
+   */
+  void preallocate(space_id_t space_id);
+
+  /**
+   * Pins a tablespace so that it is not dropped while a background operation
+   * works on it.
+   *
+   * @param[in] space_id          space id
+   *
+   * @return false if the space does not exist or is being deleted
+   */
+  [[nodiscard]] bool space_acquire(space_id_t space_id);
+
+  /**
+   * Unpins a tablespace pinned with space_acquire().
+   *
+   * @param[in] space_id          space id
+   */
+  void space_release(space_id_t space_id);
+
+  /**
+   * Deallocates a range of pages in the file, they read back as zeros and
+   * the file keeps its size. The pages must be free, see
+   * FSP::punch_free_extent().
+   *
+   * @param[in] space_id          space id
+   * @param[in] page_no           First page of the range
+   * @param[in] n_pages           Number of pages in the range
+   *
+   * @return true if success
+   */
+  bool punch_hole(space_id_t space_id, page_no_t page_no, page_no_t n_pages);
+
   /**
    * Tries to reserve free extents in a file space.
    *
@@ -341,12 +392,10 @@ struct Fil {
   /**
    * Reads or writes data. This operation is asynchronous (aio).
    * @param io_request            in: IO_request type.
-   * @param batched               in: if simulated aio and we want to post a
-   *                              batch of i/os; NOTE that a simulated batch
-   *                              may introduce hidden chances of deadlocks,
-   *                              because i/os are not actually handled until
-   *                              all have been posted: use with great
-   *                              caution!
+   * @param batched               in: if we want to post a batch of async
+   *                              i/os; the i/os are not passed to the kernel
+   *                              until the caller calls AIO::submit_batch(),
+   *                              it must do so before it waits for them
    * @param page_id               in: space id and page no
    * @param byte_offset           in: remainder of offset in bytes; in
    *                              aio this must be divisible by the OS block size
@@ -358,22 +407,44 @@ struct Fil {
    *                              appropriately aligned
    * @param message               in: message for aio handler if non-sync
    *                             aio used, else ignored
+   * @param priority              in: priority class of the i/o, by default
+   *                              derived from the request type
    * @return DB_SUCCESS, or DB_T ABLESPACE_DELETED if we are trying to do
    *         i/o on a tablespace which does not exist
    */
   db_err data_io(
-    IO_request io_request, bool batched, const Page_id &page_id, ulint byte_offset, ulint len, void *buf, void *message
+    IO_request io_request, bool batched, const Page_id &page_id, ulint byte_offset, ulint len, void *buf, void *message,
+    IO_priority priority = IO_priority::Default
+  );
+
+  /**
+   * Reads or writes consecutive pages of a tablespace with a single vectored
+   * asynchronous i/o, each page has its own frame and aio message.
+   * @param io_request            in: IO_request::Async_read or Async_write
+   * @param batched               in: if we want to post a batch of async
+   *                              i/os, see data_io()
+   * @param page_id               in: space id and page no of the first page
+   * @param n_pages               in: number of pages, > 1 and at most
+   *                              aio::MAX_IOVECS
+   * @param frames                in/out: page frames, in page number order
+   * @param messages              in: message for the aio handler of each page
+   * @param priority              in: priority class of the i/o, by default
+   *                              derived from the request type
+   * @return DB_SUCCESS, or DB_TABLESPACE_DELETED if we are trying to do
+   *         i/o on a tablespace which does not exist
+   */
+  db_err data_io_vec(
+    IO_request io_request, bool batched, const Page_id &page_id, ulint n_pages, byte *const *frames, void *const *messages,
+    IO_priority priority = IO_priority::Default
   );
 
   /**
    * Reads or writes data. This operation is asynchronous (aio).
    * @param io_request            in: IO_request type.
-   * @param batched               in: if simulated aio and we want to post a
-   *                              batch of i/os; NOTE that a simulated batch
-   *                              may introduce hidden chances of deadlocks,
-   *                              because i/os are not actually handled until
-   *                              all have been posted: use with great
-   *                              caution!
+   * @param batched               in: if we want to post a batch of async
+   *                              i/os; the i/os are not passed to the kernel
+   *                              until the caller calls AIO::submit_batch(),
+   *                              it must do so before it waits for them
    * @param page_id               in: space id and page no
    * @param byte_offset           in: remainder of offset in bytes; in
    *                              aio this must be divisible by the OS block size
@@ -414,12 +485,22 @@ struct Fil {
 
   /**
    * Flushes to disk writes in file spaces of the given type possibly cached by
-   * the OS.
+   * the OS. Only the files written to since their last flush are flushed, in
+   * parallel with AIO::fsync(), or with one syncfs() per file system if
+   * flush_syncfs is set.
    *
-   * @param[in] purpose           FIL_TABLESPACE, FIL_LOG
+   * @param[in] purpose           FIL_TABLESPACE, FIL_LOG, FIL_DBLWR
    */
   void flush_file_spaces(ulint purpose);
 
+  /**
+   * Flushes to disk the writes in the given tablespaces possibly cached by
+   * the OS, like flush_file_spaces() but only for the spaces in the list.
+   *
+   * @param[in] space_ids         Ids of the spaces to flush, sorted.
+   */
+  void flush_spaces(const std::vector<space_id_t> &space_ids);
+
   /**
    * Checks the consistency of the tablespace cache.
    *
@@ -495,6 +576,15 @@ struct Fil {
   /** @return The number of fsyncs done to the log */
   ulint get_log_flushes() const { return m_n_log_flushes; }
 
+  /** @return The number of extensions that had to allocate the pages in the foreground */
+  ulint get_foreground_extends() const { return m_n_foreground_extends; }
+
+  /** @return The number of preallocations done by the file extender */
+  ulint get_preallocations() const { return m_n_preallocations; }
+
+  /** @return The number of free extents returned to the file system */
+  ulint get_punched_holes() const { return m_n_punched_holes; }
+
  private:
   /**
    * @brief Frees a space object from the tablespace memory cache. Closes the files in
@@ -540,6 +630,81 @@ struct Fil {
    */
   void node_complete_io(fil_node_t *node, IO_request io_request);
 
+  /**
+   * Updates the data structures when a data file i/o operation finishes, the
+   * caller must not own the Fil mutex. Unlike node_complete_io() the mutex is
+   * only acquired for the first write to a space since the last flush.
+   *
+   * @param[in,out] node          File node the i/o was done on.
+   * @param[in] io_request        Type of the completed request.
+   */
+  void node_complete_data_io(fil_node_t *node, IO_request io_request);
+
+  /**
+   * Bumps the modification counter of a file after a write to it.
+   *
+   * @param[in,out] node          File node that was written to.
+   *
+   * @return true if the space must still be added to m_unflushed_spaces.
+   */
+  [[nodiscard]] bool node_note_write(fil_node_t *node) noexcept;
+
+  /**
+   * Adds a space to m_unflushed_spaces if it is not there yet. The caller
+   * must own the Fil mutex.
+   *
+   * @param[in,out] space         Space that was written to.
+   */
+  void space_add_to_unflushed(fil_space_t *space);
+
+  /**
+   * Removes a space from m_unflushed_spaces if all of its files are flushed.
+   * The caller must own the Fil mutex.
+   *
+   * @param[in,out] space         Space that was flushed.
+   */
+  void space_remove_from_unflushed_if_flushed(fil_space_t *space);
+
+  /**
+   * Flushes the files of the unflushed spaces of the given type, see
+   * flush_file_spaces().
+   *
+   * @param[in] purpose           FIL_TABLESPACE, FIL_LOG, FIL_DBLWR
+   * @param[in] space_ids         If not nullptr only the spaces in this sorted
+   *                              list are flushed.
+   */
+  void flush_spaces_low(ulint purpose, const std::vector<space_id_t> *space_ids);
+
+  /**
+   * Allows new i/o's to be posted on an open file without the Fil mutex,
+   * unless the space is being renamed or deleted. The caller must own the
+   * Fil mutex.
+   *
+   * @param[in,out] node          File node.
+   * @param[in] space             Space of the file.
+   */
+  static void node_enable_lock_free_io(fil_node_t *node, const fil_space_t *space) noexcept;
+
+  /**
+   * Stops new i/o's from being posted on a file without the Fil mutex. Once
+   * this returns, the pending i/o count of the file can only grow under the
+   * Fil mutex, which the caller must own.
+   *
+   * @param[in,out] node          File node.
+   */
+  static void node_disable_lock_free_io(fil_node_t *node) noexcept;
+
+  /**
+   * Looks up the file of a tablespace and increments its pending i/o count
+   * without acquiring the Fil mutex. This only succeeds if the file is open
+   * and the space is not being renamed or deleted.
+   *
+   * @param[in] space_id          Tablespace ID.
+   *
+   * @return the file node, or nullptr if the caller must take the slow path.
+   */
+  [[nodiscard]] fil_node_t *node_try_prepare_for_data_io(space_id_t space_id) noexcept;
+
   /**
    * @brief Checks if a single-table tablespace for a given table name
    * exists in the tablespace memory cache.
@@ -600,6 +765,20 @@ struct Fil {
    */
   void mutex_enter_and_prepare_for_io(space_id_t space_id);
 
+  /**
+   * Looks up the file of a tablespace page and prepares it for i/o. The
+   * Fil mutex is only acquired if the file must be opened first or the
+   * space is being renamed or deleted.
+   *
+   * @param[in] io_request        IO_request type.
+   * @param[in] page_id           Space id and page no of the first page.
+   * @param[in] byte_offset       Remainder of the offset in bytes.
+   * @param[in] len               How many bytes to read or write.
+   *
+   * @return the file node, or nullptr if the tablespace does not exist.
+   */
+  fil_node_t *node_prepare_for_data_io(IO_request io_request, const Page_id &page_id, ulint byte_offset, ulint len);
+
   /**
   * @brief Frees a file node object from a tablespace memory cache.
   *
@@ -700,6 +879,23 @@ struct Fil {
   */
   void node_prepare_for_io(fil_node_t *node, fil_space_t *space);
 
+  /**
+   * @return the number of pages to keep allocated ahead of the size of the
+   * file, bounded by the current size so that small tables stay small.
+   *
+   * @param[in] node              Last file of a single-table tablespace.
+   */
+  [[nodiscard]] static page_no_t preallocate_n_pages(const fil_node_t *node) noexcept;
+
+  /**
+   * Asks the file extender to preallocate pages for the space if it is
+   * running low on them. The Fil mutex must be owned.
+   *
+   * @param[in] space             Tablespace that was extended.
+   * @param[in] node              Last file of the space.
+   */
+  void request_preallocation(const fil_space_t *space, const fil_node_t *node) noexcept;
+
   /**
    * @brief Report information about an invalid page access.
    *
@@ -723,14 +919,70 @@ struct Fil {
   /** Number of pending tablespace flushes */
   ulint m_n_pending_tablespace_flushes{};
 
+  /** Number of extensions that had to allocate the pages in the foreground */
+  ulint m_n_foreground_extends{};
+
+  /** Number of preallocations done by the file extender */
+  ulint m_n_preallocations{};
+
+  /** Number of free extents returned to the file system */
+  ulint m_n_punched_holes{};
+
   /** When program is run, the default directory "." is the current datadir,
   but in ibbackup we must set it explicitly; the path must NOT contain the
   trailing '/' or '' */
   const char *m_path_to_client_datadir{};
 
+  /** Lock-free copy of m_space_by_id for the data file i/o path. The space
+  id is split into three radix levels; the directories are allocated on demand
+  and only freed in the destructor, so a lookup is three atomic loads. Only
+  spaces with a single data file are entered, once the file node was added.
+  The readers must be in an m_rcu read section, a space that is removed from
+  the map is only freed after m_rcu.synchronize(). The writers must own the
+  Fil mutex. */
+  struct Space_map {
+    /** Number of space id bits resolved by a leaf. */
+    static constexpr ulint LEAF_BITS = 11;
+
+    /** Number of space id bits resolved by a directory. */
+    static constexpr ulint DIR_BITS = 11;
+
+    /** Number of space id bits resolved by the root. */
+    static constexpr ulint ROOT_BITS = sizeof(space_id_t) * 8 - DIR_BITS - LEAF_BITS;
+
+    struct Leaf {
+      std::array<std::atomic<fil_space_t *>, 1 << LEAF_BITS> m_spaces;
+    };
+
+    struct Dir {
+      std::array<std::atomic<Leaf *>, 1 << DIR_BITS> m_leaves;
+    };
+
+    /** Destructor */
+    ~Space_map() noexcept;
+
+    /** @return the space, nullptr if not found.
+     * @param[in] space_id        Tablespace ID. */
+    [[nodiscard]] fil_space_t *get(space_id_t space_id) const noexcept;
+
+    /** Enters or removes a space.
+     * @param[in] space_id        Tablespace ID.
+     * @param[in] space           Space to enter, nullptr to remove. */
+    void set(space_id_t space_id, fil_space_t *space) noexcept;
+
+    /** Root of the radix tree. */
+    std::array<std::atomic<Dir *>, 1 << ROOT_BITS> m_dirs{};
+  };
+
   /** The mutex protecting the cache */
   mutable mutex_t m_mutex{};
 
+  /** Grace periods for freeing the spaces found through m_space_map */
+  ut::Rcu m_rcu{};
+
+  /** Lock-free map from space id to the tablespace instance, see Space_map. */
+  Space_map m_space_map{};
+
   /** Map from space id to tablespace instance. */
   std::unordered_map<space_id_t, fil_space_t *> m_space_by_id{};
 
@@ -744,7 +996,7 @@ struct Fil {
   ulint m_max_n_open{};
 
   /** When we write to a file we increment this by one */
-  int64_t m_modification_counter{};
+  std::atomic<int64_t> m_modification_counter{};
 
   /** Maximum space id in the existing tables, or assigned during the time the
   server has been up; at an InnoDB startup we scan the data dictionary and set
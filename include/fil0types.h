@@ -4,7 +4,10 @@
 
 #include "innodb0types.h"
 
+#include <atomic>
+
 #include "sync0rw.h"
+#include "ut0histogram.h"
 #include "ut0lst.h"
 
 using fil_faddr_t = byte;
@@ -131,7 +134,10 @@ enum Fil_type {
   FIL_TABLESPACE = 501,
 
   /** Redo log */
-  FIL_LOG = 502
+  FIL_LOG = 502,
+
+  /** Doublewrite file */
+  FIL_DBLWR = 503
 };
 
 /** Value of fil_space_t::magic_n */
@@ -140,6 +146,10 @@ constexpr uint32_t FIL_SPACE_MAGIC_N = 89472;
 /** Value of fil_node_t::magic_n */
 constexpr uint32_t FIL_NODE_MAGIC_N = 89389;
 
+/** Flag in fil_node_t::m_n_pending, set while the file is open and new i/o's
+may be posted on it without the Fil mutex, see Fil::node_prepare_for_data_io() */
+constexpr uint32_t FIL_NODE_LOCK_FREE_IO = 1U << 31;
+
 struct fil_space_t;
 
 /** File node of a tablespace or the log data space */
@@ -156,29 +166,44 @@ struct fil_node_t {
   /** OS handle to the file, if file open */
   os_file_t m_fh;
 
+  /** Index of the file in the io_uring fixed file tables, -1 if the
+  file is not registered, see AIO::register_file() */
+  int m_fixed_fh;
+
   /** true if the 'file' is actually a raw device or a raw
   disk partition */
   bool m_is_raw_disk;
 
   /** size of the file in database pages, 0 if not known yet;
-  the possible last incomplete megabyte may be ignored if space == 0 */
-  page_no_t m_size_in_pages;
+  the possible last incomplete megabyte may be ignored if space == 0;
+  written under the Fil mutex, Fil::node_prepare_for_data_io() reads it
+  without the mutex for the bounds check of a lock-free i/o */
+  std::atomic<page_no_t> m_size_in_pages;
+
+  /** size of the file in database pages including the pages that were
+  preallocated ahead of m_size_in_pages, see Fil_extender */
+  page_no_t m_alloc_size_in_pages;
 
-  /** count of pending i/o's on this file; closing of the file is not
-  allowed if this is > 0 */
-  uint32_t m_n_pending;
+  /** count of pending i/o's on this file and the FIL_NODE_LOCK_FREE_IO
+  flag; closing of the file is not allowed if the count is > 0 */
+  std::atomic<uint32_t> m_n_pending;
 
   /** count of pending flushes on this file; closing of the file
   is not allowed if this is > 0 */
   uint32_t m_n_pending_flushes;
 
-  /** when we write to the file we increment this by one */
-  int64_t m_modification_counter;
+  /** when we write to the file we increment this by one; the i/o
+  completions update it without the Fil mutex */
+  std::atomic<int64_t> m_modification_counter;
 
   /** Up to what modification_counter value we have flushed the
   modifications to disk */
   int64_t m_flush_counter;
 
+  /** true if the size of the file changed since the last flush, the next
+  flush must then use fsync(), otherwise fdatasync() is enough */
+  bool m_needs_fsync;
+
   /** Link field for the file chain */
   UT_LIST_NODE_T(fil_node_t) m_chain;
 
@@ -187,6 +212,9 @@ struct fil_node_t {
 
   /** FIL_NODE_MAGIC_N */
   uint32_t m_magic_n;
+
+  /** @return the number of pending i/o's on the file */
+  [[nodiscard]] uint32_t n_pending() const noexcept { return m_n_pending.load() & ~FIL_NODE_LOCK_FREE_IO; }
 };
 
 /** Tablespace or log data space: let us call them by a common name space */
@@ -217,7 +245,11 @@ struct fil_space_t {
   processed on this space */
   bool m_is_being_deleted;
 
-  /** FIL_TABLESPACE or FIL_LOG */
+  /** true while the last file of the space is extended with the Fil mutex
+  released, other extensions of the space wait until it is reset */
+  bool m_is_extending;
+
+  /** FIL_TABLESPACE, FIL_LOG or FIL_DBLWR */
   Fil_type m_type;
 
   /** base node for the file chain */
@@ -239,18 +271,26 @@ struct fil_space_t {
   the tablespace is forbidden if this is positive */
   uint32_t m_n_pending_flushes;
 
+  /** number of background operations that pinned the space with
+  Fil::space_acquire(); dropping of the tablespace waits for them */
+  uint32_t m_n_pending_ops;
+
   /** latch protecting the file space storage allocation */
   rw_lock_t m_latch;
 
   /** list of spaces with at least one unflushed file we have written to */
   UT_LIST_NODE_T(fil_space_t) m_unflushed_spaces;
 
-  /** true if this space is currently in unflushed_spaces */
-  bool m_is_in_unflushed_spaces;
+  /** true if this space is currently in unflushed_spaces; the i/o
+  completions read it without the Fil mutex */
+  std::atomic<bool> m_is_in_unflushed_spaces;
 
   /** list of all spaces */
   UT_LIST_NODE_T(fil_space_t) m_space_list;
 
+  /** latency of the completed i/o requests to the space, see AIO */
+  ut::Latency_histogram m_io_latency;
+
   /** FIL_SPACE_MAGIC_N */
   uint32_t m_magic_n;
 };
@@ -32,9 +32,11 @@ Created 12/18/1995 Heikki Tuuri
 #include "page0types.h"
 #include "ut0byte.h"
 
+#include <functional>
+
 struct Log;
 struct Fil;
-struct Buf_pool;
+struct Buf_pool_manager;
 
 struct FSP {
   /* The data structures in files are defined just as byte strings in C */
@@ -69,7 +71,7 @@ struct FSP {
    * @param[in] fil             Fil instance
    * @param[in] buf_pool        Buffer pool instance
    */
-  FSP(Log *log, Fil *fil, Buf_pool *buf_pool) noexcept
+  FSP(Log *log, Fil *fil, Buf_pool_manager *buf_pool) noexcept
     : m_log(log), m_fil(fil), m_buf_pool(buf_pool) {}
 
   /**
@@ -81,7 +83,7 @@ struct FSP {
    * 
    * @return Instance of the FSP class
    */
-  [[nodiscard]] static FSP *create(Log * log, Fil *fil, Buf_pool *buf_pool) noexcept;
+  [[nodiscard]] static FSP *create(Log * log, Fil *fil, Buf_pool_manager *buf_pool) noexcept;
 
   /**
    * Destroy an instance of the FSP class.
@@ -300,6 +302,25 @@ struct FSP {
    */
   [[nodiscard]] uint64_t get_available_space_in_free_extents(space_id_t space) noexcept;
 
+  /**
+   * Returns the blocks of a free extent to the file system by punching a
+   * hole in the file. The pages of the extent must not be needed by crash
+   * recovery: the first call only notes the current LSN and the hole is
+   * punched by a later call, once a checkpoint has been made at that LSN.
+   * Called by the file extender thread, see Fil_extender.
+   *
+   * @param[in] space           Tablespace ID
+   * @param[in] page_no         First page of the extent
+   * @param[in,out] lsn         0 on the first call, the LSN after which the
+   *                            hole can be punched on the later calls
+   * @param[in] is_current      Called with the space latch held, returns false
+   *                            if the extent was freed again since lsn was noted
+   *
+   * @return true if the request is done with: the hole was punched, or the
+   *  extent or the tablespace is gone, false if it has to be retried later
+   */
+  [[nodiscard]] bool punch_free_extent(space_id_t space, page_no_t page_no, lsn_t &lsn, const std::function<bool()> &is_current) noexcept;
+
   /**
    * Frees a single page of a segment.
    * 
@@ -703,5 +724,5 @@ public:
   /** File interface. */
   Fil *m_fil{};
 
-  Buf_pool *m_buf_pool{};
+  Buf_pool_manager *m_buf_pool{};
 };
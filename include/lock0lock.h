@@ -1373,7 +1373,7 @@ private:
    * is not owned by the lock system, but by the buffer pool. We extract the buffer pool
    * pointer from Trx_sys::Fil::m_buf_pool to simplify the calls.
    */
-  Buf_pool *m_buf_pool{};
+  Buf_pool_manager *m_buf_pool{};
 
   /**
    * @brief The transaction system.
@@ -32,7 +32,7 @@ Place, Suite 330, Boston, MA 02111-1307 USA
 
 struct Lock;
 struct Trx;
-struct Buf_pool;
+struct Buf_pool_manager;
 struct Table;
 struct Index;
 
@@ -583,7 +583,7 @@ struct Lock {
    * 
    * @return A string representation of the record lock object.
    */
-  std::string rec_to_string(Buf_pool *buf_pool) const noexcept;
+  std::string rec_to_string(Buf_pool_manager *buf_pool) const noexcept;
 
   /**
    * @brief Converts the lock object to a string representation.
@@ -594,7 +594,7 @@ struct Lock {
    *
    * @return A string representation of the lock object.
    */
-  [[nodiscard]] std::string to_string(Buf_pool *buf_pool) const noexcept;
+  [[nodiscard]] std::string to_string(Buf_pool_manager *buf_pool) const noexcept;
 
   /**
    * @brief Gets the next lock in the list.
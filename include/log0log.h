@@ -39,8 +39,11 @@ Created 12/9/1995 Heikki Tuuri
 #include "srv0srv.h"
 #include "sync0rw.h"
 #include "sync0sync.h"
+#include "ut0link_buf.h"
 #include "ut0lst.h"
 
+#include <atomic>
+
 struct Log;
 struct log_group_t;
 
@@ -242,14 +245,13 @@ struct Log {
  }
  
  /**
-  * Initializes a log block in the log buffer.
+  * Initializes a log block in the log buffer. The mini-transaction that fills
+  * the previous block initializes the next one without the log mutex.
   *
   * @param log_block Pointer to the log buffer.
   * @param lsn LSN within the log block.
   */
- void block_init(byte *log_block, lsn_t lsn) const noexcept {
-   ut_ad(mutex_own(&m_mutex));
- 
+ static void block_init(byte *log_block, lsn_t lsn) noexcept {
    const auto no = block_convert_lsn_to_no(lsn);
  
    block_set_hdr_no(log_block, no);
@@ -276,50 +278,48 @@ struct Log {
  }
  
  /**
-  * Reserves space in the log buffer and writes a string to the log.
-  * The log must be released with log_release().
+  * Converts a count of log data bytes to an lsn. The lsn also counts the
+  * headers and trailers of the log blocks, the data of a block starts at
+  * LOG_BLOCK_HDR_SIZE and ends at IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE.
   *
-  * @param str The string to write to the log.
-  * @param len The length of the string.
-  * @param start_lsn[out] The start lsn of the log record.
-  * @return The end lsn of the log record, or zero if it did not succeed.
+  * @param sn Number of data bytes.
+  * @return The lsn of the data byte.
   */
- [[nodiscard]] lsn_t reserve_and_write_fast(const void *str, ulint len, lsn_t *start_lsn) noexcept {
-   auto data_len = len + m_buf_free % IB_FILE_BLOCK_SIZE;
- 
-   if (data_len >= IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
-     /* The string does not fit within the current log block
-     or the log block would become full */
-     return 0;
-   }
- 
-   *start_lsn = m_lsn;
- 
-   memcpy(m_buf + m_buf_free, str, len);
- 
-   block_set_data_len(static_cast<byte *>(ut_align_down(m_buf + m_buf_free, IB_FILE_BLOCK_SIZE)), data_len);
- 
-   m_buf_free += len;
- 
-   ut_ad(m_buf_free <= m_buf_size);
- 
-   m_lsn += len;
- 
-   return m_lsn;
+ [[nodiscard]] static lsn_t sn_to_lsn(lsn_t sn) noexcept {
+   return sn / LOG_BLOCK_DATA_SIZE * IB_FILE_BLOCK_SIZE + sn % LOG_BLOCK_DATA_SIZE + LOG_BLOCK_HDR_SIZE;
  }
- 
- /** Gets the current lsn.
+
+ /**
+  * Converts an lsn to a count of log data bytes, the inverse of sn_to_lsn().
+  *
+  * @param lsn LSN of a data byte, not within a block header or trailer.
+  * @return The number of data bytes below the lsn.
+  */
+ [[nodiscard]] static lsn_t lsn_to_sn(lsn_t lsn) noexcept {
+   ut_ad(lsn % IB_FILE_BLOCK_SIZE >= LOG_BLOCK_HDR_SIZE);
+   ut_ad(lsn % IB_FILE_BLOCK_SIZE < IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE);
+
+   return lsn / IB_FILE_BLOCK_SIZE * LOG_BLOCK_DATA_SIZE + lsn % IB_FILE_BLOCK_SIZE - LOG_BLOCK_HDR_SIZE;
+ }
+
+ /**
+  * Gets the log block of an lsn in the log buffer. The buffer is a ring, the
+  * block of an lsn is reused once the log was written past it.
+  *
+  * @param lsn LSN within the log block.
+  * @return The log block.
+  */
+ [[nodiscard]] byte *buf_block(lsn_t lsn) const noexcept {
+   return m_buf + ut_uint64_align_down(lsn, IB_FILE_BLOCK_SIZE) % m_buf_size;
+ }
+
+ /** Gets the current lsn, the end of the log reserved so far. The log records
+  * below it may still be copied to the log buffer.
   * 
   * @return	current lsn
   */
  [[nodiscard]] lsn_t get_lsn() const noexcept {
-   acquire();
- 
-   auto lsn = m_lsn;
- 
-   release();
- 
-   return lsn;
+   return sn_to_lsn(m_sn.load(std::memory_order_acquire));
  }
  
  /**
@@ -381,30 +381,62 @@ struct Log {
     off_t log_file_size) noexcept;
  
  /**
-  * @brief Opens the log for log_write_low.
-  * The log must be closed with log_close and released with log_release.
+  * @brief Reserves an lsn range for a log record group, without the log mutex.
+  * Waits if the log buffer has no room for the range until the log was
+  * written far enough. The group must be copied with write_low() and the
+  * range closed with close().
   *
-  * @param len Length of data to be catenated.
-  * @return Start lsn of the log record.
+  * @param len Length of the log record group.
+  * @param end_lsn[out] End lsn of the range.
+  * @return Start lsn of the range.
   */
- [[nodiscard]] lsn_t reserve_and_open(ulint len) noexcept;
+ [[nodiscard]] lsn_t reserve_and_open(ulint len, lsn_t *end_lsn) noexcept;
  
  /**
-  * @brief Writes to the log the string given.
-  * It is assumed that the caller holds the log mutex.
+  * @brief Copies a string to the log buffer at an lsn in a range that was
+  * reserved with reserve_and_open(). Several threads copy to their ranges
+  * concurrently, the thread that fills a log block initializes the next one.
   *
+  * @param lsn LSN where to copy the string.
   * @param str String to write.
   * @param str_len Length of the string.
+  * @return The lsn after the string.
   */
- void write_low(const byte *str, ulint str_len) noexcept;
+ [[nodiscard]] lsn_t write_low(lsn_t lsn, const byte *str, ulint str_len) noexcept;
  
  /**
-  * @brief Closes the log.
+  * @brief Closes a range after its log record group was copied to the log
+  * buffer: from then on the log writer can write it to the log files.
   *
+  * @param start_lsn Start lsn of the range.
+  * @param end_lsn End lsn of the range.
   * @param recovery Recovery flag.
-  * @return Lsn.
+  * @return End lsn.
   */
- [[nodiscard]] lsn_t close(ib_recovery_t recovery) noexcept;
+ lsn_t close(lsn_t start_lsn, lsn_t end_lsn, ib_recovery_t recovery) noexcept;
+
+ /**
+  * @brief Notes that the mini-transaction of a range has added its modified
+  * pages to the buffer pool flush lists, see buf_pool_get_oldest_modification().
+  *
+  * @param start_lsn Start lsn of the range.
+  * @param end_lsn End lsn of the range.
+  */
+ void mark_closed(lsn_t start_lsn, lsn_t end_lsn) noexcept {
+   if (end_lsn > start_lsn) {
+     m_recent_closed.add(start_lsn, end_lsn);
+   }
+ }
+
+ /**
+  * @brief Restarts the log buffer at an lsn, after recovery or when the log
+  * files were reset. The caller must own the log mutex, there must be no
+  * mini-transactions that write to the log.
+  *
+  * @param lsn LSN where the next log record group starts.
+  * @param log_block The initialized log block that contains lsn.
+  */
+ void buf_reset(lsn_t lsn, const byte *log_block) noexcept;
  
  /**
   * @brief Initializes the log.
@@ -436,6 +468,27 @@ struct Log {
   * @param flush_to_disk True if we want the written log also to be flushed to disk.
   */
  void write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept;
+
+ /**
+  * @brief Writes the log and optionally flushes it, in the calling thread.
+  * Used by write_up_to() when the log writer threads are not running and by
+  * the log writer thread.
+  *
+  * @param lsn The log sequence number up to which the log should be written,
+  *   <= the current lsn.
+  * @param wait The wait option: LOG_NO_WAIT, LOG_WAIT_ONE_GROUP,
+  *   or LOG_WAIT_ALL_GROUPS.
+  * @param flush_to_disk True if we want the written log also to be flushed to disk.
+  */
+ void write_up_to_low(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept;
+
+ /**
+  * @brief Flushes the log files to disk up to the lsn written so far. The
+  * writes can continue while the flush runs, used by the log flusher thread.
+  *
+  * @return The lsn up to which the log was flushed.
+  */
+ lsn_t flush_written() noexcept;
  
  /**
   * @brief Does a synchronous flush of the log buffer to disk.
@@ -571,10 +624,11 @@ struct Log {
  void print() noexcept;
  
  /**
-  * @brief Peeks the current lsn.
+  * @brief Peeks the current lsn. The lsn is reserved without the log mutex,
+  * this always succeeds.
   *
-  * @param lsn The output parameter where the current lsn will be stored if the function returns true.
-  * @return True if success, false if could not get the log system mutex.
+  * @param lsn The output parameter where the current lsn will be stored.
+  * @return True.
   */
  [[nodiscard]] bool peek_lsn(lsn_t *lsn) noexcept;
  
@@ -609,7 +663,11 @@ struct Log {
 
 private:
   /**
-   * Returns the oldest modified block LSN in the pool, or m_lsn if none exists.
+   * Returns the oldest modified block LSN in the pool, or the LSN up to which
+   * all the mini-transactions have added their modified pages to the flush
+   * lists if that is lower. The mini-transactions commit concurrently, those
+   * that are still between reserve_and_open() and mark_closed() can add pages
+   * that are older than the pages in the flush lists.
    * 
    * @return LSN of oldest modification
    */
@@ -747,11 +805,21 @@ public:
    */
   byte m_pad[64];
 
-  /** Log sequence number */
-  lsn_t m_lsn{};
+  /** Number of log data bytes reserved, see sn_to_lsn(); the log records
+  are copied to the log buffer after the reservation */
+  std::atomic<lsn_t> m_sn{};
+
+  /** The ranges that were copied to the log buffer, the tail is the lsn up to
+  which the log buffer is complete and can be written */
+  ut::Link_buf m_recent_written;
 
-  /** First free offset within the log buffer */
-  ulint m_buf_free{};
+  /** The ranges whose mini-transactions have added their modified pages to
+  the flush lists, the tail bounds the checkpoint lsn */
+  ut::Link_buf m_recent_closed;
+
+  /** The log buffer can be filled up to this lsn without overwriting log that
+  was not written yet */
+  std::atomic<lsn_t> m_buf_limit_lsn{};
 
   /** Mutex protecting the log */
   mutable mutex_t m_mutex{};
@@ -759,40 +827,31 @@ public:
   /* Unaligned log buffer */
   byte *m_buf_ptr{};
 
-  /** Log buffer */
+  /** Log buffer, a ring of m_buf_size bytes, see buf_block() */
   byte *m_buf{};
 
   /** Log buffer size in bytes */
   ulint m_buf_size{};
 
-  /* recommended maximum value of buf_free, after which the buffer is flushed */
-  ulint m_max_buf_free{};
-
-#ifdef UNIV_DEBUG
-
-  /** value of buf free when log was last time opened; only in the debug version */
-  ulint m_old_buf_free{};
+  /** The last, incompletely copied, log block of a write is copied here first,
+  so that the write is not changed by mini-transactions that copy to the block */
+  byte *m_write_block{};
 
-  /** value of lsn when log was last time opened; only in the debug version */
-  lsn_t m_old_lsn{};
-#endif /* UNIV_DEBUG */
+  /* recommended maximum amount of log in the buffer that was not written,
+  after which the buffer is flushed */
+  ulint m_max_buf_free{};
 
   /** This is set to true when there may be need to flush the log buffer,
   or preflush buffer pool pages, or make a checkpoint; this MUST be true
   when lsn - last_checkpoint_lsn > max_checkpoint_age; this flag is
   peeked at by log_free_check(), which does not reserve the log mutex */
-  bool m_check_flush_or_checkpoint{};
+  std::atomic<bool> m_check_flush_or_checkpoint{};
 
   /** Log groups */
   UT_LIST_BASE_NODE_T_EXTERN(log_group_t, log_groups) m_log_groups{};
 
   /** The fields involved in the log buffer flush @{ */
 
-  /** First offset in the log buffer where the byte content may not exist
-  written to file, e.g., the start offset of a log record catenated later;
-  this is advanced when a flush operation is completed to all the log groups */
-  ulint m_buf_next_to_write{};
-
   /** First log sequence number not yet written to any log group; for this
   to be advanced, it is enough that the write i/o has been completed for
   any one log group */
@@ -803,21 +862,18 @@ public:
   log groups.  Note that since InnoDB currently has only one log group therefore
   this value is redundant. Also it is possible that this value falls behind
   the flushed_to_disk_lsn transiently.  It is appropriate to use either
-  flushed_to_disk_lsn or write_lsn which are always up-to-date and accurate. */
-  lsn_t m_written_to_all_lsn{};
+  flushed_to_disk_lsn or write_lsn which are always up-to-date and accurate.
+  Updated under the log mutex, the log writer waiters peek at it. */
+  std::atomic<lsn_t> m_written_to_all_lsn{};
 
   /** End lsn for the current running write */
   lsn_t m_write_lsn{};
 
-  /** THe data in buffer has been written up to this offset when the current
-  write ends: this field will then be copied to buf_next_to_write */
-  ulint m_write_end_offset{};
-
   /** End lsn for the current running write + flush operation */
   lsn_t m_current_flush_lsn{};
 
   /** How far we have written the log AND flushed to disk */
-  lsn_t m_flushed_to_disk_lsn{};
+  std::atomic<lsn_t> m_flushed_to_disk_lsn{};
 
   /** Number of currently pending flushes or writes */
   ulint m_n_pending_writes{};
@@ -240,6 +240,10 @@ struct Recv_sys {
   /** this is true when a log rec application batch is running */
   bool m_apply_batch_on{};
 
+  /** this is true when the apply threads of a batch apply the log records:
+  the i/o-handler then only reads the pages in */
+  bool m_apply_in_threads{};
+
   /** log sequence number */
   lsn_t m_lsn{};
 
@@ -319,6 +323,9 @@ use these free frames to read in pages when we start applying the
 log records to the database. */
 extern ulint recv_n_pool_free_frames;
 
+/** Maximum number of threads that apply the log records in a batch. */
+constexpr ulint RECV_MAX_APPLY_THREADS = 64;
+
 /** Size of the parsing buffer; it must accommodate RECV_SCAN_SIZE many times! */
 constexpr ulint RECV_PARSING_BUF_SIZE = 2 * 1024 * 1024;
 
@@ -72,6 +72,9 @@ constexpr ulint LOG_BLOCK_CHECKSUM = 4;
 /** trailer size in bytes */
 constexpr ulint LOG_BLOCK_TRL_SIZE = 4;
 
+/** Number of log data bytes in a log block */
+constexpr ulint LOG_BLOCK_DATA_SIZE = IB_FILE_BLOCK_SIZE - LOG_BLOCK_HDR_SIZE - LOG_BLOCK_TRL_SIZE;
+
 /** Maximum number of log groups in log_group_struct::checkpoint_buf */
 constexpr ulint LOG_MAX_N_GROUPS = 32;
 
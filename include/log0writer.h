@@ -0,0 +1,270 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file include/log0writer.h
+Background writing and flushing of the redo log.
+
+The log writer thread writes the log buffer to the log files and the log
+flusher thread flushes the log files to disk. A thread that needs the log
+written or flushed up to an lsn records the request, wakes up the writer,
+or the flusher if the log was already written far enough, and waits on an
+event that is picked by its lsn. Each write covers everything that the
+mini-transactions have copied to the log buffer by then, and each flush
+everything that was written: the transactions that commit while a write or
+a flush is running share the next one.
+
+A thread that does not want to wait registers a callback instead, the
+flusher invokes it once the log is flushed up to the lsn.
+*******************************************************/
+
+#pragma once
+
+#include "innodb0types.h"
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+struct Log;
+
+struct Log_writer {
+  /** Number of events that the waiters are spread over, by the log block
+  of the lsn they wait for. */
+  static constexpr ulint N_EVENTS = 64;
+
+  /** Invoked when the log is flushed up to the lsn it was registered for. */
+  using Callback = void (*)(void *arg);
+
+  /**
+   * Constructor.
+   *
+   * @param[in,out] log         Log to write and flush.
+   */
+  explicit Log_writer(Log *log) noexcept;
+
+  /**
+   * Destructor.
+   */
+  ~Log_writer() noexcept;
+
+  /**
+   * Create an instance of the log writer.
+   *
+   * @param[in,out] log         Log to write and flush.
+   *
+   * @return an instance or nullptr if there is an error.
+   */
+  [[nodiscard]] static Log_writer *create(Log *log) noexcept;
+
+  /**
+   * Destroy an instance of the log writer, the threads must have been stopped.
+   *
+   * @param[in,out] log_writer  Instance to destroy, set to nullptr.
+   */
+  static void destroy(Log_writer *&log_writer) noexcept;
+
+  /**
+   * Start the writer and the flusher threads.
+   */
+  void start() noexcept;
+
+  /**
+   * Stop the threads and wait for them to exit. The threads that are waiting
+   * do the write or the flush themselves from then on.
+   */
+  void shutdown() noexcept;
+
+  /**
+   * Requests the log to be written, and optionally flushed, up to an lsn and
+   * waits for it.
+   *
+   * @param[in] lsn             Log sequence number, <= the current lsn.
+   * @param[in] wait            LOG_NO_WAIT, LOG_WAIT_ONE_GROUP or LOG_WAIT_ALL_GROUPS.
+   * @param[in] flush_to_disk   true if the log must also be flushed to disk.
+   */
+  void write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept;
+
+  /**
+   * Requests the log to be flushed up to an lsn and returns at once. The
+   * callback is invoked by the flusher thread when the log is flushed that
+   * far, or by the caller if the threads were stopped. It must be quick, the
+   * next flush waits for it.
+   *
+   * @param[in] lsn             Log sequence number, <= the current lsn.
+   * @param[in] callback        Invoked when the log is flushed up to lsn.
+   * @param[in] arg             Argument of the callback.
+   */
+  void flush_async(lsn_t lsn, Callback callback, void *arg) noexcept;
+
+  /**
+   * @return true if the writer and the flusher threads are running.
+   */
+  [[nodiscard]] bool is_active() const noexcept { return m_n_threads_active.load(std::memory_order_relaxed) > 0; }
+
+  /**
+   * @return the number of log writes done by the writer thread.
+   */
+  [[nodiscard]] ulint get_n_writes() const noexcept { return m_n_writes.load(std::memory_order_relaxed); }
+
+  /**
+   * @return the number of log flushes done by the flusher thread.
+   */
+  [[nodiscard]] ulint get_n_flushes() const noexcept { return m_n_flushes.load(std::memory_order_relaxed); }
+
+ private:
+  /** Waiters for the log to reach an lsn. */
+  struct alignas(hardware_destructive_interference_size) Event {
+    /** Protects the wait. */
+    std::mutex m_mutex{};
+
+    /** Signalled when the log reaches the lsn of a waiter. */
+    std::condition_variable m_cv{};
+  };
+
+  using Events = std::array<Event, N_EVENTS>;
+
+  /** A callback that waits for the log to be flushed. */
+  struct Pending {
+    /** The callback runs first for the smallest lsn. */
+    bool operator<(const Pending &rhs) const noexcept { return m_lsn > rhs.m_lsn; }
+
+    /** LSN to wait for. */
+    lsn_t m_lsn{};
+
+    /** Callback to invoke. */
+    Callback m_callback{};
+
+    /** Argument of the callback. */
+    void *m_arg{};
+  };
+
+  /** A background thread and its wake up signal. */
+  struct Thread {
+    /** Protects m_wakeup_requested. */
+    std::mutex m_mutex{};
+
+    /** Signalled when there is work or on shutdown. */
+    std::condition_variable m_cv{};
+
+    /** true if the thread may be waiting on m_cv. */
+    std::atomic<bool> m_waiting{};
+
+    /** true if wakeup() was called since the thread last checked. */
+    bool m_wakeup_requested{};
+  };
+
+  /**
+   * Wakes up a thread if it waits.
+   *
+   * @param[in,out] thread      Thread to wake up.
+   */
+  static void wakeup(Thread &thread) noexcept;
+
+  /**
+   * Waits until there is work for a thread, on shutdown or for a second.
+   *
+   * @param[in,out] thread      Thread that waits.
+   * @param[in] has_work        Returns true if there is work.
+   *
+   * @return false on shutdown.
+   */
+  template <typename F>
+  [[nodiscard]] bool wait_for_work(Thread &thread, F &&has_work) noexcept;
+
+  /**
+   * Wakes up the waiters on the events of the log blocks from one lsn to another.
+   *
+   * @param[in,out] events      Events of the writes or of the flushes.
+   * @param[in] old_lsn         LSN that was reached before.
+   * @param[in] new_lsn         LSN that is reached now.
+   */
+  static void notify(Events &events, lsn_t old_lsn, lsn_t new_lsn) noexcept;
+
+  /**
+   * Invokes the callbacks that wait for the log to be flushed up to an lsn.
+   *
+   * @param[in] lsn             LSN that the log is flushed up to.
+   */
+  void run_callbacks(lsn_t lsn) noexcept;
+
+  /**
+   * The writer thread.
+   *
+   * @param[in] arg             The Log_writer instance.
+   *
+   * @return nullptr.
+   */
+  static void *writer_thread(void *arg) noexcept;
+
+  /**
+   * The flusher thread.
+   *
+   * @param[in] arg             The Log_writer instance.
+   *
+   * @return nullptr.
+   */
+  static void *flusher_thread(void *arg) noexcept;
+
+ private:
+  /** Log to write and flush. */
+  Log *m_log{};
+
+  /** The writer thread. */
+  Thread m_writer{};
+
+  /** The flusher thread. */
+  Thread m_flusher{};
+
+  /** true if the threads should exit. */
+  std::atomic<bool> m_shutdown{};
+
+  /** The highest lsn that a thread wants written. */
+  alignas(hardware_destructive_interference_size) std::atomic<lsn_t> m_write_requested_lsn{};
+
+  /** The highest lsn that a thread wants flushed to disk. */
+  alignas(hardware_destructive_interference_size) std::atomic<lsn_t> m_flush_requested_lsn{};
+
+  /** Waiters for the log to be written. */
+  Events m_write_events{};
+
+  /** Waiters for the log to be flushed. */
+  Events m_flush_events{};
+
+  /** Protects m_pending. */
+  std::mutex m_pending_mutex{};
+
+  /** Callbacks that wait for the log to be flushed, smallest lsn first. */
+  std::priority_queue<Pending, std::vector<Pending>> m_pending{};
+
+  /** The smallest lsn in m_pending, or LSN_MAX if there are none. */
+  std::atomic<lsn_t> m_pending_min_lsn{LSN_MAX};
+
+  /** Number of threads that are running. */
+  std::atomic<ulint> m_n_threads_active{};
+
+  /** Log writes done by the writer thread. */
+  std::atomic<ulint> m_n_writes{};
+
+  /** Log flushes done by the flusher thread. */
+  std::atomic<ulint> m_n_flushes{};
+};
+
+/** The log writer, nullptr if the threads that commit write the log themselves. */
+extern Log_writer *srv_log_writer;
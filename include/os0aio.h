@@ -18,6 +18,9 @@ limitations under the License.
 #pragma once
 
 #include "innodb0types.h"
+#include "ut0histogram.h"
+
+#include <sys/uio.h>
 
 struct fil_node_t;
 
@@ -29,6 +32,22 @@ constexpr ulint WRITE = 2;
 
 using Queue_id = ulint;
 
+/** Maximum number of buffers in a vectored (readv/writev) request. */
+constexpr ulint MAX_IOVECS = 64;
+
+/** A file to flush with AIO::fsync(). */
+struct Fsync_request {
+  /** File to flush. */
+  os_file_t m_fh{-1};
+
+  /** true if only the data and the metadata needed to read it back have
+  to be flushed, as with fdatasync(). */
+  bool m_datasync{};
+
+  /** Result, 0 or -errno. */
+  int m_ret{};
+};
+
 } // namespace aio
 
 /** Types for aio operations @{ */
@@ -44,9 +63,54 @@ enum class IO_request {
   Sync_log_write,
 };
 
+/** Priority classes of i/o requests, from the highest to the lowest. The
+class decides the kernel i/o priority of a request and how many of the slots
+of its handler the requests of the class can hold at the same time. */
+enum class IO_priority : uint8_t {
+  /** Derive the class from the request type, see IO_ctx::priority(). */
+  Default,
+
+  /** A user thread waits for the page, e.g., a buffer pool miss. */
+  Sync_read,
+
+  /** Redo log reads and writes. */
+  Log,
+
+  /** Read-ahead on behalf of a user thread. */
+  Read_ahead,
+
+  /** Background flushing of modified pages. */
+  Flush,
+
+  /** Background prefetch, e.g., reads of recovery and buffer pool load. */
+  Prefetch,
+};
+
+namespace aio {
+
+/** Number of priority classes, IO_priority::Default is not a class. */
+constexpr ulint N_PRIORITIES = 5;
+
+} // namespace aio
+
 struct IO_ctx {
   void validate() const noexcept;
 
+  /** @return the priority class of the request. */
+  IO_priority priority() const noexcept {
+    if (m_priority != IO_priority::Default) {
+      return m_priority;
+    } else if (is_log_request()) {
+      return IO_priority::Log;
+    } else if (!is_read_request()) {
+      return IO_priority::Flush;
+    } else if (is_sync_request()) {
+      return IO_priority::Sync_read;
+    } else {
+      return IO_priority::Read_ahead;
+    }
+  }
+
   bool is_sync_request() const noexcept {
     switch (m_io_request) {
       case IO_request::Sync_read:
@@ -92,13 +156,16 @@ struct IO_ctx {
     m_batch = false;
     m_fil_node = nullptr;
     m_msg = nullptr;
+    m_n_msgs = 1;
+    m_priority = IO_priority::Default;
     m_io_request = IO_request::None;
   }
 
   /** IO file operation result. */
   int m_ret{-1}; 
 
-  /**  Batch mode, we need to wake up the IO handler threads after posting the batch. */
+  /** Batch mode, the request is queued but it is not passed to the kernel
+  until the posting thread calls AIO::submit_batch(). */
   bool m_batch{};
 
   /** File meta data. */
@@ -109,6 +176,13 @@ struct IO_ctx {
 
   /** Request type. */
   IO_request m_io_request{};
+
+  /** Number of user defined messages. If > 1 then m_msg points to an array
+  of that many messages, one per buffer of a vectored request. */
+  uint32_t m_n_msgs{1};
+
+  /** Priority class of the request. */
+  IO_priority m_priority{IO_priority::Default};
 };
 
 struct AIO {
@@ -119,10 +193,15 @@ struct AIO {
   * @param[in] n_slots          Total number of slots per handler
   * @param[in] n_read_queues    Number of queues for read operations
   * @param[in] n_write_queues   Number of queues for write operations
+  * @param[in] sqpoll_idle_ms   If > 0 the queues are polled by a kernel
+  *                             thread (IORING_SETUP_SQPOLL) that sleeps after
+  *                             this many milliseconds without submissions.
+  *                             Falls back to normal submission if the kernel
+  *                             refuses.
   * 
   * @retval AIO* Pointer to the created instance. Call destroy() below to delete it.
   */
-  static AIO* create(ulint n_slots, ulint n_read_queues, ulint n_write_queues) noexcept;
+  static AIO* create(ulint n_slots, ulint n_read_queues, ulint n_write_queues, ulint sqpoll_idle_ms) noexcept;
 
   /** Destroy an instance that was created using AIO::create()
    * @param[own] aio The instance to destroy.
@@ -144,6 +223,79 @@ struct AIO {
   */
   [[nodiscard]] virtual db_err submit(IO_ctx&& io_ctx, void *buf, ulint n, off_t off) noexcept = 0;
 
+  /**
+  * @brief Submit a vectored asynchronous request, the buffers are read from or
+  * written to consecutive file offsets with a single readv/writev operation.
+  * Requests with a single buffer should use the submit() above, it can use
+  * the registered (fixed) buffers.
+  *
+  * @param[in] io_ctx           Context of the i/o operation, must not be a
+  *                             synchronous request.
+  * @param[in] iov              The buffers, the array is copied.
+  * @param[in] n_iov            Number of buffers, at most aio::MAX_IOVECS.
+  * @param[in] off              File offset of the first buffer.
+  * @return DB_SUCCESS or error code.
+  */
+  [[nodiscard]] virtual db_err submit(IO_ctx&& io_ctx, const iovec *iov, ulint n_iov, off_t off) noexcept = 0;
+
+  /**
+  * @brief Submits the asynchronous requests that the calling thread has
+  * posted with IO_ctx::m_batch set since its last call, with a single
+  * io_uring_submit() per queue. A thread that posts a batch must call this
+  * before it waits for any of the requests to complete.
+  */
+  virtual void submit_batch() noexcept = 0;
+
+  /**
+  * @brief Registers a memory area that stays mapped for a long time, e.g.,
+  * the page frames of a buffer pool chunk, with the kernel. Reads and writes
+  * to the area then use IORING_OP_READ_FIXED/WRITE_FIXED and the kernel
+  * doesn't have to pin the pages for every request. If the area cannot be
+  * registered the requests fall back to ordinary reads and writes.
+  *
+  * @param[in] ptr              Start of the area.
+  * @param[in] len              Length of the area in bytes.
+  */
+  virtual void register_buffer(void *ptr, ulint len) noexcept = 0;
+
+  /**
+  * @brief Unregisters a memory area that was registered with
+  * register_buffer(). There must be no pending requests to the area.
+  *
+  * @param[in] ptr              Start of the area.
+  * @param[in] len              Length of the area in bytes.
+  */
+  virtual void unregister_buffer(void *ptr, ulint len) noexcept = 0;
+
+  /**
+  * @brief Registers an open file with the kernel as a fixed file, the
+  * requests to the file then skip the file descriptor lookup and
+  * reference counting. If the file cannot be registered the requests use
+  * the file descriptor.
+  *
+  * @param[in,out] fil_node     File to register, sets m_fixed_fh.
+  */
+  virtual void register_file(fil_node_t *fil_node) noexcept = 0;
+
+  /**
+  * @brief Unregisters a file that was registered with register_file(). Must be
+  * called before the file is closed, with no pending requests to the file.
+  *
+  * @param[in,out] fil_node     File to unregister, resets m_fixed_fh.
+  */
+  virtual void unregister_file(fil_node_t *fil_node) noexcept = 0;
+
+  /**
+  * @brief Flushes several files to disk in parallel, one IORING_OP_FSYNC per
+  * file on an io_uring that is used only for this, and waits until they all
+  * complete. Falls back to one fsync() or fdatasync() call at a time if the
+  * io_uring could not be created.
+  *
+  * @param[in,out] requests     Files to flush, the results are set.
+  * @param[in] n_requests       Number of files.
+  */
+  virtual void fsync(aio::Fsync_request *requests, ulint n_requests) noexcept = 0;
+
   /**
   * @brief Reaps requests that have completed. It's a blocking function.
   *
@@ -153,6 +305,27 @@ struct AIO {
   */
   [[nodiscard]] virtual db_err reap(aio::Queue_id queue_id, IO_ctx &io_ctx) noexcept = 0;
 
+  /**
+  * @brief Adds the latency histogram of the completed requests of a type to
+  * a snapshot. The latency of a request is measured from when it is passed to
+  * the kernel until it completes, the histogram of each tablespace is in
+  * fil_space_t::m_io_latency.
+  *
+  * @param[in] io_request       Request type.
+  * @param[in,out] snapshot     Snapshot to add the histogram to.
+  */
+  virtual void io_latency(IO_request io_request, ut::Latency_histogram::Snapshot &snapshot) noexcept = 0;
+
+  /**
+  * @brief Returns the number of times a request of a priority class waited
+  * because the class held all the slots it may hold in its handler.
+  *
+  * @param[in] priority         Priority class.
+  *
+  * @return the number of waits.
+  */
+  virtual uint64_t n_throttled(IO_priority priority) noexcept = 0;
+
   /**
   * @brief Waits until there are no pending operations
   * 
@@ -171,6 +344,25 @@ struct AIO {
   virtual std::string to_string() noexcept = 0;
 };
 
+inline const char* to_string(IO_priority priority) noexcept {
+  switch(priority) {
+    case IO_priority::Default:
+      return "default";
+    case IO_priority::Sync_read:
+      return "sync_read";
+    case IO_priority::Log:
+      return "log";
+    case IO_priority::Read_ahead:
+      return "read_ahead";
+    case IO_priority::Flush:
+      return "flush";
+    case IO_priority::Prefetch:
+      return "prefetch";
+  }
+  ut_error;
+  return "Unknown IO priority";
+}
+
 inline const char* to_string(IO_request request) noexcept {
   switch(request) {
     case IO_request::None:
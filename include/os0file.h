@@ -299,6 +299,31 @@ int64_t os_file_get_size_as_iblonglong(os_file_t file);
  */
 bool os_file_set_size(const char *name, os_file_t file, off_t desired_size);
 
+/**
+ * @brief Extends a file, the blocks are allocated with fallocate() if the
+ * file system supports it, otherwise zeros are written. The file is not
+ * flushed.
+ *
+ * @param name Name of the file or path as a null-terminated string.
+ * @param file Handle to a file.
+ * @param off Offset of the range to allocate, usually the current size.
+ * @param len Length of the range in bytes.
+ * @return True if success.
+ */
+bool os_file_extend(const char *name, os_file_t file, off_t off, off_t len);
+
+/**
+ * @brief Deallocates a range of a file, the range reads back as zeros and
+ * the size of the file doesn't change.
+ *
+ * @param name Name of the file or path as a null-terminated string.
+ * @param file Handle to a file.
+ * @param off Offset of the range.
+ * @param len Length of the range in bytes.
+ * @return True if success, false also if the file system doesn't support it.
+ */
+bool os_file_punch_hole(const char *name, os_file_t file, off_t off, off_t len);
+
 /**
  * @brief Truncates a file at its current position.
  *
@@ -311,9 +336,21 @@ bool os_file_set_eof(FILE *file);
  * @brief Flushes the write buffers of a given file to the disk.
  *
  * @param file Handle to a file.
+ * @param data_only Use fdatasync(), the metadata of the file that isn't
+ *  needed to read the data back, e.g., the modification time, is not flushed.
+ * @return True if success.
+ */
+bool os_file_flush(os_file_t file, bool data_only = false);
+
+/**
+ * @brief Flushes the file systems that contain the given files with one
+ * syncfs() call per file system.
+ *
+ * @param files Handles to the files.
+ * @param n_files Number of files.
  * @return True if success.
  */
-bool os_file_flush(os_file_t file);
+bool os_file_syncfs(const os_file_t *files, ulint n_files);
 
 /**
  * @brief Retrieves the last error number if an error occurs in a file io function.
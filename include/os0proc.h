@@ -46,7 +46,18 @@ the thread id is not the same as one sees in 'top'.
 @return	process id as a number */
 ulint os_proc_get_number();
 
-/** Allocates large pages memory.
+/**
+ * Sets up the use of large pages by os_mem_alloc_large(). Must be called
+ * before the buffer pool is created.
+ *
+ * @param[in] use_large_pages   true if large pages should be used.
+ * @param[in] large_page_size   Large page size in bytes, 0 for the default
+ *                              huge page size of the system.
+ */
+void os_large_pages_init(bool use_large_pages, ulint large_page_size);
+
+/** Allocates large pages memory. Tries HugeTLB pages first, then transparent
+huge pages and falls back to conventional memory if both fail.
 @return	allocated memory */
 void *os_mem_alloc_large(ulint *n); /*!< in/out: number of bytes */
 
@@ -58,5 +69,23 @@ void os_mem_free_large(
 ); /*!< in: size returned by
                                     os_mem_alloc_large() */
 
+/**
+ * Excludes memory from core dumps.
+ *
+ * @param[in] ptr               Start of the memory, aligned to the OS page size.
+ * @param[in] size              Number of bytes.
+ */
+void os_mem_exclude_from_core(void *ptr, ulint size);
+
+/**
+ * Returns the physical memory of a range to the operating system. The range
+ * stays mapped and reads back as zeros, so that stale pointers into it do
+ * not fault. The range is shrunk to whole large pages if they are in use.
+ *
+ * @param[in] ptr               Start of the memory, aligned to the OS page size.
+ * @param[in] size              Number of bytes.
+ */
+void os_mem_release(void *ptr, ulint size);
+
 /** Reset the variables. */
 void os_proc_var_init();
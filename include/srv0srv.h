@@ -81,6 +81,20 @@ enum {
   SRV_UNIX_O_DIRECT
 };
 
+/** Alternatives for the replacement policy of the buffer pool LRU list;
+see buf0lru.h about what these mean */
+enum {
+  /** Midpoint insertion, the default */
+  SRV_LRU_MIDPOINT = 1,
+
+  /** Scan resistant 2Q, the old blocks are the FIFO of pages referenced
+  once and the page ids evicted from it are remembered */
+  SRV_LRU_2Q,
+
+  /** CLOCK, an access only sets a reference bit on the page */
+  SRV_LRU_CLOCK
+};
+
 /** Shutdown state */
 enum srv_shutdown_state {
   /** Database running normally */
@@ -180,6 +194,19 @@ struct Config {
   /** Whether to create a new file for each table. */
   bool m_file_per_table{};
 
+  /** Minimum increment in megabytes by which a tablespace that is larger
+  than 32 extents is extended, bigger tablespaces grow by 1/16 of their
+  size, see FSP::try_extend_data_file(). */
+  ulint m_autoextend_increment{8};
+
+  /** Megabytes that the file extender keeps allocated ahead of the size
+  of each single-table tablespace that grows, 0 disables it. */
+  ulint m_file_preallocate_size{64};
+
+  /** Whether the blocks of the extents that become free are returned to
+  the file system, see FSP::punch_free_extent(). */
+  bool m_punch_holes{false};
+
   /** Whether a new raw disk partition was initialized. */
   bool m_created_new_raw{};
 
@@ -200,6 +227,10 @@ struct Config {
 
   /** Whether to flush the log at transaction commit. */
   ulong m_flush_log_at_trx_commit{1};
+
+  /** Whether dedicated threads write and flush the log, the transactions
+  that commit then wait for them instead of doing the i/o. */
+  bool m_log_writer_threads{true};
   
   /** Whether to use adaptive flushing. */
   bool m_adaptive_flushing{true};
@@ -207,6 +238,12 @@ struct Config {
   /** Whether to use sys malloc. */
   bool m_use_sys_malloc{true};
 
+  /** Whether to back the buffer pool with huge pages. */
+  bool m_use_large_pages{false};
+
+  /** Huge page size in bytes, 0 for the default huge page size of the system. */
+  ulint m_large_page_size{0};
+
   /** Size of the buffer pool, in pages. */
   ulint m_buf_pool_size{ULINT_MAX};
 
@@ -216,6 +253,22 @@ struct Config {
   /** Current size of the buffer pool, in pages. */
   ulint m_buf_pool_curr_size{};
 
+  /** Number of buffer pool instances. */
+  ulint m_buf_pool_instances{1};
+
+  /** Size of a buffer pool chunk in bytes, the unit in which the buffer pool
+  instances are allocated and in which they grow and shrink online. */
+  ulint m_buf_pool_chunk_size{128 * 1024 * 1024};
+
+  /** Number of page cleaner threads, 0 if the master thread flushes. */
+  ulint m_page_cleaners{1};
+
+  /** Whether to dump the page ids of the buffer pool at shutdown. */
+  bool m_buf_pool_dump_at_shutdown{false};
+
+  /** Whether to load the pages of the last buffer pool dump at startup. */
+  bool m_buf_pool_load_at_startup{false};
+
   /** Memory pool size in bytes */
   ulint m_mem_pool_size{ULINT_MAX};
 
@@ -228,16 +281,35 @@ struct Config {
   /** Number of write I/O threads. */
   ulint m_n_write_io_threads{ULINT_MAX};
 
+  /** Whether the io_uring queues are polled by a kernel thread, see
+   * IORING_SETUP_SQPOLL. Trades a core for lower submission latency. */
+  bool m_io_uring_sqpoll{false};
+
+  /** Milliseconds without submissions after which the io_uring polling
+   * thread goes to sleep. */
+  ulint m_io_uring_sqpoll_idle{ULINT_MAX};
+
   /** User settable value of the number of pages that must be present
    * in the buffer cache and accessed sequentially for InnoDB to trigger a
    * readahead request. */
   ulong m_read_ahead_threshold{56};
 
+  /** Whether to read in the rest of an extent when enough of its pages
+   * have been recently accessed, regardless of the access order. */
+  bool m_random_read_ahead{false};
+
   /** Number of IO operations per second the server can do */ 
   ulong m_io_capacity{200};
   
   /** File flush method. */
   ulint m_unix_file_flush_method{SRV_UNIX_FSYNC};
+
+  /** Whether Fil::flush_file_spaces() flushes the tablespaces with one
+   * syncfs() per file system instead of flushing each written file. */
+  bool m_flush_syncfs{false};
+
+  /** Replacement policy of the buffer pool LRU list. */
+  ulint m_LRU_policy{SRV_LRU_MIDPOINT};
   
   /** Maximum number of open files. */  
   ulint m_max_n_open_files{1024};
@@ -249,6 +321,9 @@ struct Config {
   /** Force recovery. */
   ib_recovery_t m_force_recovery{IB_RECOVERY_DEFAULT};
 
+  /** Number of threads that apply the redo log during crash recovery. */
+  ulint m_recovery_apply_threads{4};
+
   /** Fast shutdown. */
   ib_shutdown_t m_fast_shutdown{IB_SHUTDOWN_NORMAL};
 
@@ -261,6 +336,11 @@ struct Config {
   
   /** Whether to use doublewrite buffer. */
   bool m_use_doublewrite_buf{true};
+
+  /** Number of doublewrite files the doublewrite batches are spread over.
+  There is one batch per buffer pool instance and at most one file per batch,
+  with the default single instance only one file is used. */
+  ulint m_n_dblwr_files{2};
   
   /** Whether to use checksums. */
   bool m_use_checksums{true};
@@ -331,6 +411,9 @@ constexpr ulint SRV_MAX_N_IO_THREADS = 32;
 /** Log 'spaces' have id's >= this */
 constexpr ulint SRV_LOG_SPACE_FIRST_ID = 0xFFFFFFF0UL;
 
+/** Doublewrite file 'spaces' have id's >= this, they are kept open like the log */
+constexpr ulint SRV_DBLWR_SPACE_FIRST_ID = SRV_LOG_SPACE_FIRST_ID + 8;
+
 /* the number of the log write requests done */
 extern ulint srv_log_write_requests;
 
@@ -623,6 +706,18 @@ struct Export_vars {
   /** Data bytes written */
   ulint innodb_data_written;            
 
+  /** Fil::get_foreground_extends() */
+  ulint innodb_data_foreground_extends;
+
+  /** Fil::get_preallocations() */
+  ulint innodb_data_preallocations;
+
+  /** Fil::get_punched_holes() */
+  ulint innodb_data_punched_holes;
+
+  /** AIO::n_throttled() of all the priority classes */
+  ulint innodb_data_throttled_reqs;
+
   /** I/O read requests */
   ulint innodb_data_reads;              
 
@@ -667,6 +762,9 @@ struct Export_vars {
   /** srv_read_ahead evicted*/
   ulint innodb_buffer_pool_read_ahead_evicted; 
 
+  /** srv_read_ahead used */
+  ulint innodb_buffer_pool_read_ahead_used;
+
   /** srv_dblwr_pages_written */
   ulint innodb_dblwr_pages_written;            
 
@@ -353,7 +353,8 @@ its logical level is SYNC_SEARCH_SYS, as memory allocation can call routines
 there! Otherwise the level is SYNC_MEM_HASH. */
 constexpr ulint SYNC_SEARCH_SYS = 160;
 
-constexpr ulint SYNC_BUF_POOL = 150;
+constexpr ulint SYNC_BUF_POOL = 151;
+constexpr ulint SYNC_BUF_PAGE_HASH = 150;
 constexpr ulint SYNC_BUF_BLOCK = 149;
 constexpr ulint SYNC_PARALLEL_READ = 148;
 constexpr ulint SYNC_DOUBLEWRITE = 140;
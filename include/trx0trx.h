@@ -545,6 +545,10 @@ struct Trx {
   /** LSN at the time of the commit */
   lsn_t m_commit_lsn{};
 
+  /** true if the commit does not write or flush the log, the caller waits
+  for the flush itself, see ib_trx_commit_async() */
+  bool m_flush_log_async{};
+
   /** Table to drop iff dict_operation is true, or 0. */
   trx_id_t m_table_id{};
 
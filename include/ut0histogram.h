@@ -0,0 +1,102 @@
+/***********************************************************************
+Copyright 2024 Sunny Bains
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or Implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+
+#include "innodb0types.h"
+
+namespace ut {
+
+/** Latency histogram with power of two buckets. Bucket 0 counts the samples
+below 2 microseconds, bucket i > 0 the samples in [2^i, 2^(i+1)) microseconds
+and the last bucket also counts all the longer samples. The counters are
+atomics, recording a sample doesn't need a latch. A snapshot that is taken
+while samples are recorded never has more samples in the buckets than in
+m_n_samples. */
+struct Latency_histogram {
+  /** Number of buckets, the last one starts at ~8.4 seconds. */
+  static constexpr ulint N_BUCKETS = 24;
+
+  /** A copy of the counters of one or more histograms. */
+  struct Snapshot {
+    /** Number of samples. */
+    uint64_t m_n_samples{};
+
+    /** Sum of the samples in microseconds. */
+    uint64_t m_total_us{};
+
+    /** Largest sample in microseconds. */
+    uint64_t m_max_us{};
+
+    /** Number of samples in each bucket. */
+    std::array<uint64_t, N_BUCKETS> m_buckets{};
+  };
+
+  /** @return the bucket of a sample.
+   * @param[in] us                Sample in microseconds. */
+  [[nodiscard]] static ulint bucket(uint64_t us) noexcept {
+    return us < 2 ? 0 : std::min<ulint>(std::bit_width(us) - 1, N_BUCKETS - 1);
+  }
+
+  /** Records a sample.
+   * @param[in] us                Sample in microseconds. */
+  void record(uint64_t us) noexcept {
+    m_n_samples.fetch_add(1, std::memory_order_relaxed);
+    m_total_us.fetch_add(us, std::memory_order_relaxed);
+
+    /* Pairs with the acquire in add_to(), the sample is counted first. */
+    m_buckets[bucket(us)].fetch_add(1, std::memory_order_release);
+
+    for (auto max = m_max_us.load(std::memory_order_relaxed);
+         us > max && !m_max_us.compare_exchange_weak(max, us, std::memory_order_relaxed);) {
+    }
+  }
+
+  /** Adds the counters to a snapshot, the counters of several histograms
+   * can be added to the same snapshot.
+   * @param[in,out] snapshot      Snapshot to add to. */
+  void add_to(Snapshot &snapshot) const noexcept {
+    /* The buckets are read first, a sample that is in them is counted. */
+    for (ulint i = 0; i < N_BUCKETS; ++i) {
+      snapshot.m_buckets[i] += m_buckets[i].load(std::memory_order_acquire);
+    }
+
+    snapshot.m_n_samples += m_n_samples.load(std::memory_order_relaxed);
+    snapshot.m_total_us += m_total_us.load(std::memory_order_relaxed);
+    snapshot.m_max_us = std::max(snapshot.m_max_us, m_max_us.load(std::memory_order_relaxed));
+  }
+
+  /** Number of samples. */
+  std::atomic<uint64_t> m_n_samples{};
+
+  /** Sum of the samples in microseconds. */
+  std::atomic<uint64_t> m_total_us{};
+
+  /** Largest sample in microseconds. */
+  std::atomic<uint64_t> m_max_us{};
+
+  /** Number of samples in each bucket. */
+  std::array<std::atomic<uint64_t>, N_BUCKETS> m_buckets{};
+};
+
+} // namespace ut
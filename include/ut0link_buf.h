@@ -0,0 +1,118 @@
+/***********************************************************************
+Copyright 2024 Sunny Bains
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or Implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+***********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "innodb0types.h"
+
+namespace ut {
+
+/** Tracks the completion of disjoint ranges [from, to) of a sequence that
+threads reserved up front and complete in any order, e.g., the redo log
+records that mini-transactions copy concurrently to the log buffer. A
+completed range is recorded in the slot of its start, keyed modulo the
+capacity, and advance() follows the recorded links from the tail to find
+the end of the contiguous completed prefix.
+
+The ranges must be contiguous and must not overlap: each range starts where
+the previous one ended. A slot can then only be reused once the tail has
+passed its previous range and a stale link always points at or below the
+position that is looked up. */
+struct Link_buf {
+  /** Constructor.
+   * @param[in] capacity          Number of slots, a power of 2. */
+  explicit Link_buf(std::size_t capacity) noexcept
+    : m_capacity(capacity), m_links(std::make_unique<std::atomic<uint64_t>[]>(capacity)) {
+    ut_a(std::has_single_bit(capacity));
+  }
+
+  /** Forgets all the ranges and restarts the sequence. Must not run
+   * concurrently with the other methods.
+   * @param[in] tail              Position where the next range starts. */
+  void reset(uint64_t tail) noexcept {
+    for (std::size_t i{}; i < m_capacity; ++i) {
+      m_links[i].store(0, std::memory_order_relaxed);
+    }
+
+    m_tail.store(tail, std::memory_order_release);
+  }
+
+  /** Records that a range was completed. Waits while the start of the range
+   * is a whole capacity ahead of the tail, the ranges before it complete and
+   * someone else advances the tail, or we do it ourselves.
+   * @param[in] from              Start of the range.
+   * @param[in] to                End of the range, > from. */
+  void add(uint64_t from, uint64_t to) noexcept {
+    ut_ad(to > from);
+
+    while (from - m_tail.load(std::memory_order_acquire) >= m_capacity) {
+      if (advance() <= from) {
+        std::this_thread::yield();
+      }
+    }
+
+    m_links[from & (m_capacity - 1)].store(to, std::memory_order_release);
+  }
+
+  /** Moves the tail over the completed ranges that follow it.
+   * @return the new tail, everything below it was completed. */
+  uint64_t advance() noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    auto tail = m_tail.load(std::memory_order_relaxed);
+
+    for (;;) {
+      const auto to = m_links[tail & (m_capacity - 1)].load(std::memory_order_acquire);
+
+      if (to <= tail) {
+        /* Not completed yet, or a link left from a range that was passed. */
+        break;
+      }
+
+      tail = to;
+    }
+
+    m_tail.store(tail, std::memory_order_release);
+
+    return tail;
+  }
+
+  /** @return the tail as of the last advance(). */
+  [[nodiscard]] uint64_t tail() const noexcept { return m_tail.load(std::memory_order_acquire); }
+
+ private:
+  /** Number of slots. */
+  const std::size_t m_capacity;
+
+  /** End of the range that starts at each slot, modulo the capacity. */
+  std::unique_ptr<std::atomic<uint64_t>[]> m_links;
+
+  /** Serializes advance(). */
+  std::mutex m_mutex{};
+
+  /** Everything below this was completed. */
+  alignas(hardware_destructive_interference_size) std::atomic<uint64_t> m_tail{};
+};
+
+} // namespace ut
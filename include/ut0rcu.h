@@ -0,0 +1,124 @@
+/***********************************************************************
+Copyright 2024 Sunny Bains
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or Implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+
+***********************************************************************/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "innodb0types.h"
+#include "ut0counter.h"
+
+namespace ut {
+
+/** Grace periods for read-mostly structures, in the spirit of RCU. Readers
+bracket their accesses with read_lock() and read_unlock(), they never block
+and only update a counter in a cache line picked by their thread id. A writer
+first unlinks an object so that new readers cannot find it and then calls
+synchronize(): once it returns, no reader can still reference the object and
+the writer can free it.
+
+The readers are counted in two phases. synchronize() waits for the readers
+of the previous phase to drain, flips the phase and then waits for the readers
+of the current phase, new readers enter the other phase so a steady stream of
+them cannot starve the writer. */
+struct Rcu {
+  /** Number of reader counter cache lines. */
+  static constexpr std::size_t N_SLOTS = 64;
+
+  /** Handle of a read section, returned by read_lock(). */
+  using Token = std::atomic<uint64_t> *;
+
+  /** Enters a read section, the pointers loaded from the protected structure
+   * stay valid until the matching read_unlock().
+   * @return the handle to pass to read_unlock(). */
+  [[nodiscard]] Token read_lock() noexcept {
+    auto &slot = m_slots[m_indexer.get_index() % N_SLOTS];
+    auto counter = &slot.m_n_readers[m_phase.load()];
+
+    /* Sequentially consistent so that a writer that doesn't see this
+    increment has unlinked the object before our following loads. */
+    counter->fetch_add(1);
+
+    return counter;
+  }
+
+  /** Leaves a read section.
+   * @param[in] token             Handle returned by read_lock(). */
+  static void read_unlock(Token token) noexcept {
+    token->fetch_sub(1, std::memory_order_release);
+  }
+
+  /** Waits until all the read sections that were active when this was
+   * called have ended. The caller must have unlinked the objects that it
+   * wants to free before the call. */
+  void synchronize() noexcept {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const auto phase = m_phase.load();
+
+    wait_for_readers(phase ^ 1);
+
+    m_phase.store(phase ^ 1);
+
+    wait_for_readers(phase);
+  }
+
+ private:
+  /** Waits until there are no readers in a phase.
+   * @param[in] phase             Phase to drain. */
+  void wait_for_readers(uint32_t phase) noexcept {
+    for (ulint n_rounds{};; ++n_rounds) {
+      uint64_t n_readers{};
+
+      for (const auto &slot : m_slots) {
+        n_readers += slot.m_n_readers[phase].load();
+      }
+
+      if (n_readers == 0) {
+        return;
+      } else if (n_rounds < 100) {
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    }
+  }
+
+  /** Reader counters of both phases, one cache line per slot. */
+  struct alignas(hardware_destructive_interference_size) Slot {
+    std::array<std::atomic<uint64_t>, 2> m_n_readers{};
+  };
+
+  /** Picks the slot of the calling thread. */
+  Thread_id_indexer m_indexer{};
+
+  /** Phase that new readers enter, 0 or 1. */
+  alignas(hardware_destructive_interference_size) std::atomic<uint32_t> m_phase{};
+
+  /** Serializes the writers in synchronize(). */
+  std::mutex m_mutex{};
+
+  /** Reader counters. */
+  std::array<Slot, N_SLOTS> m_slots{};
+};
+
+} // namespace ut
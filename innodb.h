@@ -50,6 +50,10 @@ using ib_msg_stream_t = FILE*;
  * behavior as fprintf(3). */
 typedef int (*ib_msg_log_t)(ib_msg_stream_t, const char*, ...);
 
+/** Invoked when the log of a transaction committed with ib_trx_commit_async()
+ * is flushed to disk. The argument is the one passed to ib_trx_commit_async(). */
+typedef void (*ib_trx_durable_t)(void*);
+
 /** \enum db_err InnoDB error codes.
  * Most of the error codes are internal to the engine
  * and will not be seen by user applications. The partial error codes reflect
@@ -817,6 +821,14 @@ extern ib_client_cmp_t  ib_client_compare;
  * @return  DB_SUCCESS or error code */
 [[nodiscard]] ib_err_t ib_shutdown(ib_shutdown_t flag);
 
+/** Write the page ids of the pages in the buffer pool to the dump file
+ * in the data home directory. The pages are read back in at the next
+ * startup if "buffer_pool_load_at_startup" is set.
+ *
+ * @ingroup init
+ * @return  DB_SUCCESS or error code */
+[[nodiscard]] ib_err_t ib_buffer_pool_dump();
+
 /** Start a transaction that's been rolled back. This special function
  * exists for the case when InnoDB's deadlock detector has rolledack
  * a transaction. While the transaction has been rolled back the handle
@@ -876,6 +888,23 @@ void ib_trx_set_client_data(ib_trx_t trx, void* client_data);
 * @return  DB_SUCCESS or err code */
 [[nodiscard]] ib_err_t ib_trx_commit(ib_trx_t trx);
 
+/** Commit a transaction without waiting for its log to be flushed to disk.
+* The locks are released and the changes are visible to other transactions
+* when it returns, like ib_trx_commit(). The callback is invoked from a
+* background thread once the log is flushed up to the commit, regardless of
+* flush_log_at_trx_commit. It is invoked before this function returns if the
+* transaction is already durable, e.g. it did not modify anything, or if the
+* log_writer_threads are not running. The callback must be quick, the next
+* log flush waits for it. This function will release the schema latches
+* too. It will also free the transaction handle.
+*
+* @ingroup trx
+* @param trx is the transaction handle
+* @param callback is invoked when the transaction is durable
+* @param arg is the argument of the callback
+* @return  DB_SUCCESS or err code */
+[[nodiscard]] ib_err_t ib_trx_commit_async(ib_trx_t trx, ib_trx_durable_t callback, void *arg);
+
 /** Rollback a transaction. This function will release the schema latches too.
 * It will also free the transaction handle.
 * 
@@ -1840,6 +1869,52 @@ struct ib_table_stats_t {
  * @returns \ref DB_SUCCESS or error.  */
 [[nodiscard]] ib_err_t ib_update_table_statistics(ib_crsr_t crsr);
 
+/** Number of buckets in an \ref ib_io_latency_t histogram. */
+constexpr int IB_IO_LATENCY_BUCKETS = 24;
+
+/** @struct ib_io_latency_t Latency histogram of completed i/o requests.
+ * Bucket 0 counts the requests that took less than 2 microseconds, bucket
+ * i > 0 the requests that took [2^i, 2^(i+1)) microseconds and the last
+ * bucket also counts all the requests that took longer. */
+struct ib_io_latency_t {
+  /** Number of completed requests */
+  uint64_t  n_ios;
+
+  /** Sum of the latencies in microseconds */
+  uint64_t  total_us;
+
+  /** Largest latency in microseconds */
+  uint64_t  max_us;
+
+  /** Number of requests in each bucket */
+  uint64_t  buckets[IB_IO_LATENCY_BUCKETS];
+};
+
+/** Get the latency histogram of an i/o request type.
+ * 
+ * The histograms are kept from startup and are cheap enough to be always on.
+ * 
+ * @ingroup misc
+ * @param type The request type, one of "Async_read", "Async_write",
+ *  "Async_log_read", "Async_log_write", "Sync_read", "Sync_write",
+ *  "Sync_log_read" or "Sync_log_write", the case is ignored
+ * @param latency a \ref ib_io_latency_t to be filled out by InnoDB
+ * @param sizeof_ib_io_latency_t sizeof(ib_io_latency_t).
+ * @returns \ref DB_SUCCESS or error. \ref DB_NOT_FOUND if the type is unknown */
+[[nodiscard]] ib_err_t ib_io_latency_get_by_type(const char *type, ib_io_latency_t *latency, size_t sizeof_ib_io_latency_t);
+
+/** Get the latency histogram of the i/o requests to the tablespace of a table.
+ * 
+ * Tables that are not in a tablespace of their own share the histogram of
+ * the system tablespace.
+ * 
+ * @ingroup misc
+ * @param table_name Name of the table, in the "database/table" format
+ * @param latency a \ref ib_io_latency_t to be filled out by InnoDB
+ * @param sizeof_ib_io_latency_t sizeof(ib_io_latency_t).
+ * @returns \ref DB_SUCCESS or error. \ref DB_TABLE_NOT_FOUND if the table is not found */
+[[nodiscard]] ib_err_t ib_io_latency_get_by_table(const char *table_name, ib_io_latency_t *latency, size_t sizeof_ib_io_latency_t);
+
 /** Inject an error into InnoDB
  * 
  * This function will simulate an error condition inside InnoDB.
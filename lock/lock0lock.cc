@@ -579,7 +579,7 @@ std::string Lock::table_to_string() const noexcept {
   return str;
 }
 
-std::string Lock::rec_to_string(Buf_pool *buf_pool) const noexcept {
+std::string Lock::rec_to_string(Buf_pool_manager *buf_pool) const noexcept {
   ut_ad(mutex_own(&kernel_mutex));
   ut_a(type() == LOCK_REC);
 
@@ -666,7 +666,7 @@ std::string Lock::rec_to_string(Buf_pool *buf_pool) const noexcept {
   return str;
 }
 
-std::string Lock::to_string(Buf_pool *buf_pool) const noexcept {
+std::string Lock::to_string(Buf_pool_manager *buf_pool) const noexcept {
   return std::format(
     "Lock {} type: {} mode: {}, - {}",
     (void *)this,
@@ -31,10 +31,12 @@ Created 12/9/1995 Heikki Tuuri
 
 #include "log0log.h"
 #include "buf0buf.h"
+#include "buf0cleaner.h"
 #include "buf0flu.h"
 #include "dict0store.h"
 #include "fil0fil.h"
 #include "log0recv.h"
+#include "log0writer.h"
 #include "mem0mem.h"
 #include "srv0srv.h"
 #include "sync0rw.h"
@@ -107,11 +109,17 @@ constexpr ulint LOG_POOL_PREFLUSH_RATIO_ASYNC = 6;
 
 /* Extra margin, in addition to one log file, used in archiving */
 
+/** Number of slots in the link buffers that track the mini-transactions that
+copy to the log buffer and add their pages to the flush lists, it bounds the
+lsn distance between the oldest and the newest of them */
+constexpr std::size_t LOG_RECENT_WRITTEN_SIZE = 1 << 16;
+constexpr std::size_t LOG_RECENT_CLOSED_SIZE = 1 << 16;
+
 /* Codes used in unlocking flush latches */
 constexpr ulint LOG_UNLOCK_NONE_FLUSHED_LOCK = 1;
 constexpr ulint LOG_UNLOCK_FLUSH_LOCK = 2;
 
-Log::Log() noexcept {
+Log::Log() noexcept : m_recent_written(LOG_RECENT_WRITTEN_SIZE), m_recent_closed(LOG_RECENT_CLOSED_SIZE) {
   mutex_create(&m_mutex, IF_DEBUG("log_sys_mutex", ) IF_SYNC_DEBUG(SYNC_LOG, ) Current_location());
 
   acquire();
@@ -119,18 +127,21 @@ Log::Log() noexcept {
   /* Start the lsn from one log block from zero: this way every
   log record has a start lsn != zero, a fact which we will use */
 
-  m_lsn = LOG_START_LSN;
+  const auto lsn = LOG_START_LSN;
 
   ut_a(LOG_BUFFER_SIZE >= 16 * IB_FILE_BLOCK_SIZE);
   ut_a(LOG_BUFFER_SIZE >= 4 * UNIV_PAGE_SIZE);
 
-  m_buf_ptr = static_cast<byte *>(mem_alloc(LOG_BUFFER_SIZE + IB_FILE_BLOCK_SIZE));
+  /* The log buffer, the block for m_write_block and the alignment. */
+  m_buf_ptr = static_cast<byte *>(mem_alloc(LOG_BUFFER_SIZE + 2 * IB_FILE_BLOCK_SIZE));
 
   m_buf = static_cast<byte *>(ut_align(m_buf_ptr, IB_FILE_BLOCK_SIZE));
 
   m_buf_size = LOG_BUFFER_SIZE;
 
-  memset(m_buf, '\0', LOG_BUFFER_SIZE);
+  m_write_block = m_buf + m_buf_size;
+
+  memset(m_buf, '\0', LOG_BUFFER_SIZE + IB_FILE_BLOCK_SIZE);
 
   m_max_buf_free = m_buf_size / LOG_BUF_FLUSH_RATIO - LOG_BUF_FLUSH_MARGIN;
   m_check_flush_or_checkpoint = true;
@@ -142,15 +153,10 @@ Log::Log() noexcept {
   m_last_printout_time = time(nullptr);
   /*----------------------------*/
 
-  m_buf_next_to_write = 0;
-
   m_write_lsn = 0;
   m_current_flush_lsn = 0;
   m_flushed_to_disk_lsn = 0;
 
-  m_written_to_some_lsn = m_lsn;
-  m_written_to_all_lsn = m_lsn;
-
   m_n_pending_writes = 0;
 
   m_no_flush_event = os_event_create(nullptr);
@@ -165,7 +171,7 @@ Log::Log() noexcept {
   m_adm_checkpoint_interval = ULINT_MAX;
 
   m_next_checkpoint_no = 0;
-  m_last_checkpoint_lsn = m_lsn;
+  m_last_checkpoint_lsn = lsn;
   m_n_pending_checkpoint_writes = 0;
 
   rw_lock_create(&m_checkpoint_lock, SYNC_NO_ORDER_CHECK);
@@ -177,11 +183,10 @@ Log::Log() noexcept {
   memset(m_checkpoint_buf, '\0', IB_FILE_BLOCK_SIZE);
   /*----------------------------*/
 
-  block_init(m_buf, m_lsn);
-  block_set_first_rec_group(m_buf, LOG_BLOCK_HDR_SIZE);
+  block_init(m_write_block, lsn);
+  block_set_first_rec_group(m_write_block, LOG_BLOCK_HDR_SIZE);
 
-  m_buf_free = LOG_BLOCK_HDR_SIZE;
-  m_lsn = LOG_START_LSN + LOG_BLOCK_HDR_SIZE;
+  buf_reset(lsn + LOG_BLOCK_HDR_SIZE, m_write_block);
 
   release();
 }
@@ -190,6 +195,25 @@ Log::~Log() noexcept {
   // FIXME:
 }
 
+void Log::buf_reset(lsn_t lsn, const byte *log_block) noexcept {
+  ut_ad(mutex_own(&m_mutex));
+  ut_ad(m_n_pending_writes == 0);
+
+  const auto block_lsn = ut_uint64_align_down(lsn, IB_FILE_BLOCK_SIZE);
+
+  memmove(buf_block(block_lsn), log_block, IB_FILE_BLOCK_SIZE);
+
+  m_sn.store(lsn_to_sn(lsn), std::memory_order_release);
+
+  m_recent_written.reset(lsn);
+  m_recent_closed.reset(lsn);
+
+  m_written_to_some_lsn = lsn;
+  m_written_to_all_lsn = lsn;
+
+  m_buf_limit_lsn.store(block_lsn + m_buf_size, std::memory_order_release);
+}
+
 void Log::var_init() noexcept {
   ut_a(log_sys == nullptr);
   log_last_warning_time = 0;
@@ -214,112 +238,99 @@ void Log::fsp_current_free_limit_set_and_checkpoint(ulint limit) noexcept {
 lsn_t Log::buf_pool_get_oldest_modification() noexcept {
   ut_ad(mutex_own(&m_mutex));
 
-  auto lsn = srv_buf_pool->get_oldest_modification();
+  /* Read the closed lsn first: the mini-transactions below it have pushed
+  their pages before, the flush lists then contain them. */
+  const auto closed_lsn = m_recent_closed.advance();
+  const auto lsn = srv_buf_pool->get_oldest_modification();
 
-  if (lsn == 0) {
-    lsn = m_lsn;
+  if (lsn == 0 || lsn > closed_lsn) {
+    return closed_lsn;
+  } else {
+    return lsn;
   }
-
-  return lsn;
 }
 
-lsn_t Log::reserve_and_open(ulint len) noexcept {
-  IF_DEBUG(ulint count = 0;)
-
+lsn_t Log::reserve_and_open(ulint len, lsn_t *end_lsn) noexcept {
   ut_a(len < m_buf_size / 2);
 
-  for (;;) {
-    acquire();
-
-    /* Calculate an upper limit for the space the string may take in the
-    log buffer */
-
-    auto len_upper_limit = LOG_BUF_WRITE_MARGIN + (5 * len) / 4;
+  const auto sn = m_sn.fetch_add(len, std::memory_order_acq_rel);
+  const auto start_lsn = sn_to_lsn(sn);
 
-    if (m_buf_free + len_upper_limit > m_buf_size) {
-      release();
-
-      /* Not enough free space, do a synchronous flush of the log buffer */
+  *end_lsn = sn_to_lsn(sn + len);
 
-      buffer_flush_to_disk();
+  /* The ring has no room for the range before the log below start_lsn is
+  written. The ranges before ours are copied without waiting for us, write
+  them so that our blocks in the ring can be reused. */
+  while (*end_lsn > m_buf_limit_lsn.load(std::memory_order_acquire)) {
+    write_up_to(start_lsn, LOG_WAIT_ALL_GROUPS, false);
 
-      srv_log_waits++;
-
-      ut_ad(++count < 50);
-    } else {
-      break;
-    }
+    ++srv_log_waits;
   }
 
-  return m_lsn;
+  return start_lsn;
 }
 
-void Log::write_low(const byte *str, ulint str_len) noexcept {
-  ut_ad(mutex_own(&m_mutex));
-
+lsn_t Log::write_low(lsn_t lsn, const byte *str, ulint str_len) noexcept {
   while (str_len > 0) {
-    /* Calculate a part length */
-    auto data_len = (m_buf_free % IB_FILE_BLOCK_SIZE) + str_len;
+    auto log_block = buf_block(lsn);
+    const auto offset = ulint(lsn % IB_FILE_BLOCK_SIZE);
 
-    ulint len;
+    ut_ad(offset >= LOG_BLOCK_HDR_SIZE);
+    ut_ad(offset < IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE);
 
-    if (data_len <= IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
-      /* The string fits within the current log block */
-      len = str_len;
-    } else {
-      data_len = IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE;
-      len = IB_FILE_BLOCK_SIZE - (m_buf_free % IB_FILE_BLOCK_SIZE) - LOG_BLOCK_TRL_SIZE;
-    }
+    /* Calculate a part length */
+    const auto len = std::min<ulint>(str_len, IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE - offset);
 
-    memcpy(m_buf + m_buf_free, str, len);
+    memcpy(log_block + offset, str, len);
 
     str_len -= len;
     str += len;
+    lsn += len;
 
-    auto log_block = static_cast<byte *>(ut_align_down(m_buf + m_buf_free, IB_FILE_BLOCK_SIZE));
-
-    block_set_data_len(log_block, data_len);
-
-    if (data_len == IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
-      /* This block is full. */
-      block_set_data_len(log_block, IB_FILE_BLOCK_SIZE);
-      block_set_checkpoint_no(log_block, m_next_checkpoint_no);
-      len += LOG_BLOCK_HDR_SIZE + LOG_BLOCK_TRL_SIZE;
-
-      m_lsn += len;
+    if (offset + len == IB_FILE_BLOCK_SIZE - LOG_BLOCK_TRL_SIZE) {
+      /* This block is full. Its data length and checkpoint number are set
+      by the log writer: the mini-transaction that ends at the start of the
+      block may initialize its header after we have filled it. */
+      lsn += LOG_BLOCK_TRL_SIZE + LOG_BLOCK_HDR_SIZE;
 
       // Initialize the next block header
-      block_init(log_block + IB_FILE_BLOCK_SIZE, m_lsn);
-    } else {
-      m_lsn += len;
+      block_init(buf_block(lsn), lsn);
     }
-
-    m_buf_free += len;
-
-    ut_ad(m_buf_free <= m_buf_size);
   }
 
-  ++srv_log_write_requests;
+  return lsn;
 }
 
-lsn_t Log::close(ib_recovery_t recovery) noexcept {
-  auto log_block = static_cast<byte *>(ut_align_down(m_buf + m_buf_free, IB_FILE_BLOCK_SIZE));
-  auto first_rec_group = block_get_first_rec_group(log_block);
-  auto lsn = m_lsn;
-  auto checkpoint_age = lsn - m_last_checkpoint_lsn;
-  auto oldest_lsn = srv_buf_pool->get_oldest_modification();
+lsn_t Log::close(lsn_t start_lsn, lsn_t end_lsn, ib_recovery_t recovery) noexcept {
+  ut_ad(end_lsn > start_lsn);
 
-  ut_ad(mutex_own(&m_mutex));
+  const auto block_lsn = ut_uint64_align_down(end_lsn, IB_FILE_BLOCK_SIZE);
 
-  if (first_rec_group == 0) {
+  if (ut_uint64_align_down(start_lsn, IB_FILE_BLOCK_SIZE) != block_lsn) {
     /* We initialized a new log block which was not written
     full by the current mtr: the next mtr log record group
-    will start within this block at the offset data_len */
+    will start within this block at the end of ours */
+
+    block_set_first_rec_group(buf_block(end_lsn), ulint(end_lsn - block_lsn));
+  }
+
+  m_recent_written.add(start_lsn, end_lsn);
+
+  ++srv_log_write_requests;
 
-    block_set_first_rec_group(log_block, block_get_data_len(log_block));
+  if (block_lsn == ut_uint64_align_down(start_lsn, IB_FILE_BLOCK_SIZE)) {
+    /* Check the margins only when a block was filled, like the single
+    block fast path did. */
+    return end_lsn;
   }
 
-  if (m_buf_free > m_max_buf_free) {
+  /* The checkpoint fields are peeked at without the log mutex, they
+  only decide if log_free_check() has work to do. */
+  const auto lsn = end_lsn;
+  const auto checkpoint_age = lsn - m_last_checkpoint_lsn;
+  const auto oldest_lsn = srv_buf_pool->get_oldest_modification();
+
+  if (lsn - (m_buf_limit_lsn.load(std::memory_order_relaxed) - m_buf_size) > m_max_buf_free) {
     m_check_flush_or_checkpoint = true;
   }
 
@@ -352,7 +363,7 @@ lsn_t Log::close(ib_recovery_t recovery) noexcept {
     m_check_flush_or_checkpoint = true;
   }
 
-  return lsn;
+  return end_lsn;
 }
 
 ulint Log::group_get_capacity(const log_group_t *group) noexcept {
@@ -596,27 +607,15 @@ void Log::io_complete_checkpoint() noexcept {
 }
 
 ulint Log::sys_check_flush_completion() noexcept {
-  ulint move_start;
-  ulint move_end;
-
   ut_ad(mutex_own(&m_mutex));
 
   if (m_n_pending_writes == 0) {
 
     m_written_to_all_lsn = m_write_lsn;
-    m_buf_next_to_write = m_write_end_offset;
-
-    if (m_write_end_offset > m_max_buf_free / 2) {
-      /* Move the log buffer content to the start of the buffer */
 
-      move_start = ut_calc_align_down(m_write_end_offset, IB_FILE_BLOCK_SIZE);
-      move_end = ut_calc_align(m_buf_free, IB_FILE_BLOCK_SIZE);
-
-      memmove(m_buf, m_buf + move_start, move_end - move_start);
-      m_buf_free -= move_start;
-
-      m_buf_next_to_write -= move_start;
-    }
+    /* The log buffer is a ring: the blocks below the last, incompletely
+    written, one can now be reused. */
+    m_buf_limit_lsn.store(ut_uint64_align_down(m_write_lsn, IB_FILE_BLOCK_SIZE) + m_buf_size, std::memory_order_release);
 
     return LOG_UNLOCK_FLUSH_LOCK;
   }
@@ -765,15 +764,24 @@ void Log::group_write_buf(log_group_t *group, byte *buf, ulint len, lsn_t start_
 }
 
 void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
+  /* The log beyond the current lsn was not reserved yet, e.g., when called
+  with IB_UINT64_T_MAX. The ranges below it are copied without waiting for
+  anyone, so we can wait for them. */
+  lsn = std::min(lsn, get_lsn());
+
+  if (srv_log_writer != nullptr && srv_log_writer->is_active()) {
+    /* Let the log writer threads write and flush for us, together with the
+    other threads that wait. */
+    srv_log_writer->write_up_to(lsn, wait, flush_to_disk);
+  } else {
+    write_up_to_low(lsn, wait, flush_to_disk);
+  }
+}
+
+void Log::write_up_to_low(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
   log_group_t *group;
-  ulint start_offset;
-  ulint end_offset;
-  ulint area_start;
-  ulint area_end;
   ulint unlock;
 
-  IF_DEBUG(ulint loop_count = 0;)
-
   auto do_waits = [this](ulint wait) {
     switch (wait) {
       case LOG_WAIT_ONE_GROUP:
@@ -791,9 +799,9 @@ void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
     }
   };
 
-  for (;;) {
-    ut_ad(++loop_count < 5);
+  ut_ad(lsn <= get_lsn());
 
+  for (;;) {
     acquire();
 
     if (flush_to_disk && m_flushed_to_disk_lsn >= lsn) {
@@ -830,10 +838,16 @@ void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
       continue;
     }
 
-    if (!flush_to_disk && m_buf_free == m_buf_next_to_write) {
-      /* Nothing to write and no flush to disk requested */
+    /* Only the contiguous prefix of the ranges that the mini-transactions
+    have copied to the log buffer can be written. */
+    const auto write_lsn = m_recent_written.advance();
+
+    if (write_lsn < lsn && write_lsn == m_written_to_all_lsn && (!flush_to_disk || m_flushed_to_disk_lsn >= write_lsn)) {
+      /* Nothing to write or flush yet, wait for the mini-transactions
+      that are still copying their log records */
       release();
-      return;
+      std::this_thread::yield();
+      continue;
     }
 
     ++m_n_pending_writes;
@@ -846,61 +860,74 @@ void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
     os_event_reset(m_no_flush_event);
     os_event_reset(m_one_flushed_event);
 
-    start_offset = m_buf_next_to_write;
-    end_offset = m_buf_free;
-
-    area_start = ut_calc_align_down(start_offset, IB_FILE_BLOCK_SIZE);
-    area_end = ut_calc_align(end_offset, IB_FILE_BLOCK_SIZE);
+    const auto area_start_lsn = ut_uint64_align_down(m_written_to_all_lsn, IB_FILE_BLOCK_SIZE);
+    const auto last_block_lsn = ut_uint64_align_down(write_lsn, IB_FILE_BLOCK_SIZE);
 
-    ut_ad(area_end - area_start > 0);
-
-    m_write_lsn = m_lsn;
+    m_write_lsn = write_lsn;
 
     if (flush_to_disk) {
-      m_current_flush_lsn = m_lsn;
+      m_current_flush_lsn = write_lsn;
     }
 
     m_one_flushed = false;
 
-    block_set_flush_bit(m_buf + area_start, true);
+    /* The blocks below the last one were filled, no one copies to them
+    anymore. */
+    for (auto block_lsn = area_start_lsn; block_lsn < last_block_lsn; block_lsn += IB_FILE_BLOCK_SIZE) {
+      auto log_block = buf_block(block_lsn);
+
+      block_set_data_len(log_block, IB_FILE_BLOCK_SIZE);
+      block_set_checkpoint_no(log_block, m_next_checkpoint_no);
+    }
 
-    block_set_checkpoint_no(m_buf + area_end - IB_FILE_BLOCK_SIZE, m_next_checkpoint_no);
+    /* Copy the last, incompletely written, log block to m_write_block, so
+    that the segment to write will not be changed by writers to the log */
+    memcpy(m_write_block, buf_block(last_block_lsn), IB_FILE_BLOCK_SIZE);
 
-    /* Copy the last, incompletely written, log block a log block length
-    up, so that when the flush operation writes from the log buffer, the
-    segment to write will not be changed by writers to the log */
-    memcpy(m_buf + area_end, m_buf + area_end - IB_FILE_BLOCK_SIZE, IB_FILE_BLOCK_SIZE);
+    block_set_data_len(m_write_block, ulint(write_lsn - last_block_lsn));
+    block_set_checkpoint_no(m_write_block, m_next_checkpoint_no);
 
-    m_buf_free += IB_FILE_BLOCK_SIZE;
-    m_write_end_offset = m_buf_free;
+    block_set_flush_bit(area_start_lsn == last_block_lsn ? m_write_block : buf_block(area_start_lsn), true);
 
     /* Do the write to the log files */
     for (auto group : m_log_groups) {
-      group_write_buf(
-        group,
-        m_buf + area_start,
-        area_end - area_start,
-        ut_uint64_align_down(m_written_to_all_lsn, IB_FILE_BLOCK_SIZE),
-        start_offset - area_start
-      );
+      auto start_lsn = area_start_lsn;
+      auto new_data_offset = ulint(m_written_to_all_lsn - area_start_lsn);
+
+      /* The log buffer is a ring, the complete blocks can wrap around its end. */
+      while (start_lsn < last_block_lsn) {
+        auto buf = buf_block(start_lsn);
+        const auto len = std::min<lsn_t>(last_block_lsn - start_lsn, m_buf + m_buf_size - buf);
+
+        group_write_buf(group, buf, ulint(len), start_lsn, new_data_offset);
+
+        start_lsn += len;
+        new_data_offset = 0;
+      }
+
+      group_write_buf(group, m_write_block, IB_FILE_BLOCK_SIZE, last_block_lsn, new_data_offset);
 
       group_set_fields(group, m_write_lsn);
     }
 
     release();
 
-    if (srv_config.m_unix_file_flush_method == SRV_UNIX_O_DSYNC) {
-      /* O_DSYNC means the OS did not buffer the log file at all:
-      so we have also flushed to disk what we have written */
-      m_flushed_to_disk_lsn = m_write_lsn;
-    } else if (flush_to_disk) {
+    /* O_DSYNC means the OS did not buffer the log file at all:
+    so we have also flushed to disk what we have written */
+    const auto flushed = flush_to_disk || srv_config.m_unix_file_flush_method == SRV_UNIX_O_DSYNC;
+
+    if (flush_to_disk && srv_config.m_unix_file_flush_method != SRV_UNIX_O_DSYNC) {
       group = UT_LIST_GET_FIRST(m_log_groups);
       srv_fil->flush(group->space_id);
-      m_flushed_to_disk_lsn = m_write_lsn;
     }
 
     acquire();
 
+    /* The log flusher thread can have flushed further meanwhile. */
+    if (flushed && write_lsn > m_flushed_to_disk_lsn) {
+      m_flushed_to_disk_lsn = write_lsn;
+    }
+
     group = UT_LIST_GET_FIRST(m_log_groups);
 
     ut_a(group->n_pending_writes == 1);
@@ -916,41 +943,62 @@ void Log::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
 
     release();
 
-    return;
+    if (write_lsn >= lsn) {
+      return;
+    }
+
+    /* The mini-transactions below lsn had not all copied their log
+    records, write the rest. */
   }
 }
 
-void Log::buffer_flush_to_disk() noexcept {
+lsn_t Log::flush_written() noexcept {
   acquire();
 
-  auto lsn = m_lsn;
+  const lsn_t lsn = m_written_to_all_lsn;
+  const auto group = UT_LIST_GET_FIRST(m_log_groups);
 
   release();
 
-  write_up_to(lsn, LOG_WAIT_ALL_GROUPS, true);
-}
+  if (srv_config.m_unix_file_flush_method != SRV_UNIX_O_DSYNC) {
+    srv_fil->flush(group->space_id);
+  }
 
-void Log::buffer_sync_in_background(bool flush) noexcept {
-  mutex_enter(&m_mutex);
+  acquire();
+
+  if (lsn > m_flushed_to_disk_lsn) {
+    m_flushed_to_disk_lsn = lsn;
+  }
+
+  release();
+
+  return lsn;
+}
 
-  auto lsn = m_lsn;
+void Log::buffer_flush_to_disk() noexcept {
+  write_up_to(get_lsn(), LOG_WAIT_ALL_GROUPS, true);
+}
 
-  mutex_exit(&m_mutex);
+void Log::buffer_sync_in_background(bool flush) noexcept {
+  /* Don't wait for the mini-transactions that are still copying. */
+  const auto lsn = m_recent_written.advance();
 
   write_up_to(lsn, LOG_NO_WAIT, flush);
 }
 
 void Log::flush_margin() noexcept {
-  lsn_t lsn;
+  lsn_t lsn{};
 
   acquire();
 
-  if (m_buf_free > m_max_buf_free) {
+  const auto write_lsn = m_recent_written.advance();
+
+  if (write_lsn - ut_uint64_align_down(m_written_to_all_lsn, IB_FILE_BLOCK_SIZE) > m_max_buf_free) {
 
     if (m_n_pending_writes > 0) {
       /* A flush is running: hope that it will provide enough free space */
     } else {
-      lsn = m_lsn;
+      lsn = write_lsn;
     }
   }
 
@@ -975,10 +1023,10 @@ bool Log::preflush_pool_modified_pages(lsn_t new_oldest, bool sync) noexcept {
     recv_apply_log_recs(srv_dblwr, false);
   }
 
-  auto n_pages = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, ULINT_MAX, new_oldest);
+  auto n_pages = srv_buf_pool->flush_list(srv_dblwr, ULINT_MAX, new_oldest);
 
   if (sync) {
-    srv_buf_pool->m_flusher->wait_batch_end(BUF_FLUSH_LIST);
+    srv_buf_pool->wait_batch_end(BUF_FLUSH_LIST);
   }
 
   return n_pages != ULINT_UNDEFINED;
@@ -1123,7 +1171,7 @@ bool Log::checkpoint(bool sync, bool write_always) noexcept {
 
   /* Because log also contains headers and dummy log records,
   if the buffer pool contains no dirty buffers, oldest_lsn
-  gets the value m_lsn from the previous function,
+  gets the closed lsn from the previous function,
   and we must make sure that the log is flushed up to that
   lsn. If there are dirty buffers in the buffer pool, then our
   write-ahead-logging algorithm ensures that the log has been flushed
@@ -1199,8 +1247,9 @@ void Log::checkpoint_margin() noexcept {
       return;
     }
 
+    const auto lsn = get_lsn();
     auto oldest_lsn = buf_pool_get_oldest_modification();
-    auto age = m_lsn - oldest_lsn;
+    auto age = lsn - oldest_lsn;
 
     if (age > m_max_modified_age_sync) {
       sync = true;
@@ -1211,7 +1260,7 @@ void Log::checkpoint_margin() noexcept {
       advance = 0;
     }
 
-    auto checkpoint_age = m_lsn - m_last_checkpoint_lsn;
+    auto checkpoint_age = lsn - m_last_checkpoint_lsn;
 
     if (checkpoint_age > m_max_checkpoint_age) {
       checkpoint_sync = true;
@@ -1226,12 +1275,19 @@ void Log::checkpoint_margin() noexcept {
     release();
 
     if (advance) {
-      auto new_oldest = oldest_lsn + advance;
+      if (!sync && srv_page_cleaner != nullptr && srv_page_cleaner->is_active()) {
 
-      success = preflush_pool_modified_pages(new_oldest, sync);
+        /* There is still room in the log, let the page cleaner flush in the background. */
+        srv_page_cleaner->wakeup();
 
-      if (sync && !success) {
-        continue;
+      } else {
+        auto new_oldest = oldest_lsn + advance;
+
+        success = preflush_pool_modified_pages(new_oldest, sync);
+
+        if (sync && !success) {
+          continue;
+        }
       }
     }
 
@@ -1301,15 +1357,10 @@ void Log::check_margins() noexcept {
 }
 
 bool Log::peek_lsn(lsn_t *lsn) noexcept {
-  if (mutex_enter_nowait(&m_mutex) == 0) {
-    *lsn = m_lsn;
+  /* The lsn is reserved without the log mutex. */
+  *lsn = get_lsn();
 
-    release();
-
-    return true;
-  } else {
-    return false;
-  }
+  return true;
 }
 
 void Log::print() noexcept {
@@ -1319,8 +1370,8 @@ void Log::print() noexcept {
     "Log sequence number {}\n"
     "Log flushed up to   {}\n"
     "Last checkpoint at  {}\n",
-    m_lsn,
-    m_flushed_to_disk_lsn,
+    get_lsn(),
+    m_flushed_to_disk_lsn.load(),
     m_last_checkpoint_lsn
   ));
 
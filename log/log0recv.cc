@@ -42,12 +42,19 @@ Created 9/20/1997 Heikki Tuuri
 #include "trx0roll.h"
 #include "trx0undo.h"
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
 /** Log records are stored in the hash table in chunks at most of this size;
 this must be less than UNIV_PAGE_SIZE as it is stored in the buffer pool */
 constexpr ulint RECV_DATA_BLOCK_SIZE = MEM_MAX_ALLOC_IN_BUF - sizeof(Log_record_data);
 
-/** Read-ahead area in applying log records to file pages */
-constexpr ulint RECV_READ_AHEAD_AREA = 32;
+/** The apply threads take the pages of a batch in slices of this many */
+constexpr ulint RECV_APPLY_SLICE = 32;
+
+/** The pages of a batch are prefetched in chunks of this many */
+constexpr ulint RECV_PREFETCH_CHUNK = 256;
 
 /** The recovery system */
 Recv_sys *recv_sys = nullptr;
@@ -789,9 +796,9 @@ void recv_recover_page(bool just_read_in, Buf_block *block) noexcept {
 
   mutex_enter(&recv_sys->m_mutex);
 
-  if (!recv_sys->m_apply_log_recs) {
+  if (!recv_sys->m_apply_log_recs || (just_read_in && recv_sys->m_apply_in_threads)) {
 
-    /* Log records should not be applied now */
+    /* Log records should not be applied now, or not by the i/o-handler */
 
     mutex_exit(&recv_sys->m_mutex);
 
@@ -919,7 +926,7 @@ void recv_recover_page(bool just_read_in, Buf_block *block) noexcept {
   if (modification_to_page) {
     ut_a(block != nullptr);
 
-    srv_buf_pool->m_flusher->recv_note_modification(block, start_lsn, end_lsn);
+    srv_buf_pool->get_instance(&block->m_page)->m_flusher->recv_note_modification(block, start_lsn, end_lsn);
   }
 
   /* Make sure that committing mtr does not change the modification
@@ -930,43 +937,148 @@ void recv_recover_page(bool just_read_in, Buf_block *block) noexcept {
   mtr.commit();
 }
 
+/** An apply batch, shared by the threads that apply its log records. */
+struct Recv_apply_batch {
+  /** Pages that have log records to apply, in (space, page_no) order. */
+  std::vector<Page_id> m_pages{};
+
+  /** Index in m_pages of the next slice to hand out. */
+  std::atomic<ulint> m_next{};
+
+  /** Number of apply threads that are still running. */
+  std::atomic<ulint> m_n_threads_active{};
+};
+
 /**
- * Reads in pages which have hashed log records, from an area around a given
- * page number.
+ * Applies the log records to a page, reads it in first if the prefetch did
+ * not.
  *
- * @param space The space id.
- * @param start_page_no The start page number.
+ * @param page_id The page to recover.
+ */
+static void recv_apply_page(const Page_id &page_id) noexcept {
+  if (!srv_buf_pool->peek(page_id) && !srv_fil->tablespace_exists_in_mem(page_id.space_id())) {
+    /* The .ibd file is missing, the page can't be read in and there is
+    nothing to apply the log records to. */
+    mutex_enter(&recv_sys->m_mutex);
+
+    auto log_record = recv_get_log_record(page_id.space_id(), page_id.page_no());
+
+    if (log_record->m_state == RECV_NOT_PROCESSED) {
+      log_record->m_state = RECV_PROCESSED;
+
+      ut_a(recv_sys->m_n_log_records > 0);
+      --recv_sys->m_n_log_records;
+    }
+
+    mutex_exit(&recv_sys->m_mutex);
+
+    return;
+  }
+
+  mtr_t mtr;
+
+  mtr.start();
+
+  Buf_pool::Request req{
+    .m_rw_latch = RW_X_LATCH, .m_page_id = page_id, .m_mode = BUF_GET, .m_file = __FILE__, .m_line = __LINE__, .m_mtr = &mtr
+  };
+
+  /* If the page is being read in this waits for the read to complete. */
+  auto block = srv_buf_pool->get(req, nullptr);
+  buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_NO_ORDER_CHECK));
+
+  recv_recover_page(false, block);
+
+  mtr.commit();
+}
+
+/**
+ * Posts the reads of the next chunk of pages of a batch that are not in the
+ * buffer pool, unless the chunk is too far ahead of the apply threads.
+ *
+ * @param batch The batch to prefetch.
+ * @param prefetched Index in the batch of the first page not prefetched yet.
  *
- * @return	number of pages found
+ * @return true if there may be more pages to prefetch now.
  */
-static ulint recv_read_in_area(space_id_t space, page_no_t start_page_no) noexcept {
-  std::array<page_no_t, RECV_READ_AHEAD_AREA> page_nos;
-  const auto low_limit = start_page_no - (start_page_no % RECV_READ_AHEAD_AREA);
+static bool recv_prefetch_pages(Recv_apply_batch *batch, ulint &prefetched) noexcept {
+  const auto n_pages = batch->m_pages.size();
+
+  /* The pages before the next slice were taken by the threads already. */
+  const auto next = std::min(batch->m_next.load(std::memory_order_relaxed), n_pages);
 
-  ulint n = 0;
+  /* Don't read in more than the buffer pool holds until they are applied. */
+  const auto max_ahead = std::max(srv_buf_pool->get_curr_n_pages() / 4, RECV_PREFETCH_CHUNK);
 
-  for (auto page_no = low_limit; page_no < low_limit + RECV_READ_AHEAD_AREA; ++page_no) {
-    auto log_record = recv_get_log_record(space, page_no);
+  prefetched = std::max(prefetched, next);
 
-    if (log_record != nullptr && !srv_buf_pool->peek(Page_id(space, page_no))) {
+  if (prefetched >= n_pages || prefetched >= next + max_ahead) {
+    return false;
+  }
 
-      mutex_enter(&recv_sys->m_mutex);
+  const auto last = std::min(prefetched + RECV_PREFETCH_CHUNK, n_pages);
 
-      if (log_record->m_state == RECV_NOT_PROCESSED) {
-        log_record->m_state = RECV_BEING_READ;
+  std::vector<Page_id> page_ids;
 
-        page_nos[n] = page_no;
+  page_ids.reserve(last - prefetched);
 
-        n++;
-      }
+  for (auto i = prefetched; i < last; ++i) {
+    if (!srv_buf_pool->peek(batch->m_pages[i])) {
+      page_ids.push_back(batch->m_pages[i]);
+    }
+  }
+
+  buf_read_recv_pages(page_ids.data(), page_ids.size(), recv_n_pool_free_frames / 2);
+
+  prefetched = last;
+
+  return true;
+}
+
+/**
+ * Applies the log records to the slices of pages of a batch until there are
+ * none left.
+ *
+ * @param batch The batch to apply.
+ */
+static void recv_apply_pages(Recv_apply_batch *batch) noexcept {
+  const auto n_pages = batch->m_pages.size();
+
+  for (;;) {
+    const auto first = batch->m_next.fetch_add(RECV_APPLY_SLICE, std::memory_order_relaxed);
+
+    if (first >= n_pages) {
+      break;
+    }
+
+    const auto last = std::min(first + RECV_APPLY_SLICE, n_pages);
 
-      mutex_exit(&recv_sys->m_mutex);
+    for (auto i = first; i < last; ++i) {
+      recv_apply_page(batch->m_pages[i]);
     }
   }
+}
+
+/**
+ * A thread that applies the log records of a batch.
+ *
+ * @param arg The Recv_apply_batch.
+ *
+ * @return nullptr.
+ */
+static void *recv_apply_thread(void *arg) noexcept {
+  auto batch = static_cast<Recv_apply_batch *>(arg);
+
+  recv_apply_pages(batch);
 
-  buf_read_recv_pages(false, Page_id(space, 0), page_nos.data(), n);
+  batch->m_n_threads_active.fetch_sub(1, std::memory_order_release);
 
-  return n;
+  /* We count the number of threads in os_thread_exit(). A created
+  thread should always use that to exit and not use return() to exit. */
+
+  os_thread_exit();
+
+  return nullptr;
 }
 
 void recv_apply_log_recs(DBLWR *dblwr, bool flush_and_free_pages) noexcept {
@@ -987,70 +1099,92 @@ void recv_apply_log_recs(DBLWR *dblwr, bool flush_and_free_pages) noexcept {
 
   const ulint n_total{recv_sys->m_n_log_records};
 
-  ulint n_recs{};
-  bool printed_header{};
+  Recv_apply_batch batch;
+
+  batch.m_pages.reserve(n_total);
 
   for (const auto &[space_id, log_records_map] : recv_sys->m_log_records) {
+    /* The .ibd file of a single table tablespace may be missing, there is
+    nothing to apply the log records to then. */
+    const auto missing = srv_fil->space_get_size(space_id) == ULINT_UNDEFINED;
 
     for (const auto &[page_no, log_record] : log_records_map) {
+      if (log_record->m_state != RECV_NOT_PROCESSED) {
+        continue;
+      } else if (!missing) {
+        batch.m_pages.emplace_back(space_id, page_no);
+      } else {
+        log_record->m_state = RECV_PROCESSED;
+
+        ut_a(recv_sys->m_n_log_records > 0);
+        --recv_sys->m_n_log_records;
+      }
+    }
+  }
 
-      if (log_record->m_state == RECV_NOT_PROCESSED) {
+  /* The pages that the i/o-handler reads in are applied by the threads. */
+  recv_sys->m_apply_in_threads = true;
 
-        if (!printed_header) {
-          log_info("Starting an apply batch of log records to the database");
-          log_info_hdr("Progress in percents: ");
-          printed_header = true;
-        }
+  mutex_exit(&recv_sys->m_mutex);
+
+  /* The pages are prefetched and applied in this order, neighbouring
+  pages are read in together and applied by the same thread. */
+  std::sort(batch.m_pages.begin(), batch.m_pages.end(), [](const Page_id &lhs, const Page_id &rhs) {
+    return lhs.space_id() < rhs.space_id() || (lhs.space_id() == rhs.space_id() && lhs.page_no() < rhs.page_no());
+  });
+
+  const bool printed_header{!batch.m_pages.empty()};
 
-        mutex_exit(&recv_sys->m_mutex);
+  if (printed_header) {
+    const auto n_slices = (batch.m_pages.size() + RECV_APPLY_SLICE - 1) / RECV_APPLY_SLICE;
+    const auto n_threads = std::min(std::max(srv_config.m_recovery_apply_threads, ulint{1}), n_slices);
 
-        if (srv_buf_pool->peek(Page_id(space_id, page_no))) {
+    log_info(std::format(
+      "Starting an apply batch of log records to {} pages with {} threads", batch.m_pages.size(), n_threads
+    ));
+    log_info_hdr("Progress in percents: ");
 
-          mtr_t mtr;
+    batch.m_n_threads_active.store(n_threads, std::memory_order_relaxed);
 
-          mtr.start();
+    for (ulint i = 0; i < n_threads; ++i) {
+      os_thread_create(recv_apply_thread, &batch, nullptr);
+    }
+  }
 
-          Buf_pool::Request req{
-            .m_rw_latch = RW_X_LATCH,
-            .m_page_id = {space_id, page_no},
-            .m_mode = BUF_GET,
-            .m_file = __FILE__,
-            .m_line = __LINE__,
-            .m_mtr = &mtr
-          };
+  ulint prefetched{};
+  ulint printed_pct{};
 
-          auto block = srv_buf_pool->get(req, nullptr);
-          buf_block_dbg_add_level(IF_SYNC_DEBUG(block, SYNC_NO_ORDER_CHECK));
+  /* Read in the pages ahead of the apply threads, in large batches, and
+  report the progress until all the pages have been processed. */
+  for (;;) {
+    if (recv_prefetch_pages(&batch, prefetched)) {
+      continue;
+    }
 
-          recv_recover_page(false, block);
+    mutex_enter(&recv_sys->m_mutex);
 
-          mtr.commit();
-        } else {
-          recv_read_in_area(space_id, page_no);
-        }
+    const auto n_left = recv_sys->m_n_log_records;
 
-        mutex_enter(&recv_sys->m_mutex);
-      }
+    mutex_exit(&recv_sys->m_mutex);
 
-      const auto pct{(n_recs * 100) / n_total};
+    if (printed_header) {
+      const auto pct = ((n_total - n_left) * 100) / n_total;
 
-      if (printed_header && pct != ((n_recs + 1) * 100) / n_total) {
-        log_info_msg(std::format("{} ", pct));
+      for (; printed_pct < pct; ++printed_pct) {
+        log_info_msg(std::format("{} ", printed_pct));
       }
-
-      ++n_recs;
     }
-  }
 
-  /* Wait until all the pages have been processed */
-  while (recv_sys->m_n_log_records != 0) {
+    if (n_left == 0 && batch.m_n_threads_active.load(std::memory_order_acquire) == 0) {
+      break;
+    }
 
-    mutex_exit(&recv_sys->m_mutex);
+    os_thread_sleep(10000);
+  }
 
-    os_thread_sleep(100000);
+  mutex_enter(&recv_sys->m_mutex);
 
-    mutex_enter(&recv_sys->m_mutex);
-  }
+  recv_sys->m_apply_in_threads = false;
 
   if (printed_header) {
     log_info_msg("\n");
@@ -1061,10 +1195,10 @@ void recv_apply_log_recs(DBLWR *dblwr, bool flush_and_free_pages) noexcept {
     mutex_exit(&recv_sys->m_mutex);
     log_sys->release();
 
-    auto n_pages = srv_buf_pool->m_flusher->batch(dblwr, BUF_FLUSH_LIST, ULINT_MAX, IB_UINT64_T_MAX);
+    auto n_pages = srv_buf_pool->flush_list(dblwr, ULINT_MAX, IB_UINT64_T_MAX);
     ut_a(n_pages != ULINT_UNDEFINED);
 
-    srv_buf_pool->m_flusher->wait_batch_end(BUF_FLUSH_LIST);
+    srv_buf_pool->wait_batch_end(BUF_FLUSH_LIST);
 
     srv_buf_pool->invalidate();
 
@@ -1649,7 +1783,7 @@ static void recv_group_scan_log_recs(
     finished = recv_scan_log_recs(
       dblwr,
       recovery,
-      (srv_buf_pool->m_curr_size - recv_n_pool_free_frames) * UNIV_PAGE_SIZE,
+      (srv_buf_pool->get_curr_n_pages() - recv_n_pool_free_frames) * UNIV_PAGE_SIZE,
       true,
       log_sys->m_buf,
       RECV_SCAN_SIZE,
@@ -1835,14 +1969,7 @@ db_err recv_recovery_from_checkpoint_start(DBLWR *dblwr, ib_recovery_t recovery,
     srv_start_lsn = recv_sys->m_recovered_lsn;
   }
 
-  log_sys->m_lsn = recv_sys->m_recovered_lsn;
-
-  memcpy(log_sys->m_buf, recv_sys->m_last_block, IB_FILE_BLOCK_SIZE);
-
-  log_sys->m_buf_free = ulint(log_sys->m_lsn % IB_FILE_BLOCK_SIZE);
-  log_sys->m_buf_next_to_write = log_sys->m_buf_free;
-  log_sys->m_written_to_some_lsn = log_sys->m_lsn;
-  log_sys->m_written_to_all_lsn = log_sys->m_lsn;
+  log_sys->buf_reset(recv_sys->m_recovered_lsn, recv_sys->m_last_block);
 
   log_sys->m_last_checkpoint_lsn = checkpoint_lsn;
 
@@ -1900,7 +2027,7 @@ void recv_recovery_from_checkpoint_finish(DBLWR *dblwr, ib_recovery_t recovery)
   recv_sys = nullptr;
 
   /* Free up the flush_rbt. */
-  srv_buf_pool->m_flusher->free_flush_list();
+  srv_buf_pool->free_flush_list();
 
   /* Roll back any recovered data dictionary transactions, so
   that the data dictionary tables will be free of any locks.
@@ -1940,10 +2067,10 @@ void recv_recovery_rollback_active() noexcept {
 void recv_reset_logs(lsn_t lsn, bool new_logs_created) noexcept {
   ut_ad(mutex_own(&log_sys->m_mutex));
 
-  log_sys->m_lsn = ut_uint64_align_up(lsn, IB_FILE_BLOCK_SIZE);
+  lsn = ut_uint64_align_up(lsn, IB_FILE_BLOCK_SIZE);
 
   for (auto group : log_sys->m_log_groups) {
-    group->lsn = log_sys->m_lsn;
+    group->lsn = lsn;
     group->lsn_offset = LOG_FILE_HDR_SIZE;
 
     if (!new_logs_created) {
@@ -1951,18 +2078,18 @@ void recv_reset_logs(lsn_t lsn, bool new_logs_created) noexcept {
     }
   }
 
-  log_sys->m_buf_next_to_write = 0;
-  log_sys->m_written_to_some_lsn = log_sys->m_lsn;
-  log_sys->m_written_to_all_lsn = log_sys->m_lsn;
-
   log_sys->m_next_checkpoint_no = 0;
   log_sys->m_last_checkpoint_lsn = 0;
 
-  log_sys->block_init(log_sys->m_buf, log_sys->m_lsn);
-  log_sys->block_set_first_rec_group(log_sys->m_buf, LOG_BLOCK_HDR_SIZE);
+  log_sys->block_init(log_sys->m_write_block, lsn);
+  log_sys->block_set_first_rec_group(log_sys->m_write_block, LOG_BLOCK_HDR_SIZE);
+
+  log_sys->buf_reset(lsn + LOG_BLOCK_HDR_SIZE, log_sys->m_write_block);
 
-  log_sys->m_buf_free = LOG_BLOCK_HDR_SIZE;
-  log_sys->m_lsn += LOG_BLOCK_HDR_SIZE;
+  /* Nothing of the first block was written yet, the first write also
+  writes the log file header. */
+  log_sys->m_written_to_some_lsn = lsn;
+  log_sys->m_written_to_all_lsn = lsn;
 
   log_sys->release();
 
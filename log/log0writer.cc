@@ -0,0 +1,372 @@
+/****************************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+/** @file log/log0writer.cc
+Background writing and flushing of the redo log.
+*******************************************************/
+
+#include "log0writer.h"
+
+#include "log0log.h"
+#include "os0thread.h"
+
+#include <chrono>
+#include <thread>
+
+Log_writer *srv_log_writer{};
+
+/**
+ * Raises an lsn to at least a value.
+ *
+ * @param[in,out] lsn           LSN to raise.
+ * @param[in] new_lsn           Value to raise it to.
+ */
+static void log_writer_raise(std::atomic<lsn_t> &lsn, lsn_t new_lsn) noexcept {
+  auto old_lsn = lsn.load(std::memory_order_relaxed);
+
+  while (old_lsn < new_lsn && !lsn.compare_exchange_weak(old_lsn, new_lsn, std::memory_order_seq_cst)) {
+    ;
+  }
+}
+
+Log_writer::Log_writer(Log *log) noexcept : m_log(log) {}
+
+Log_writer::~Log_writer() noexcept {
+  ut_a(!is_active());
+}
+
+Log_writer *Log_writer::create(Log *log) noexcept {
+  auto ptr = ut_new(sizeof(Log_writer));
+
+  return ptr != nullptr ? new (ptr) Log_writer(log) : nullptr;
+}
+
+void Log_writer::destroy(Log_writer *&log_writer) noexcept {
+  call_destructor(log_writer);
+  ut_delete(log_writer);
+  log_writer = nullptr;
+}
+
+void Log_writer::start() noexcept {
+  ut_a(!is_active());
+
+  m_shutdown.store(false, std::memory_order_relaxed);
+
+  m_n_threads_active.store(2, std::memory_order_relaxed);
+
+  os_thread_create(&Log_writer::writer_thread, this, nullptr);
+  os_thread_create(&Log_writer::flusher_thread, this, nullptr);
+
+  log_info("Started the log writer and the log flusher threads");
+}
+
+void Log_writer::shutdown() noexcept {
+  /* flush_async() checks m_shutdown under m_pending_mutex: a callback is
+  either queued before this or run by the caller. */
+  {
+    std::lock_guard<std::mutex> lock(m_pending_mutex);
+
+    m_shutdown.store(true, std::memory_order_seq_cst);
+  }
+
+  for (auto thread : {&m_writer, &m_flusher}) {
+    std::lock_guard<std::mutex> lock(thread->m_mutex);
+
+    thread->m_cv.notify_one();
+  }
+
+  while (is_active()) {
+    os_thread_sleep(10000);
+  }
+
+  /* Wake up the threads that still wait, they write the log themselves. */
+  notify(m_write_events, 0, IB_UINT64_T_MAX);
+  notify(m_flush_events, 0, IB_UINT64_T_MAX);
+
+  /* No callback can be added any more, run the ones left after the log is
+  flushed up to the largest lsn that they wait for. */
+  std::vector<Pending> ready;
+
+  {
+    std::lock_guard<std::mutex> lock(m_pending_mutex);
+
+    for (; !m_pending.empty(); m_pending.pop()) {
+      ready.push_back(m_pending.top());
+    }
+
+    m_pending_min_lsn.store(LSN_MAX, std::memory_order_seq_cst);
+  }
+
+  if (ready.empty()) {
+    return;
+  }
+
+  /* The queue is popped in ascending lsn order. */
+  m_log->write_up_to_low(ready.back().m_lsn, LOG_WAIT_ALL_GROUPS, true);
+
+  for (const auto &pending : ready) {
+    pending.m_callback(pending.m_arg);
+  }
+}
+
+void Log_writer::wakeup(Thread &thread) noexcept {
+  /* The requested lsn was raised before, with a full barrier: either the
+  thread sees it before it waits or we see that it waits. */
+  if (!thread.m_waiting.load(std::memory_order_seq_cst)) {
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(thread.m_mutex);
+
+    if (thread.m_wakeup_requested) {
+      return;
+    }
+
+    thread.m_wakeup_requested = true;
+  }
+
+  thread.m_cv.notify_one();
+}
+
+template <typename F>
+bool Log_writer::wait_for_work(Thread &thread, F &&has_work) noexcept {
+  std::unique_lock<std::mutex> lock(thread.m_mutex);
+
+  thread.m_waiting.store(true, std::memory_order_seq_cst);
+
+  thread.m_cv.wait_for(lock, std::chrono::seconds(1), [&] {
+    return thread.m_wakeup_requested || m_shutdown.load(std::memory_order_relaxed) || has_work();
+  });
+
+  thread.m_waiting.store(false, std::memory_order_relaxed);
+  thread.m_wakeup_requested = false;
+
+  return !m_shutdown.load(std::memory_order_relaxed);
+}
+
+void Log_writer::notify(Events &events, lsn_t old_lsn, lsn_t new_lsn) noexcept {
+  const auto first = old_lsn / IB_FILE_BLOCK_SIZE;
+  const auto last = std::min(new_lsn / IB_FILE_BLOCK_SIZE, first + N_EVENTS - 1);
+
+  for (auto block_no = first; block_no <= last; ++block_no) {
+    auto &event = events[block_no % N_EVENTS];
+
+    /* The waiter checks the lsn under the mutex, it can't miss the signal. */
+    {
+      std::lock_guard<std::mutex> lock(event.m_mutex);
+    }
+
+    event.m_cv.notify_all();
+  }
+}
+
+void Log_writer::write_up_to(lsn_t lsn, ulint wait, bool flush_to_disk) noexcept {
+  auto &reached_lsn = flush_to_disk ? m_log->m_flushed_to_disk_lsn : m_log->m_written_to_all_lsn;
+
+  if (reached_lsn.load(std::memory_order_acquire) >= lsn) {
+    return;
+  }
+
+  if (flush_to_disk) {
+    log_writer_raise(m_flush_requested_lsn, lsn);
+  }
+
+  log_writer_raise(m_write_requested_lsn, lsn);
+
+  if (m_log->m_written_to_all_lsn.load(std::memory_order_seq_cst) < lsn) {
+    wakeup(m_writer);
+  } else {
+    wakeup(m_flusher);
+  }
+
+  if (wait == LOG_NO_WAIT) {
+    return;
+  }
+
+  auto &event = (flush_to_disk ? m_flush_events : m_write_events)[lsn / IB_FILE_BLOCK_SIZE % N_EVENTS];
+
+  std::unique_lock<std::mutex> lock(event.m_mutex);
+
+  while (reached_lsn.load(std::memory_order_acquire) < lsn) {
+    if (!is_active()) {
+      /* The threads were stopped, do it ourselves. */
+      lock.unlock();
+
+      m_log->write_up_to_low(lsn, wait, flush_to_disk);
+
+      return;
+    }
+
+    event.m_cv.wait_for(lock, std::chrono::milliseconds(100));
+  }
+}
+
+void Log_writer::flush_async(lsn_t lsn, Callback callback, void *arg) noexcept {
+  bool queued{};
+
+  {
+    std::lock_guard<std::mutex> lock(m_pending_mutex);
+
+    if (!m_shutdown.load(std::memory_order_relaxed)) {
+      m_pending.push(Pending{lsn, callback, arg});
+      m_pending_min_lsn.store(m_pending.top().m_lsn, std::memory_order_seq_cst);
+      queued = true;
+    }
+  }
+
+  if (!queued) {
+    /* The threads were stopped, do it ourselves. */
+    m_log->write_up_to_low(lsn, LOG_WAIT_ALL_GROUPS, true);
+
+    callback(arg);
+
+  } else if (m_log->m_flushed_to_disk_lsn.load(std::memory_order_seq_cst) >= lsn) {
+    /* The flush that covered it may have checked the callbacks before we
+    added ours. */
+    wakeup(m_flusher);
+
+  } else {
+    write_up_to(lsn, LOG_NO_WAIT, true);
+  }
+}
+
+void Log_writer::run_callbacks(lsn_t lsn) noexcept {
+  if (m_pending_min_lsn.load(std::memory_order_seq_cst) > lsn) {
+    return;
+  }
+
+  std::vector<Pending> ready;
+
+  {
+    std::lock_guard<std::mutex> lock(m_pending_mutex);
+
+    while (!m_pending.empty() && m_pending.top().m_lsn <= lsn) {
+      ready.push_back(m_pending.top());
+      m_pending.pop();
+    }
+
+    m_pending_min_lsn.store(m_pending.empty() ? LSN_MAX : m_pending.top().m_lsn, std::memory_order_seq_cst);
+  }
+
+  for (const auto &pending : ready) {
+    pending.m_callback(pending.m_arg);
+  }
+}
+
+void *Log_writer::writer_thread(void *arg) noexcept {
+  auto writer = static_cast<Log_writer *>(arg);
+  auto log = writer->m_log;
+
+  auto has_work = [writer, log] {
+    return writer->m_write_requested_lsn.load(std::memory_order_seq_cst) > log->m_written_to_all_lsn.load(std::memory_order_relaxed);
+  };
+
+  for (;;) {
+    if (!has_work()) {
+      if (!writer->wait_for_work(writer->m_writer, has_work)) {
+        break;
+      }
+
+      continue;
+    }
+
+    const lsn_t written_lsn = log->m_written_to_all_lsn;
+    const lsn_t flushed_lsn = log->m_flushed_to_disk_lsn;
+
+    /* Write everything that the mini-transactions have copied so far, not
+    only what was requested. */
+    const auto lsn = log->m_recent_written.advance();
+
+    if (lsn == written_lsn) {
+      /* The mini-transactions below the requested lsn are still copying. */
+      std::this_thread::yield();
+      continue;
+    }
+
+    log->write_up_to_low(lsn, LOG_WAIT_ALL_GROUPS, false);
+
+    writer->m_n_writes.fetch_add(1, std::memory_order_relaxed);
+
+    notify(writer->m_write_events, written_lsn, lsn);
+
+    if (log->m_flushed_to_disk_lsn > flushed_lsn) {
+      /* O_DSYNC, the write also flushed. */
+      notify(writer->m_flush_events, flushed_lsn, log->m_flushed_to_disk_lsn);
+
+      writer->run_callbacks(log->m_flushed_to_disk_lsn);
+    }
+
+    if (writer->m_flush_requested_lsn.load(std::memory_order_seq_cst) > log->m_flushed_to_disk_lsn) {
+      wakeup(writer->m_flusher);
+    }
+  }
+
+  writer->m_n_threads_active.fetch_sub(1, std::memory_order_relaxed);
+
+  /* We count the number of threads in os_thread_exit(). A created
+  thread should always use that to exit and not use return() to exit. */
+
+  os_thread_exit();
+
+  return nullptr;
+}
+
+void *Log_writer::flusher_thread(void *arg) noexcept {
+  auto writer = static_cast<Log_writer *>(arg);
+  auto log = writer->m_log;
+
+  auto has_work = [writer, log] {
+    const lsn_t flushed_lsn = log->m_flushed_to_disk_lsn;
+
+    return (writer->m_flush_requested_lsn.load(std::memory_order_seq_cst) > flushed_lsn && log->m_written_to_all_lsn > flushed_lsn) ||
+           writer->m_pending_min_lsn.load(std::memory_order_seq_cst) <= flushed_lsn;
+  };
+
+  for (;;) {
+    if (!has_work()) {
+      if (!writer->wait_for_work(writer->m_flusher, has_work)) {
+        break;
+      }
+
+      continue;
+    }
+
+    const lsn_t flushed_lsn = log->m_flushed_to_disk_lsn;
+
+    if (writer->m_flush_requested_lsn.load(std::memory_order_seq_cst) > flushed_lsn && log->m_written_to_all_lsn > flushed_lsn) {
+      /* Flush everything that was written so far, the writer thread keeps
+      writing meanwhile. */
+      const auto lsn = log->flush_written();
+
+      writer->m_n_flushes.fetch_add(1, std::memory_order_relaxed);
+
+      notify(writer->m_flush_events, flushed_lsn, lsn);
+    }
+
+    writer->run_callbacks(log->m_flushed_to_disk_lsn);
+  }
+
+  writer->m_n_threads_active.fetch_sub(1, std::memory_order_relaxed);
+
+  /* We count the number of threads in os_thread_exit(). A created
+  thread should always use that to exit and not use return() to exit. */
+
+  os_thread_exit();
+
+  return nullptr;
+}
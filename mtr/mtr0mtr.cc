@@ -102,39 +102,27 @@ static void mtr_log_reserve_and_write(mtr_t *mtr, Log *log, ulint recovery) noex
     *first_data = byte(ulint(*first_data) | MLOG_SINGLE_REC_FLAG);
   }
 
-  if (mlog->single_block()) {
-
-    log->acquire();
-
-    mtr->m_end_lsn = log->reserve_and_write_fast(first_data, mlog->get_used(mlog->get_first_block()), &mtr->m_start_lsn);
-
-    if (mtr->m_end_lsn != 0) {
-      /* We were able to successfully write to the log. */
-      return;
-    }
-
-    log->release();
-  }
-
-  auto data_size = mlog->get_data_size();
-
-  /* Open the database log for log_write_low */
-  mtr->m_start_lsn = log->reserve_and_open(data_size);
-
   if (mtr->m_log_mode == MTR_LOG_ALL) {
+    /* Reserve the lsn range without the log mutex and copy to it, other
+    mini-transactions copy to their ranges concurrently */
+    mtr->m_start_lsn = log->reserve_and_open(mlog->get_data_size(), &mtr->m_end_lsn);
 
+    auto lsn = mtr->m_start_lsn;
     auto block = mlog->get_first_block();
 
     while (block != nullptr) {
-      log->write_low(mlog->get_data(block), mlog->get_used(block));
+      lsn = log->write_low(lsn, mlog->get_data(block), mlog->get_used(block));
       block = mlog->get_next_block(block);
     }
+
+    ut_ad(lsn == mtr->m_end_lsn);
+
+    log->close(mtr->m_start_lsn, mtr->m_end_lsn, ib_recovery_t(recovery));
   } else {
     ut_ad(mtr->m_log_mode == MTR_LOG_NONE);
-    /* Do nothing */
+    /* Nothing is written, the pages get the current lsn */
+    mtr->m_start_lsn = mtr->m_end_lsn = log->get_lsn();
   }
-
-  mtr->m_end_lsn = log->close(ib_recovery_t(recovery));
 }
 
 void mtr_t::commit() noexcept {
@@ -150,17 +138,16 @@ void mtr_t::commit() noexcept {
   }
 
   /* We first update the modification info to buffer pages, and only
-  after that release the log mutex: this guarantees that when the log
-  mutex is free, all buffer pages contain an up-to-date info of their
-  modifications. This fact is used in making a checkpoint when we look
-  at the oldest modification of any page in the buffer pool. It is also
-  required when we insert modified buffer pages in to the flush list
-  which must be sorted on oldest_modification. */
+  after that mark the lsn range closed: the log checkpoint does not pass
+  a range that is not closed, see Log::buf_pool_get_oldest_modification().
+  The modified pages are pushed to Buf_pool::m_flush_pending without the
+  buffer pool mutex, concurrent mini-transactions push them out of lsn
+  order and they are inserted sorted when moved to the flush list. */
 
   mtr_memo_pop_all(this);
 
   if (write_log) {
-    log_sys->release();
+    log_sys->mark_closed(m_start_lsn, m_end_lsn);
   }
 
   m_state = MTR_COMMITTED;
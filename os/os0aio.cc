@@ -16,8 +16,15 @@ limitations under the License.
 ***********************************************************************/
 
 #include <errno.h>
+#include <unistd.h>
 
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <shared_mutex>
 #include <vector>
 
 #include <liburing.h>
@@ -35,25 +42,125 @@ AIO *srv_aio{};
 
 namespace aio {
 
+/** Number of entries in the fixed buffer table of each io_uring. */
+constexpr ulint MAX_FIXED_BUFFERS = 4096;
+
+/** The kernel limits the size of a fixed buffer to 1 GiB, larger areas
+are registered as several buffers. */
+constexpr ulint MAX_FIXED_BUFFER_SIZE = 1024UL * 1024 * 1024;
+
+/** Number of entries in the fixed file table of each io_uring. */
+constexpr ulint MAX_FIXED_FILES = 4096;
+
+/** Number of IO_request types. */
+constexpr ulint N_IO_REQUESTS = ulint(IO_request::Sync_log_write) + 1;
+
+/** Number of entries in the io_uring that flushes the files, larger
+AIO::fsync() calls are split into batches of this size. */
+constexpr ulint FSYNC_QUEUE_SIZE = 64;
+
+/** @return the kernel i/o priority of the best effort class with the given
+level, 0 is the highest, see ioprio_set(2). The other classes need privileges. */
+constexpr uint16_t ioprio_best_effort(uint16_t level) {
+  return uint16_t((2 << 13) | level);
+}
+
+/** Settings of an IO_priority class. */
+struct Priority_class {
+  /** Kernel i/o priority of the SQEs of the class. */
+  uint16_t m_ioprio;
+
+  /** Percentage of the slots of a handler that the requests of the
+  class can hold at the same time. */
+  ulint m_max_slots_pct;
+};
+
+/** The settings of the priority classes, indexed by priority_index(). The
+read handler serves the sync reads, read-ahead and prefetch classes. The
+limits of the lower two add up to 75% so that a sync read always finds a
+slot however heavy the read-ahead or prefetch is. The limits only apply on a
+handler that serves more than one class, see handler_classes. */
+constexpr std::array<Priority_class, N_PRIORITIES> priority_classes{{
+  /* Sync_read */
+  {ioprio_best_effort(0), 100},
+  /* Log */
+  {ioprio_best_effort(1), 100},
+  /* Read_ahead */
+  {ioprio_best_effort(4), 50},
+  /* Flush */
+  {ioprio_best_effort(5), 75},
+  /* Prefetch */
+  {ioprio_best_effort(7), 25},
+}};
+
+/** @return the index of the priority class in priority_classes. */
+inline ulint priority_index(IO_priority priority) noexcept {
+  ut_ad(priority != IO_priority::Default);
+  return ulint(priority) - 1;
+}
+
+/** @return the bit of the priority class in handler_classes. */
+constexpr uint32_t priority_bit(IO_priority priority) {
+  return 1U << (uint32_t(priority) - 1);
+}
+
+/** The priority classes of the requests that each handler serves, indexed by
+the handler id. All the writes that are not log writes, the doublewrite
+included, are flushes, the write handler has no other class to leave slots
+to. */
+constexpr std::array<uint32_t, WRITE + 1> handler_classes{{
+  /* LOG */
+  priority_bit(IO_priority::Log),
+  /* READ */
+  priority_bit(IO_priority::Sync_read) | priority_bit(IO_priority::Read_ahead) | priority_bit(IO_priority::Prefetch),
+  /* WRITE */
+  priority_bit(IO_priority::Flush),
+}};
+
 struct Stats {
   std::string to_string() const {
     return std::format(
-      "sqes: {}, cqes: {}, total: {}, partial = {{ reqs: {}, data: {} }}, retries: {{ sqe: {}, cqe: {} }}",
-      m_n_sqes.load(), m_n_cqes.load(),
+      "sqes: {}, submits: {}, sqes/submit: {:.2f}, cqes: {}, total: {}, fixed = {{ bufs: {}, files: {} }}, "
+      "vectored = {{ sqes: {}, iovs: {} }}, partial = {{ reqs: {}, data: {} }}, retries: {{ sqe: {}, cqe: {} }}",
+      m_n_sqes.load(), m_n_submits.load(), sqes_per_submit(), m_n_cqes.load(),
       m_total.load(),
+      m_n_fixed_bufs.load(), m_n_fixed_files.load(),
+      m_n_vectored.load(), m_n_iovs.load(),
       m_partial_ops.load(), m_partial_data.load(),
       m_sqe_eintrs.load(), m_cqe_eintrs.load());
   }
 
+  /** @return the average number of SQEs passed to the kernel per io_uring_submit() call. */
+  double sqes_per_submit() const {
+    const auto n_submits = m_n_submits.load();
+
+    return n_submits == 0 ? 0.0 : double(m_n_sqes.load()) / double(n_submits);
+  }
+
   /** Total number of SQEs submitted (including partial). */
   std::atomic<uint64_t> m_n_sqes{};
 
+  /** Total number of io_uring_submit() calls that submitted at least one SQE. */
+  std::atomic<uint64_t> m_n_submits{};
+
   /** Total number of CQEs reaple (including partial), */
   std::atomic<uint64_t> m_n_cqes{};
 
   /** Total number of bytes read/written. */
   std::atomic<uint64_t> m_total{};
 
+  /** Total number of SQEs that used a fixed buffer. */
+  std::atomic<uint64_t> m_n_fixed_bufs{};
+
+  /** Total number of SQEs that used a fixed file. */
+  std::atomic<uint64_t> m_n_fixed_files{};
+
+  /** Total number of readv/writev SQEs. */
+  std::atomic<uint64_t> m_n_vectored{};
+
+  /** Total number of buffers passed in readv/writev SQEs. */
+  std::atomic<uint64_t> m_n_iovs{};
+
   /** Total number of partial SQEs submitted, */
   std::atomic<uint64_t> m_partial_ops{};
 
@@ -86,15 +193,73 @@ struct Slot {
   /** File offset in bytes */
   off_t m_off{};
 
+  /** Index of the fixed buffer that contains the request buffer, -1 if none. */
+  int m_buf_index{-1};
+
+  /** Buffers of a vectored request, m_request.m_ptr is not used then. */
+  std::array<iovec, MAX_IOVECS> m_iov{};
+
+  /** Index of the first buffer in m_iov with bytes left to read or write. */
+  uint32_t m_iov_first{};
+
+  /** Number of buffers left in m_iov, 0 if it's not a vectored request. */
+  uint32_t m_n_iov{};
+
+  /** When the request was first passed to the io_uring. */
+  std::chrono::steady_clock::time_point m_start{};
+
+  /** Set by the reap thread when a synchronous request completes, the
+   * submitter waits on it and frees the slot. */
+  bool m_done{};
+
   /** true if this slot is reserved */
   IF_DEBUG(bool m_reserved{};)
 
   /** The IO context */
   IO_ctx m_io_ctx{};
+
+  /** Account for bytes that were read or written.
+   *
+   * @param[in] n Number of bytes that the kernel transferred. */
+  void consume(uint32_t n) noexcept {
+    m_off += n;
+    m_len += n;
+    m_request.m_len -= n;
+
+    if (m_n_iov == 0) {
+      m_request.m_ptr += n;
+      return;
+    }
+
+    while (n > 0) {
+      auto &iov = m_iov[m_iov_first];
+
+      if (n < iov.iov_len) {
+        iov.iov_base = static_cast<byte*>(iov.iov_base) + n;
+        iov.iov_len -= n;
+        n = 0;
+      } else {
+        n -= iov.iov_len;
+        ++m_iov_first;
+        --m_n_iov;
+      }
+    }
+  }
 };
 
 using Slots_pool = Bounded_channel<Slot*>;
 
+/** Settings of the kernel thread that polls the io_uring submission queues. */
+struct Sqpoll {
+  /** Milliseconds without submissions before the thread sleeps, 0 if the
+   * queues are not polled. */
+  ulint m_idle_ms{};
+
+  /** File descriptor of the first polled io_uring, the other queues attach
+   * to its thread, -1 if none has been created yet. */
+  int m_ring_fd{-1};
+};
+
 /** There are three different types of requests:
  * 1. Log requests
  * 2. Read requests
@@ -143,8 +308,9 @@ struct Handler {
    * @param[in] id Id of the handler
    * @param[in] n_slots Number of slots in the handler
    * @param[in] n_queues Number of queues per handler
+   * @param[in,out] sqpoll Polling thread settings of the queues
    */
-  explicit Handler(ulint id, size_t n_slots, size_t n_queues) noexcept;
+  explicit Handler(ulint id, size_t n_slots, size_t n_queues, Sqpoll &sqpoll) noexcept;
 
   /* Destructor */
   ~Handler() noexcept;
@@ -185,6 +351,11 @@ struct Handler {
   /** Wake up the queue queues, we are shutting down. */
   void shutdown() noexcept;
 
+  /** Record the latency of a completed request.
+  * @param[in] io_ctx Context of the request.
+  * @param[in] start When the request was passed to the kernel. */
+  void record_latency(const IO_ctx &io_ctx, std::chrono::steady_clock::time_point start) noexcept;
+
   /** @return the handlers state as a string. */
   [[nodiscard]] std::string to_string() const;
 
@@ -194,9 +365,10 @@ struct Handler {
   * @param[in] id               Id of the handler
   * @param n_slots              Number of slots.
   * @param n_queues            Number of queues in the handler 
+  * @param sqpoll              Polling thread settings of the queues
   * @return own: handler instance.
   */
-  [[nodiscard]] static Handler *create(ulint id, ulint n_slots, ulint n_queues) noexcept;
+  [[nodiscard]] static Handler *create(ulint id, ulint n_slots, ulint n_queues, Sqpoll &sqpoll) noexcept;
 
   /** Destoy a Handler instance.
    * @param[in,own] Handler instance to destroy.
@@ -217,6 +389,18 @@ struct Handler {
   /** Number of  reserved slots in the handler */
   std::atomic<ulint> m_n_reserved{};
 
+  /** Number of reserved slots of each priority class. */
+  std::array<std::atomic<ulint>, N_PRIORITIES> m_n_inflight{};
+
+  /** Maximum number of reserved slots of each priority class. */
+  std::array<ulint, N_PRIORITIES> m_max_inflight{};
+
+  /** Number of times a request waited because its class was at its limit. */
+  std::array<std::atomic<uint64_t>, N_PRIORITIES> m_n_throttled{};
+
+  /** Latency of the completed requests of each IO_request type. */
+  std::array<ut::Latency_histogram, N_IO_REQUESTS> m_latency{};
+
   /** Slots to use for submitting/reapling requwests. */
   std::vector<Slot> m_slots{};
 
@@ -233,13 +417,20 @@ struct Handler::Queue {
   * @param[in] handler The owning handler of this queue
   * @param[in] id Id of the queue
   * @param[in] queue_size Size of the io_uring queue
+  * @param[in,out] sqpoll Polling thread settings, see Sqpoll.
   */
-  Queue(Handler *handler, ulint id, ulint queue_size) noexcept
+  Queue(Handler *handler, ulint id, ulint queue_size, Sqpoll &sqpoll) noexcept
     : m_handler(handler),
       m_id(id) {
 
-    if (auto ret = io_uring_queue_init(queue_size, &m_iouring, 0); ret < 0) {
-      log_fatal("Initializing io_uring queue failed: " + std::to_string(ret));
+    if (sqpoll.m_idle_ms > 0) {
+      init_sqpoll(queue_size, sqpoll);
+    }
+
+    if (!m_sqpoll) {
+      if (auto ret = io_uring_queue_init(queue_size, &m_iouring, 0); ret < 0) {
+        log_fatal("Initializing io_uring queue failed: " + std::to_string(ret));
+      }
     }
   }
 
@@ -260,6 +451,110 @@ struct Handler::Queue {
   */
   db_err submit(Slot *slot) noexcept ;
 
+  /** Prepare the SQE for an asynchronous IO request but don't pass it to
+   * the kernel, that is done by the next submit() or submit_batch() call
+   * on this queue.
+   *
+   * @param[in,out] slot Slot to prepare
+   *
+   * @return DB_SUCCESS or error code.
+  */
+  db_err prepare(Slot *slot) noexcept;
+
+  /** Pass the prepared SQEs to the kernel with a single io_uring_submit(). */
+  void submit_batch() noexcept;
+
+  /** Try to create the io_uring with a kernel thread that polls the
+   * submission queue. The first queue that succeeds creates the thread,
+   * the others attach to it so that all of them share one core. If the
+   * kernel refuses, polling is disabled for the remaining queues.
+   *
+   * @param[in] queue_size Size of the io_uring queue
+   * @param[in,out] sqpoll Polling thread settings.
+  */
+  void init_sqpoll(ulint queue_size, Sqpoll &sqpoll) noexcept {
+    io_uring_params params{};
+
+    params.flags = IORING_SETUP_SQPOLL;
+    params.sq_thread_idle = sqpoll.m_idle_ms;
+
+    if (sqpoll.m_ring_fd != -1) {
+      params.flags |= IORING_SETUP_ATTACH_WQ;
+      params.wq_fd = sqpoll.m_ring_fd;
+    }
+
+    auto ret = io_uring_queue_init_params(queue_size, &m_iouring, &params);
+
+    if (ret < 0 && sqpoll.m_ring_fd != -1) {
+      /* Older kernels can't share the thread, use one per queue. */
+      params.flags &= ~IORING_SETUP_ATTACH_WQ;
+      params.wq_fd = 0;
+
+      ret = io_uring_queue_init_params(queue_size, &m_iouring, &params);
+    }
+
+    if (ret < 0) {
+      log_warn(std::format("Cannot create an io_uring with a polling thread, error: {}. Using normal submission", -ret));
+
+      sqpoll.m_idle_ms = 0;
+    } else {
+      m_sqpoll = true;
+
+      if (sqpoll.m_ring_fd == -1) {
+        sqpoll.m_ring_fd = m_iouring.ring_fd;
+      }
+    }
+  }
+
+  /** Create empty fixed buffer and fixed file tables for the io_uring.
+   *
+   * @param[in] n_buffers Number of entries in the buffer table, 0 for none.
+   * @param[in] n_files Number of entries in the file table, 0 for none.
+   *
+   * @return 0 or -errno of the first registration that failed.
+  */
+  [[nodiscard]] int register_tables(ulint n_buffers, ulint n_files) noexcept {
+    if (n_buffers > 0) {
+      if (auto ret = io_uring_register_buffers_sparse(&m_iouring, n_buffers); ret < 0) {
+        return ret;
+      }
+    }
+
+    if (n_files > 0) {
+      if (auto ret = io_uring_register_files_sparse(&m_iouring, n_files); ret < 0) {
+        return ret;
+      }
+    }
+
+    return 0;
+  }
+
+  /** Set an entry of the fixed buffer table.
+   *
+   * @param[in] index Entry to set.
+   * @param[in] iov Buffer to register, {nullptr, 0} clears the entry.
+   *
+   * @return 0 or -errno.
+  */
+  [[nodiscard]] int update_buffer(ulint index, const iovec &iov) noexcept {
+    const auto ret = io_uring_register_buffers_update_tag(&m_iouring, index, &iov, nullptr, 1);
+
+    return ret < 0 ? ret : 0;
+  }
+
+  /** Set an entry of the fixed file table.
+   *
+   * @param[in] index Entry to set.
+   * @param[in] fd File to register, -1 clears the entry.
+   *
+   * @return 0 or -errno.
+  */
+  [[nodiscard]] int update_file(ulint index, int fd) noexcept {
+    const auto ret = io_uring_register_files_update(&m_iouring, index, &fd, 1);
+
+    return ret < 0 ? ret : 0;
+  }
+
   /** Wait for completed requests and return the IO context.
    * 
    * @param[out] io_ctx IO context
@@ -285,6 +580,10 @@ struct Handler::Queue {
 
     m_shutdown.store(true);
 
+    std::lock_guard<std::mutex> lock(m_sq_mutex);
+
+    ut_a(m_n_prepared == 0);
+
     io_uring_sqe *sqe = io_uring_get_sqe(&m_iouring);
     ut_a(sqe != nullptr);
 
@@ -296,6 +595,7 @@ struct Handler::Queue {
       switch(ret) {
         case 1:
           m_stats.m_n_sqes.fetch_add(1, std::memory_order_relaxed);
+          m_stats.m_n_submits.fetch_add(1, std::memory_order_relaxed);
           return;
         case -EINTR:
         case -EAGAIN:
@@ -309,18 +609,38 @@ struct Handler::Queue {
 
   /** @return the queue's state as a string. */
   [[nodiscard]] std::string to_string() const {
-    return "stats: { " + m_stats.to_string() + " }";
+    return std::format("sqpoll: {}, stats: {{ {} }}", m_sqpoll, m_stats.to_string());
   }
 
+  /** Fill in an SQE for the slot, the caller must own m_sq_mutex.
+   *
+   * @param[in,out] slot Slot to prepare
+  */
+  void prepare_low(Slot *slot) noexcept;
+
+  /** Pass the prepared SQEs to the kernel, the caller must own m_sq_mutex. */
+  void submit_low() noexcept;
+
   /** We are shutting down. */
   std::atomic<bool> m_shutdown{};
 
+  /** true if a kernel thread polls the submission queue. */
+  bool m_sqpoll{};
+
   /* For collecting operational statistics. */
   Stats m_stats{};
 
   /** Number of pending AIO slots. */
   std::atomic<ulint> m_pending_slots{};
 
+  /** Serializes the threads that fill in and submit SQEs, the reap thread
+   * only touches the completion queue. */
+  std::mutex m_sq_mutex{};
+
+  /** Number of SQEs that have been prepared but not submitted yet,
+   * protected by m_sq_mutex. */
+  ulint m_n_prepared{};
+
   /** Parent handler. */
   Handler *m_handler{};
 
@@ -336,15 +656,33 @@ struct Impl : public AIO {
    * @param[in] n_slots Total number of slots for all queues
    * @param[in] read_queues Number of reader queues.
    * @param[in] writer_queues Number of writer queues.
+   * @param[in] sqpoll_idle_ms Idle time of the polling thread, 0 for none.
    */ 
-  Impl(ulint n_slots, ulint read_queues, ulint write_queues) noexcept
+  Impl(ulint n_slots, ulint read_queues, ulint write_queues, ulint sqpoll_idle_ms) noexcept
     : m_n_queues(read_queues + write_queues + 1) {
-    m_handlers[LOG] = Handler::create(LOG, n_slots, 1);
-    m_handlers[READ] = Handler::create(READ, n_slots, read_queues);
-    m_handlers[WRITE] = Handler::create(WRITE, n_slots, write_queues);
+    Sqpoll sqpoll{.m_idle_ms = sqpoll_idle_ms};
+
+    m_handlers[LOG] = Handler::create(LOG, n_slots, 1, sqpoll);
+    m_handlers[READ] = Handler::create(READ, n_slots, read_queues, sqpoll);
+    m_handlers[WRITE] = Handler::create(WRITE, n_slots, write_queues, sqpoll);
+
+    /* The polling is disabled if the kernel refused it. */
+    m_sqpoll = sqpoll.m_idle_ms > 0;
+
+    register_tables();
+
+    if (auto ret = io_uring_queue_init(FSYNC_QUEUE_SIZE, &m_fsync_iouring, 0); ret < 0) {
+      log_warn("Initializing the io_uring queue for flushing failed, the files are flushed one at a time: " + std::to_string(ret));
+    } else {
+      m_use_fsync_iouring = true;
+    }
   }
 
   ~Impl() noexcept {
+    if (m_use_fsync_iouring) {
+      io_uring_queue_exit(&m_fsync_iouring);
+    }
+
     Handler::destroy(m_handlers[LOG]);
     Handler::destroy(m_handlers[READ]);
     Handler::destroy(m_handlers[WRITE]);
@@ -361,6 +699,60 @@ struct Impl : public AIO {
   */
   [[nodiscard]] virtual db_err submit(IO_ctx&& io_ctx, void *buf, ulint n, off_t off) noexcept;
 
+  /**
+  * @brief Submit a vectored asynchronous request.
+  *
+  * @param io_ctx Context of the i/o operation.
+  * @param iov Buffers to read into or to write from.
+  * @param n_iov Number of buffers.
+  * @param off File offset of the first buffer.
+  * @return DB_SUCCESS or error code.
+  */
+  [[nodiscard]] virtual db_err submit(IO_ctx&& io_ctx, const iovec *iov, ulint n_iov, off_t off) noexcept;
+
+  /**
+  * @brief Submits the requests that the calling thread posted in batch mode.
+  */
+  virtual void submit_batch() noexcept;
+
+  /**
+  * @brief Registers a memory area with all the io_urings.
+  *
+  * @param[in] ptr Start of the area.
+  * @param[in] len Length of the area in bytes.
+  */
+  virtual void register_buffer(void *ptr, ulint len) noexcept;
+
+  /**
+  * @brief Unregisters a memory area from all the io_urings.
+  *
+  * @param[in] ptr Start of the area.
+  * @param[in] len Length of the area in bytes.
+  */
+  virtual void unregister_buffer(void *ptr, ulint len) noexcept;
+
+  /**
+  * @brief Registers an open file with all the io_urings.
+  *
+  * @param[in,out] fil_node File to register.
+  */
+  virtual void register_file(fil_node_t *fil_node) noexcept;
+
+  /**
+  * @brief Unregisters a file from all the io_urings.
+  *
+  * @param[in,out] fil_node File to unregister.
+  */
+  virtual void unregister_file(fil_node_t *fil_node) noexcept;
+
+  /**
+  * @brief Flushes several files in parallel.
+  *
+  * @param[in,out] requests Files to flush, the results are set.
+  * @param[in] n_requests Number of files.
+  */
+  virtual void fsync(Fsync_request *requests, ulint n_requests) noexcept;
+
   /**
   * @brief Reap the completed request from io_uring.
   *
@@ -370,6 +762,23 @@ struct Impl : public AIO {
   */
   [[nodiscard]] virtual db_err reap(ulint queue_id, IO_ctx &io_ctx) noexcept;
 
+  /**
+  * @brief Adds the latency histogram of a request type to a snapshot.
+  *
+  * @param[in] io_request Request type.
+  * @param[in,out] snapshot Snapshot to add to.
+  */
+  virtual void io_latency(IO_request io_request, ut::Latency_histogram::Snapshot &snapshot) noexcept;
+
+  /**
+  * @brief Returns the number of times a request of a class waited for a slot.
+  *
+  * @param[in] priority Priority class.
+  *
+  * @return the number of waits.
+  */
+  virtual uint64_t n_throttled(IO_priority priority) noexcept;
+
   /**
   * @brief Waits until there are no pending async operations.
   */
@@ -422,6 +831,39 @@ struct Impl : public AIO {
     return m_n_queues;
   }
 
+  /** Create the fixed buffer and file tables of all the io_urings, the
+   * use of the tables is disabled if the kernel doesn't support them. */
+  void register_tables() noexcept;
+
+  /** Find the fixed buffer that contains a request buffer.
+   *
+   * @param[in] ptr Start of the request buffer.
+   * @param[in] len Length of the request buffer.
+   *
+   * @return the index of the fixed buffer, -1 if there is none.
+  */
+  [[nodiscard]] int find_fixed_buffer(const void *ptr, ulint len) noexcept;
+
+  /** Set an entry of the fixed buffer table in all the io_urings.
+   *
+   * @param[in] index Entry to set.
+   * @param[in] iov Buffer to register, {nullptr, 0} clears the entry.
+   *
+   * @return 0 or -errno of the first update that failed, the entries
+   * that were updated before the failure are cleared again.
+  */
+  [[nodiscard]] int update_buffer(ulint index, const iovec &iov) noexcept;
+
+  /** Set an entry of the fixed file table in all the io_urings.
+   *
+   * @param[in] index Entry to set.
+   * @param[in] fd File to register, -1 clears the entry.
+   *
+   * @return 0 or -errno of the first update that failed, the entries
+   * that were updated before the failure are cleared again.
+  */
+  [[nodiscard]] int update_file(ulint index, int fd) noexcept;
+
   Impl(Impl&&) = delete;
   Impl(const Impl&) = delete;
   Impl& operator=(Impl&&) = delete;
@@ -432,22 +874,85 @@ struct Impl : public AIO {
   /** true if shutdown has been called. */
   bool m_shutdown{};
 
+  /** true if the queues are polled by a kernel thread. */
+  bool m_sqpoll{};
+
   /** The handler instances. */
   Array m_handlers;
 
   /** Total number of queues/queues. */
   std::size_t m_n_queues;
+
+  /** A registered memory area, or a part of it if it's larger than
+   * MAX_FIXED_BUFFER_SIZE. */
+  struct Fixed_buffer {
+    /** End of the area. */
+    const byte *m_end{};
+
+    /** Index in the fixed buffer tables. */
+    int m_index{-1};
+  };
+
+  /** Protects the fixed buffer and file bookkeeping below. The submitters
+   * only look up the fixed buffers, they take it in shared mode. */
+  std::shared_mutex m_fixed_latch{};
+
+  /** true if new buffers can be registered. */
+  bool m_use_fixed_buffers{};
+
+  /** true if new files can be registered. */
+  bool m_use_fixed_files{};
+
+  /** The registered areas by start address. */
+  std::map<const byte *, Fixed_buffer> m_fixed_buffers{};
+
+  /** Free entries of the fixed buffer tables. */
+  std::vector<int> m_free_buffers{};
+
+  /** Free entries of the fixed file tables. */
+  std::vector<int> m_free_files{};
+
+  /** Serializes the use of m_fsync_iouring. */
+  std::mutex m_fsync_mutex{};
+
+  /** true if m_fsync_iouring was created. */
+  bool m_use_fsync_iouring{};
+
+  /** io_uring for flushing the files, see fsync(). */
+  io_uring m_fsync_iouring{};
+
+  /** Number of files flushed. */
+  std::atomic<uint64_t> m_n_fsyncs{};
+
+  /** Number of batches the files were flushed in. */
+  std::atomic<uint64_t> m_n_fsync_batches{};
 };
 
-Handler::Handler(ulint id, size_t n_slots, size_t n_queues) noexcept
+/** The queue of each handler that the calling thread has posted batch mode
+requests to since its last AIO::submit_batch() call. All the requests of a
+batch go to the same queue so that they are submitted with one system call. */
+static thread_local std::array<Handler::Queue *, WRITE + 1> batch_queues{};
+
+Handler::Handler(ulint id, size_t n_slots, size_t n_queues, Sqpoll &sqpoll) noexcept
   : m_id(id) {
   m_not_full = Cond_var::create(nullptr);
   m_is_empty = Cond_var::create(nullptr);
 
   m_slots.resize(n_slots);
 
+  /* A class can only leave slots to the other classes of the handler. */
+  const auto capped = std::popcount(handler_classes[id]) > 1;
+
+  for (ulint i = 0; i < N_PRIORITIES; ++i) {
+    if (capped) {
+      m_max_inflight[i] = std::max<ulint>(1, n_slots * priority_classes[i].m_max_slots_pct / 100);
+    } else {
+      m_max_inflight[i] = n_slots;
+    }
+  }
+
   for (size_t i = 0; i < n_queues; i++) {
-    auto queue = new (ut_new(sizeof(Queue))) Queue(this, i, n_slots);
+    auto queue = new (ut_new(sizeof(Queue))) Queue(this, i, n_slots, sqpoll);
     ut_a(queue != nullptr);
     m_queues.push_back(queue);
   }
@@ -501,6 +1006,16 @@ std::string Handler::to_string() const {
 
   os << m_queues.back()->to_string() << " ]";
 
+  os << ", classes: {";
+
+  for (ulint i = 0; i < N_PRIORITIES; ++i) {
+    os << (i == 0 ? " " : ", ") << ::to_string(IO_priority(i + 1))
+       << ": { inflight: " << m_n_inflight[i].load() << ", max: " << m_max_inflight[i]
+       << ", throttled: " << m_n_throttled[i].load() << " }";
+  }
+
+  os << " }";
+
   return os.str();
 }
 
@@ -536,20 +1051,35 @@ void Handler::destroy(Handler *handler) noexcept {
   ut_delete(handler);
 }
 
-Handler *Handler::create(ulint id, ulint n_slots, ulint n_queues) noexcept {
+Handler *Handler::create(ulint id, ulint n_slots, ulint n_queues, Sqpoll &sqpoll) noexcept {
   ut_a(n_slots > 0);
   ut_a(n_queues > 0);
 
-  return new (ut_new(sizeof(Handler))) Handler(id, n_slots, n_queues);
+  return new (ut_new(sizeof(Handler))) Handler(id, n_slots, n_queues, sqpoll);
+}
+
+void Handler::record_latency(const IO_ctx &io_ctx, std::chrono::steady_clock::time_point start) noexcept {
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const auto us = uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+
+  m_latency[ulint(io_ctx.m_io_request)].record(us);
+
+  /* The space can't go away, the file has a pending i/o. */
+  io_ctx.m_fil_node->m_space->m_io_latency.record(us);
 }
 
 void Handler::mark_as_free(Slot *slot) noexcept {
   ut_ad(slot->m_reserved);
   ut_d(slot->m_reserved = false);
 
+  auto &n_inflight = m_n_inflight[priority_index(slot->m_io_ctx.priority())];
+
   auto success = m_free_pool->enqueue(slot);
   ut_a(success);
 
+  n_inflight.fetch_sub(1, std::memory_order_release);
+  n_inflight.notify_all();
+
   m_n_reserved.fetch_sub(1, std::memory_order_relaxed);
 
   if (m_n_reserved.load() == m_slots.capacity() - 1) {
@@ -562,11 +1092,39 @@ void Handler::mark_as_free(Slot *slot) noexcept {
 }
 
 Slot *Handler::Queue::reserve_slot(const IO_ctx &io_ctx, void *ptr, uint32_t len, off_t off) noexcept {
+  const auto prio = priority_index(io_ctx.priority());
+  auto &n_inflight = m_handler->m_n_inflight[prio];
+  const auto max_inflight = m_handler->m_max_inflight[prio];
+
+  /* Take a slot of the priority class first, a class that is at its
+  limit leaves the rest of the slots to the higher classes. */
+  for (auto n = n_inflight.load(std::memory_order_acquire);;) {
+    if (n < max_inflight) {
+      if (n_inflight.compare_exchange_weak(n, n + 1, std::memory_order_acq_rel)) {
+        break;
+      }
+    } else {
+      /* The slots of the class may be held by our own requests that were
+      prepared in batch mode, submit those first. */
+      submit_batch();
+
+      m_handler->m_n_throttled[prio].fetch_add(1, std::memory_order_relaxed);
+
+      n_inflight.wait(n, std::memory_order_acquire);
+
+      n = n_inflight.load(std::memory_order_acquire);
+    }
+  }
+
   for (;;) {
     if (m_handler->m_n_reserved.load(std::memory_order_relaxed) == m_handler->m_slots.capacity()) {
 
       /* If the handler queues are suspended, wake them
-      so that we get more slots */
+      so that we get more slots. The slots may be held by
+      requests that were prepared in batch mode, submit those
+      first otherwise we could wait forever. */
+
+      submit_batch();
 
       m_handler->m_not_full->wait(0);
 
@@ -593,6 +1151,10 @@ Slot *Handler::Queue::reserve_slot(const IO_ctx &io_ctx, void *ptr, uint32_t len
 
       slot->m_len = 0;
       slot->m_off = off;
+      slot->m_buf_index = -1;
+      slot->m_iov_first = 0;
+      slot->m_n_iov = 0;
+      slot->m_done = false;
       ut_ad(slot->m_reserved = true);
       slot->m_io_ctx = std::move(io_ctx_copy);
       slot->m_request = {static_cast<byte*>(ptr), len};
@@ -605,48 +1167,118 @@ Slot *Handler::Queue::reserve_slot(const IO_ctx &io_ctx, void *ptr, uint32_t len
   return nullptr;
 }
 
-db_err Handler::Queue::submit(Slot *slot) noexcept {
-  ut_a(!m_shutdown.load(std::memory_order_acquire));
-  ut_ad(m_handler->m_n_reserved.load(std::memory_order_acquire) > 0);
-
+void Handler::Queue::prepare_low(Slot *slot) noexcept {
   auto sqe = io_uring_get_sqe(&m_iouring);
 
   if (sqe == nullptr) {
-    return DB_OUT_OF_MEMORY;
+    /* The submission queue is full of prepared requests, make room. */
+    submit_low();
+
+    sqe = io_uring_get_sqe(&m_iouring);
+    ut_a(sqe != nullptr);
+  }
+
+  if (slot->m_len == 0) {
+    /* Not a resubmission of a partial read or write. */
+    slot->m_start = std::chrono::steady_clock::now();
   }
 
   auto &buffer = slot->m_request;
-  auto fh{slot->m_io_ctx.m_fil_node->m_fh};
+  auto fil_node{slot->m_io_ctx.m_fil_node};
+  auto fh{fil_node->m_fixed_fh != -1 ? fil_node->m_fixed_fh : fil_node->m_fh};
+
+  if (slot->m_n_iov > 0) {
+    auto iov = &slot->m_iov[slot->m_iov_first];
+
+    if (slot->m_io_ctx.is_read_request()) {
+      io_uring_prep_readv(sqe, fh, iov, slot->m_n_iov, slot->m_off);
+    } else {
+      io_uring_prep_writev(sqe, fh, iov, slot->m_n_iov, slot->m_off);
+    }
 
-  /* Do the i/o with ordinary, synchronous i/o functions: */
-  if (slot->m_io_ctx.is_read_request()) {
-    io_uring_prep_read(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off);
+    m_stats.m_n_vectored.fetch_add(1, std::memory_order_relaxed);
+    m_stats.m_n_iovs.fetch_add(slot->m_n_iov, std::memory_order_relaxed);
+  } else if (slot->m_buf_index == -1) {
+    if (slot->m_io_ctx.is_read_request()) {
+      io_uring_prep_read(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off);
+    } else {
+      io_uring_prep_write(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off);
+    }
   } else {
-    io_uring_prep_write(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off);
+    if (slot->m_io_ctx.is_read_request()) {
+      io_uring_prep_read_fixed(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off, slot->m_buf_index);
+    } else {
+      io_uring_prep_write_fixed(sqe, fh, buffer.m_ptr, buffer.m_len, slot->m_off, slot->m_buf_index);
+    }
+
+    m_stats.m_n_fixed_bufs.fetch_add(1, std::memory_order_relaxed);
   }
 
+  if (fil_node->m_fixed_fh != -1) {
+    io_uring_sqe_set_flags(sqe, IOSQE_FIXED_FILE);
+
+    m_stats.m_n_fixed_files.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /* The block layer schedulers that support i/o priorities serve the
+  higher priority requests first when the device is busy. */
+  sqe->ioprio = priority_classes[priority_index(slot->m_io_ctx.priority())].m_ioprio;
+
   io_uring_sqe_set_data64(sqe, uintptr_t(slot));
 
+  ++m_n_prepared;
+
   m_pending_slots.fetch_add(1, std::memory_order_relaxed);
 
   m_stats.m_n_sqes.fetch_add(1, std::memory_order_relaxed);
+}
 
-  for (;;) {
+void Handler::Queue::submit_low() noexcept {
+  while (m_n_prepared > 0) {
     const auto ret = io_uring_submit(&m_iouring);
 
-    switch(ret) {
-      case 1:
-        return DB_SUCCESS;
-      case -EINTR:
-      case -EAGAIN:
-        m_stats.m_sqe_eintrs.fetch_add(1);
-        continue;
-      default:
-        log_fatal("io_uring_submit failed: " + std::to_string(ret));
+    if (ret > 0) {
+      ut_a(ulint(ret) <= m_n_prepared);
+      m_n_prepared -= ret;
+      m_stats.m_n_submits.fetch_add(1, std::memory_order_relaxed);
+    } else if (ret == -EINTR || ret == -EAGAIN) {
+      m_stats.m_sqe_eintrs.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      log_fatal("io_uring_submit failed: " + std::to_string(ret));
     }
-    return DB_ERROR;
   }
-} 
+}
+
+db_err Handler::Queue::prepare(Slot *slot) noexcept {
+  ut_a(!m_shutdown.load(std::memory_order_acquire));
+  ut_ad(m_handler->m_n_reserved.load(std::memory_order_acquire) > 0);
+
+  std::lock_guard<std::mutex> lock(m_sq_mutex);
+
+  prepare_low(slot);
+
+  return DB_SUCCESS;
+}
+
+db_err Handler::Queue::submit(Slot *slot) noexcept {
+  ut_a(!m_shutdown.load(std::memory_order_acquire));
+  ut_ad(m_handler->m_n_reserved.load(std::memory_order_acquire) > 0);
+
+  std::lock_guard<std::mutex> lock(m_sq_mutex);
+
+  prepare_low(slot);
+
+  /* This also submits any requests that other threads have prepared. */
+  submit_low();
+
+  return DB_SUCCESS;
+}
+
+void Handler::Queue::submit_batch() noexcept {
+  std::lock_guard<std::mutex> lock(m_sq_mutex);
+
+  submit_low();
+}
 
 db_err Handler::Queue::reap(IO_ctx &io_ctx) noexcept {
   ut_ad(m_handler->validate());
@@ -682,25 +1314,36 @@ db_err Handler::Queue::reap(IO_ctx &io_ctx) noexcept {
     ut_ad(slot->m_reserved);
     ut_a(decltype(cqe->res)(slot->m_request.m_len) >= cqe->res);
 
-    slot->m_off += cqe->res;
-    slot->m_len += cqe->res;
-    slot->m_request.m_len -= cqe->res;
-    slot->m_request.m_ptr += cqe->res;
+    slot->consume(cqe->res);
 
     m_stats.m_total.fetch_add(cqe->res, std::memory_order_relaxed);
 
+    const auto res = cqe->res;
+
+    auto n = m_pending_slots.fetch_sub(1, std::memory_order_relaxed);
+    ut_a(n > 0);
+
+    io_uring_cqe_seen(&m_iouring, cqe);
+
     if (slot->m_request.m_len > 0) {
       m_stats.m_partial_ops.fetch_add(1, std::memory_order_relaxed);
       m_stats.m_partial_data.fetch_add(slot->m_request.m_len, std::memory_order_relaxed);
       /* It was a partial read/write, try and read the remaining bytes. */
       submit(slot);
     } else {
-      slot->m_io_ctx.m_ret = cqe->res;
+      slot->m_io_ctx.m_ret = res;
 
-      auto n = m_pending_slots.fetch_sub(1, std::memory_order_relaxed);
-      ut_a(n > 0);
+      m_handler->record_latency(slot->m_io_ctx, slot->m_start);
 
-      io_uring_cqe_seen(&m_iouring, cqe);
+      if (slot->m_io_ctx.is_sync_request()) {
+        /* The submitter is waiting for it and frees the slot. */
+        std::atomic_ref<bool> done(slot->m_done);
+
+        done.store(true, std::memory_order_release);
+        done.notify_one();
+
+        continue;
+      }
 
       io_ctx = slot->m_io_ctx;
 
@@ -758,24 +1401,297 @@ db_err Impl::submit(IO_ctx&& io_ctx, void *ptr, ulint n, off_t off) noexcept {
   ut_ad(n % IB_FILE_BLOCK_SIZE == 0);
   ut_ad(off % IB_FILE_BLOCK_SIZE == 0);
 
-  if (io_ctx.is_sync_request()) {
+  /* When the queues are polled a synchronous read is cheaper through the
+  io_uring than with pread(), the polling thread does the submission. */
+  const auto use_ring = m_sqpoll && io_ctx.is_read_request();
+
+  if (io_ctx.is_sync_request() && !use_ring) {
     auto fh{io_ctx.m_fil_node->m_fh};
+    const auto start = std::chrono::steady_clock::now();
+
+    bool success;
 
     if (io_ctx.is_read_request()) {
-      return os_file_read(fh, ptr, n, off) ? DB_SUCCESS : DB_ERROR;
+      success = os_file_read(fh, ptr, n, off);
     } else {
       auto name{io_ctx.m_fil_node->m_file_name};
 
-      return os_file_write(name, fh, ptr, n, off) ? DB_SUCCESS : DB_ERROR;
+      success = os_file_write(name, fh, ptr, n, off);
     }
+
+    m_handlers[get_type(io_ctx)]->record_latency(io_ctx, start);
+
+    return success ? DB_SUCCESS : DB_ERROR;
   }
-  auto handler = m_handlers[get_type(io_ctx)];
-  auto queue = handler->get_queue_for_submit();
-  auto slot = queue->reserve_slot(io_ctx, ptr, n, off);
+  const auto type = get_type(io_ctx);
+  auto handler = m_handlers[type];
 
-  queue->submit(slot);
+  auto &batch_queue = batch_queues[type];
+  const auto buf_index = find_fixed_buffer(ptr, n);
 
-  return DB_SUCCESS;
+  if (!io_ctx.m_batch) {
+    /* If we have an open batch, submit this request with it. */
+    auto queue = batch_queue != nullptr ? batch_queue : handler->get_queue_for_submit();
+    auto slot = queue->reserve_slot(io_ctx, ptr, n, off);
+
+    slot->m_buf_index = buf_index;
+
+    batch_queue = nullptr;
+
+    if (!io_ctx.is_sync_request()) {
+      return queue->submit(slot);
+    }
+
+    auto err = queue->submit(slot);
+    ut_a(err == DB_SUCCESS);
+
+    std::atomic_ref<bool> done(slot->m_done);
+
+    done.wait(false, std::memory_order_acquire);
+
+    const auto len = slot->m_len;
+
+    handler->mark_as_free(slot);
+
+    return len == n ? DB_SUCCESS : DB_ERROR;
+  }
+
+  if (batch_queue == nullptr) {
+    batch_queue = handler->get_queue_for_submit();
+  }
+
+  auto slot = batch_queue->reserve_slot(io_ctx, ptr, n, off);
+
+  slot->m_buf_index = buf_index;
+
+  return batch_queue->prepare(slot);
+}
+
+db_err Impl::submit(IO_ctx&& io_ctx, const iovec *iov, ulint n_iov, off_t off) noexcept {
+  io_ctx.validate();
+
+  ut_a(!io_ctx.is_sync_request());
+  ut_a(n_iov > 0 && n_iov <= MAX_IOVECS);
+  ut_ad(off % IB_FILE_BLOCK_SIZE == 0);
+
+  ulint n{};
+
+  for (ulint i = 0; i < n_iov; ++i) {
+    ut_ad(iov[i].iov_base != nullptr);
+    ut_ad(iov[i].iov_len % IB_FILE_BLOCK_SIZE == 0);
+    n += iov[i].iov_len;
+  }
+
+  const auto type = get_type(io_ctx);
+  auto handler = m_handlers[type];
+  auto &batch_queue = batch_queues[type];
+
+  if (!io_ctx.m_batch) {
+    /* If we have an open batch, submit this request with it. */
+    auto queue = batch_queue != nullptr ? batch_queue : handler->get_queue_for_submit();
+    auto slot = queue->reserve_slot(io_ctx, nullptr, n, off);
+
+    std::copy_n(iov, n_iov, slot->m_iov.begin());
+    slot->m_n_iov = n_iov;
+
+    batch_queue = nullptr;
+
+    return queue->submit(slot);
+  }
+
+  if (batch_queue == nullptr) {
+    batch_queue = handler->get_queue_for_submit();
+  }
+
+  auto slot = batch_queue->reserve_slot(io_ctx, nullptr, n, off);
+
+  std::copy_n(iov, n_iov, slot->m_iov.begin());
+  slot->m_n_iov = n_iov;
+
+  return batch_queue->prepare(slot);
+}
+
+void Impl::submit_batch() noexcept {
+  for (auto &queue : batch_queues) {
+    if (queue != nullptr) {
+      queue->submit_batch();
+      queue = nullptr;
+    }
+  }
+}
+
+void Impl::register_tables() noexcept {
+  m_use_fixed_buffers = true;
+  m_use_fixed_files = true;
+
+  for (auto handler : m_handlers) {
+    for (auto queue : handler->m_queues) {
+      if (m_use_fixed_buffers) {
+        if (auto ret = queue->register_tables(MAX_FIXED_BUFFERS, 0); ret < 0) {
+          log_warn(std::format("Cannot register io_uring fixed buffers, error: {}. Not using fixed buffers", -ret));
+          m_use_fixed_buffers = false;
+        }
+      }
+
+      if (m_use_fixed_files) {
+        if (auto ret = queue->register_tables(0, MAX_FIXED_FILES); ret < 0) {
+          log_warn(std::format("Cannot register io_uring fixed files, error: {}. Not using fixed files", -ret));
+          m_use_fixed_files = false;
+        }
+      }
+    }
+  }
+
+  /* Hand out the low entries first. */
+  for (int i = MAX_FIXED_BUFFERS - 1; i >= 0; --i) {
+    m_free_buffers.push_back(i);
+  }
+
+  for (int i = MAX_FIXED_FILES - 1; i >= 0; --i) {
+    m_free_files.push_back(i);
+  }
+}
+
+int Impl::update_buffer(ulint index, const iovec &iov) noexcept {
+  const iovec empty{};
+
+  for (auto handler : m_handlers) {
+    for (auto queue : handler->m_queues) {
+      if (auto ret = queue->update_buffer(index, iov); ret < 0) {
+        if (iov.iov_base != nullptr) {
+          /* Clearing an entry doesn't fail. */
+          const auto err = update_buffer(index, empty);
+          ut_a(err == 0);
+        }
+        return ret;
+      }
+    }
+  }
+
+  return 0;
+}
+
+int Impl::update_file(ulint index, int fd) noexcept {
+  for (auto handler : m_handlers) {
+    for (auto queue : handler->m_queues) {
+      if (auto ret = queue->update_file(index, fd); ret < 0) {
+        if (fd != -1) {
+          /* Clearing an entry doesn't fail. */
+          const auto err = update_file(index, -1);
+          ut_a(err == 0);
+        }
+        return ret;
+      }
+    }
+  }
+
+  return 0;
+}
+
+int Impl::find_fixed_buffer(const void *ptr, ulint len) noexcept {
+  const auto start = static_cast<const byte *>(ptr);
+
+  std::shared_lock<std::shared_mutex> lock(m_fixed_latch);
+
+  auto it = m_fixed_buffers.upper_bound(start);
+
+  if (it == m_fixed_buffers.begin()) {
+    return -1;
+  }
+
+  --it;
+
+  return start + len <= it->second.m_end ? it->second.m_index : -1;
+}
+
+void Impl::register_buffer(void *ptr, ulint len) noexcept {
+  auto start = static_cast<const byte *>(ptr);
+  const auto end = start + len;
+
+  std::lock_guard<std::shared_mutex> lock(m_fixed_latch);
+
+  while (m_use_fixed_buffers && start < end) {
+    if (m_free_buffers.empty()) {
+      log_warn(std::format(
+        "All {} io_uring fixed buffers are in use, the rest of the buffer pool uses ordinary reads and writes", MAX_FIXED_BUFFERS
+      ));
+      m_use_fixed_buffers = false;
+      break;
+    }
+
+    const auto size = std::min<ulint>(end - start, MAX_FIXED_BUFFER_SIZE);
+    const auto index = m_free_buffers.back();
+    const iovec iov{const_cast<byte *>(start), size};
+
+    if (auto ret = update_buffer(index, iov); ret < 0) {
+      log_warn(std::format("Cannot register an io_uring fixed buffer of {} bytes, error: {}. Not using fixed buffers", size, -ret));
+      m_use_fixed_buffers = false;
+      break;
+    }
+
+    m_free_buffers.pop_back();
+
+    m_fixed_buffers[start] = Fixed_buffer{start + size, index};
+
+    start += size;
+  }
+}
+
+void Impl::unregister_buffer(void *ptr, ulint len) noexcept {
+  const auto start = static_cast<const byte *>(ptr);
+  const auto end = start + len;
+  const iovec empty{};
+
+  std::lock_guard<std::shared_mutex> lock(m_fixed_latch);
+
+  auto it = m_fixed_buffers.lower_bound(start);
+
+  while (it != m_fixed_buffers.end() && it->first < end) {
+    auto ret = update_buffer(it->second.m_index, empty);
+    ut_a(ret == 0);
+
+    m_free_buffers.push_back(it->second.m_index);
+
+    it = m_fixed_buffers.erase(it);
+  }
+}
+
+void Impl::register_file(fil_node_t *fil_node) noexcept {
+  ut_a(fil_node->m_fixed_fh == -1);
+
+  std::lock_guard<std::shared_mutex> lock(m_fixed_latch);
+
+  if (!m_use_fixed_files || m_free_files.empty()) {
+    /* Use the file descriptor, the table is full with the files that are open. */
+    return;
+  }
+
+  const auto index = m_free_files.back();
+
+  if (auto ret = update_file(index, fil_node->m_fh); ret < 0) {
+    log_warn(std::format("Cannot register {} as an io_uring fixed file, error: {}. Not using fixed files", fil_node->m_file_name, -ret));
+    m_use_fixed_files = false;
+    return;
+  }
+
+  m_free_files.pop_back();
+
+  fil_node->m_fixed_fh = index;
+}
+
+void Impl::unregister_file(fil_node_t *fil_node) noexcept {
+  if (fil_node->m_fixed_fh == -1) {
+    return;
+  }
+
+  std::lock_guard<std::shared_mutex> lock(m_fixed_latch);
+
+  auto ret = update_file(fil_node->m_fixed_fh, -1);
+  ut_a(ret == 0);
+
+  m_free_files.push_back(fil_node->m_fixed_fh);
+
+  fil_node->m_fixed_fh = -1;
 }
 
 std::string Impl::to_string() noexcept {
@@ -791,16 +1707,97 @@ std::string Impl::to_string() noexcept {
     }
   }
 
-  os << "]";
+  os << "], fsyncs = { files: " << m_n_fsyncs.load(std::memory_order_relaxed)
+     << ", batches: " << m_n_fsync_batches.load(std::memory_order_relaxed) << " }";
 
   return os.str();
 }
 
+void Impl::fsync(Fsync_request *requests, ulint n_requests) noexcept {
+  if (!m_use_fsync_iouring) {
+    for (ulint i = 0; i < n_requests; ++i) {
+      auto &request = requests[i];
+
+      do {
+        request.m_ret = request.m_datasync ? ::fdatasync(request.m_fh) : ::fsync(request.m_fh);
+      } while (request.m_ret == -1 && errno == EINTR);
+
+      if (request.m_ret == -1) {
+        request.m_ret = -errno;
+      }
+    }
+
+    m_n_fsyncs.fetch_add(n_requests, std::memory_order_relaxed);
+
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_fsync_mutex);
+
+  for (ulint start = 0; start < n_requests; start += FSYNC_QUEUE_SIZE) {
+    const auto n = std::min(n_requests - start, FSYNC_QUEUE_SIZE);
+
+    for (ulint i = start; i < start + n; ++i) {
+      auto sqe = io_uring_get_sqe(&m_fsync_iouring);
+      ut_a(sqe != nullptr);
+
+      io_uring_prep_fsync(sqe, requests[i].m_fh, requests[i].m_datasync ? IORING_FSYNC_DATASYNC : 0);
+      io_uring_sqe_set_data64(sqe, i);
+    }
+
+    int ret;
+
+    do {
+      ret = io_uring_submit_and_wait(&m_fsync_iouring, unsigned(n));
+    } while (ret == -EINTR);
+
+    ut_a(ret == int(n));
+
+    for (ulint i = 0; i < n; ++i) {
+      io_uring_cqe *cqe{};
+
+      do {
+        ret = io_uring_wait_cqe(&m_fsync_iouring, &cqe);
+      } while (ret == -EINTR);
+
+      ut_a(ret == 0);
+
+      requests[io_uring_cqe_get_data64(cqe)].m_ret = cqe->res;
+
+      io_uring_cqe_seen(&m_fsync_iouring, cqe);
+    }
+
+    m_n_fsync_batches.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  m_n_fsyncs.fetch_add(n_requests, std::memory_order_relaxed);
+}
+
 db_err Impl::reap(ulint handler_id, IO_ctx &io_ctx) noexcept {
   return get_queue(handler_id)->reap(io_ctx);
 }
 
+void Impl::io_latency(IO_request io_request, ut::Latency_histogram::Snapshot &snapshot) noexcept {
+  /* Only the handler of the request type has samples of the type. */
+  for (auto handler : m_handlers) {
+    handler->m_latency[ulint(io_request)].add_to(snapshot);
+  }
+}
+
+uint64_t Impl::n_throttled(IO_priority priority) noexcept {
+  uint64_t n{};
+
+  for (auto handler : m_handlers) {
+    n += handler->m_n_throttled[priority_index(priority)].load(std::memory_order_relaxed);
+  }
+
+  return n;
+}
+
 void Impl::wait_for_pending_ops(ulint handler_id) noexcept {
+  /* The requests that we have not submitted yet would never complete. */
+  submit_batch();
+
   m_handlers[handler_id]->m_is_empty->wait(0);
 }
 
@@ -822,11 +1819,11 @@ void IO_ctx::validate() const noexcept {
   ut_a(m_fil_node->m_file_name != nullptr);
 }
 
-AIO* AIO::create(ulint max_slots, ulint read_queues, ulint write_queues) noexcept {
+AIO* AIO::create(ulint max_slots, ulint read_queues, ulint write_queues, ulint sqpoll_idle_ms) noexcept {
   ut_a(read_queues > 0);
   ut_a(write_queues > 0);
 
-  return new (ut_new(sizeof(aio::Impl))) aio::Impl(max_slots, read_queues, write_queues);
+  return new (ut_new(sizeof(aio::Impl))) aio::Impl(max_slots, read_queues, write_queues, sqpoll_idle_ms);
 }
 
 void AIO::destroy(AIO *&aio) noexcept {
@@ -597,16 +597,83 @@ bool os_file_set_size(const char *name, os_file_t file, off_t desired_size) {
   return os_file_flush(file);
 }
 
+bool os_file_extend(const char *name, os_file_t file, off_t off, off_t len) {
+  ut_a(off >= 0 && len > 0);
+
+  /* Allocate the blocks without writing them, the new range reads back as zeros. */
+  if (fallocate(file, 0, off, len) == 0) {
+    return true;
+  }
+
+  if (errno != EOPNOTSUPP && errno != ENOSYS) {
+    log_err(std::format(
+      "fallocate() of {} bytes at offset {} of file {} failed. Operating system error number {} - '{}'."
+      " Check that the disk is not full or a disk quota exceeded.",
+      len,
+      off,
+      name,
+      errno,
+      strerror(errno)
+    ));
+
+    return false;
+  }
+
+  /* The file system can't preallocate, write zeros up to 1 MB at a time. */
+  const auto buf_size = std::min<off_t>(len, 1024 * 1024);
+  auto ptr = static_cast<byte *>(ut_new(ulint(buf_size) + UNIV_PAGE_SIZE));
+  auto buf = static_cast<byte *>(ut_align(ptr, UNIV_PAGE_SIZE));
+
+  memset(buf, 0, ulint(buf_size));
+
+  for (const auto end = off + len; off < end;) {
+    const auto n_bytes = std::min<off_t>(end - off, buf_size);
+
+    if (!os_file_write(name, file, buf, ulint(n_bytes), off)) {
+      ut_delete(ptr);
+      return false;
+    }
+
+    off += n_bytes;
+  }
+
+  ut_delete(ptr);
+
+  return true;
+}
+
+bool os_file_punch_hole(const char *name, os_file_t file, off_t off, off_t len) {
+  ut_a(off >= 0 && len > 0);
+
+  if (fallocate(file, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, off, len) == 0) {
+    return true;
+  }
+
+  if (errno != EOPNOTSUPP && errno != ENOSYS) {
+    log_warn(std::format(
+      "Punching a hole of {} bytes at offset {} of file {} failed. Operating system error number {} - '{}'.",
+      len,
+      off,
+      name,
+      errno,
+      strerror(errno)
+    ));
+  }
+
+  return false;
+}
+
 /** Sync file contenst to the device.
 @param[in] file                 File to sync.
+@param[in] data_only            Use fdatasync() instead of fsync().
 @return -1 on failure. */
-static int os_file_fsync(os_file_t file) {
+static int os_file_fsync(os_file_t file, bool data_only) {
   int ret;
   bool retry{};
   int failures = 0;
 
   do {
-    ret = fsync(file);
+    ret = data_only ? fdatasync(file) : fsync(file);
 
     ++os_n_fsyncs;
 
@@ -630,8 +697,8 @@ static int os_file_fsync(os_file_t file) {
   return ret;
 }
 
-bool os_file_flush(os_file_t file) {
-  int ret = os_file_fsync(file);
+bool os_file_flush(os_file_t file, bool data_only) {
+  int ret = os_file_fsync(file, data_only);
 
   if (ret == 0) {
     return true;
@@ -654,6 +721,38 @@ bool os_file_flush(os_file_t file) {
   return false;
 }
 
+bool os_file_syncfs(const os_file_t *files, ulint n_files) {
+  std::vector<dev_t> devices;
+
+  for (ulint i = 0; i < n_files; ++i) {
+    struct stat statinfo;
+
+    if (fstat(files[i], &statinfo) == -1) {
+      os_file_handle_error(nullptr, "fstat");
+      return false;
+    }
+
+    if (std::find(devices.begin(), devices.end(), statinfo.st_dev) != devices.end()) {
+      continue;
+    }
+
+    devices.push_back(statinfo.st_dev);
+
+    ++os_n_fsyncs;
+
+    if (syncfs(files[i]) == -1) {
+      os_file_handle_error(nullptr, "syncfs");
+
+      /* Same as for a failed fsync(), the database could get corrupt on disk */
+      log_fatal("The OS said file system flush did not succeed");
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
 /**
  * Does a synchronous read operation in Posix.
  *
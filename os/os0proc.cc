@@ -23,9 +23,10 @@ process control primitives
 Created 9/30/1995 Heikki Tuuri
 *******************************************************/
 
-#include "innodb0types.h"
+#include "os0proc.h"
 
 #include <errno.h>
+#include <stdio.h>
 #include <sys/mman.h>
 #include <sys/types.h>
 
@@ -54,69 +55,143 @@ ulint os_proc_get_number() {
   return (ulint)getpid();
 }
 
+/**
+ * Reads the default huge page size of the system from /proc/meminfo.
+ *
+ * @return the huge page size in bytes, or 0 if it is not known.
+ */
+static ulint os_get_default_large_page_size() {
+  auto file = fopen("/proc/meminfo", "r");
+
+  if (file == nullptr) {
+    return 0;
+  }
+
+  char line[256];
+  ulint size_kb{};
+
+  while (fgets(line, sizeof(line), file) != nullptr) {
+    if (sscanf(line, "Hugepagesize: %lu kB", &size_kb) == 1) {
+      break;
+    }
+  }
+
+  fclose(file);
+
+  return size_kb * 1024;
+}
+
+void os_large_pages_init(bool use_large_pages, ulint large_page_size) {
+  os_use_large_pages = use_large_pages;
+
+  if (!os_use_large_pages) {
+    os_large_page_size = 0;
+    return;
+  }
+
+  if (large_page_size == 0) {
+    large_page_size = os_get_default_large_page_size();
+  }
+
+  if (large_page_size < UNIV_PAGE_SIZE || !ut_is_2pow(large_page_size)) {
+    log_warn(std::format("Large pages: invalid or unknown large page size {}, using 2 MB", large_page_size));
+
+    large_page_size = 2 * 1024 * 1024;
+  }
+
+  os_large_page_size = large_page_size;
+
+  log_info(std::format("Large pages: using a large page size of {} KB", os_large_page_size / 1024));
+}
+
+/**
+ * Maps anonymous memory backed by huge pages from the HugeTLB pool.
+ *
+ * @param[in] size              Number of bytes, a multiple of os_large_page_size.
+ *
+ * @return the memory, or nullptr if the pool has not enough free huge pages.
+ */
+static void *os_mem_map_hugetlb(ulint size) {
+  int flags = MAP_PRIVATE | OS_MAP_ANON | MAP_HUGETLB;
+
+#ifdef MAP_HUGE_SHIFT
+  /* Ask for the configured size, the kernel uses the default huge page size otherwise. */
+  flags |= int(ut_2_log(os_large_page_size)) << MAP_HUGE_SHIFT;
+#endif /* MAP_HUGE_SHIFT */
+
+  auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+/**
+ * Maps anonymous memory that is aligned to os_large_page_size and asks the
+ * kernel to back it with transparent huge pages.
+ *
+ * @param[in] size              Number of bytes, a multiple of os_large_page_size.
+ *
+ * @return the memory, or nullptr if the mapping failed.
+ */
+static void *os_mem_map_thp(ulint size) {
+  const auto align = os_large_page_size;
+
+  /* Map an extra large page and trim the unaligned start and the rest at the end. */
+  auto ptr = static_cast<byte *>(mmap(nullptr, size + align, PROT_READ | PROT_WRITE, MAP_PRIVATE | OS_MAP_ANON, -1, 0));
+
+  if (ptr == MAP_FAILED) {
+    return nullptr;
+  }
+
+  auto aligned = static_cast<byte *>(ut_align(ptr, align));
+  const auto head = ulint(aligned - ptr);
+
+  if (head > 0) {
+    munmap(ptr, head);
+  }
+
+  if (align - head > 0) {
+    munmap(aligned + size, align - head);
+  }
+
+  if (madvise(aligned, size, MADV_HUGEPAGE) != 0) {
+    log_warn(std::format("Large pages: madvise(MADV_HUGEPAGE) failed; errno {}: {}", errno, strerror(errno)));
+  }
+
+  return aligned;
+}
+
 void *os_mem_alloc_large(ulint *n) {
   void *ptr;
   ulint size;
 
-#if defined HAVE_LARGE_PAGES && defined UNIV_LINUX
-  int shmid;
-  struct shmid_ds buf;
+  if (os_use_large_pages && os_large_page_size > 0) {
+    /* Align block size to os_large_page_size */
+    ut_ad(ut_is_2pow(os_large_page_size));
+    size = ut_2pow_round(*n + (os_large_page_size - 1), os_large_page_size);
 
-  if (!os_use_large_pages || !os_large_page_size) {
-    goto skip;
-  }
+    ptr = os_mem_map_hugetlb(size);
 
-  /* Align block size to os_large_page_size */
-  ut_ad(ut_is_2pow(os_large_page_size));
-  size = ut_2pow_round(*n + (os_large_page_size - 1), os_large_page_size);
-
-  shmid = shmget(IPC_PRIVATE, (size_t)size, SHM_HUGETLB | SHM_R | SHM_W);
-  if (shmid < 0) {
-    ib_logger(
-      ib_stream,
-      "HugeTLB: Warning: Failed to allocate"
-      " %lu bytes. errno %d\n",
-      size,
-      errno
-    );
-    ptr = NULL;
-  } else {);
-
-  ut_a(block->m_magic_n == UT_MEM_MAGIC_N);
-  ut_a(ut_total_allocated_memory >= block->m_size);
-    ptr = shmat(shmid, NULL, 0);
-    if (ptr == (void *)-1) {
-      ib_logger(
-        ib_stream,
-        "HugeTLB: Warning: Failed to"
-        " attach shared memory segment, errno %d\n",
-        errno
-      );
-      ptr = NULL;
+    if (ptr == nullptr) {
+      log_warn(std::format(
+        "Large pages: failed to map {} bytes of HugeTLB memory; errno {}: {}. Trying transparent huge pages",
+        size,
+        errno,
+        strerror(errno)
+      ));
+
+      ptr = os_mem_map_thp(size);
     }
 
-    /* Remove the shared memory segment so that it will be
-    automatically freed after memory is detached or
-    process exits */
-    shmctl(shmid, IPC_RMID, &buf);
-  }
+    if (ptr != nullptr) {
+      *n = size;
+      ut_allocated_memory(size);
+      UNIV_MEM_ALLOC(ptr, size);
+      return ptr;
+    }
 
-  if (ptr) {
-    *n = size;
-    os_fast_mutex_lock(&ut_list_mutex);
-    ut_total_allocated_memory += size;
-    os_fast_mutex_unlock(&ut_list_mutex);
-#ifdef UNIV_SET_MEM_TO_ZERO
-    memset(ptr, '\0', size);
-#endif
-    UNIV_MEM_ALLOC(ptr, size);
-    return (ptr);
+    log_warn("Large pages: using conventional memory");
   }
 
-  ib_logger(ib_stream, "InnoDB HugeTLB: Warning: Using conventional memory pool\n");
-skip:
-#endif /* HAVE_LARGE_PAGES && UNIV_LINUX */
-
 #ifdef HAVE_GETPAGESIZE
   size = getpagesize();
 #else
@@ -140,16 +215,8 @@ skip:
 void os_mem_free_large(void *ptr, ulint size) {
   ut_a(ut_total_allocated_memory() >= size);
 
-#if defined HAVE_LARGE_PAGES && defined UNIV_LINUX
-  if (os_use_large_pages && os_large_page_size && !shmdt(ptr)) {
-    os_fast_mutex_lock(&ut_list_mutex);
-    ut_a(ut_total_allocated_memory >= size);
-    ut_total_allocated_memory -= size;
-    os_fast_mutex_unlock(&ut_list_mutex);
-    UNIV_MEM_FREE(ptr, size);
-    return;
-  }
-#endif /* HAVE_LARGE_PAGES && UNIV_LINUX */
+  /* HugeTLB, transparent huge page and conventional mappings are all
+  released with munmap(), size is a multiple of the page size used. */
   if (munmap(ptr, size) != 0) {
     log_err(std::format("munmap({}, {}) failed; errno {}: {}", ptr, size, errno, strerror(errno)));
   } else {
@@ -157,3 +224,26 @@ void os_mem_free_large(void *ptr, ulint size) {
     UNIV_MEM_FREE(ptr, size);
   }
 }
+
+void os_mem_exclude_from_core(void *ptr, ulint size) {
+#ifdef MADV_DONTDUMP
+  if (madvise(ptr, size, MADV_DONTDUMP) != 0) {
+    log_warn(std::format("madvise(MADV_DONTDUMP) failed; errno {}: {}", errno, strerror(errno)));
+  }
+#endif /* MADV_DONTDUMP */
+}
+
+void os_mem_release(void *ptr, ulint size) {
+  auto start = static_cast<byte *>(ptr);
+  auto end = start + size;
+
+  if (os_use_large_pages) {
+    /* A huge page can only be released as a whole. */
+    start = static_cast<byte *>(ut_align(start, os_large_page_size));
+    end = static_cast<byte *>(ut_align_down(end, os_large_page_size));
+  }
+
+  if (start < end && madvise(start, end - start, MADV_DONTNEED) != 0) {
+    log_warn(std::format("madvise(MADV_DONTNEED) failed; errno {}: {}", errno, strerror(errno)));
+  }
+}
@@ -212,7 +212,7 @@ db_err Row_insert::sec_index_entry_by_modify(ulint mode, Btree_cursor *btr_cur,
 
     auto buf_pool = m_dict->m_store.m_fsp->m_buf_pool;
 
-    if (unlikely(buf_pool->m_LRU->buf_pool_running_out())) {
+    if (unlikely(buf_pool->running_out())) {
       err = DB_LOCK_TABLE_FULL;
     } else {
       big_rec_t *dummy_big_rec;
@@ -266,7 +266,7 @@ db_err Row_insert::clust_index_entry_by_modify(ulint mode, Btree_cursor *btr_cur
 
     auto buf_pool = m_dict->m_store.m_fsp->m_buf_pool;
 
-    if (unlikely(buf_pool->m_LRU->buf_pool_running_out())) {
+    if (unlikely(buf_pool->running_out())) {
 
       return DB_LOCK_TABLE_FULL;
 
@@ -1573,7 +1573,7 @@ db_err Row_insert::index_entry_low(ulint mode, const Index *index, DTuple *entry
 
       auto buf_pool = m_dict->m_store.m_fsp->m_buf_pool;
 
-      if (unlikely(buf_pool->m_LRU->buf_pool_running_out())) {
+      if (unlikely(buf_pool->running_out())) {
 
         err = DB_LOCK_TABLE_FULL;
 
@@ -593,7 +593,7 @@ inline db_err Row_sel::set_rec_lock(const Buf_block *block, const rec_t *rec, In
   auto trx = thr_get_trx(thr);
   auto buf_pool = m_dict->m_store.m_btree->m_buf_pool;
 
-  if (trx->m_trx_locks.size() > 10000 && buf_pool->m_LRU->buf_pool_running_out()) {
+  if (trx->m_trx_locks.size() > 10000 && buf_pool->running_out()) {
     return DB_LOCK_TABLE_FULL;
   } else  if (index->is_clustered()) {
     return m_lock_sys->clust_rec_read_check_and_lock(0, block, rec, index, offsets, mode, type, thr);
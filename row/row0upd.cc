@@ -1048,7 +1048,7 @@ db_err Row_update::clust_rec(upd_node_t *upd_node, const Index *index, que_thr_t
     return DB_SUCCESS;
   }
 
-  if (m_dict->m_store.m_fsp->m_buf_pool->m_LRU->buf_pool_running_out()) {
+  if (m_dict->m_store.m_fsp->m_buf_pool->running_out()) {
 
     return DB_LOCK_TABLE_FULL;
   }
@@ -44,6 +44,7 @@ Created 10/8/1995 Heikki Tuuri
 #include "api0ucode.h"
 #include "btr0cur.h"
 
+#include "buf0cleaner.h"
 #include "buf0flu.h"
 #include "buf0lru.h"
 #include "ddl0ddl.h"
@@ -1408,23 +1409,38 @@ void InnoDB::export_innodb_status() noexcept {
   export_vars.innodb_data_reads = os_n_file_reads;
   export_vars.innodb_data_writes = os_n_file_writes;
   export_vars.innodb_data_written = srv_data_written;
-  export_vars.innodb_buffer_pool_read_requests = srv_buf_pool->m_stat.n_page_gets;
-  export_vars.innodb_buffer_pool_write_requests = srv_buf_pool->m_write_requests;
+  export_vars.innodb_data_foreground_extends = srv_fil->get_foreground_extends();
+  export_vars.innodb_data_preallocations = srv_fil->get_preallocations();
+  export_vars.innodb_data_punched_holes = srv_fil->get_punched_holes();
+
+  export_vars.innodb_data_throttled_reqs = 0;
+
+  for (ulint i = 1; i <= aio::N_PRIORITIES; ++i) {
+    export_vars.innodb_data_throttled_reqs += srv_aio->n_throttled(IO_priority(i));
+  }
+
+  const auto buf_pool_stat = srv_buf_pool->get_stat();
+  const auto buf_pool_n_pages = srv_buf_pool->get_curr_n_pages();
+  const auto buf_pool_LRU_len = srv_buf_pool->get_LRU_len();
+  const auto buf_pool_free_len = srv_buf_pool->get_free_len();
+
+  export_vars.innodb_buffer_pool_read_requests = buf_pool_stat.n_page_gets;
+  export_vars.innodb_buffer_pool_write_requests = srv_buf_pool->get_write_requests();
   export_vars.innodb_buffer_pool_wait_free = srv_buf_pool_wait_free;
   export_vars.innodb_buffer_pool_pages_flushed = srv_buf_pool_flushed;
   export_vars.innodb_buffer_pool_reads = srv_buf_pool_reads;
-  export_vars.innodb_buffer_pool_read_ahead = srv_buf_pool->m_stat.n_ra_pages_read;
-  export_vars.innodb_buffer_pool_read_ahead_evicted = srv_buf_pool->m_stat.n_ra_pages_evicted;
-  export_vars.innodb_buffer_pool_pages_data = UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list);
-  export_vars.innodb_buffer_pool_pages_dirty = UT_LIST_GET_LEN(srv_buf_pool->m_flush_list);
-  export_vars.innodb_buffer_pool_pages_free = UT_LIST_GET_LEN(srv_buf_pool->m_free_list);
+  export_vars.innodb_buffer_pool_read_ahead = buf_pool_stat.n_ra_pages_read;
+  export_vars.innodb_buffer_pool_read_ahead_evicted = buf_pool_stat.n_ra_pages_evicted;
+  export_vars.innodb_buffer_pool_read_ahead_used = buf_pool_stat.n_ra_pages_used;
+  export_vars.innodb_buffer_pool_pages_data = buf_pool_LRU_len;
+  export_vars.innodb_buffer_pool_pages_dirty = srv_buf_pool->get_flush_list_len();
+  export_vars.innodb_buffer_pool_pages_free = buf_pool_free_len;
 
   ut_d(export_vars.innodb_buffer_pool_pages_latched = srv_buf_pool->get_latched_pages_number());
 
-  export_vars.innodb_buffer_pool_pages_total = srv_buf_pool->m_curr_size;
+  export_vars.innodb_buffer_pool_pages_total = buf_pool_n_pages;
 
-  export_vars.innodb_buffer_pool_pages_misc =
-    srv_buf_pool->m_curr_size - UT_LIST_GET_LEN(srv_buf_pool->m_LRU_list) - UT_LIST_GET_LEN(srv_buf_pool->m_free_list);
+  export_vars.innodb_buffer_pool_pages_misc = buf_pool_n_pages - buf_pool_LRU_len - buf_pool_free_len;
 
   export_vars.innodb_have_atomic_builtins = 1;
   export_vars.innodb_page_size = UNIV_PAGE_SIZE;
@@ -1437,9 +1453,9 @@ void InnoDB::export_innodb_status() noexcept {
   export_vars.innodb_log_writes = srv_log_writes;
   export_vars.innodb_dblwr_pages_written = srv_dblwr_pages_written;
   export_vars.innodb_dblwr_writes = srv_dblwr_writes;
-  export_vars.innodb_pages_created = srv_buf_pool->m_stat.n_pages_created;
-  export_vars.innodb_pages_read = srv_buf_pool->m_stat.n_pages_read;
-  export_vars.innodb_pages_written = srv_buf_pool->m_stat.n_pages_written;
+  export_vars.innodb_pages_created = buf_pool_stat.n_pages_created;
+  export_vars.innodb_pages_read = buf_pool_stat.n_pages_read;
+  export_vars.innodb_pages_written = buf_pool_stat.n_pages_written;
   export_vars.innodb_row_lock_waits = srv_n_lock_wait_count;
   export_vars.innodb_row_lock_current_waits = srv_n_lock_wait_current_count;
   export_vars.innodb_row_lock_time = srv_n_lock_wait_time / 1000;
@@ -1681,11 +1697,9 @@ loop:
     srv_refresh_innodb_monitor_stats();
   }
 
-  /* Update the statistics collected for deciding LRU eviction policy. */
-  srv_buf_pool->m_LRU->stat_update();
-
-  /* Update the statistics collected for flush rate policy. */
-  srv_buf_pool->m_flusher->stat_update();
+  /* Update the statistics collected for deciding LRU eviction policy
+  and for flush rate policy. */
+  srv_buf_pool->stat_update();
 
   /* In case mutex_exit is not a memory barrier, it is
   theoretically possible some threads are left waiting though
@@ -1767,6 +1781,14 @@ static void srv_sync_log_buffer_in_background() {
   }
 }
 
+/**
+ * @return true if the dirty pages are flushed by the page cleaner threads
+ * and not by the master thread.
+ */
+static bool srv_page_cleaner_is_active() {
+  return srv_page_cleaner != nullptr && srv_page_cleaner->is_active();
+}
+
 void *InnoDB::master_thread(void *) noexcept {
   Cond_var *event;
   ulint old_activity_count;
@@ -1798,7 +1820,7 @@ loop:
 
   srv_main_thread_op_info = "reserving kernel mutex";
 
-  n_ios_very_old = log_sys->m_n_log_ios + srv_buf_pool->m_stat.n_pages_read + srv_buf_pool->m_stat.n_pages_written;
+  n_ios_very_old = log_sys->m_n_log_ios + srv_buf_pool->get_n_page_ios();
   mutex_enter(&kernel_mutex);
 
   /* Store the user activity counter at the start of this loop */
@@ -1856,15 +1878,19 @@ loop:
 
     n_pend_ios = srv_buf_pool->get_n_pending_ios() + log_sys->m_n_pending_writes;
 
-    n_ios = log_sys->m_n_log_ios + srv_buf_pool->m_stat.n_pages_read + srv_buf_pool->m_stat.n_pages_written;
+    n_ios = log_sys->m_n_log_ios + srv_buf_pool->get_n_page_ios();
+
+    if (srv_page_cleaner_is_active()) {
+
+      /* The page cleaner flushes the dirty pages in the background */
 
-    if (unlikely(srv_buf_pool->get_modified_ratio_pct() > srv_config.m_max_buf_pool_modified_pct)) {
+    } else if (unlikely(srv_buf_pool->get_modified_ratio_pct() > srv_config.m_max_buf_pool_modified_pct)) {
 
       /* Try to keep the number of modified pages in the
       buffer pool under the limit wished by the user */
 
       srv_main_thread_op_info = "flushing buffer pool pages";
-      n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_UINT64_T_MAX);
+      n_pages_flushed = srv_buf_pool->flush_list(srv_dblwr, PCT_IO(100), IB_UINT64_T_MAX);
 
       /* If we had to do the flush, it may have taken
       even more than 1 second, and also, there may be more
@@ -1878,12 +1904,12 @@ loop:
       /* Try to keep the rate of flushing of dirty
       pages such that redo log generation does not
       produce bursts of IO at checkpoint time. */
-      ulint n_flush = srv_buf_pool->m_flusher->get_desired_flush_rate();
+      ulint n_flush = srv_buf_pool->get_desired_flush_rate();
 
       if (n_flush) {
         srv_main_thread_op_info = "flushing buffer pool pages";
         n_flush = std::min<ulint>(PCT_IO(100), n_flush);
-        n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, n_flush, IB_ULONGLONG_MAX);
+        n_pages_flushed = srv_buf_pool->flush_list(srv_dblwr, n_flush, IB_ULONGLONG_MAX);
 
         if (n_flush == PCT_IO(100)) {
           skip_sleep = true;
@@ -1910,14 +1936,14 @@ loop:
   are not required, and may be disabled. */
 
   n_pend_ios = srv_buf_pool->get_n_pending_ios() + log_sys->m_n_pending_writes;
-  n_ios = log_sys->m_n_log_ios + srv_buf_pool->m_stat.n_pages_read + srv_buf_pool->m_stat.n_pages_written;
+  n_ios = log_sys->m_n_log_ios + srv_buf_pool->get_n_page_ios();
 
   ++srv_main_10_second_loops;
 
-  if (n_pend_ios < SRV_PEND_IO_THRESHOLD && (n_ios - n_ios_very_old < SRV_PAST_IO_ACTIVITY)) {
+  if (!srv_page_cleaner_is_active() && n_pend_ios < SRV_PEND_IO_THRESHOLD && (n_ios - n_ios_very_old < SRV_PAST_IO_ACTIVITY)) {
 
     srv_main_thread_op_info = "flushing buffer pool pages";
-    srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_ULONGLONG_MAX);
+    srv_buf_pool->flush_list(srv_dblwr, PCT_IO(100), IB_ULONGLONG_MAX);
 
     /* Flush logs if needed */
     srv_sync_log_buffer_in_background();
@@ -1947,19 +1973,24 @@ loop:
 
   /* Flush a few oldest pages to make a new checkpoint younger */
 
-  if (srv_buf_pool->get_modified_ratio_pct() > srv_config.m_max_buf_pool_modified_pct) {
+  if (srv_page_cleaner_is_active()) {
+
+    /* The page cleaner flushes the dirty pages in the background */
+    n_pages_flushed = 0;
+
+  } else if (srv_buf_pool->get_modified_ratio_pct() > srv_config.m_max_buf_pool_modified_pct) {
 
     /* If there are lots of modified pages in the buffer pool
     (> 70 %), we assume we can afford reserving the disk(s) for
     the time it requires to flush 100 pages */
 
-    n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_UINT64_T_MAX);
+    n_pages_flushed = srv_buf_pool->flush_list(srv_dblwr, PCT_IO(100), IB_UINT64_T_MAX);
   } else {
     /* Otherwise, we only flush a small number of pages so that
     we do not unnecessarily use much disk i/o capacity from
     other work */
 
-    n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(10), IB_UINT64_T_MAX);
+    n_pages_flushed = srv_buf_pool->flush_list(srv_dblwr, PCT_IO(10), IB_UINT64_T_MAX);
   }
 
   srv_main_thread_op_info = "making checkpoint";
@@ -2052,8 +2083,13 @@ background_loop:
 flush_loop:
   srv_main_thread_op_info = "flushing buffer pool pages";
   srv_main_flush_loops++;
-  if (srv_config.m_fast_shutdown != IB_SHUTDOWN_NO_BUFPOOL_FLUSH) {
-    n_pages_flushed = srv_buf_pool->m_flusher->batch(srv_dblwr, BUF_FLUSH_LIST, PCT_IO(100), IB_UINT64_T_MAX);
+  if (srv_page_cleaner_is_active()) {
+    /* The page cleaner flushes the dirty pages in the background, it is
+    stopped at shutdown before the master thread does the final flush. */
+
+    n_pages_flushed = 0;
+  } else if (srv_config.m_fast_shutdown != IB_SHUTDOWN_NO_BUFPOOL_FLUSH) {
+    n_pages_flushed = srv_buf_pool->flush_list(srv_dblwr, PCT_IO(100), IB_UINT64_T_MAX);
   } else {
     /* In the fastest shutdown we do not flush the buffer pool
     to data files: we set n_pages_flushed to 0 artificially. */
@@ -2071,7 +2107,7 @@ flush_loop:
   mutex_exit(&kernel_mutex);
 
   srv_main_thread_op_info = "waiting for buffer pool flush to end";
-  srv_buf_pool->m_flusher->wait_batch_end(BUF_FLUSH_LIST);
+  srv_buf_pool->wait_batch_end(BUF_FLUSH_LIST);
 
   /* Flush logs if needed */
   srv_sync_log_buffer_in_background();
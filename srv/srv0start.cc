@@ -41,18 +41,24 @@ Created 2/16/1996 Heikki Tuuri
 #include "btr0cur.h"
 #include "btr0pcur.h"
 #include "buf0buf.h"
+#include "buf0cleaner.h"
 #include "buf0dblwr.h"
+#include "buf0dump.h"
+#include "buf0resize.h"
 #include "buf0flu.h"
+#include "buf0lru.h"
 #include "buf0rea.h"
 #include "data0data.h"
 #include "data0type.h"
 #include "dict0dict.h"
 #include "dict0load.h"
+#include "fil0extend.h"
 #include "fil0fil.h"
 #include "fsp0fsp.h"
 #include "lock0lock.h"
 #include "log0log.h"
 #include "log0recv.h"
+#include "log0writer.h"
 #include "mem0mem.h"
 #include "mtr0mtr.h"
 #include "os0file.h"
@@ -355,6 +361,15 @@ static void srv_startup_abort(db_err err) noexcept {
   we have contexts we can get rid of this global. */
   srv_config.m_fast_shutdown = IB_SHUTDOWN_NORMAL;
 
+  /* It must not extend the files while they are closed. */
+  if (srv_fil_extender != nullptr) {
+    srv_fil_extender->shutdown();
+  }
+
+  if (srv_log_writer != nullptr) {
+    srv_log_writer->shutdown();
+  }
+
   /* For fatal errors we want to avoid writing to the data files. */
   if (err != DB_FATAL) {
 
@@ -368,6 +383,18 @@ static void srv_startup_abort(db_err err) noexcept {
 
   srv_threads_shutdown();
 
+  if (srv_page_cleaner != nullptr) {
+    Page_cleaner::destroy(srv_page_cleaner);
+  }
+
+  if (srv_fil_extender != nullptr) {
+    Fil_extender::destroy(srv_fil_extender);
+  }
+
+  if (srv_log_writer != nullptr) {
+    Log_writer::destroy(srv_log_writer);
+  }
+
   log_sys->shutdown();
 
   srv_buf_pool->close();
@@ -469,7 +496,9 @@ ib_err_t InnoDB::start() noexcept {
 
   os_file_init();
 
-  srv_aio = AIO::create(io_limit, srv_config.m_n_read_io_threads, srv_config.m_n_write_io_threads);
+  const auto sqpoll_idle_ms = srv_config.m_io_uring_sqpoll ? srv_config.m_io_uring_sqpoll_idle : 0;
+
+  srv_aio = AIO::create(io_limit, srv_config.m_n_read_io_threads, srv_config.m_n_write_io_threads, sqpoll_idle_ms);
 
   if (srv_aio == nullptr) {
     log_err("Failed to create an AIO instance.");
@@ -491,9 +520,11 @@ ib_err_t InnoDB::start() noexcept {
     return DB_OUT_OF_MEMORY;
   }
 
-  srv_buf_pool = new (std::nothrow) Buf_pool();
+  os_large_pages_init(srv_config.m_use_large_pages, srv_config.m_large_page_size);
+
+  srv_buf_pool = new (std::nothrow) Buf_pool_manager();
 
-  if (!srv_buf_pool->open(srv_config.m_buf_pool_size)) {
+  if (!srv_buf_pool->open(srv_config.m_buf_pool_size, srv_config.m_buf_pool_instances)) {
     /* Shutdown all sub-systems that have been initialized. */
     delete srv_fil;
     srv_fil = nullptr;
@@ -507,6 +538,8 @@ ib_err_t InnoDB::start() noexcept {
     return DB_OUT_OF_MEMORY;
   }
 
+  log_info(std::format("Buffer pool LRU replacement policy: {}", srv_buf_pool->get_instance(ulint{0})->m_LRU->get_policy_name()));
+
   ut_a(log_sys == nullptr);
   log_sys = Log::create();
 
@@ -741,6 +774,10 @@ ib_err_t InnoDB::start() noexcept {
 
       err = srv_dblwr->initialize();
 
+      if (err == DB_SUCCESS) {
+        err = srv_dblwr->open(srv_buf_pool->get_n_instances(), srv_config.m_n_dblwr_files);
+      }
+
       if (err != DB_SUCCESS) {
         srv_startup_abort(err);
         return DB_ERROR;
@@ -780,6 +817,13 @@ ib_err_t InnoDB::start() noexcept {
       srv_dblwr->m_block2 = offsets.second;
     }
 
+    err = srv_dblwr->open(srv_buf_pool->get_n_instances(), srv_config.m_n_dblwr_files);
+
+    if (err != DB_SUCCESS) {
+      srv_startup_abort(err);
+      return DB_ERROR;
+    }
+
     log_warn("Reading tablespace information from the .ibd files...");
 
     /* Recursively scan to a depth of 2. InnoDB needs to do this because the DD
@@ -917,6 +961,52 @@ ib_err_t InnoDB::start() noexcept {
 
   os_thread_create(&InnoDB::master_thread, nullptr, thread_ids + (1 + SRV_MAX_N_IO_THREADS));
 
+  /* Create the page cleaner threads which flush the buffer pool in the background */
+  if (srv_config.m_page_cleaners > 0 && srv_config.m_force_recovery < IB_RECOVERY_NO_BACKGROUND) {
+    ut_a(srv_page_cleaner == nullptr);
+    srv_page_cleaner = Page_cleaner::create(srv_buf_pool, srv_dblwr, srv_config.m_page_cleaners);
+
+    if (srv_page_cleaner == nullptr) {
+      srv_startup_abort(DB_OUT_OF_MEMORY);
+      return DB_ERROR;
+    }
+
+    srv_page_cleaner->start();
+  }
+
+  /* Create the thread that preallocates space in the growing tablespaces and
+  returns the free extents to the file system */
+  if (srv_config.m_force_recovery < IB_RECOVERY_NO_BACKGROUND) {
+    ut_a(srv_fil_extender == nullptr);
+    srv_fil_extender = Fil_extender::create(srv_fil, srv_fsp);
+
+    if (srv_fil_extender == nullptr) {
+      srv_startup_abort(DB_OUT_OF_MEMORY);
+      return DB_ERROR;
+    }
+
+    srv_fil_extender->start();
+  }
+
+  /* Create the threads that write and flush the log for the transactions
+  that commit */
+  if (srv_config.m_log_writer_threads && srv_config.m_force_recovery < IB_RECOVERY_NO_BACKGROUND) {
+    ut_a(srv_log_writer == nullptr);
+    srv_log_writer = Log_writer::create(log_sys);
+
+    if (srv_log_writer == nullptr) {
+      srv_startup_abort(DB_OUT_OF_MEMORY);
+      return DB_ERROR;
+    }
+
+    srv_log_writer->start();
+  }
+
+  /* Warm up the buffer pool with the pages that were cached at the last shutdown */
+  if (srv_config.m_buf_pool_load_at_startup && srv_config.m_force_recovery < IB_RECOVERY_NO_BACKGROUND) {
+    buf_load_start(srv_buf_pool);
+  }
+
   {
     const auto size = srv_fsp->get_system_space_size();
     log_info(std::format("system.ibd file size in the header is {} pages", size));
@@ -1002,6 +1092,30 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
 
   srv_shutdown_state = SRV_SHUTDOWN_CLEANUP;
 
+  buf_resize_abort();
+
+  buf_load_abort();
+
+  /* Don't overwrite the last dump with the pages of an aborted startup. */
+  if (srv_was_started && srv_config.m_buf_pool_dump_at_shutdown) {
+    /* A failure is logged and must not stop the shutdown. */
+    (void) buf_dump(srv_buf_pool);
+  }
+
+  /* The master thread does the final flushing of the buffer pool. */
+  if (srv_page_cleaner != nullptr) {
+    srv_page_cleaner->shutdown();
+  }
+
+  if (srv_fil_extender != nullptr) {
+    srv_fil_extender->shutdown();
+  }
+
+  /* The final log writes and the checkpoints are done by this thread. */
+  if (srv_log_writer != nullptr) {
+    srv_log_writer->shutdown();
+  }
+
   lsn_t lsn;
 
   for (;;) {
@@ -1077,7 +1191,7 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
 
     log_sys->acquire();
 
-    lsn = log_sys->m_lsn;
+    lsn = log_sys->get_lsn();
 
     if (lsn != log_sys->m_last_checkpoint_lsn) {
 
@@ -1117,7 +1231,7 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
   srv_shutdown_state = SRV_SHUTDOWN_LAST_PHASE;
 
   /* Make some checks that the server really is quiet */
-  ut_a(lsn == log_sys->m_lsn);
+  ut_a(lsn == log_sys->get_lsn());
   ut_a(srv_buf_pool->all_freed());
   ut_a(srv_n_threads_active[SRV_MASTER] == 0);
 
@@ -1139,7 +1253,7 @@ static void srv_prepare_for_shutdown(ib_recovery_t recovery, ib_shutdown_t shutd
   /* Make some checks that the server really is quiet */
   ut_a(srv_n_threads_active[SRV_MASTER] == 0);
   ut_a(srv_buf_pool->all_freed());
-  ut_a(lsn == log_sys->m_lsn);
+  ut_a(lsn == log_sys->get_lsn());
 }
 
 db_err InnoDB::shutdown(ib_shutdown_t shutdown) noexcept {
@@ -1177,6 +1291,18 @@ db_err InnoDB::shutdown(ib_shutdown_t shutdown) noexcept {
 
   srv_threads_shutdown();
 
+  if (srv_page_cleaner != nullptr) {
+    Page_cleaner::destroy(srv_page_cleaner);
+  }
+
+  if (srv_fil_extender != nullptr) {
+    Fil_extender::destroy(srv_fil_extender);
+  }
+
+  if (srv_log_writer != nullptr) {
+    Log_writer::destroy(srv_log_writer);
+  }
+
   log_sys->shutdown();
 
   Row_insert::destroy(srv_row_ins);
@@ -864,6 +864,7 @@ void sync_thread_add_level(void *latch, ulint level) {
     case SYNC_FILE_FORMAT_TAG:
     case SYNC_DOUBLEWRITE:
     case SYNC_BUF_POOL:
+    case SYNC_BUF_PAGE_HASH:
     case SYNC_SEARCH_SYS:
     case SYNC_SEARCH_SYS_CONF:
     case SYNC_TRX_LOCK_HEAP:
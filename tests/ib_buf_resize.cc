@@ -0,0 +1,487 @@
+/***********************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Test of the online resizing of the buffer pool. It does the equivalent of:
+
+ CREATE TABLE T(c1 INT, c2 INT, c3 VARCHAR(n), PK(c1));
+ INSERT N rows into T;
+
+ and then, while reader threads look up random rows and writer threads
+ update them, grows and shrinks the buffer pool a number of times. Each
+ update increments c2 and rewrites c3 from c1 and c2. The readers and the
+ writers check that c3 matches c1 and c2 of every row they read, and the
+ writers that c2 is the value they committed last. At the end all the rows
+ are checked against the c2 values that the writers committed, before and
+ after a restart. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t_resize"
+
+/* Length of the c3 column. */
+static const uint32_t C3_LEN = 200;
+
+static const uint32_t N_ROWS = 60000;
+
+static const uint32_t N_READERS = 4;
+static const uint32_t N_WRITERS = 4;
+
+/* Chunk size, small so that a resize moves many chunks. */
+static const ulint CHUNK_SIZE = 1024 * 1024;
+
+/* The buffer pool sizes to resize to in turn, the table is about 14 MB. */
+static const ulint SIZES[] = {32 * 1024 * 1024, 6 * 1024 * 1024, 24 * 1024 * 1024, 8 * 1024 * 1024, 16 * 1024 * 1024};
+
+/* Seconds to wait for a resize to take effect. */
+static const int MAX_WAIT = 60;
+
+/** The committed value of c2 of each row, row i is updated only by writer
+i % N_WRITERS. */
+static std::unique_ptr<std::atomic<uint32_t>[]> versions;
+
+static std::atomic<bool> done{};
+
+/** Start InnoDB with a buffer pool that is smaller than the table. */
+static void startup(void) {
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  err = ib_cfg_set_int("buffer_pool_size", 8 * 1024 * 1024);
+  assert(err == DB_SUCCESS);
+
+  err = ib_cfg_set_int("buffer_pool_chunk_size", CHUNK_SIZE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+}
+
+/** Read a status variable. */
+static int64_t status_get(const char *name) {
+  int64_t val;
+
+  auto err = ib_status_get_i64(name, &val);
+  assert(err == DB_SUCCESS);
+
+  return val;
+}
+
+/** Fill c3 from c1 and c2. */
+static void make_c3(char *c3, uint32_t c1, uint32_t c2) {
+  for (uint32_t i = 0; i < C3_LEN; ++i) {
+    c3[i] = 'a' + (c1 + c2 + i) % 26;
+  }
+}
+
+/** Create an InnoDB database (sub-directory). */
+static ib_err_t create_database(const char *name) {
+  bool err;
+
+  err = ib_database_create(name);
+  assert(err == true);
+
+  return (DB_SUCCESS);
+}
+
+/** CREATE TABLE T (c1 INT, c2 INT, c3 VARCHAR(n), PRIMARY KEY(c1)); */
+static ib_err_t create_table(const char *dbname, /*!< in: database name */
+                             const char *name)   /*!< in: table name */
+{
+  ib_trx_t ib_trx;
+  ib_id_t table_id = 0;
+  ib_err_t err = DB_SUCCESS;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  err = ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c3", IB_VARCHAR, IB_COL_NONE, 0, C3_LEN);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  return (err);
+}
+
+/** Open a table and return a cursor for the table. */
+static ib_crsr_t open_table(const char *dbname, const char *name, ib_trx_t ib_trx) {
+  ib_crsr_t crsr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  auto err = ib_cursor_open_table(table_name, ib_trx, &crsr);
+  assert(err == DB_SUCCESS);
+
+  return crsr;
+}
+
+/** INSERT INTO T VALUE(i, 0, c3(i, 0)); in batches of 10000 rows. */
+static void insert_rows(void) {
+  char c3[C3_LEN];
+
+  for (uint32_t i = 0; i < N_ROWS;) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+    auto err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    for (uint32_t end = i + 10000; i < end && i < N_ROWS; ++i) {
+      make_c3(c3, i, 0);
+
+      err = ib_tuple_write_u32(tpl, 0, i);
+      assert(err == DB_SUCCESS);
+
+      err = ib_tuple_write_u32(tpl, 1, 0);
+      assert(err == DB_SUCCESS);
+
+      err = ib_col_set_value(tpl, 2, c3, sizeof(c3));
+      assert(err == DB_SUCCESS);
+
+      err = ib_cursor_insert_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+    }
+
+    ib_tuple_delete(tpl);
+
+    err = ib_cursor_close(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+}
+
+/** Check that c3 of a row matches its c1 and c2.
+@return c2 of the row */
+static uint32_t check_row(ib_tpl_t tpl, uint32_t *c1) {
+  uint32_t c2;
+  char c3[C3_LEN];
+
+  auto err = ib_tuple_read_u32(tpl, 0, c1);
+  assert(err == DB_SUCCESS);
+
+  err = ib_tuple_read_u32(tpl, 1, &c2);
+  assert(err == DB_SUCCESS);
+
+  assert(ib_col_get_len(tpl, 2) == C3_LEN);
+
+  make_c3(c3, *c1, c2);
+
+  assert(memcmp(ib_col_get_value(tpl, 2), c3, C3_LEN) == 0);
+
+  return c2;
+}
+
+/** Position the cursor on row c1. */
+static void moveto(ib_crsr_t crsr, ib_tpl_t key_tpl, uint32_t c1) {
+  int res = ~0;
+
+  auto err = ib_tuple_write_u32(key_tpl, 0, c1);
+  assert(err == DB_SUCCESS);
+
+  err = ib_cursor_moveto(crsr, key_tpl, IB_CUR_GE, &res);
+  assert(err == DB_SUCCESS);
+  assert(res == 0);
+}
+
+/** SELECT * FROM T WHERE c1 = k; for random k until done. */
+static void reader(uint32_t seed) {
+  while (!done.load()) {
+    auto ib_trx = ib_trx_begin(IB_TRX_READ_COMMITTED);
+    auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+    auto key_tpl = ib_clust_search_tuple_create(crsr);
+    assert(key_tpl != nullptr);
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    for (int i = 0; i < 100; ++i) {
+      const uint32_t key = rand_r(&seed) % N_ROWS;
+      uint32_t c1;
+
+      moveto(crsr, key_tpl, key);
+
+      auto err = ib_cursor_read_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+
+      (void)check_row(tpl, &c1);
+
+      assert(c1 == key);
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+    }
+
+    ib_tuple_delete(tpl);
+    ib_tuple_delete(key_tpl);
+
+    auto err = ib_cursor_close(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+}
+
+/** UPDATE T SET c2 = c2 + 1, c3 = c3(c1, c2 + 1) WHERE c1 = k; for random
+keys of this writer until done. */
+static void writer(uint32_t id) {
+  uint32_t seed = id + 1000;
+  char c3[C3_LEN];
+
+  while (!done.load()) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+    auto err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    err = ib_cursor_set_lock_mode(crsr, IB_LOCK_X);
+    assert(err == DB_SUCCESS);
+
+    auto key_tpl = ib_clust_search_tuple_create(crsr);
+    assert(key_tpl != nullptr);
+
+    auto old_tpl = ib_clust_read_tuple_create(crsr);
+    assert(old_tpl != nullptr);
+
+    auto new_tpl = ib_clust_read_tuple_create(crsr);
+    assert(new_tpl != nullptr);
+
+    const uint32_t key = (rand_r(&seed) % (N_ROWS / N_WRITERS)) * N_WRITERS + id;
+    uint32_t c1;
+
+    moveto(crsr, key_tpl, key);
+
+    err = ib_cursor_read_row(crsr, old_tpl);
+    assert(err == DB_SUCCESS);
+
+    const auto c2 = check_row(old_tpl, &c1);
+
+    assert(c1 == key);
+    assert(c2 == versions[key].load());
+
+    err = ib_tuple_copy(new_tpl, old_tpl);
+    assert(err == DB_SUCCESS);
+
+    make_c3(c3, key, c2 + 1);
+
+    err = ib_tuple_write_u32(new_tpl, 1, c2 + 1);
+    assert(err == DB_SUCCESS);
+
+    err = ib_col_set_value(new_tpl, 2, c3, sizeof(c3));
+    assert(err == DB_SUCCESS);
+
+    err = ib_cursor_update_row(crsr, old_tpl, new_tpl);
+    assert(err == DB_SUCCESS);
+
+    ib_tuple_delete(new_tpl);
+    ib_tuple_delete(old_tpl);
+    ib_tuple_delete(key_tpl);
+
+    err = ib_cursor_close(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+
+    versions[key] = c2 + 1;
+  }
+}
+
+/** Resize the buffer pool and wait until its size changed. */
+static void resize(ulint size) {
+  const auto before = status_get("buffer_pool_current_size");
+
+  auto err = ib_cfg_set_int("buffer_pool_size", size);
+  assert(err == DB_SUCCESS);
+
+  const auto grow = (int64_t)(size / status_get("page_size")) > before;
+
+  for (int i = 0; i < MAX_WAIT * 10; ++i) {
+    const auto n_pages = status_get("buffer_pool_current_size");
+
+    if (grow ? n_pages > before : n_pages < before) {
+      printf("Resized the buffer pool from %ld to %ld pages\n", (long)before, (long)n_pages);
+      return;
+    }
+
+    usleep(100000);
+  }
+
+  fprintf(stderr, "Resizing the buffer pool to %lu bytes did not complete\n", (unsigned long)size);
+  exit(EXIT_FAILURE);
+}
+
+/** SELECT * FROM T; check that every row has the committed c2. */
+static void check_rows(void) {
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  uint32_t n_rows = 0;
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    uint32_t c1;
+
+    err = ib_cursor_read_row(crsr, tpl);
+    assert(err == DB_SUCCESS);
+
+    const auto c2 = check_row(tpl, &c1);
+
+    assert(c1 == n_rows);
+    assert(c2 == versions[c1].load());
+
+    ++n_rows;
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+  assert(n_rows == N_ROWS);
+
+  ib_tuple_delete(tpl);
+
+  err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  versions.reset(new std::atomic<uint32_t>[N_ROWS]);
+
+  for (uint32_t i = 0; i < N_ROWS; ++i) {
+    versions[i] = 0;
+  }
+
+  startup();
+
+  auto err = create_database(DATABASE);
+  assert(err == DB_SUCCESS);
+
+  /* Start from an empty table, a previous run may have left one behind. */
+  (void)drop_table(DATABASE, TABLE);
+
+  err = create_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  insert_rows();
+
+  std::vector<std::thread> threads;
+
+  for (uint32_t i = 0; i < N_READERS; ++i) {
+    threads.emplace_back(reader, i + 1);
+  }
+
+  for (uint32_t i = 0; i < N_WRITERS; ++i) {
+    threads.emplace_back(writer, i);
+  }
+
+  for (auto size : SIZES) {
+    resize(size);
+
+    /* Let the load run on the resized buffer pool for a while. */
+    sleep(1);
+  }
+
+  done = true;
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  check_rows();
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  startup();
+
+  check_rows();
+
+  err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  return (EXIT_SUCCESS);
+}
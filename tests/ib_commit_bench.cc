@@ -0,0 +1,395 @@
+/***********************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Benchmark of the commit throughput with and without the log writer and
+log flusher threads (the log_writer_threads configuration variable), and
+with ib_trx_commit_async(). Each client thread does the equivalent of:
+
+ INSERT INTO T VALUE(k, 'xxx...'); COMMIT;
+
+ in a loop, with flush_log_at_trx_commit=1, so that every commit has to
+ wait for its log to be written and flushed. In the async mode the client
+ starts its next transaction at once and waits for all the durability
+ callbacks at the end. The commits per second, the
+ log writes and the log flushes are reported for each number of client
+ threads.
+
+ Each mode is benchmarked in a child process, or only the one given with
+ --mode. The InnoDB options, e.g. --ib-log-file-size, apply to both. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <getopt.h> /* For getopt_long() */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t_commit"
+
+/* Length of the c2 column. */
+static const uint32_t C2_LEN = 64;
+
+static uint32_t n_commits = 2000;
+static uint32_t max_threads = 64;
+static const char *mode = nullptr;
+
+static const char *modes[] = {"user", "writer", "async"};
+
+/** @return the current time in nanoseconds. */
+static uint64_t now_nsecs(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/** Read a status variable. */
+static int64_t status_get(const char *name) {
+  int64_t val;
+
+  auto err = ib_status_get_i64(name, &val);
+  assert(err == DB_SUCCESS);
+
+  return val;
+}
+
+/** Create an InnoDB database (sub-directory). */
+static ib_err_t create_database(const char *name) {
+  bool err;
+
+  err = ib_database_create(name);
+  assert(err == true);
+
+  return (DB_SUCCESS);
+}
+
+/** CREATE TABLE T (c1 INT, c2 VARCHAR(n), PRIMARY KEY(c1)); */
+static ib_err_t create_table(const char *dbname, /*!< in: database name */
+                             const char *name)   /*!< in: table name */
+{
+  ib_trx_t ib_trx;
+  ib_id_t table_id = 0;
+  ib_err_t err = DB_SUCCESS;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  err = ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_VARCHAR, IB_COL_NONE, 0, C2_LEN);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  return (err);
+}
+
+/** Open a table and return a cursor for the table. */
+static ib_crsr_t open_table(const char *dbname, const char *name, ib_trx_t ib_trx) {
+  ib_crsr_t crsr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  auto err = ib_cursor_open_table(table_name, ib_trx, &crsr);
+  assert(err == DB_SUCCESS);
+
+  return crsr;
+}
+
+/** Durability callback of ib_trx_commit_async(), counts the durable commits. */
+static void commit_durable(void *arg) {
+  auto n_durable = static_cast<std::atomic<uint32_t> *>(arg);
+
+  n_durable->fetch_add(1, std::memory_order_relaxed);
+}
+
+/** INSERT INTO T VALUE(k, 'xxx...'); COMMIT; for n_commits keys starting
+from first_key. */
+static void insert_and_commit(uint32_t first_key) {
+  char c2[C2_LEN];
+  std::atomic<uint32_t> n_durable{};
+  const bool async = strcmp(mode, "async") == 0;
+
+  memset(c2, 'x', sizeof(c2));
+
+  for (uint32_t i = 0; i < n_commits; ++i) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+    auto err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    err = ib_tuple_write_u32(tpl, 0, first_key + i);
+    assert(err == DB_SUCCESS);
+
+    err = ib_col_set_value(tpl, 1, c2, sizeof(c2));
+    assert(err == DB_SUCCESS);
+
+    err = ib_cursor_insert_row(crsr, tpl);
+    assert(err == DB_SUCCESS);
+
+    ib_tuple_delete(tpl);
+
+    err = ib_cursor_close(crsr);
+    assert(err == DB_SUCCESS);
+
+    if (async) {
+      err = ib_trx_commit_async(ib_trx, commit_durable, &n_durable);
+    } else {
+      err = ib_trx_commit(ib_trx);
+    }
+    assert(err == DB_SUCCESS);
+  }
+
+  while (async && n_durable.load(std::memory_order_relaxed) < n_commits) {
+    std::this_thread::yield();
+  }
+}
+
+/** Run n_threads clients that commit concurrently and print the throughput.
+@return the next unused key. */
+static uint32_t run_clients(uint32_t n_threads, uint32_t first_key) {
+  std::vector<std::thread> threads;
+
+  auto n_writes = status_get("log_write_flush_count");
+  auto n_fsyncs = status_get("log_fsync_req_done");
+
+  auto start = now_nsecs();
+
+  for (uint32_t i = 0; i < n_threads; ++i) {
+    threads.emplace_back(insert_and_commit, first_key + i * n_commits);
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  auto secs = (now_nsecs() - start) / 1e9;
+  auto n_trx = (uint64_t)n_threads * n_commits;
+
+  printf("%-8s threads: %4u commits: %8lu commits/s: %10.1lf log writes: %8ld log fsyncs: %8ld\n", mode, n_threads,
+         (unsigned long)n_trx, n_trx / secs, (long)(status_get("log_write_flush_count") - n_writes),
+         (long)(status_get("log_fsync_req_done") - n_fsyncs));
+
+  return first_key + n_threads * n_commits;
+}
+
+/** Set the runtime global options. */
+static void set_options(int argc, char *argv[]) {
+  int opt;
+  int optind;
+  int size = 0;
+  struct option *longopts;
+  int count = 0;
+
+  /* Count the number of InnoDB system options. */
+  while (ib_longopts[count].name) {
+    ++count;
+  }
+
+  /* Add our options and a spot for the sentinel. */
+  size = sizeof(struct option) * (count + 4);
+  longopts = (struct option *)malloc(size);
+  memset(longopts, 0x0, size);
+  memcpy(longopts, ib_longopts, sizeof(struct option) * count);
+
+  longopts[count].name = "commits";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 1;
+  ++count;
+
+  longopts[count].name = "threads";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 2;
+  ++count;
+
+  longopts[count].name = "mode";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 3;
+
+  while ((opt = getopt_long(argc, argv, "", longopts, &optind)) != -1) {
+    switch (opt) {
+
+    case USER_OPT + 1:
+      n_commits = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 2:
+      max_threads = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 3:
+      mode = optarg;
+      break;
+
+    default:
+      /* If it's an InnoDB parameter, then we let the
+      auxillary function handle it. */
+      if (set_global_option(opt, optarg) != DB_SUCCESS) {
+        print_usage(argv[0]);
+        fprintf(stderr,
+                "[--commits n] [--threads max]\n"
+                "[--mode user|writer|async]\n");
+        exit(EXIT_FAILURE);
+      }
+
+    } /* switch */
+  }
+
+  free(longopts);
+
+  if (n_commits == 0) {
+    n_commits = 1;
+  }
+
+  if (max_threads == 0) {
+    max_threads = 1;
+  }
+}
+
+/** Benchmark the mode in this process. */
+static void run_mode(int argc, char *argv[]) {
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  err = ib_cfg_set_int("flush_log_at_trx_commit", 1);
+  assert(err == DB_SUCCESS);
+
+  /* The InnoDB options are parsed after test_configure() so that they
+  override its settings. */
+  optind = 1;
+  set_options(argc, argv);
+
+  if (strcmp(mode, "writer") == 0 || strcmp(mode, "async") == 0) {
+    err = ib_cfg_set_bool_on("log_writer_threads");
+    assert(err == DB_SUCCESS);
+  } else {
+    assert(strcmp(mode, "user") == 0);
+
+    err = ib_cfg_set_bool_off("log_writer_threads");
+    assert(err == DB_SUCCESS);
+  }
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+
+  err = create_database(DATABASE);
+  assert(err == DB_SUCCESS);
+
+  /* Start from an empty table, a previous run may have left one behind. */
+  (void)drop_table(DATABASE, TABLE);
+
+  err = create_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  uint32_t key = 0;
+
+  for (uint32_t n_threads = 1; n_threads <= max_threads; n_threads *= 2) {
+    key = run_clients(n_threads, key);
+  }
+
+  err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+}
+
+int main(int argc, char *argv[]) {
+  /* Look for --mode only, the InnoDB options are parsed after ib_init(). */
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+      mode = argv[i + 1];
+    } else if (strncmp(argv[i], "--mode=", 7) == 0) {
+      mode = argv[i] + 7;
+    }
+  }
+
+  if (mode != nullptr) {
+    run_mode(argc, argv);
+    return (EXIT_SUCCESS);
+  }
+
+  /* Run each mode in its own process, InnoDB can be started only once. */
+  for (auto name : modes) {
+    fflush(stdout);
+
+    auto pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+      mode = name;
+      run_mode(argc, argv);
+      exit(EXIT_SUCCESS);
+    }
+
+    int status;
+
+    auto ret = waitpid(pid, &status, 0);
+    assert(ret == pid);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+      fprintf(stderr, "Benchmark of mode %s failed\n", name);
+      return (EXIT_FAILURE);
+    }
+  }
+
+  return (EXIT_SUCCESS);
+}
@@ -0,0 +1,449 @@
+/***********************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Benchmark of the i/o priority classes. It does the equivalent of:
+
+ CREATE TABLE T(c1 INT, c2 VARCHAR(n), PK(c1));
+ INSERT N rows into T;
+
+ and then:
+
+ 1. SELECT * FROM T WHERE c1 = k; for random k, in --lookup-threads threads
+ 2. The same lookups while --scan-threads threads do SELECT COUNT(*) FROM T;
+    in a loop
+
+ The table is several times larger than the buffer pool, the lookups miss
+ the buffer pool and wait for synchronous reads. The scans flood the read
+ handler with read-ahead requests. The 99th percentile of the synchronous
+ read latency and the number of requests that waited because their class
+ was at its limit are reported for each phase. With the read-ahead limited
+ to a share of the slots the p99 of phase 2 should stay close to that of
+ phase 1. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <getopt.h> /* For getopt_long() */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t_io_priority"
+
+/* Length of the c2 column, makes about 70 rows fit in a page. */
+static const uint32_t C2_LEN = 200;
+
+static uint32_t n_rows = 100000;
+static uint32_t n_lookups = 10000;
+static uint32_t n_lookup_threads = 4;
+static uint32_t n_scan_threads = 4;
+
+/** Set when the lookups of a phase are done, the scans stop then. */
+static std::atomic<bool> lookups_done{};
+
+/** @return the current time in microseconds. */
+static uint64_t now_usecs(void) {
+  struct timeval tv;
+
+  gettimeofday(&tv, nullptr);
+
+  return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/** Read a status variable. */
+static int64_t status_get(const char *name) {
+  int64_t val;
+
+  auto err = ib_status_get_i64(name, &val);
+  assert(err == DB_SUCCESS);
+
+  return val;
+}
+
+/** Read the latency histogram of the synchronous reads. */
+static ib_io_latency_t sync_read_latency(void) {
+  ib_io_latency_t latency;
+
+  auto err = ib_io_latency_get_by_type("Sync_read", &latency, sizeof(latency));
+  assert(err == DB_SUCCESS);
+
+  return latency;
+}
+
+/** @return the upper bound in microseconds of the bucket of the given
+percentile of the requests that completed between two snapshots. */
+static uint64_t percentile_us(const ib_io_latency_t *before, const ib_io_latency_t *after, double pct) {
+  uint64_t n_ios = 0;
+
+  for (int i = 0; i < IB_IO_LATENCY_BUCKETS; ++i) {
+    n_ios += after->buckets[i] - before->buckets[i];
+  }
+
+  const auto target = (uint64_t)(n_ios * pct / 100.0);
+  uint64_t n = 0;
+
+  for (int i = 0; i < IB_IO_LATENCY_BUCKETS; ++i) {
+    n += after->buckets[i] - before->buckets[i];
+
+    if (n > target) {
+      return (uint64_t)2 << i;
+    }
+  }
+
+  return (uint64_t)2 << (IB_IO_LATENCY_BUCKETS - 1);
+}
+
+/** Create an InnoDB database (sub-directory). */
+static ib_err_t create_database(const char *name) {
+  bool err;
+
+  err = ib_database_create(name);
+  assert(err == true);
+
+  return (DB_SUCCESS);
+}
+
+/** CREATE TABLE T (c1 INT, c2 VARCHAR(n), PRIMARY KEY(c1)); */
+static ib_err_t create_table(const char *dbname, /*!< in: database name */
+                             const char *name)   /*!< in: table name */
+{
+  ib_trx_t ib_trx;
+  ib_id_t table_id = 0;
+  ib_err_t err = DB_SUCCESS;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  err = ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_VARCHAR, IB_COL_NONE, 0, C2_LEN);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  return (err);
+}
+
+/** Open a table and return a cursor for the table. */
+static ib_crsr_t open_table(const char *dbname, const char *name, ib_trx_t ib_trx) {
+  ib_crsr_t crsr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  auto err = ib_cursor_open_table(table_name, ib_trx, &crsr);
+  assert(err == DB_SUCCESS);
+
+  return crsr;
+}
+
+/** INSERT INTO T VALUE(i, 'xxx...'); in batches of 10000 rows. */
+static void insert_rows(void) {
+  char c2[C2_LEN];
+
+  memset(c2, 'x', sizeof(c2));
+
+  for (uint32_t i = 0; i < n_rows;) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+    auto err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    for (uint32_t end = i + 10000; i < end && i < n_rows; ++i) {
+      err = ib_tuple_write_u32(tpl, 0, i);
+      assert(err == DB_SUCCESS);
+
+      err = ib_col_set_value(tpl, 1, c2, sizeof(c2));
+      assert(err == DB_SUCCESS);
+
+      err = ib_cursor_insert_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+    }
+
+    ib_tuple_delete(tpl);
+
+    err = ib_cursor_close(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+}
+
+/** SELECT * FROM T WHERE c1 = k; for n_lookups random keys. */
+static void lookup_keys(uint32_t seed) {
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+  auto key_tpl = ib_clust_search_tuple_create(crsr);
+  assert(key_tpl != nullptr);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (uint32_t i = 0; i < n_lookups; ++i) {
+    int res = ~0;
+    uint32_t key = rand_r(&seed) % n_rows;
+
+    auto err = ib_tuple_write_u32(key_tpl, 0, key);
+    assert(err == DB_SUCCESS);
+
+    err = ib_cursor_moveto(crsr, key_tpl, IB_CUR_GE, &res);
+    assert(err == DB_SUCCESS);
+    assert(res == 0);
+
+    err = ib_cursor_read_row(crsr, tpl);
+    assert(err == DB_SUCCESS);
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+  }
+
+  ib_tuple_delete(tpl);
+  ib_tuple_delete(key_tpl);
+
+  auto err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+/** SELECT COUNT(*) FROM T; until the lookups are done. */
+static void scan_table(void) {
+  while (!lookups_done.load()) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    auto err = ib_cursor_first(crsr);
+    assert(err == DB_SUCCESS);
+
+    while (err == DB_SUCCESS && !lookups_done.load()) {
+      err = ib_cursor_read_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+
+      err = ib_cursor_next(crsr);
+    }
+
+    assert(err == DB_SUCCESS || err == DB_END_OF_INDEX);
+
+    ib_tuple_delete(tpl);
+
+    err = ib_cursor_close(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+}
+
+/** Run the lookups, with n_scans scan threads alongside, and print the
+latency of the synchronous reads. */
+static void run_phase(const char *name, uint32_t n_scans) {
+  std::vector<std::thread> scanners;
+  std::vector<std::thread> lookups;
+
+  lookups_done = false;
+
+  for (uint32_t i = 0; i < n_scans; ++i) {
+    scanners.emplace_back(scan_table);
+  }
+
+  const auto before = sync_read_latency();
+  const auto n_throttled = status_get("throttled_req_done");
+  const auto start = now_usecs();
+
+  for (uint32_t i = 0; i < n_lookup_threads; ++i) {
+    lookups.emplace_back(lookup_keys, i + 1);
+  }
+
+  for (auto &thread : lookups) {
+    thread.join();
+  }
+
+  const auto usecs = now_usecs() - start;
+  const auto after = sync_read_latency();
+
+  lookups_done = true;
+
+  for (auto &thread : scanners) {
+    thread.join();
+  }
+
+  const auto n_reads = after.n_ios - before.n_ios;
+  const double secs = usecs / 1000000.0;
+
+  printf("%-16s lookups/s: %10.0lf sync reads: %8lu avg: %6luus p50: <%luus p99: <%luus throttled: %ld\n", name,
+         secs > 0 ? n_lookups * n_lookup_threads / secs : 0.0, (unsigned long)n_reads,
+         (unsigned long)(n_reads > 0 ? (after.total_us - before.total_us) / n_reads : 0),
+         (unsigned long)percentile_us(&before, &after, 50.0), (unsigned long)percentile_us(&before, &after, 99.0),
+         (long)(status_get("throttled_req_done") - n_throttled));
+}
+
+/** Set the runtime global options. */
+static void set_options(int argc, char *argv[]) {
+  int opt;
+  int optind;
+  int size = 0;
+  struct option *longopts;
+  int count = 0;
+
+  /* Count the number of InnoDB system options. */
+  while (ib_longopts[count].name) {
+    ++count;
+  }
+
+  /* Add our options and a spot for the sentinel. */
+  size = sizeof(struct option) * (count + 5);
+  longopts = (struct option *)malloc(size);
+  memset(longopts, 0x0, size);
+  memcpy(longopts, ib_longopts, sizeof(struct option) * count);
+
+  longopts[count].name = "rows";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 1;
+  ++count;
+
+  longopts[count].name = "lookups";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 2;
+  ++count;
+
+  longopts[count].name = "lookup-threads";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 3;
+  ++count;
+
+  longopts[count].name = "scan-threads";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 4;
+
+  while ((opt = getopt_long(argc, argv, "", longopts, &optind)) != -1) {
+    switch (opt) {
+
+    case USER_OPT + 1:
+      n_rows = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 2:
+      n_lookups = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 3:
+      n_lookup_threads = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 4:
+      n_scan_threads = strtoul(optarg, nullptr, 10);
+      break;
+
+    default:
+      /* If it's an InnoDB parameter, then we let the
+      auxillary function handle it. */
+      if (set_global_option(opt, optarg) != DB_SUCCESS) {
+        print_usage(argv[0]);
+        fprintf(stderr, "[--rows n] [--lookups n] [--lookup-threads n] [--scan-threads n]\n");
+        exit(EXIT_FAILURE);
+      }
+
+    } /* switch */
+  }
+
+  free(longopts);
+
+  assert(n_rows > 0);
+}
+
+int main(int argc, char *argv[]) {
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  /* The InnoDB options are parsed after test_configure() so that they
+  override its settings. */
+  set_options(argc, argv);
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+
+  err = create_database(DATABASE);
+  assert(err == DB_SUCCESS);
+
+  /* Start from an empty table, a previous run may have left one behind. */
+  (void)drop_table(DATABASE, TABLE);
+
+  err = create_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  insert_rows();
+
+  run_phase("lookups", 0);
+  run_phase("lookups + scans", n_scan_threads);
+
+  err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  return (EXIT_SUCCESS);
+}
@@ -0,0 +1,487 @@
+/***********************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Benchmark of the buffer pool LRU replacement policies. It does the
+equivalent of:
+
+ CREATE TABLE T(c1 INT, c2 VARCHAR(n), PK(c1));
+ INSERT N rows into T;
+
+ and then for a number of rounds:
+
+ 1. SELECT * FROM T WHERE c1 = k; for random k in a small hot set
+ 2. SELECT COUNT(*) FROM T;
+ 3. SELECT * FROM T WHERE c1 = k; for random k in the hot set
+
+ The table is several times larger than the buffer pool and the hot set
+ fits in it. The buffer pool hit ratio and the throughput of each phase
+ are reported. A scan resistant policy keeps the hit ratio of the lookups
+ in phase 3 close to that of phase 1.
+
+ Each policy is benchmarked in a child process, or only the one given
+ with --policy. The InnoDB options, e.g. --ib-buffer-pool-size, apply to
+ all of them. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <getopt.h> /* For getopt_long() */
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t_lru"
+
+/* Length of the c2 column, makes about 70 rows fit in a page. */
+static const uint32_t C2_LEN = 200;
+
+static uint32_t n_rows = 100000;
+static uint32_t n_hot_keys = 128;
+static uint32_t n_lookups = 20000;
+static uint32_t n_rounds = 5;
+static const char *policy = nullptr;
+
+static const char *policies[] = {"midpoint", "2q", "clock"};
+
+/** Counters of one phase of the workload. */
+typedef struct phase_stats {
+  const char *name;
+
+  /** Rows read. */
+  uint64_t n_ops;
+
+  /** Elapsed time in microseconds. */
+  uint64_t usecs;
+
+  /** Page requests. */
+  int64_t n_read_reqs;
+
+  /** Page requests that had to read the page from disk. */
+  int64_t n_reads;
+} phase_stats_t;
+
+static phase_stats_t lookup_stats = {"lookup", 0, 0, 0, 0};
+static phase_stats_t scan_stats = {"scan", 0, 0, 0, 0};
+static phase_stats_t after_scan_stats = {"lookup after scan", 0, 0, 0, 0};
+
+/** @return the current time in microseconds. */
+static uint64_t now_usecs(void) {
+  struct timeval tv;
+
+  gettimeofday(&tv, nullptr);
+
+  return (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/** Read a status variable. */
+static int64_t status_get(const char *name) {
+  int64_t val;
+
+  auto err = ib_status_get_i64(name, &val);
+  assert(err == DB_SUCCESS);
+
+  return val;
+}
+
+/** Create an InnoDB database (sub-directory). */
+static ib_err_t create_database(const char *name) {
+  bool err;
+
+  err = ib_database_create(name);
+  assert(err == true);
+
+  return (DB_SUCCESS);
+}
+
+/** CREATE TABLE T (c1 INT, c2 VARCHAR(n), PRIMARY KEY(c1)); */
+static ib_err_t create_table(const char *dbname, /*!< in: database name */
+                             const char *name)   /*!< in: table name */
+{
+  ib_trx_t ib_trx;
+  ib_id_t table_id = 0;
+  ib_err_t err = DB_SUCCESS;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  err = ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_VARCHAR, IB_COL_NONE, 0, C2_LEN);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  return (err);
+}
+
+/** Open a table and return a cursor for the table. */
+static ib_crsr_t open_table(const char *dbname, const char *name, ib_trx_t ib_trx) {
+  ib_crsr_t crsr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  auto err = ib_cursor_open_table(table_name, ib_trx, &crsr);
+  assert(err == DB_SUCCESS);
+
+  return crsr;
+}
+
+/** INSERT INTO T VALUE(i, 'xxx...'); in batches of 10000 rows. */
+static void insert_rows(void) {
+  char c2[C2_LEN];
+
+  memset(c2, 'x', sizeof(c2));
+
+  for (uint32_t i = 0; i < n_rows;) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+    auto err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    for (uint32_t end = i + 10000; i < end && i < n_rows; ++i) {
+      err = ib_tuple_write_u32(tpl, 0, i);
+      assert(err == DB_SUCCESS);
+
+      err = ib_col_set_value(tpl, 1, c2, sizeof(c2));
+      assert(err == DB_SUCCESS);
+
+      err = ib_cursor_insert_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+    }
+
+    ib_tuple_delete(tpl);
+
+    err = ib_cursor_close(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+}
+
+/** Run a phase and add its counters to stats. */
+static void run_phase(phase_stats_t *stats, uint64_t (*phase)(ib_crsr_t)) {
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+  auto n_read_reqs = status_get("buffer_pool_read_reqs");
+  auto n_reads = status_get("buffer_pool_reads");
+  auto start = now_usecs();
+
+  stats->n_ops += phase(crsr);
+
+  stats->usecs += now_usecs() - start;
+  stats->n_read_reqs += status_get("buffer_pool_read_reqs") - n_read_reqs;
+  stats->n_reads += status_get("buffer_pool_reads") - n_reads;
+
+  auto err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+/** SELECT * FROM T WHERE c1 = k; for n_lookups random keys in the hot set.
+The hot keys are spread over the table, one per page. */
+static uint64_t lookup_hot_keys(ib_crsr_t crsr) {
+  auto key_tpl = ib_clust_search_tuple_create(crsr);
+  assert(key_tpl != nullptr);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  const uint32_t stride = n_rows / n_hot_keys;
+
+  for (uint32_t i = 0; i < n_lookups; ++i) {
+    int res = ~0;
+    uint32_t key = (random() % n_hot_keys) * stride;
+
+    auto err = ib_tuple_write_u32(key_tpl, 0, key);
+    assert(err == DB_SUCCESS);
+
+    err = ib_cursor_moveto(crsr, key_tpl, IB_CUR_GE, &res);
+    assert(err == DB_SUCCESS);
+    assert(res == 0);
+
+    err = ib_cursor_read_row(crsr, tpl);
+    assert(err == DB_SUCCESS);
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+  }
+
+  ib_tuple_delete(tpl);
+  ib_tuple_delete(key_tpl);
+
+  return n_lookups;
+}
+
+/** SELECT COUNT(*) FROM T; */
+static uint64_t scan_table(ib_crsr_t crsr) {
+  uint64_t count = 0;
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  auto err = ib_cursor_first(crsr);
+  assert(err == DB_SUCCESS);
+
+  while (err == DB_SUCCESS) {
+    err = ib_cursor_read_row(crsr, tpl);
+    assert(err == DB_SUCCESS);
+
+    ++count;
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+  assert(count == n_rows);
+
+  ib_tuple_delete(tpl);
+
+  return count;
+}
+
+/** Print the counters of a phase. */
+static void print_phase(const phase_stats_t *stats) {
+  double secs = stats->usecs / 1000000.0;
+  double hit_ratio = 100.0;
+
+  if (stats->n_read_reqs > 0) {
+    hit_ratio = 100.0 * (stats->n_read_reqs - stats->n_reads) / stats->n_read_reqs;
+  }
+
+  printf("%-10s %-18s rows: %10lu time: %8.2lfs rows/s: %12.0lf hit ratio: %6.2lf%% reads: %ld\n", policy, stats->name,
+         (unsigned long)stats->n_ops, secs, secs > 0 ? stats->n_ops / secs : 0.0, hit_ratio, (long)stats->n_reads);
+}
+
+/** Set the runtime global options. */
+static void set_options(int argc, char *argv[]) {
+  int opt;
+  int optind;
+  int size = 0;
+  struct option *longopts;
+  int count = 0;
+
+  /* Count the number of InnoDB system options. */
+  while (ib_longopts[count].name) {
+    ++count;
+  }
+
+  /* Add our options and a spot for the sentinel. */
+  size = sizeof(struct option) * (count + 6);
+  longopts = (struct option *)malloc(size);
+  memset(longopts, 0x0, size);
+  memcpy(longopts, ib_longopts, sizeof(struct option) * count);
+
+  longopts[count].name = "rows";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 1;
+  ++count;
+
+  longopts[count].name = "hot-keys";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 2;
+  ++count;
+
+  longopts[count].name = "lookups";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 3;
+  ++count;
+
+  longopts[count].name = "rounds";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 4;
+  ++count;
+
+  longopts[count].name = "policy";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 5;
+
+  while ((opt = getopt_long(argc, argv, "", longopts, &optind)) != -1) {
+    switch (opt) {
+
+    case USER_OPT + 1:
+      n_rows = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 2:
+      n_hot_keys = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 3:
+      n_lookups = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 4:
+      n_rounds = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 5:
+      policy = optarg;
+      break;
+
+    default:
+      /* If it's an InnoDB parameter, then we let the
+      auxillary function handle it. */
+      if (set_global_option(opt, optarg) != DB_SUCCESS) {
+        print_usage(argv[0]);
+        fprintf(stderr,
+                "[--rows n] [--hot-keys n] [--lookups n] [--rounds n]\n"
+                "[--policy midpoint|2q|clock]\n");
+        exit(EXIT_FAILURE);
+      }
+
+    } /* switch */
+  }
+
+  free(longopts);
+
+  if (n_hot_keys == 0 || n_hot_keys > n_rows) {
+    n_hot_keys = n_rows;
+  }
+}
+
+/** Benchmark the policy in this process. */
+static void run_policy(int argc, char *argv[]) {
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  /* The InnoDB options are parsed after test_configure() so that they
+  override its settings. */
+  optind = 1;
+  set_options(argc, argv);
+
+  err = ib_cfg_set_text("lru_policy", policy);
+  assert(err == DB_SUCCESS);
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+
+  err = create_database(DATABASE);
+  assert(err == DB_SUCCESS);
+
+  /* Start from an empty table, a previous run may have left one behind. */
+  (void)drop_table(DATABASE, TABLE);
+
+  err = create_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  insert_rows();
+
+  srandom(1);
+
+  for (uint32_t i = 0; i < n_rounds; ++i) {
+    run_phase(&lookup_stats, lookup_hot_keys);
+    run_phase(&scan_stats, scan_table);
+    run_phase(&after_scan_stats, lookup_hot_keys);
+  }
+
+  print_phase(&lookup_stats);
+  print_phase(&scan_stats);
+  print_phase(&after_scan_stats);
+
+  err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+}
+
+int main(int argc, char *argv[]) {
+  /* Look for --policy only, the InnoDB options are parsed after ib_init(). */
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--policy") == 0 && i + 1 < argc) {
+      policy = argv[i + 1];
+    } else if (strncmp(argv[i], "--policy=", 9) == 0) {
+      policy = argv[i] + 9;
+    }
+  }
+
+  if (policy != nullptr) {
+    run_policy(argc, argv);
+    return (EXIT_SUCCESS);
+  }
+
+  /* Run each policy in its own process, InnoDB can be started only once. */
+  for (auto name : policies) {
+    fflush(stdout);
+
+    auto pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+      policy = name;
+      run_policy(argc, argv);
+      exit(EXIT_SUCCESS);
+    }
+
+    int status;
+
+    auto ret = waitpid(pid, &status, 0);
+    assert(ret == pid);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+      fprintf(stderr, "Benchmark of policy %s failed\n", name);
+      return (EXIT_FAILURE);
+    }
+  }
+
+  return (EXIT_SUCCESS);
+}
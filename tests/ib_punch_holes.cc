@@ -0,0 +1,325 @@
+/***********************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Test of the punch_holes configuration variable. It does the equivalent of:
+
+ CREATE TABLE T(c1 INT, c2 VARCHAR(n), PK(c1), INDEX(c2));
+ INSERT N rows into T;
+ DROP INDEX c2;
+
+ and waits until the extents that the index used are returned to the file
+ system, the file then occupies fewer blocks. It then inserts N more rows,
+ which allocates the extents again, and checks all the rows, before and
+ after a restart. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t_punch"
+
+/* Length of the c2 column. */
+static const uint32_t C2_LEN = 200;
+
+static const uint32_t N_ROWS = 50000;
+
+/* Seconds to wait for the holes, a checkpoint must be made first. */
+static const int MAX_WAIT = 120;
+
+/** Start InnoDB with the hole punching on. */
+static void startup(void) {
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  err = ib_cfg_set_bool_on("punch_holes");
+  assert(err == DB_SUCCESS);
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+}
+
+/** Create an InnoDB database (sub-directory). */
+static ib_err_t create_database(const char *name) {
+  bool err;
+
+  err = ib_database_create(name);
+  assert(err == true);
+
+  return (DB_SUCCESS);
+}
+
+/** CREATE TABLE T (c1 INT, c2 VARCHAR(n), PRIMARY KEY(c1), INDEX(c2)); */
+static ib_err_t create_table(const char *dbname, /*!< in: database name */
+                             const char *name)   /*!< in: table name */
+{
+  ib_trx_t ib_trx;
+  ib_id_t table_id = 0;
+  ib_err_t err = DB_SUCCESS;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  err = ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_VARCHAR, IB_COL_NONE, 0, C2_LEN);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "c2", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c2", 0);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  return (err);
+}
+
+/** DROP INDEX c2 ON T; */
+static void drop_index(const char *dbname, const char *name) {
+  ib_id_t index_id;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  auto err = ib_index_get_id(table_name, "c2", &index_id);
+  assert(err == DB_SUCCESS);
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_drop(ib_trx, index_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+/** Open a table and return a cursor for the table. */
+static ib_crsr_t open_table(const char *dbname, const char *name, ib_trx_t ib_trx) {
+  ib_crsr_t crsr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  auto err = ib_cursor_open_table(table_name, ib_trx, &crsr);
+  assert(err == DB_SUCCESS);
+
+  return crsr;
+}
+
+/** The value of c2 for a key, long enough to make the index span many extents. */
+static void make_c2(uint32_t key, char *c2) {
+  for (uint32_t i = 0; i < C2_LEN; ++i) {
+    c2[i] = 'a' + (key * 7 + i) % 26;
+  }
+}
+
+/** INSERT INTO T VALUE(i, c2(i)); for i in [first, last), in batches of 10000 rows. */
+static void insert_rows(uint32_t first, uint32_t last) {
+  char c2[C2_LEN];
+
+  for (uint32_t i = first; i < last;) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+    auto err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    for (uint32_t end = i + 10000; i < end && i < last; ++i) {
+      make_c2(i, c2);
+
+      err = ib_tuple_write_u32(tpl, 0, i);
+      assert(err == DB_SUCCESS);
+
+      err = ib_col_set_value(tpl, 1, c2, sizeof(c2));
+      assert(err == DB_SUCCESS);
+
+      err = ib_cursor_insert_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+
+      tpl = ib_tuple_clear(tpl);
+      assert(tpl != nullptr);
+    }
+
+    ib_tuple_delete(tpl);
+
+    err = ib_cursor_close(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+}
+
+/** SELECT * FROM T; checks that the rows are 0..n_rows - 1 with their c2. */
+static void check_rows(uint32_t n_rows) {
+  char c2[C2_LEN];
+  uint32_t n{};
+
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  auto err = ib_cursor_first(crsr);
+
+  while (err == DB_SUCCESS) {
+    uint32_t key;
+
+    err = ib_cursor_read_row(crsr, tpl);
+    assert(err == DB_SUCCESS);
+
+    err = ib_tuple_read_u32(tpl, 0, &key);
+    assert(err == DB_SUCCESS);
+    assert(key == n);
+
+    make_c2(key, c2);
+
+    assert(ib_col_get_len(tpl, 1) == C2_LEN);
+    assert(memcmp(ib_col_get_value(tpl, 1), c2, C2_LEN) == 0);
+
+    ++n;
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+
+    err = ib_cursor_next(crsr);
+  }
+
+  assert(err == DB_END_OF_INDEX);
+  assert(n == n_rows);
+
+  ib_tuple_delete(tpl);
+
+  err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+/** @return the number of 512 byte blocks that the file of the table occupies. */
+static int64_t table_blocks(const char *dbname, const char *name) {
+  struct stat st;
+  char path[IB_MAX_TABLE_NAME_LEN + 16];
+
+  snprintf(path, sizeof(path), "./%s/%s.ibd", dbname, name);
+
+  auto ret = stat(path, &st);
+  assert(ret == 0);
+
+  return (int64_t)st.st_blocks;
+}
+
+int main(int argc, char *argv[]) {
+  (void)argc;
+  (void)argv;
+
+  startup();
+
+  auto err = create_database(DATABASE);
+  assert(err == DB_SUCCESS);
+
+  /* Start from an empty table, a previous run may have left one behind. */
+  (void)drop_table(DATABASE, TABLE);
+
+  err = create_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  insert_rows(0, N_ROWS);
+
+  const auto blocks = table_blocks(DATABASE, TABLE);
+
+  drop_index(DATABASE, TABLE);
+
+  int waited{};
+
+  while (table_blocks(DATABASE, TABLE) >= blocks && waited < MAX_WAIT) {
+    sleep(1);
+    ++waited;
+  }
+
+  const auto punched_blocks = table_blocks(DATABASE, TABLE);
+
+  printf("Blocks before DROP INDEX: %ld, after %d seconds: %ld\n", (long)blocks, waited, (long)punched_blocks);
+
+  if (punched_blocks >= blocks) {
+    fprintf(stderr, "No holes were punched, does the file system support them?\n");
+    return (EXIT_FAILURE);
+  }
+
+  /* Allocates the extents that have holes again. */
+  insert_rows(N_ROWS, 2 * N_ROWS);
+
+  check_rows(2 * N_ROWS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  startup();
+
+  check_rows(2 * N_ROWS);
+
+  err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+
+  return (EXIT_SUCCESS);
+}
@@ -0,0 +1,434 @@
+/***********************************************************************
+Copyright (c) 2024 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA
+
+************************************************************************/
+
+/* Benchmark of the read latency with and without an io_uring polling
+thread (the io_uring_sqpoll configuration variable). It does the
+equivalent of:
+
+ CREATE TABLE T(c1 INT, c2 VARCHAR(n), PK(c1));
+ INSERT N rows into T;
+
+ and then:
+
+ SELECT * FROM T WHERE c1 = k; for random k over the whole table
+
+ The table is several times larger than the buffer pool so that most of
+ the lookups have to read a page. The latency of every lookup is recorded
+ and the p50, p99 and p99.9 latencies are reported.
+
+ Each mode is benchmarked in a child process, or only the one given with
+ --mode. The InnoDB options, e.g. --ib-buffer-pool-size, apply to both. */
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <getopt.h> /* For getopt_long() */
+
+#include <algorithm>
+#include <vector>
+
+#include "test0aux.h"
+
+#define DATABASE "test"
+#define TABLE "t_sqpoll"
+
+/* Length of the c2 column, makes about 70 rows fit in a page. */
+static const uint32_t C2_LEN = 200;
+
+static uint32_t n_rows = 200000;
+static uint32_t n_lookups = 20000;
+static uint32_t sqpoll_idle = 1000;
+static const char *mode = nullptr;
+
+static const char *modes[] = {"normal", "sqpoll"};
+
+/** @return the current time in nanoseconds. */
+static uint64_t now_nsecs(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/** Read a status variable. */
+static int64_t status_get(const char *name) {
+  int64_t val;
+
+  auto err = ib_status_get_i64(name, &val);
+  assert(err == DB_SUCCESS);
+
+  return val;
+}
+
+/** Create an InnoDB database (sub-directory). */
+static ib_err_t create_database(const char *name) {
+  bool err;
+
+  err = ib_database_create(name);
+  assert(err == true);
+
+  return (DB_SUCCESS);
+}
+
+/** CREATE TABLE T (c1 INT, c2 VARCHAR(n), PRIMARY KEY(c1)); */
+static ib_err_t create_table(const char *dbname, /*!< in: database name */
+                             const char *name)   /*!< in: table name */
+{
+  ib_trx_t ib_trx;
+  ib_id_t table_id = 0;
+  ib_err_t err = DB_SUCCESS;
+  ib_tbl_sch_t ib_tbl_sch = nullptr;
+  ib_idx_sch_t ib_idx_sch = nullptr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  err = ib_table_schema_create(table_name, &ib_tbl_sch, IB_TBL_V1, 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c1", IB_INT, IB_COL_UNSIGNED, 0, sizeof(uint32_t));
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_col(ib_tbl_sch, "c2", IB_VARCHAR, IB_COL_NONE, 0, C2_LEN);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_schema_add_index(ib_tbl_sch, "PRIMARY", &ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_add_col(ib_idx_sch, "c1", 0);
+  assert(err == DB_SUCCESS);
+
+  err = ib_index_schema_set_clustered(ib_idx_sch);
+  assert(err == DB_SUCCESS);
+
+  ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  err = ib_schema_lock_exclusive(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  err = ib_table_create(ib_trx, ib_tbl_sch, &table_id);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+
+  ib_table_schema_delete(ib_tbl_sch);
+
+  return (err);
+}
+
+/** Open a table and return a cursor for the table. */
+static ib_crsr_t open_table(const char *dbname, const char *name, ib_trx_t ib_trx) {
+  ib_crsr_t crsr;
+  char table_name[IB_MAX_TABLE_NAME_LEN];
+
+  snprintf(table_name, sizeof(table_name), "%s/%s", dbname, name);
+
+  auto err = ib_cursor_open_table(table_name, ib_trx, &crsr);
+  assert(err == DB_SUCCESS);
+
+  return crsr;
+}
+
+/** INSERT INTO T VALUE(i, 'xxx...'); in batches of 10000 rows. */
+static void insert_rows(void) {
+  char c2[C2_LEN];
+
+  memset(c2, 'x', sizeof(c2));
+
+  for (uint32_t i = 0; i < n_rows;) {
+    auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+    auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+    auto err = ib_cursor_lock(crsr, IB_LOCK_IX);
+    assert(err == DB_SUCCESS);
+
+    auto tpl = ib_clust_read_tuple_create(crsr);
+    assert(tpl != nullptr);
+
+    for (uint32_t end = i + 10000; i < end && i < n_rows; ++i) {
+      err = ib_tuple_write_u32(tpl, 0, i);
+      assert(err == DB_SUCCESS);
+
+      err = ib_col_set_value(tpl, 1, c2, sizeof(c2));
+      assert(err == DB_SUCCESS);
+
+      err = ib_cursor_insert_row(crsr, tpl);
+      assert(err == DB_SUCCESS);
+    }
+
+    ib_tuple_delete(tpl);
+
+    err = ib_cursor_close(crsr);
+    assert(err == DB_SUCCESS);
+
+    err = ib_trx_commit(ib_trx);
+    assert(err == DB_SUCCESS);
+  }
+}
+
+/** SELECT * FROM T WHERE c1 = k; for n_lookups random keys, records the
+latency of each lookup in nanoseconds. */
+static void lookup_random_keys(std::vector<uint64_t> &latencies) {
+  auto ib_trx = ib_trx_begin(IB_TRX_REPEATABLE_READ);
+  auto crsr = open_table(DATABASE, TABLE, ib_trx);
+
+  auto key_tpl = ib_clust_search_tuple_create(crsr);
+  assert(key_tpl != nullptr);
+
+  auto tpl = ib_clust_read_tuple_create(crsr);
+  assert(tpl != nullptr);
+
+  for (uint32_t i = 0; i < n_lookups; ++i) {
+    int res = ~0;
+    uint32_t key = random() % n_rows;
+
+    auto start = now_nsecs();
+
+    auto err = ib_tuple_write_u32(key_tpl, 0, key);
+    assert(err == DB_SUCCESS);
+
+    err = ib_cursor_moveto(crsr, key_tpl, IB_CUR_GE, &res);
+    assert(err == DB_SUCCESS);
+    assert(res == 0);
+
+    err = ib_cursor_read_row(crsr, tpl);
+    assert(err == DB_SUCCESS);
+
+    latencies.push_back(now_nsecs() - start);
+
+    tpl = ib_tuple_clear(tpl);
+    assert(tpl != nullptr);
+  }
+
+  ib_tuple_delete(tpl);
+  ib_tuple_delete(key_tpl);
+
+  auto err = ib_cursor_close(crsr);
+  assert(err == DB_SUCCESS);
+
+  err = ib_trx_commit(ib_trx);
+  assert(err == DB_SUCCESS);
+}
+
+/** @return the latency at percentile pct of the sorted latencies, in microseconds. */
+static double percentile(const std::vector<uint64_t> &latencies, double pct) {
+  auto i = (size_t)(pct / 100.0 * (latencies.size() - 1));
+
+  return latencies[i] / 1000.0;
+}
+
+/** Print the latency distribution. */
+static void print_latencies(std::vector<uint64_t> &latencies, int64_t n_reads) {
+  assert(!latencies.empty());
+
+  std::sort(latencies.begin(), latencies.end());
+
+  uint64_t total = 0;
+
+  for (auto latency : latencies) {
+    total += latency;
+  }
+
+  printf("%-8s lookups: %8lu reads: %8ld mean: %9.1lfus p50: %9.1lfus p99: %9.1lfus p99.9: %9.1lfus\n", mode,
+         (unsigned long)latencies.size(), (long)n_reads, total / 1000.0 / latencies.size(), percentile(latencies, 50.0),
+         percentile(latencies, 99.0), percentile(latencies, 99.9));
+}
+
+/** Set the runtime global options. */
+static void set_options(int argc, char *argv[]) {
+  int opt;
+  int optind;
+  int size = 0;
+  struct option *longopts;
+  int count = 0;
+
+  /* Count the number of InnoDB system options. */
+  while (ib_longopts[count].name) {
+    ++count;
+  }
+
+  /* Add our options and a spot for the sentinel. */
+  size = sizeof(struct option) * (count + 5);
+  longopts = (struct option *)malloc(size);
+  memset(longopts, 0x0, size);
+  memcpy(longopts, ib_longopts, sizeof(struct option) * count);
+
+  longopts[count].name = "rows";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 1;
+  ++count;
+
+  longopts[count].name = "lookups";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 2;
+  ++count;
+
+  longopts[count].name = "sqpoll-idle";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 3;
+  ++count;
+
+  longopts[count].name = "mode";
+  longopts[count].has_arg = required_argument;
+  longopts[count].val = USER_OPT + 4;
+
+  while ((opt = getopt_long(argc, argv, "", longopts, &optind)) != -1) {
+    switch (opt) {
+
+    case USER_OPT + 1:
+      n_rows = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 2:
+      n_lookups = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 3:
+      sqpoll_idle = strtoul(optarg, nullptr, 10);
+      break;
+
+    case USER_OPT + 4:
+      mode = optarg;
+      break;
+
+    default:
+      /* If it's an InnoDB parameter, then we let the
+      auxillary function handle it. */
+      if (set_global_option(opt, optarg) != DB_SUCCESS) {
+        print_usage(argv[0]);
+        fprintf(stderr,
+                "[--rows n] [--lookups n] [--sqpoll-idle ms]\n"
+                "[--mode normal|sqpoll]\n");
+        exit(EXIT_FAILURE);
+      }
+
+    } /* switch */
+  }
+
+  free(longopts);
+
+  if (n_rows == 0) {
+    n_rows = 1;
+  }
+}
+
+/** Benchmark the mode in this process. */
+static void run_mode(int argc, char *argv[]) {
+  auto err = ib_init();
+  assert(err == DB_SUCCESS);
+
+  test_configure();
+
+  /* The InnoDB options are parsed after test_configure() so that they
+  override its settings. */
+  optind = 1;
+  set_options(argc, argv);
+
+  if (strcmp(mode, "sqpoll") == 0) {
+    err = ib_cfg_set_bool_on("io_uring_sqpoll");
+    assert(err == DB_SUCCESS);
+
+    err = ib_cfg_set_int("io_uring_sqpoll_idle", sqpoll_idle);
+    assert(err == DB_SUCCESS);
+  } else {
+    assert(strcmp(mode, "normal") == 0);
+
+    err = ib_cfg_set_bool_off("io_uring_sqpoll");
+    assert(err == DB_SUCCESS);
+  }
+
+  err = ib_startup("default");
+  assert(err == DB_SUCCESS);
+
+  err = create_database(DATABASE);
+  assert(err == DB_SUCCESS);
+
+  /* Start from an empty table, a previous run may have left one behind. */
+  (void)drop_table(DATABASE, TABLE);
+
+  err = create_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  insert_rows();
+
+  srandom(1);
+
+  std::vector<uint64_t> latencies;
+
+  latencies.reserve(n_lookups);
+
+  auto n_reads = status_get("buffer_pool_reads");
+
+  lookup_random_keys(latencies);
+
+  print_latencies(latencies, status_get("buffer_pool_reads") - n_reads);
+
+  err = drop_table(DATABASE, TABLE);
+  assert(err == DB_SUCCESS);
+
+  err = ib_shutdown(IB_SHUTDOWN_NORMAL);
+  assert(err == DB_SUCCESS);
+}
+
+int main(int argc, char *argv[]) {
+  /* Look for --mode only, the InnoDB options are parsed after ib_init(). */
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+      mode = argv[i + 1];
+    } else if (strncmp(argv[i], "--mode=", 7) == 0) {
+      mode = argv[i] + 7;
+    }
+  }
+
+  if (mode != nullptr) {
+    run_mode(argc, argv);
+    return (EXIT_SUCCESS);
+  }
+
+  /* Run each mode in its own process, InnoDB can be started only once. */
+  for (auto name : modes) {
+    fflush(stdout);
+
+    auto pid = fork();
+    assert(pid >= 0);
+
+    if (pid == 0) {
+      mode = name;
+      run_mode(argc, argv);
+      exit(EXIT_SUCCESS);
+    }
+
+    int status;
+
+    auto ret = waitpid(pid, &status, 0);
+    assert(ret == pid);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+      fprintf(stderr, "Benchmark of mode %s failed\n", name);
+      return (EXIT_FAILURE);
+    }
+  }
+
+  return (EXIT_SUCCESS);
+}
@@ -45,6 +45,41 @@ static void get_all(void) {
   }
 }
 
+static void get_io_latency(void) {
+  static const char *types[] = {
+    "Async_read", "Async_write", "Async_log_read", "Async_log_write",
+    "Sync_read", "Sync_write", "Sync_log_read", "Sync_log_write"};
+
+  for (auto type : types) {
+    ib_io_latency_t latency;
+
+    OK(ib_io_latency_get_by_type(type, &latency, sizeof(latency)));
+
+    uint64_t n_ios{};
+
+    for (int i = 0; i < IB_IO_LATENCY_BUCKETS; ++i) {
+      n_ios += latency.buckets[i];
+    }
+
+    /* I/O may complete while the histogram is read, e.g., of the
+    background threads. A sample is counted before it is put in a bucket. */
+    assert(n_ios <= latency.n_ios);
+
+    printf("io_latency %s: n_ios: %lu, total_us: %lu, max_us: %lu\n",
+      type, (unsigned long)latency.n_ios, (unsigned long)latency.total_us, (unsigned long)latency.max_us);
+  }
+
+  ib_io_latency_t latency;
+
+  assert(ib_io_latency_get_by_type("no_such_type", &latency, sizeof(latency)) == DB_NOT_FOUND);
+
+  /* The data dictionary tables are in the system tablespace, it has been read at startup. */
+  OK(ib_io_latency_get_by_table("SYS_TABLES", &latency, sizeof(latency)));
+  assert(latency.n_ios > 0);
+
+  assert(ib_io_latency_get_by_table("no_such_db/no_such_table", &latency, sizeof(latency)) == DB_TABLE_NOT_FOUND);
+}
+
 int main(int argc, char **argv) {
   ib_err_t err;
 
@@ -61,6 +96,8 @@ int main(int argc, char **argv) {
 
   get_all();
 
+  get_io_latency();
+
   err = ib_shutdown(IB_SHUTDOWN_NORMAL);
   assert(err == DB_SUCCESS);
 
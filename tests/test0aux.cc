@@ -340,6 +340,7 @@ struct option ib_longopts[] = {
     {"ib-write-threads", required_argument, nullptr, 17},
     {"ib-max-open-files", required_argument, nullptr, 18},
     {"ib-lock-wait-timeout", required_argument, nullptr, 19},
+    {"ib-lru-policy", required_argument, nullptr, 20},
     {nullptr, 0, nullptr, 0}};
 
 /** Print usage. */
@@ -363,7 +364,8 @@ void print_usage(const char *progname) {
           "[--ib-read-threads count]\n"
           "[--ib-write-threads count]\n"
           "[--ib-max-open-files count]\n"
-          "[--ib-lock-wait-timeout seconds]\n",
+          "[--ib-lock-wait-timeout seconds]\n"
+          "[--ib-lru-policy midpoint|2q|clock]\n",
           progname);
 }
 
@@ -512,6 +514,12 @@ ib_err_t set_global_option(int opt, const char *arg) {
     break;
   }
 
+  case 20: {
+    err = ib_cfg_set_text("lru_policy", arg);
+    assert(err == DB_SUCCESS);
+    break;
+  }
+
   default:
     err = DB_ERROR;
     break;
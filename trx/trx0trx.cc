@@ -157,6 +157,7 @@ bool Trx::start_low(ulint rseg_id) noexcept {
   m_no = LSN_MAX;
   m_conc_state = TRX_ACTIVE;
   m_start_time = time(nullptr);
+  m_flush_log_async = false;
 
 #ifdef WITH_XOPEN
   m_flush_log_later = false;
@@ -351,7 +352,9 @@ void Trx::commit_off_kernel() noexcept {
       m_must_flush_log_later = true;
     } else
 #endif /* WITH_XOPEN */
-      if (srv_config.m_flush_log_at_trx_commit == 0) {
+      if (m_flush_log_async) {
+        /* Do nothing, the caller requests the flush */
+      } else if (srv_config.m_flush_log_at_trx_commit == 0) {
         /* Do nothing */
       } else if (srv_config.m_flush_log_at_trx_commit == 1) {
         if (srv_config.m_unix_file_flush_method == SRV_UNIX_NOSYNC) {
@@ -0,0 +1,167 @@
+/****************************************************************************
+Copyright (c) 2025 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "innodb0types.h"
+
+#include "fil0types.h"
+#include "os0aio.h"
+#include "os0sync.h"
+#include "ut0mem.h"
+
+#include "gtest/gtest.h"
+
+namespace logger {
+int level = (int)Level::Debug;
+const char *Progname = "os0aio-t";
+}  // namespace logger
+
+namespace {
+
+/** Slots of each handler, the read handler lets a prefetch hold 2 of them. */
+constexpr ulint N_SLOTS = 8;
+
+/** Size of a request. */
+constexpr ulint LEN = 4096;
+
+/** The queue ids of the handlers, one queue each. */
+constexpr aio::Queue_id READ_QUEUE = 1;
+constexpr aio::Queue_id WRITE_QUEUE = 2;
+
+struct AIOTest : public ::testing::Test {
+  static void SetUpTestSuite() {
+    ut_mem_init();
+    os_sync_init();
+  }
+
+  void SetUp() override {
+    char name[] = "/tmp/os0aio-tXXXXXX";
+
+    m_fh = mkstemp(name);
+    ASSERT_NE(m_fh, -1);
+
+    m_file_name = name;
+    unlink(name);
+
+    ASSERT_EQ(ftruncate(m_fh, N_SLOTS * 2 * LEN), 0);
+
+    m_node.m_space = &m_space;
+    m_node.m_file_name = m_file_name.data();
+    m_node.m_fh = m_fh;
+    m_node.m_fixed_fh = -1;
+
+    m_bufs.resize(N_SLOTS * 2 * LEN);
+
+    m_aio = AIO::create(N_SLOTS, 1, 1, 0);
+  }
+
+  void TearDown() override {
+    m_aio->shutdown();
+    AIO::destroy(m_aio);
+
+    close(m_fh);
+  }
+
+  /** Submits a request that reads or writes the i'th block of the file. */
+  db_err submit(IO_request io_request, IO_priority priority, ulint i) {
+    IO_ctx io_ctx{.m_fil_node = &m_node, .m_io_request = io_request, .m_priority = priority};
+
+    return m_aio->submit(std::move(io_ctx), &m_bufs[i * LEN], LEN, off_t(i * LEN));
+  }
+
+  /** Reaps a completed request of the queue. */
+  void reap(aio::Queue_id queue_id) {
+    IO_ctx io_ctx;
+
+    ASSERT_EQ(m_aio->reap(queue_id, io_ctx), DB_SUCCESS);
+    ASSERT_EQ(io_ctx.m_ret, int(LEN));
+  }
+
+  AIO *m_aio{};
+  int m_fh{-1};
+  std::string m_file_name{};
+  fil_space_t m_space{};
+  fil_node_t m_node{};
+  std::vector<byte> m_bufs{};
+};
+
+}  // namespace
+
+// A class at its limit waits for one of its own slots, the other classes
+// of the handler are not held up
+TEST_F(AIOTest, PrefetchIsThrottled) {
+  constexpr ulint N_PREFETCH = N_SLOTS / 4;
+
+  for (ulint i = 0; i < N_PREFETCH; ++i) {
+    ASSERT_EQ(submit(IO_request::Async_read, IO_priority::Prefetch, i), DB_SUCCESS);
+  }
+
+  std::atomic<bool> submitted{};
+
+  std::thread prefetch([&] {
+    EXPECT_EQ(submit(IO_request::Async_read, IO_priority::Prefetch, N_PREFETCH), DB_SUCCESS);
+    submitted = true;
+  });
+
+  /* The request can only get a slot after a prefetch completes. */
+  while (m_aio->n_throttled(IO_priority::Prefetch) == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  EXPECT_FALSE(submitted.load());
+
+  /* A read-ahead request still gets a slot, the prefetch ones hold 2 of 8. */
+  ASSERT_EQ(submit(IO_request::Async_read, IO_priority::Read_ahead, N_PREFETCH + 1), DB_SUCCESS);
+
+  /* And so does a synchronous read. */
+  ASSERT_EQ(submit(IO_request::Sync_read, IO_priority::Default, N_PREFETCH + 2), DB_SUCCESS);
+
+  EXPECT_FALSE(submitted.load());
+
+  /* Reaping a request of the class lets the waiting one in, the last one
+  reaped is the waiting prefetch. */
+  for (ulint i = 0; i < N_PREFETCH + 2; ++i) {
+    reap(READ_QUEUE);
+  }
+
+  prefetch.join();
+
+  EXPECT_TRUE(submitted.load());
+  EXPECT_EQ(m_aio->n_throttled(IO_priority::Read_ahead), 0);
+}
+
+// The write handler serves only the flush class, it may hold all the slots
+TEST_F(AIOTest, FlushUsesAllWriteSlots) {
+  for (ulint i = 0; i < N_SLOTS; ++i) {
+    ASSERT_EQ(submit(IO_request::Async_write, IO_priority::Default, i), DB_SUCCESS);
+  }
+
+  EXPECT_EQ(m_aio->n_throttled(IO_priority::Flush), 0);
+
+  for (ulint i = 0; i < N_SLOTS; ++i) {
+    reap(WRITE_QUEUE);
+  }
+}
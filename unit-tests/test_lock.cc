@@ -147,10 +147,10 @@ int main() {
   {
     srv_config.m_buf_pool_size = 64 * 1024 * 1024;
 
-    srv_buf_pool = new (std::nothrow) Buf_pool();
+    srv_buf_pool = new (std::nothrow) Buf_pool_manager();
     ut_a(srv_buf_pool != nullptr);
 
-    auto success = srv_buf_pool->open(srv_config.m_buf_pool_size);
+    auto success = srv_buf_pool->open(srv_config.m_buf_pool_size, srv_config.m_buf_pool_instances);
     ut_a(success);
   }
 
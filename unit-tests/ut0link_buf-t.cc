@@ -0,0 +1,95 @@
+/****************************************************************************
+Copyright (c) 2025 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "innodb0types.h"
+
+#include "ut0link_buf.h"
+
+#include "gtest/gtest.h"
+
+namespace logger {
+int level = (int)Level::Debug;
+const char *Progname = "ut0link_buf-t";
+}  // namespace logger
+
+// The tail only passes ranges that are completed and contiguous
+TEST(LinkBufTest, AdvanceStopsAtGaps) {
+  ut::Link_buf link_buf(16);
+
+  link_buf.reset(100);
+
+  link_buf.add(110, 120);
+  EXPECT_EQ(link_buf.advance(), 100);
+
+  link_buf.add(100, 110);
+  EXPECT_EQ(link_buf.advance(), 120);
+
+  link_buf.add(130, 135);
+  EXPECT_EQ(link_buf.advance(), 120);
+
+  link_buf.add(120, 130);
+  EXPECT_EQ(link_buf.advance(), 135);
+  EXPECT_EQ(link_buf.tail(), 135);
+}
+
+// Links left over from the ranges that were passed must be ignored
+TEST(LinkBufTest, StaleLinksAreIgnored) {
+  ut::Link_buf link_buf(4);
+
+  link_buf.reset(0);
+
+  for (uint64_t pos = 0; pos < 64; pos += 3) {
+    link_buf.add(pos, pos + 3);
+    EXPECT_EQ(link_buf.advance(), pos + 3);
+  }
+
+  /* Slot 66 % 4 holds the link of range [54, 57), it must not be followed. */
+  EXPECT_EQ(link_buf.advance(), 66);
+}
+
+// Threads that reserve ranges with a fetch-add and complete them in any order
+TEST(LinkBufTest, ConcurrentRanges) {
+  constexpr int N_THREADS = 8;
+  constexpr int N_RANGES = 20000;
+
+  ut::Link_buf link_buf(256);
+  std::atomic<uint64_t> next{};
+  std::vector<std::thread> threads;
+
+  link_buf.reset(0);
+
+  for (int i = 0; i < N_THREADS; ++i) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < N_RANGES; ++j) {
+        const uint64_t len = 1 + (i + j) % 7;
+        const auto from = next.fetch_add(len);
+
+        link_buf.add(from, from + len);
+      }
+    });
+  }
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(link_buf.advance(), next.load());
+}
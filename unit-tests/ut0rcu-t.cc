@@ -0,0 +1,103 @@
+/****************************************************************************
+Copyright (c) 2025 Sunny Bains. All rights reserved.
+
+This program is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free Software
+Foundation; version 2 of the License.
+
+This program is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+Place, Suite 330, Boston, MA 02111-1307 USA
+
+*****************************************************************************/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "innodb0types.h"
+
+#include "ut0rcu.h"
+
+#include "gtest/gtest.h"
+
+namespace logger {
+int level = (int)Level::Debug;
+const char *Progname = "ut0rcu-t";
+}  // namespace logger
+
+namespace {
+
+constexpr uint64_t LIVE = 0x1122334455667788;
+constexpr uint64_t DEAD = 0xdeaddeaddeaddead;
+
+struct Object {
+  std::atomic<uint64_t> m_magic{LIVE};
+};
+
+}  // namespace
+
+// synchronize() must not wait if there are no readers
+TEST(RcuTest, SynchronizeWithoutReaders) {
+  ut::Rcu rcu;
+
+  rcu.synchronize();
+  rcu.synchronize();
+}
+
+// The readers must never see an object that the writer retired
+TEST(RcuTest, ReadersNeverSeeRetiredObjects) {
+  constexpr int N_READERS = 4;
+  constexpr int N_UPDATES = 2000;
+
+  ut::Rcu rcu;
+  std::atomic<bool> done{};
+  std::atomic<uint64_t> n_errors{};
+  std::atomic<Object *> current{new Object};
+
+  std::vector<Object *> retired;
+  std::vector<std::thread> readers;
+
+  for (int i = 0; i < N_READERS; ++i) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        auto token = rcu.read_lock();
+
+        if (current.load()->m_magic.load(std::memory_order_relaxed) != LIVE) {
+          n_errors.fetch_add(1);
+        }
+
+        ut::Rcu::read_unlock(token);
+      }
+    });
+  }
+
+  for (int i = 0; i < N_UPDATES; ++i) {
+    auto old = current.exchange(new Object);
+
+    rcu.synchronize();
+
+    /* Poison instead of freeing so that a late reader is detected. */
+    old->m_magic.store(DEAD, std::memory_order_relaxed);
+
+    retired.push_back(old);
+  }
+
+  done.store(true);
+
+  for (auto &reader : readers) {
+    reader.join();
+  }
+
+  EXPECT_EQ(n_errors.load(), 0);
+
+  for (auto object : retired) {
+    delete object;
+  }
+
+  delete current.load();
+}